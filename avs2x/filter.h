@@ -10,6 +10,10 @@ namespace Filtering { namespace Avisynth2x {
 
 static CpuFlags AvsToInternalCpuFlags(int avsCpuFlags) {
   int flags = CPU_NONE;
+  if (avsCpuFlags & CPUF_AVX512F) flags |= CPU_AVX512F;
+  if (avsCpuFlags & CPUF_AVX512BW) flags |= CPU_AVX512BW;
+  if (avsCpuFlags & CPUF_AVX512VL) flags |= CPU_AVX512VL;
+  if (avsCpuFlags & CPUF_AVX512VBMI) flags |= CPU_AVX512VBMI;
   if (avsCpuFlags & CPUF_AVX2) flags |= CPU_AVX2;
   if (avsCpuFlags & CPUF_AVX) flags |= CPU_AVX;
   if (avsCpuFlags & CPUF_SSE4_2) flags |= CPU_SSE4_2;
@@ -20,6 +20,10 @@ enum {
   CPU_SSE4_2 = 0x100,
   CPU_AVX    = 0x200,
   CPU_AVX2   = 0x400,
+  CPU_AVX512F  = 0x800,
+  CPU_AVX512BW = 0x1000,
+  CPU_AVX512VL = 0x2000,
+  CPU_AVX512VBMI = 0x4000,
 };
 
 typedef int CpuFlags;
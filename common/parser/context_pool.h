@@ -0,0 +1,130 @@
+#ifndef __Mt_ContextPool_H__
+#define __Mt_ContextPool_H__
+
+#include "symbol.h"
+#include <assert.h>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Filtering { namespace Parser {
+
+// Contexts of one expression for the realtime processors.
+// A context is not thread safe, so each call borrows one for the time of a plane and gives it
+// back afterwards: there are never more contexts than threads using the pool at once, and
+// the compiled program (and its native code) survives from frame to frame. Only the x, y, z, a
+// registers change between uses, and the row functions set them on every call.
+// Filters with the same program share one pool through shared().
+class ContextPool {
+
+   std::deque<Symbol> expression;
+   bool use_jit;
+   bool jit_avx;
+
+   std::mutex mutex;
+   std::vector<std::unique_ptr<Context>> idle;
+
+   std::unique_ptr<Context> take()
+   {
+      {
+         std::lock_guard<std::mutex> lock(mutex);
+         if (!idle.empty()) {
+            std::unique_ptr<Context> ctx = std::move(idle.back());
+            idle.pop_back();
+            return ctx;
+         }
+      }
+      std::unique_ptr<Context> ctx(new Context(expression));
+      if (use_jit)
+         ctx->enable_jit(jit_avx);
+      return ctx;
+   }
+
+   void give_back(std::unique_ptr<Context> ctx)
+   {
+      std::lock_guard<std::mutex> lock(mutex);
+      idle.push_back(std::move(ctx));
+   }
+
+public:
+
+   // returns the context to the pool when it goes out of scope
+   class Lease {
+      ContextPool *pool;
+      std::unique_ptr<Context> ctx;
+   public:
+      explicit Lease(ContextPool &pool) : pool(&pool), ctx(pool.take()) { }
+      Lease(Lease &&other) : pool(other.pool), ctx(std::move(other.ctx)) { }
+      ~Lease() { if (ctx) pool->give_back(std::move(ctx)); }
+
+      Context &operator*() const { return *ctx; }
+      Context *operator->() const { return ctx.get(); }
+      Context *get() const { return ctx.get(); }
+   };
+
+   ContextPool(const std::deque<Symbol> &expression, bool use_jit, bool jit_avx)
+      : expression(expression), use_jit(use_jit), jit_avx(jit_avx) { }
+
+   Lease acquire() { return Lease(*this); }
+
+   // whether the pool computes the same as expression at bitdepth on a few inputs: debug builds
+   // check with it that shared() only joins expressions with the same results
+   bool agrees_with(const std::deque<Symbol> &other, int bitdepth) const
+   {
+      Context mine(expression), theirs(other);
+      const double max_value = bitdepth == 32 ? 1.0 : double((1 << bitdepth) - 1);
+      static const double probes[][4] = {
+         { 0.0, 0.0, 0.0, 0.0 }, { 0.25, 0.5, 0.75, 1.0 }, { 0.5, 1.0, 0.0, 0.25 }, { 1.0, 0.75, 0.5, 0.0 }
+      };
+      for (const auto &p : probes) {
+         double a, b;
+         if (bitdepth == 32) {
+            a = mine.compute_float(p[0], p[1], p[2], p[3]);
+            b = theirs.compute_float(p[0], p[1], p[2], p[3]);
+         }
+         else {
+            a = mine.compute(int(p[0] * max_value), int(p[1] * max_value), int(p[2] * max_value), int(p[3] * max_value), bitdepth);
+            b = theirs.compute(int(p[0] * max_value), int(p[1] * max_value), int(p[2] * max_value), int(p[3] * max_value), bitdepth);
+         }
+         if (a != b && (a == a || b == b)) // both NaN agree
+            return false;
+      }
+      return true;
+   }
+
+   // pool of every filter instance whose expression compiles to the same program at bitdepth
+   static std::shared_ptr<ContextPool> shared(const std::deque<Symbol> &expression, int bitdepth, bool use_jit, bool jit_avx)
+   {
+      static std::mutex cache_mutex;
+      static std::map<String, std::weak_ptr<ContextPool>> cache;
+
+      std::unique_ptr<Context> ctx(new Context(expression));
+      if (use_jit)
+         ctx->enable_jit(jit_avx);
+      const String key = ctx->fingerprint(bitdepth) + (use_jit ? (jit_avx ? "jit avx" : "jit") : "");
+
+      std::lock_guard<std::mutex> lock(cache_mutex);
+      for (auto it = cache.begin(); it != cache.end(); ) {
+         if (it->second.expired())
+            it = cache.erase(it);
+         else
+            ++it;
+      }
+
+      auto &entry = cache[key];
+      if (auto pool = entry.lock()) {
+         assert(pool->agrees_with(expression, bitdepth));
+         return pool;
+      }
+
+      std::shared_ptr<ContextPool> pool(new ContextPool(expression, use_jit, jit_avx));
+      pool->idle.push_back(std::move(ctx)); // already compiled for the bit depth it runs at
+      entry = pool;
+      return pool;
+   }
+};
+
+} }
+
+#endif
@@ -0,0 +1,689 @@
+#include "jit.h"
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define MT_JIT_X64
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+#endif
+
+using namespace Filtering;
+using namespace Filtering::Parser;
+
+#ifdef MT_JIT_X64
+
+namespace {
+
+// general purpose registers
+enum { RAX, RCX, RDX, RBX, RSP, RBP, RSI, RDI, R8, R9, R10, R11, R12, R13, R14, R15 };
+
+#ifdef _WIN64
+const int ARG0 = RCX, ARG1 = RDX, ARG2 = R8;
+#else
+const int ARG0 = RDI, ARG1 = RSI, ARG2 = RDX;
+#endif
+
+// fixed register roles of the generated function
+const int REG_VARS = R12;    // const double *const *vars
+const int REG_DST = R13;     // double *dst
+const int REG_DATA = R14;    // constant pool
+const int REG_END = R15;     // count in bytes
+const int REG_OFFSET = RBX;  // current position in bytes
+
+// packed double opcodes, 66 0F xx
+enum {
+   OP_MOVUPD_LOAD = 0x10,
+   OP_MOVUPD_STORE = 0x11,
+   OP_MOVAPD = 0x28,
+   OP_AND = 0x54,
+   OP_ANDN = 0x55,
+   OP_OR = 0x56,
+   OP_XOR = 0x57,
+   OP_ADD = 0x58,
+   OP_MUL = 0x59,
+   OP_SUB = 0x5C,
+   OP_MIN = 0x5D,
+   OP_DIV = 0x5E,
+   OP_MAX = 0x5F,
+   OP_CMP = 0xC2,
+};
+
+// cmppd predicates
+enum { CMP_LT = 1, CMP_LE = 2 };
+
+// constants used by the native sequences, appended to the expression constants
+enum { CONST_ABSMASK, CONST_ONE, CONST_TWO, CONST_EPSILON, CONST_COUNT };
+
+// each constant is stored 4 times, one full ymm register
+const int CONST_STRIDE = 32;
+
+// stack frame: shadow space for calls, xmm6-xmm15 (callee saved on win64), then the memory homes of the stack slots
+const int FRAME_XMM_SAVE = 32;
+const int FRAME_HOMES = FRAME_XMM_SAVE + 10 * 16;
+// stay within one page, there is no stack probing
+const int FRAME_MAX = 4000;
+
+// bytes per pixel group
+const int GROUP_SIZE = Jit::LANES * sizeof(double);
+
+class Emitter {
+public:
+   std::vector<unsigned char> code;
+   bool avx;
+
+   explicit Emitter(bool avx) : avx(avx) { }
+
+   void byte(int b) { code.push_back((unsigned char)b); }
+   void dword(int v) { for (int i = 0; i < 4; i++) byte((v >> (i * 8)) & 0xFF); }
+   void qword(uint64_t v) { for (int i = 0; i < 8; i++) byte(int((v >> (i * 8)) & 0xFF)); }
+
+   // modrm + sib + disp32 for [base + index + disp], index < 0: none
+   void mem(int reg, int base, int index, int disp)
+   {
+      if (index < 0 && (base & 7) != RSP) {
+         byte(0x80 | ((reg & 7) << 3) | (base & 7));
+      }
+      else {
+         byte(0x80 | ((reg & 7) << 3) | 4);
+         byte(((index < 0 ? RSP : index) & 7) << 3 | (base & 7));
+      }
+      dword(disp);
+   }
+
+   int rex_bits(int reg, int index, int base) const
+   {
+      return ((reg & 8) ? 4 : 0) | ((index >= 0 && (index & 8)) ? 2 : 0) | ((base & 8) ? 1 : 0);
+   }
+
+   /* general purpose */
+   void push(int r) { if (r & 8) byte(0x41); byte(0x50 + (r & 7)); }
+   void pop(int r) { if (r & 8) byte(0x41); byte(0x58 + (r & 7)); }
+   void mov(int dst, int src) { byte(0x48 | rex_bits(src, -1, dst)); byte(0x89); byte(0xC0 | ((src & 7) << 3) | (dst & 7)); }
+   size_t mov_imm64(int dst, uint64_t imm) { byte(0x48 | rex_bits(0, -1, dst)); byte(0xB8 + (dst & 7)); size_t pos = code.size(); qword(imm); return pos; }
+   void load64(int dst, int base, int disp) { byte(0x48 | rex_bits(dst, -1, base)); byte(0x8B); mem(dst, base, -1, disp); }
+   void lea(int dst, int base, int disp) { byte(0x48 | rex_bits(dst, -1, base)); byte(0x8D); mem(dst, base, -1, disp); }
+   size_t add_imm(int r, int imm) { byte(0x48 | rex_bits(0, -1, r)); byte(0x81); byte(0xC0 | (r & 7)); size_t pos = code.size(); dword(imm); return pos; }
+   size_t sub_imm(int r, int imm) { byte(0x48 | rex_bits(0, -1, r)); byte(0x81); byte(0xE8 | (r & 7)); size_t pos = code.size(); dword(imm); return pos; }
+   void shl_imm(int r, int imm) { byte(0x48 | rex_bits(0, -1, r)); byte(0xC1); byte(0xE0 | (r & 7)); byte(imm); }
+   void cmp(int a, int b) { byte(0x48 | rex_bits(b, -1, a)); byte(0x39); byte(0xC0 | ((b & 7) << 3) | (a & 7)); }
+   void test(int r) { byte(0x48 | rex_bits(r, -1, r)); byte(0x85); byte(0xC0 | ((r & 7) << 3) | (r & 7)); }
+   void zero32(int r) { if (r & 8) byte(0x45); byte(0x31); byte(0xC0 | ((r & 7) << 3) | (r & 7)); }
+   void call(int r) { if (r & 8) byte(0x41); byte(0xFF); byte(0xD0 | (r & 7)); }
+   void ret() { byte(0xC3); }
+   // conditional jump with rel32 to be patched, cc: 2 = below, 4 = zero
+   size_t jcc(int cc) { byte(0x0F); byte(0x80 + cc); size_t pos = code.size(); dword(0); return pos; }
+   void patch_jump(size_t pos, size_t target) { patch32(pos, int(target - (pos + 4))); }
+   void patch32(size_t pos, int v) { for (int i = 0; i < 4; i++) code[pos + i] = (unsigned char)((v >> (i * 8)) & 0xFF); }
+   void patch64(size_t pos, uint64_t v) { for (int i = 0; i < 8; i++) code[pos + i] = (unsigned char)((v >> (i * 8)) & 0xFF); }
+
+   /* packed double, register forms */
+   void vex(int reg, int vvvv, int index, int base, int L)
+   {
+      // 3 byte VEX, map 0F, pp = 66, W0
+      byte(0xC4);
+      byte((rex_bits(reg, index, base) ^ 7) << 5 | 0x01);
+      byte(((~vvvv & 15) << 3) | (L << 2) | 0x01);
+   }
+
+   void sse_rr(int op, int dst, int src, int imm)
+   {
+      byte(0x66);
+      int rex = rex_bits(dst, -1, src);
+      if (rex) byte(0x40 | rex);
+      byte(0x0F); byte(op); byte(0xC0 | ((dst & 7) << 3) | (src & 7));
+      if (imm >= 0) byte(imm);
+   }
+
+   void sse_rm(int op, int reg, int base, int index, int disp)
+   {
+      byte(0x66);
+      int rex = rex_bits(reg, index, base);
+      if (rex) byte(0x40 | rex);
+      byte(0x0F); byte(op); mem(reg, base, index, disp);
+   }
+
+   // dst = src1 op src2. Without avx dst must not be src2, unless it is src1 too
+   void op3(int op, int dst, int src1, int src2, int imm = -1)
+   {
+      if (avx) {
+         vex(dst, src1, -1, src2, 1);
+         byte(op); byte(0xC0 | ((dst & 7) << 3) | (src2 & 7));
+         if (imm >= 0) byte(imm);
+      }
+      else {
+         if (dst != src1) {
+            assert(dst != src2);
+            sse_rr(OP_MOVAPD, dst, src1, -1);
+         }
+         sse_rr(op, dst, src2, imm);
+      }
+   }
+
+   void move(int dst, int src)
+   {
+      if (dst == src) return;
+      if (avx) op3(OP_MOVAPD, dst, 0, src);
+      else sse_rr(OP_MOVAPD, dst, src, -1);
+   }
+
+   void zero(int r) { op3(OP_XOR, r, r, r); }
+
+   void load(int dst, int base, int index, int disp)
+   {
+      if (avx) { vex(dst, 0, index, base, 1); byte(OP_MOVUPD_LOAD); mem(dst, base, index, disp); }
+      else sse_rm(OP_MOVUPD_LOAD, dst, base, index, disp);
+   }
+
+   void store(int base, int index, int disp, int src)
+   {
+      if (avx) { vex(src, 0, index, base, 1); byte(OP_MOVUPD_STORE); mem(src, base, index, disp); }
+      else sse_rm(OP_MOVUPD_STORE, src, base, index, disp);
+   }
+
+   // xmm part only, for the callee saved registers
+   void load128(int dst, int base, int disp)
+   {
+      if (avx) { vex(dst, 0, -1, base, 0); byte(OP_MOVUPD_LOAD); mem(dst, base, -1, disp); }
+      else sse_rm(OP_MOVUPD_LOAD, dst, base, -1, disp);
+   }
+
+   void store128(int base, int disp, int src)
+   {
+      if (avx) { vex(src, 0, -1, base, 0); byte(OP_MOVUPD_STORE); mem(src, base, -1, disp); }
+      else sse_rm(OP_MOVUPD_STORE, src, base, -1, disp);
+   }
+
+   void vzeroupper() { byte(0xC5); byte(0xF8); byte(0x77); }
+};
+
+// applies a non native operation lane by lane. block: the operands' memory homes, result goes to the first one
+static void call_symbol(const Instruction *ins, double *block)
+{
+   for (int i = 0; i < Jit::LANES; i++) {
+      switch (ins->opcode)
+      {
+      case Instruction::CALL0: block[i] = ins->process0(); break;
+      case Instruction::CALL1: block[i] = ins->process1(block[i]); break;
+      case Instruction::SCALE: block[i] = ins->processScale(block[i], ins->target_bitdepth, ins->source_bitdepth); break;
+      case Instruction::CALL2: block[i] = ins->process2(block[i], block[Jit::LANES + i]); break;
+      case Instruction::CALL3: block[i] = ins->process3(block[i], block[Jit::LANES + i], block[2 * Jit::LANES + i]); break;
+      default: assert(0);
+      }
+   }
+}
+
+// Maps the expression stack onto vector registers: stack slot s lives in registers
+// s*parts .. s*parts+parts-1 when s < resident, above that in its memory home.
+class Translator {
+   Emitter &e;
+   int width;    // bytes per vector register
+   int parts;    // registers per slot
+   int resident; // number of register resident slots
+   int nUserConstants;
+   int depth;
+   int max_depth;
+
+   // scratch registers
+   enum { T0 = 11, T1, T2, T3, T4 };
+
+   bool in_reg(int slot) const { return slot < resident; }
+   int reg(int slot, int p) const { return slot * parts + p; }
+   int home(int slot, int p) const { return FRAME_HOMES + slot * GROUP_SIZE + p * width; }
+
+   void grow(int n)
+   {
+      depth += n;
+      if (depth > max_depth) max_depth = depth;
+   }
+
+   // register holding the part, memory resident slots are loaded into tmp
+   int fetch(int slot, int p, int tmp)
+   {
+      if (in_reg(slot)) return reg(slot, p);
+      e.load(tmp, RSP, -1, home(slot, p));
+      return tmp;
+   }
+
+   void put(int slot, int p, int r)
+   {
+      if (in_reg(slot)) e.move(reg(slot, p), r);
+      else e.store(RSP, -1, home(slot, p), r);
+   }
+
+   void load_const(int dst, int index) { e.load(dst, REG_DATA, -1, index * CONST_STRIDE); }
+
+   // register file slot: variables from the input rows, then the constants
+   void load_operand(int regslot, int p, int dst)
+   {
+      if (regslot < 4) {
+         e.load64(RAX, REG_VARS, regslot * 8);
+         e.load(dst, RAX, REG_OFFSET, p * width);
+      }
+      else
+         load_const(dst, regslot - 4);
+   }
+
+   // comparison mask to 1 / -1
+   void to_bool(int dst, int mask, int scratch)
+   {
+      load_const(scratch, nUserConstants + CONST_TWO);
+      e.op3(OP_AND, dst, mask, scratch);
+      load_const(scratch, nUserConstants + CONST_ONE);
+      e.op3(OP_SUB, dst, dst, scratch);
+   }
+
+   // dst = a op b, dst is a, a and b may be clobbered
+   void binary(Instruction::Opcode opcode, int dst, int a, int b)
+   {
+      switch (opcode)
+      {
+      case Instruction::ADD: e.op3(OP_ADD, dst, a, b); break;
+      case Instruction::SUB: e.op3(OP_SUB, dst, a, b); break;
+      case Instruction::MUL: e.op3(OP_MUL, dst, a, b); break;
+      case Instruction::DIV: e.op3(OP_DIV, dst, a, b); break;
+      case Instruction::MIN: e.op3(OP_MIN, dst, a, b); break; // a < b ? a : b
+      case Instruction::MAX: e.op3(OP_MAX, dst, a, b); break; // a > b ? a : b
+      case Instruction::INFERIOR: e.op3(OP_CMP, T2, a, b, CMP_LE); to_bool(dst, T2, T3); break;
+      case Instruction::INFERIORSTRICT: e.op3(OP_CMP, T2, a, b, CMP_LT); to_bool(dst, T2, T3); break;
+      case Instruction::SUPERIOR: e.op3(OP_CMP, T2, b, a, CMP_LE); to_bool(dst, T2, T3); break;
+      case Instruction::SUPERIORSTRICT: e.op3(OP_CMP, T2, b, a, CMP_LT); to_bool(dst, T2, T3); break;
+      case Instruction::EQUAL:
+      case Instruction::NOTEQUAL:
+         e.op3(OP_SUB, T2, a, b);
+         load_const(T3, nUserConstants + CONST_ABSMASK);
+         e.op3(OP_AND, T2, T2, T3);
+         load_const(T3, nUserConstants + CONST_EPSILON);
+         if (opcode == Instruction::EQUAL) {
+            e.op3(OP_CMP, T2, T2, T3, CMP_LT); // |a-b| < eps
+            to_bool(dst, T2, T3);
+         }
+         else {
+            e.op3(OP_CMP, T3, T3, T2, CMP_LE); // eps <= |a-b|
+            to_bool(dst, T3, T2);
+         }
+         break;
+      case Instruction::AND:
+      case Instruction::OR:
+         e.zero(T4);
+         e.op3(OP_CMP, T2, T4, a, CMP_LT);
+         e.op3(OP_CMP, T3, T4, b, CMP_LT);
+         e.op3(opcode == Instruction::AND ? OP_AND : OP_OR, T2, T2, T3);
+         to_bool(dst, T2, T3);
+         break;
+      case Instruction::ANDNOT:
+         e.zero(T4);
+         e.op3(OP_CMP, T2, T4, a, CMP_LT); // a > 0
+         e.op3(OP_CMP, T3, b, T4, CMP_LE); // b <= 0
+         e.op3(OP_AND, T2, T2, T3);
+         to_bool(dst, T2, T3);
+         break;
+      case Instruction::XOR:
+         e.zero(T4);
+         e.op3(OP_CMP, T2, T4, a, CMP_LT); // a > 0
+         e.op3(OP_CMP, T3, b, T4, CMP_LE); // b <= 0
+         e.op3(OP_AND, T2, T2, T3);
+         e.op3(OP_CMP, a, a, T4, CMP_LE);  // a <= 0
+         e.op3(OP_CMP, T3, T4, b, CMP_LT); // b > 0
+         e.op3(OP_AND, a, a, T3);
+         e.op3(OP_OR, T2, T2, a);
+         to_bool(dst, T2, T3);
+         break;
+      default: assert(0);
+      }
+   }
+
+   // spills the register resident slots, calls the symbol function on the topmost n slots, reloads
+   void call(const Instruction *ins, int n)
+   {
+      for (int s = 0; s < depth && in_reg(s); s++)
+         for (int p = 0; p < parts; p++)
+            e.store(RSP, -1, home(s, p), reg(s, p));
+
+      const int base = depth - n;
+      if (e.avx)
+         e.vzeroupper();
+      e.mov_imm64(ARG0, (uint64_t)(uintptr_t)ins);
+      e.lea(ARG1, RSP, home(base, 0));
+      e.mov_imm64(RAX, (uint64_t)(uintptr_t)&call_symbol);
+      e.call(RAX);
+
+      depth = base;
+      grow(1);
+      for (int s = 0; s < depth && in_reg(s); s++)
+         for (int p = 0; p < parts; p++)
+            e.load(reg(s, p), RSP, -1, home(s, p));
+   }
+
+public:
+   Translator(Emitter &e, int nUserConstants) : e(e), nUserConstants(nUserConstants), depth(0), max_depth(0)
+   {
+      width = e.avx ? 32 : 16;
+      parts = GROUP_SIZE / width;
+      resident = T0 / parts;
+   }
+
+   int frame_homes_size() const { return (max_depth + 1) * GROUP_SIZE; }
+
+   // body of the pixel loop, false if the program is not translatable
+   bool translate(const Instruction *program, int nInstructions)
+   {
+      for (int i = 0; i < nInstructions; i++) {
+         const Instruction &ins = program[i];
+
+         switch (ins.opcode)
+         {
+         case Instruction::LOAD:
+            grow(1);
+            for (int p = 0; p < parts; p++) {
+               int dst = in_reg(depth - 1) ? reg(depth - 1, p) : T0;
+               load_operand(ins.slot, p, dst);
+               put(depth - 1, p, dst);
+            }
+            break;
+
+         case Instruction::DUP:
+            if (depth < 1) return false;
+            grow(1);
+            for (int p = 0; p < parts; p++)
+               put(depth - 1, p, fetch(depth - 2, p, T0));
+            break;
+
+         case Instruction::SWAP:
+            if (depth < 2) return false;
+            for (int p = 0; p < parts; p++) {
+               e.move(T0, fetch(depth - 1, p, T0));
+               e.move(T1, fetch(depth - 2, p, T1));
+               put(depth - 1, p, T1);
+               put(depth - 2, p, T0);
+            }
+            break;
+
+         case Instruction::ADD:
+         case Instruction::SUB:
+         case Instruction::MUL:
+         case Instruction::DIV:
+         case Instruction::MIN:
+         case Instruction::MAX:
+         case Instruction::EQUAL:
+         case Instruction::NOTEQUAL:
+         case Instruction::INFERIOR:
+         case Instruction::INFERIORSTRICT:
+         case Instruction::SUPERIOR:
+         case Instruction::SUPERIORSTRICT:
+         case Instruction::AND:
+         case Instruction::OR:
+         case Instruction::ANDNOT:
+         case Instruction::XOR:
+         {
+            const bool fused = ins.slot >= 0;
+            if (depth < (fused ? 1 : 2)) return false;
+            const int a = depth - (fused ? 1 : 2);
+            for (int p = 0; p < parts; p++) {
+               int ra = fetch(a, p, T0);
+               int rb = T1;
+               if (fused)
+                  load_operand(ins.slot, p, T1);
+               else
+                  rb = fetch(depth - 1, p, T1);
+               binary(ins.opcode, ra, ra, rb);
+               if (!in_reg(a))
+                  put(a, p, ra);
+            }
+            if (!fused)
+               depth--;
+            break;
+         }
+
+         case Instruction::ABS:
+            // fabs: clear the sign bit
+            if (depth < 1) return false;
+            for (int p = 0; p < parts; p++) {
+               int ra = fetch(depth - 1, p, T0);
+               load_const(T3, nUserConstants + CONST_ABSMASK);
+               e.op3(OP_AND, ra, ra, T3);
+               if (!in_reg(depth - 1))
+                  put(depth - 1, p, ra);
+            }
+            break;
+
+         case Instruction::TERNARY:
+            // c > 0 ? a : b
+            if (depth < 3) return false;
+            for (int p = 0; p < parts; p++) {
+               int rc = fetch(depth - 3, p, T0);
+               int ra = fetch(depth - 2, p, T1);
+               int rb = fetch(depth - 1, p, T2);
+               e.zero(T3);
+               e.op3(OP_CMP, T4, T3, rc, CMP_LT);
+               e.op3(OP_AND, ra, ra, T4);
+               e.op3(OP_ANDN, T3, T4, rb);
+               int dst = in_reg(depth - 3) ? reg(depth - 3, p) : T0;
+               e.op3(OP_OR, dst, ra, T3);
+               if (!in_reg(depth - 3))
+                  put(depth - 3, p, dst);
+            }
+            depth -= 2;
+            break;
+
+         case Instruction::CLIP:
+            // min(hi, max(lo, x))
+            if (depth < 3) return false;
+            for (int p = 0; p < parts; p++) {
+               int rx = fetch(depth - 3, p, T0);
+               int rlo = fetch(depth - 2, p, T1);
+               int rhi = fetch(depth - 1, p, T2);
+               e.op3(OP_MAX, rlo, rlo, rx);
+               e.op3(OP_MIN, rhi, rhi, rlo);
+               put(depth - 3, p, rhi);
+            }
+            depth -= 2;
+            break;
+
+         case Instruction::CALL0:
+            call(&ins, 0);
+            break;
+
+         case Instruction::CALL1:
+         case Instruction::SCALE:
+            if (depth < 1) return false;
+            call(&ins, 1);
+            break;
+
+         case Instruction::CALL2:
+            if (ins.slot >= 0) {
+               // operand folded into the instruction, push it like a LOAD
+               if (depth < 1) return false;
+               grow(1);
+               for (int p = 0; p < parts; p++) {
+                  int dst = in_reg(depth - 1) ? reg(depth - 1, p) : T0;
+                  load_operand(ins.slot, p, dst);
+                  put(depth - 1, p, dst);
+               }
+            }
+            if (depth < 2) return false;
+            call(&ins, 2);
+            break;
+
+         case Instruction::CALL3:
+            if (depth < 3) return false;
+            call(&ins, 3);
+            break;
+
+         default:
+            return false;
+         }
+      }
+
+      if (depth != 1)
+         return false;
+
+      for (int p = 0; p < parts; p++)
+         e.store(REG_DST, REG_OFFSET, p * width, fetch(0, p, T0));
+      return true;
+   }
+};
+
+static bool jit_disabled_by_environment()
+{
+   const char *value = getenv("MASKTOOLS_DISABLE_JIT");
+   return value != NULL && *value != '\0' && strcmp(value, "0") != 0;
+}
+
+static void *allocate_executable(size_t size)
+{
+#ifdef _WIN32
+   return VirtualAlloc(NULL, size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+#else
+   void *p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+   return p == MAP_FAILED ? NULL : p;
+#endif
+}
+
+static bool protect_executable(void *p, size_t size)
+{
+#ifdef _WIN32
+   DWORD old_protect;
+   if (!VirtualProtect(p, size, PAGE_EXECUTE_READ, &old_protect))
+      return false;
+   FlushInstructionCache(GetCurrentProcess(), p, size);
+   return true;
+#else
+   return mprotect(p, size, PROT_READ | PROT_EXEC) == 0;
+#endif
+}
+
+static void free_executable(void *p, size_t size)
+{
+#ifdef _WIN32
+   UNUSED(size);
+   VirtualFree(p, 0, MEM_RELEASE);
+#else
+   munmap(p, size);
+#endif
+}
+
+} // namespace
+
+bool Jit::available()
+{
+   static const bool disabled = jit_disabled_by_environment();
+   return !disabled;
+}
+
+Jit::Jit(const Instruction *_program, int nInstructions, const double *constants, int nConstants, bool avx) :
+   program(_program, _program + nInstructions), memory(NULL), memory_size(0), fn(NULL)
+{
+   if (!available())
+      return;
+
+   Emitter e(avx);
+
+   /* prologue */
+   const int saved[] = { RBX, RBP, R12, R13, R14, R15 };
+   for (int i = 0; i < 6; i++)
+      e.push(saved[i]);
+   // 6 pushes + return address: rsp is 16 byte aligned again after an odd multiple of 8
+   size_t frame_pos = e.sub_imm(RSP, 0);
+#ifdef _WIN64
+   for (int i = 0; i < 10; i++)
+      e.store128(RSP, FRAME_XMM_SAVE + i * 16, 6 + i);
+#endif
+   e.mov(REG_VARS, ARG0);
+   e.mov(REG_DST, ARG1);
+   e.mov(REG_END, ARG2);
+   e.shl_imm(REG_END, 3);
+   size_t data_pos = e.mov_imm64(REG_DATA, 0);
+   e.zero32(REG_OFFSET);
+   e.test(REG_END);
+   size_t skip_pos = e.jcc(4);
+
+   /* pixel loop */
+   size_t loop_start = e.code.size();
+   Translator translator(e, nConstants);
+   if (!translator.translate(program.data(), nInstructions))
+      return;
+   e.add_imm(REG_OFFSET, GROUP_SIZE);
+   e.cmp(REG_OFFSET, REG_END);
+   e.patch_jump(e.jcc(2), loop_start);
+
+   /* epilogue */
+   e.patch_jump(skip_pos, e.code.size());
+   if (avx)
+      e.vzeroupper();
+#ifdef _WIN64
+   for (int i = 0; i < 10; i++)
+      e.load128(6 + i, RSP, FRAME_XMM_SAVE + i * 16);
+#endif
+   int frame = FRAME_HOMES + translator.frame_homes_size();
+   if (frame > FRAME_MAX)
+      return;
+   frame = (frame + 15) / 16 * 16 + 8;
+   e.patch32(frame_pos, frame);
+   e.add_imm(RSP, frame);
+   for (int i = 5; i >= 0; i--)
+      e.pop(saved[i]);
+   e.ret();
+
+   /* constant pool after the code */
+   const size_t code_size = (e.code.size() + 63) & ~size_t(63);
+   const int nAllConstants = nConstants + CONST_COUNT;
+   memory_size = code_size + nAllConstants * CONST_STRIDE;
+   memory = allocate_executable(memory_size);
+   if (!memory)
+      return;
+
+   unsigned char *base = static_cast<unsigned char *>(memory);
+   e.patch64(data_pos, (uint64_t)(uintptr_t)(base + code_size));
+   memcpy(base, e.code.data(), e.code.size());
+
+   double *pool = reinterpret_cast<double *>(base + code_size);
+   const uint64_t bits[CONST_COUNT] = { 0x7FFFFFFFFFFFFFFFull, 0, 0, 0 };
+   for (int i = 0; i < nAllConstants; i++) {
+      double value;
+      if (i < nConstants)
+         value = constants[i];
+      else if (i - nConstants == CONST_ONE)
+         value = 1.0;
+      else if (i - nConstants == CONST_TWO)
+         value = 2.0;
+      else if (i - nConstants == CONST_EPSILON)
+         value = 0.000001; // same as the comparison operators
+      else
+         memcpy(&value, &bits[i - nConstants], sizeof(value));
+      for (int j = 0; j < CONST_STRIDE / (int)sizeof(double); j++)
+         pool[i * CONST_STRIDE / sizeof(double) + j] = value;
+   }
+
+   if (!protect_executable(memory, memory_size))
+      return;
+
+   fn = reinterpret_cast<Function>(memory);
+}
+
+Jit::~Jit()
+{
+   if (memory)
+      free_executable(memory, memory_size);
+}
+
+#else // MT_JIT_X64
+
+bool Jit::available()
+{
+   return false;
+}
+
+Jit::Jit(const Instruction *, int, const double *, int, bool) : memory(NULL), memory_size(0), fn(NULL)
+{
+}
+
+Jit::~Jit()
+{
+}
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef __Mt_Jit_H__
+#define __Mt_Jit_H__
+
+#include "symbol.h"
+#include <vector>
+#include <stdint.h>
+
+namespace Filtering { namespace Parser {
+
+// x86-64 native code for a compiled expression (Context program).
+// Evaluates 8 pixels per loop iteration in double precision (AVX: 2x4 lanes, SSE2: 4x2 lanes),
+// so the results are identical to the interpreter. Operators without a native sequence
+// (pow, trigonometry, bit arithmetic...) are called through their symbol function.
+class Jit {
+public:
+   // vars: x, y, z, a input rows, count: number of pixels, multiple of LANES
+   typedef void (*Function)(const double *const *vars, double *dst, intptr_t count);
+
+   static const int LANES = 8;
+
+   // false on 32 bit builds or when disabled with the MASKTOOLS_DISABLE_JIT environment variable
+   static bool available();
+
+   Jit(const Instruction *program, int nInstructions, const double *constants, int nConstants, bool avx);
+   ~Jit();
+
+   // NULL when the program could not be translated
+   Function function() const { return fn; }
+
+private:
+   std::vector<Instruction> program; // referenced by the generated code for function calls
+   void *memory;
+   size_t memory_size;
+   Function fn;
+
+   Jit(const Jit &);
+   Jit &operator=(const Jit &);
+};
+
+} } // namespace Parser, Filtering
+
+#endif
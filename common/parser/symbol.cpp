@@ -1,5 +1,9 @@
 #include "symbol.h"
+#include "jit.h"
 #include <math.h>
+#include <emmintrin.h>
+#include <string.h>
+#include <stdio.h>
 
 using namespace Filtering;
 using namespace Filtering::Parser;
@@ -259,7 +263,7 @@ void Symbol::setValue(double _dValue)
 }
 */
 
-// called from rec_compute_old, why
+// value of a number symbol, used by the coefficient and coordinate lists
 double Symbol::getValue(double x, double y, double z) const
 {
    switch ( type )
@@ -277,7 +281,25 @@ Context::Context(const std::deque<Symbol> &expression)
    nPos = -1;
    nSymbols = expression.size();
    pSymbols = new Symbol[nSymbols];
-   exprstack = new double[nSymbols];
+   exprstack = new double[nSymbols + 1];
+
+   // worst case: two instructions and two constants per symbol (lowered scaling)
+   program = new Instruction[2 * nSymbols];
+   nInstructions = 0;
+   registers = new double[4 + 2 * nSymbols];
+   nRegisters = 4;
+   for (int i = 0; i < 4; i++)
+     registers[i] = 0;
+   bitdepth = 0; // compiled on first use, when the bit depth is known
+
+   jit = NULL;
+   jit_enabled = false;
+   jit_avx = false;
+   batch = new double[5 * BATCH_SIZE];
+   for (int i = 0; i < 5 * BATCH_SIZE; i++)
+     batch[i] = 0;
+   batch_stack = new double[(nSymbols + 1) * BATCH_SIZE];
+   well_formed = false;
 
    nSymbols_control = expression.size();
    pSymbols_control = new Symbol[nSymbols];
@@ -314,7 +336,7 @@ Context::Context(const std::deque<Symbol> &expression)
    sbitdepth = default_sbitdepth;
    sbitdepth_f = default_sbitdepth; // copy to double type for direct variable use
 
-   // fill predefined constants for faster rec_compute access
+   // fill predefined constants, folded into the program when compiling
    for (int bits = 8; bits <= 16; bits++) {
      a_range_half[bits - 8] = 128 << (bits - 8); // or 0.0 for float chroma in the future?
      a_range_max[bits - 8] = (1 << bits) - 1; // max_pixel_value. 255, 1023, 4095, 16383, 65535 (1.0 for float)
@@ -342,86 +364,106 @@ Context::Context(const std::deque<Symbol> &expression)
 
 }
 
+Context::Context(const Context &other) : Context(other.expression())
+{
+   jit_enabled = other.jit_enabled;
+   jit_avx = other.jit_avx;
+}
+
+std::deque<Symbol> Context::expression() const
+{
+   // control mnemonics only set defaults, their place in the expression does not matter
+   std::deque<Symbol> result(pSymbols_control, pSymbols_control + nSymbols_control);
+   result.insert(result.end(), pSymbols, pSymbols + nSymbols);
+   return result;
+}
+
 Context::~Context()
 {
    delete[] pSymbols;
    delete[] exprstack;
    delete[] pSymbols_control;
+   delete[] program;
+   delete[] registers;
+   delete jit;
+   delete[] batch;
+   delete[] batch_stack;
 }
 
-double Context::rec_compute()
+double Context::variable_value(Symbol::VarType vartype, int bitdepth) const
 {
-  double last = 0;
+  switch (vartype) {
+  case Symbol::VARIABLE_BITDEPTH: return bitdepth; // bit-depth for autoscale
+  case Symbol::VARIABLE_SCRIPT_BITDEPTH: return sbitdepth_f; // source bit depth for autoscale
+
+  case Symbol::VARIABLE_RANGE_HALF: return bitdepth == 32 ? range_half_f : a_range_half[bitdepth - 8]; // or 0.0 for float in the future?
+  case Symbol::VARIABLE_RANGE_MAX: return bitdepth == 32 ? range_max_f : a_range_max[bitdepth - 8]; // max_pixel_value. 255, 1023, 4095, 16383, 65535 (1.0 for float)
+  case Symbol::VARIABLE_RANGE_SIZE: return bitdepth == 32 ? range_size_f : a_range_size[bitdepth - 8]; // 256, 1024, 4096, 16384, 65536 (1.0 for float)
+  case Symbol::VARIABLE_YMIN: return bitdepth == 32 ? ymin_f : a_ymin[bitdepth - 8]; // 16 scaled
+  case Symbol::VARIABLE_YMAX: return bitdepth == 32 ? ymax_f : a_ymax[bitdepth - 8]; // 235 scaled
+  case Symbol::VARIABLE_CMIN: return bitdepth == 32 ? cmin_f : a_cmin[bitdepth - 8]; // 16 scaled
+  case Symbol::VARIABLE_CMAX: return bitdepth == 32 ? cmax_f : a_cmax[bitdepth - 8]; // 240 scaled
+  default:
+    assert(0);
+    return 0;
+  }
+}
 
-  Symbol &s_first = pSymbols[0];
+int Context::add_constant(double value)
+{
+  registers[nRegisters] = value;
+  return nRegisters++;
+}
 
-  int p = 0;
+void Context::emit(Instruction::Opcode opcode, int slot)
+{
+  Instruction &ins = program[nInstructions++];
+  ins.opcode = opcode;
+  ins.slot = slot;
+  ins.target_bitdepth = 0;
+  ins.source_bitdepth = 0;
+  ins.process0 = NULL;
+}
 
-  switch (s_first.type)
-  {
-  case Symbol::NUMBER: { last = s_first.dValue; break; }
-  case Symbol::VARIABLE: {
-    switch (s_first.vartype) {
-    case Symbol::VARIABLE_X: { last = x; break; }
-    case Symbol::VARIABLE_Y: { last = y; break; }
-    case Symbol::VARIABLE_Z: { last = z; break; }
-    case Symbol::VARIABLE_A: { last = a; break; }
-    case Symbol::VARIABLE_BITDEPTH: { last = bitdepth; break; } // bit-depth for autoscale
-    case Symbol::VARIABLE_SCRIPT_BITDEPTH: { last = sbitdepth_f; break; } // source bit depth for autoscale
-
-    case Symbol::VARIABLE_RANGE_HALF: { last = bitdepth == 32 ? range_half_f : a_range_half[bitdepth - 8]; break; } // or 0.0 for float in the future?
-    case Symbol::VARIABLE_RANGE_MAX: { last = bitdepth == 32 ? range_max_f : a_range_max[bitdepth-8]; break; }// max_pixel_value. 255, 1023, 4095, 16383, 65535 (1.0 for float)
-    case Symbol::VARIABLE_RANGE_SIZE: { last = bitdepth == 32 ? range_size_f : a_range_size[bitdepth-8]; break; } // 256, 1024, 4096, 16384, 65536 (1.0 for float)
-    case Symbol::VARIABLE_YMIN: { last = bitdepth == 32 ? ymin_f : a_ymin[bitdepth - 8]; break;  }   // 16 scaled
-    case Symbol::VARIABLE_YMAX: { last = bitdepth == 32 ? ymax_f : a_ymax[bitdepth - 8]; break; } // 235 scaled
-    case Symbol::VARIABLE_CMIN: { last = bitdepth == 32 ? cmin_f : a_cmin[bitdepth - 8]; break;  } // 16 scaled
-    case Symbol::VARIABLE_CMAX: { last = bitdepth == 32 ? cmax_f : a_cmax[bitdepth - 8]; break;  } // 240 scaled
-    default: assert(0);
-    }
-    break;
-  }
-  default: return 0; // assert
-  }
+// Translates the symbols into a flat instruction list for the given bit depth.
+// Every bit depth dependent variable becomes a plain constant, and a binary operator
+// directly following a load takes its right operand from the register instead of the stack.
+void Context::compile(int _bitdepth)
+{
+  bitdepth = _bitdepth;
+  nInstructions = 0;
+  nRegisters = 4;
+
+  // same as the old interpreter: an expression not starting with an operand evaluates to 0
+  const bool valid = nSymbols > 0 && (pSymbols[0].type == Symbol::NUMBER || pSymbols[0].type == Symbol::VARIABLE);
 
-  for (int i = 1; i < nPos; i++) {
-    Symbol &s = pSymbols[i];
+  for (int i = 0; valid && i < nSymbols; i++) {
+    const Symbol &s = pSymbols[i];
 
     switch (s.type)
     {
-    case Symbol::NUMBER: { exprstack[p++] = last; last=s.dValue; break; }
-    case Symbol::VARIABLE: {
+    case Symbol::NUMBER: emit(Instruction::LOAD, add_constant(s.dValue)); break;
+    case Symbol::VARIABLE:
       switch (s.vartype) {
-      case Symbol::VARIABLE_X: { exprstack[p++] = last; last = x; break; }
-      case Symbol::VARIABLE_Y: { exprstack[p++] = last; last = y; break; }
-      case Symbol::VARIABLE_Z: { exprstack[p++] = last; last = z; break; }
-      case Symbol::VARIABLE_A: { exprstack[p++] = last; last = a; break; }
-      case Symbol::VARIABLE_BITDEPTH: { exprstack[p++] = last; last = bitdepth; break; } // bit-depth for autoscale
-      case Symbol::VARIABLE_SCRIPT_BITDEPTH: { exprstack[p++] = last; last = sbitdepth_f; break; } // source bit depth for autoscale
-
-      case Symbol::VARIABLE_RANGE_HALF: { exprstack[p++] = last; last = bitdepth == 32 ? range_half_f : a_range_half[bitdepth - 8]; break; } // or 0.0 for float in the future?
-      case Symbol::VARIABLE_RANGE_MAX: { exprstack[p++] = last; last = bitdepth == 32 ? range_max_f : a_range_max[bitdepth - 8]; break; }// max_pixel_value. 255, 1023, 4095, 16383, 65535 (1.0 for float)
-      case Symbol::VARIABLE_RANGE_SIZE: { exprstack[p++] = last; last = bitdepth == 32 ? range_size_f : a_range_size[bitdepth - 8]; break; } // 256, 1024, 4096, 16384, 65536 (1.0 for float)
-      case Symbol::VARIABLE_YMIN: { exprstack[p++] = last; last = bitdepth == 32 ? ymin_f : a_ymin[bitdepth - 8]; break;  }   // 16 scaled
-      case Symbol::VARIABLE_YMAX: { exprstack[p++] = last; last = bitdepth == 32 ? ymax_f : a_ymax[bitdepth - 8]; break; } // 235 scaled
-      case Symbol::VARIABLE_CMIN: { exprstack[p++] = last; last = bitdepth == 32 ? cmin_f : a_cmin[bitdepth - 8]; break;  } // 16 scaled
-      case Symbol::VARIABLE_CMAX: { exprstack[p++] = last; last = bitdepth == 32 ? cmax_f : a_cmax[bitdepth - 8]; break;  } // 240 scaled
-      default: assert(0);
+      case Symbol::VARIABLE_X: emit(Instruction::LOAD, 0); break;
+      case Symbol::VARIABLE_Y: emit(Instruction::LOAD, 1); break;
+      case Symbol::VARIABLE_Z: emit(Instruction::LOAD, 2); break;
+      case Symbol::VARIABLE_A: emit(Instruction::LOAD, 3); break;
+      default: emit(Instruction::LOAD, add_constant(variable_value(s.vartype, bitdepth))); break;
       }
       break;
-    }
-    case Symbol::DUP: { exprstack[p++] = last; break;  }
-
-    case Symbol::SWAP:
-    {
-      double p1 = exprstack[p-1];
-      exprstack[p-1] = last;
-      last = p1;
-      break;
-    }
+    case Symbol::DUP: emit(Instruction::DUP); break;
+    case Symbol::SWAP: emit(Instruction::SWAP); break;
 
     case Symbol::FUNCTION_WITH_BITDEPTH_AS_AUTOPARAM: // silent bit-depth parameter for autoscale
-      // only exists with one user parameter, plus two silent params
-      last = s.processScale(last, bitdepth, sbitdepth);
+      if (s.processScale == upscaleByShift || s.processScale == upscaleByStretch)
+        emit_scale(s.processScale == upscaleByStretch, bitdepth, sbitdepth);
+      else {
+        emit(Instruction::SCALE);
+        program[nInstructions - 1].target_bitdepth = bitdepth;
+        program[nInstructions - 1].source_bitdepth = sbitdepth;
+        program[nInstructions - 1].processScale = s.processScale;
+      }
       break;
 
     // OPERATOR, FUNCTION, TERNARY
@@ -430,154 +472,696 @@ double Context::rec_compute()
       {
       case 2:
       {
-        double xx = exprstack[--p];
-        last = s.process2(xx, last); // two-operand function/operator
+        Instruction::Opcode opcode = Instruction::CALL2;
+        if (s.process2 == addition) opcode = Instruction::ADD;
+        else if (s.process2 == substraction) opcode = Instruction::SUB;
+        else if (s.process2 == multiplication) opcode = Instruction::MUL;
+        else if (s.process2 == division) opcode = Instruction::DIV;
+        else if (s.process2 == mtmin) opcode = Instruction::MIN;
+        else if (s.process2 == mtmax) opcode = Instruction::MAX;
+        else if (s.process2 == equal) opcode = Instruction::EQUAL;
+        else if (s.process2 == notEqual) opcode = Instruction::NOTEQUAL;
+        else if (s.process2 == inferior) opcode = Instruction::INFERIOR;
+        else if (s.process2 == inferiorStrict) opcode = Instruction::INFERIORSTRICT;
+        else if (s.process2 == superior) opcode = Instruction::SUPERIOR;
+        else if (s.process2 == superiorStrict) opcode = Instruction::SUPERIORSTRICT;
+        else if (s.process2 == and) opcode = Instruction::AND;
+        else if (s.process2 == or) opcode = Instruction::OR;
+        else if (s.process2 == andNot) opcode = Instruction::ANDNOT;
+        else if (s.process2 == xor) opcode = Instruction::XOR;
+
+        // x 2 ^ -> x dup *, exact for integer pixel values
+        if (s.process2 == power && nInstructions > 0 && program[nInstructions - 1].opcode == Instruction::LOAD
+          && program[nInstructions - 1].slot >= 4 && registers[program[nInstructions - 1].slot] == 2.0) {
+          nInstructions--;
+          emit(Instruction::DUP);
+          emit(Instruction::MUL);
+          program[nInstructions - 1].process2 = multiplication;
+          break;
+        }
+
+        // fold a preceding load into the operand slot
+        int slot = -1;
+        if (nInstructions > 0 && program[nInstructions - 1].opcode == Instruction::LOAD) {
+          slot = program[nInstructions - 1].slot;
+          nInstructions--;
+        }
+        emit(opcode, slot);
+        program[nInstructions - 1].process2 = s.process2;
         break;
       }
-      case 1: {
-        last = s.process1(last); // one-operand function/operator
+      case 1:
+        if (s.process1 == mtmabs)
+          emit(Instruction::ABS);
+        else {
+          emit(Instruction::CALL1);
+          program[nInstructions - 1].process1 = s.process1;
+        }
         break;
-      }
       case 3:
-      {
-        double yy = exprstack[--p];  // three-operand
-        double xx = exprstack[--p];
-        last = s.process3(xx,yy,last);
+        if (s.process3 == interrogation)
+          emit(Instruction::TERNARY);
+        else if (s.process3 == mtclip)
+          emit(Instruction::CLIP);
+        else {
+          emit(Instruction::CALL3);
+          program[nInstructions - 1].process3 = s.process3;
+        }
         break;
-      }
       default: // function with zero parameters, none
-      {
-        exprstack[p++] = last;
-        last = s.process0(); 
-        break; 
-      }
+        emit(Instruction::CALL0);
+        program[nInstructions - 1].process0 = s.process0;
+        break;
       }
     }
   }
 
-  return last;
+  optimize();
+
+  // stack effect of the program, the batch evaluators rely on it
+  int depth = 0;
+  well_formed = nInstructions > 0;
+  for (int i = 0; i < nInstructions && well_formed; i++) {
+    int pops = 0, pushes = 1;
+    switch (program[i].opcode)
+    {
+    case Instruction::LOAD: case Instruction::CALL0: break;
+    case Instruction::DUP: pops = 1; pushes = 2; break;
+    case Instruction::SWAP: pops = 2; pushes = 2; break;
+    case Instruction::ABS: case Instruction::CALL1: case Instruction::SCALE: pops = 1; break;
+    case Instruction::TERNARY: case Instruction::CLIP: case Instruction::CALL3: pops = 3; break;
+    default: pops = program[i].slot < 0 ? 2 : 1; break; // binary operators
+    }
+    well_formed = depth >= pops;
+    depth += pushes - pops;
+  }
+  well_formed = well_formed && depth == 1;
+
+  delete jit;
+  jit = NULL;
+  if (jit_enabled) {
+    jit = new Jit(program, nInstructions, registers + 4, nRegisters - 4, jit_avx);
+    if (!jit->function()) {
+      // not translatable, the interpreter handles it
+      delete jit;
+      jit = NULL;
+    }
+  }
+}
+
+// upscaleByShift and upscaleByStretch with the bit depths known: same operations in the same order
+void Context::emit_scale(bool stretch, int target_bitdepth, int source_bitdepth)
+{
+  if (target_bitdepth == source_bitdepth)
+    return;
+  if (target_bitdepth == 32) {
+    emit(Instruction::DIV, add_constant((1 << source_bitdepth) - 1));
+    return;
+  }
+  if (source_bitdepth == 32) {
+    emit(Instruction::MUL, add_constant((1 << target_bitdepth) - 1));
+    return;
+  }
+  if (stretch) {
+    emit(Instruction::MUL, add_constant((1 << target_bitdepth) - 1));
+    emit(Instruction::DIV, add_constant((1 << source_bitdepth) - 1));
+  }
+  else if (target_bitdepth > source_bitdepth)
+    emit(Instruction::MUL, add_constant(1 << (target_bitdepth - source_bitdepth)));
+  else
+    emit(Instruction::DIV, add_constant(1 << (source_bitdepth - target_bitdepth)));
+}
+
+static bool is_constant_load(const Instruction &ins) { return ins.opcode == Instruction::LOAD && ins.slot >= 4; }
+
+// lowered scaling emits MUL and DIV without a function pointer
+static double apply_binary(const Instruction &ins, double x, double y)
+{
+  switch (ins.opcode) {
+  case Instruction::MUL: return multiplication(x, y);
+  case Instruction::DIV: return division(x, y);
+  default: return ins.process2(x, y);
+  }
+}
+
+static bool is_commutative(Instruction::Opcode opcode)
+{
+  switch (opcode) {
+  case Instruction::ADD: case Instruction::MUL: case Instruction::EQUAL: case Instruction::NOTEQUAL:
+  case Instruction::AND: case Instruction::OR: case Instruction::XOR:
+    return true;
+  default:
+    return false;
+  }
 }
 
-double Context::rec_compute_old()
+// x / c == x * (1 / c) for every x only when 1 / c is exact
+static bool is_power_of_two(double value)
 {
-  const Symbol &s = pSymbols[--nPos];
+  int exponent;
+  return value == value && value != 0 && fabs(value) != HUGE_VAL && frexp(fabs(value), &exponent) == 0.5 && exponent > -1000 && exponent < 1000;
+}
+
+// One rewrite at the end of the program, false if nothing matched. Every constant register is
+// referenced by a single instruction, so folded values are written back in place.
+bool Context::optimize_tail(int &n)
+{
+  Instruction *last = program + n - 1;
 
-  switch (s.type)
+  switch (last->opcode)
   {
-  case Symbol::NUMBER: return s.dValue;
-  case Symbol::VARIABLE:
-    switch (s.vartype) {
-    case Symbol::VARIABLE_X: return x;
-    case Symbol::VARIABLE_Y: return y;
-    case Symbol::VARIABLE_Z: return z;
-    case Symbol::VARIABLE_A: return a;
-    case Symbol::VARIABLE_BITDEPTH: return bitdepth; // bit-depth for autoscale
-    case Symbol::VARIABLE_SCRIPT_BITDEPTH: return sbitdepth_f; // source bit depth for autoscale
-
-    case Symbol::VARIABLE_RANGE_HALF: return bitdepth == 32 ? 0.5 : (128 << (bitdepth - 8)); // or 0.0 for float in the future?
-    case Symbol::VARIABLE_RANGE_MAX: return bitdepth == 32 ? 1.0 : ((1 << bitdepth) - 1); // max_pixel_value. 255, 1023, 4095, 16383, 65535 (1.0 for float)
-    case Symbol::VARIABLE_RANGE_SIZE: return bitdepth == 32 ? 1.0 : (1 << bitdepth); // 256, 1024, 4096, 16384, 65536 (1.0 for float)
-    case Symbol::VARIABLE_YMIN: return bitdepth == 32 ? 16.0 / 255 : (16 << (bitdepth - 8));    // 16 scaled
-    case Symbol::VARIABLE_YMAX: return bitdepth == 32 ? 235.0 / 255 : (235 << (bitdepth - 8));  // 235 scaled
-    case Symbol::VARIABLE_CMIN: return bitdepth == 32 ? 16.0 / 255 : (16 << (bitdepth - 8));    // 16 scaled
-    case Symbol::VARIABLE_CMAX: return bitdepth == 32 ? 240.0 / 255 : (240 << (bitdepth - 8));  // 240 scaled
-    default: 
-      assert(0);
-      return 0;
-    }
-    break;
-  case Symbol::FUNCTION_WITH_BITDEPTH_AS_AUTOPARAM: // silent bit-depth parameter for autoscale
-    switch (s.nParameter) // only exists with one user parameters
-    {
-    case 1: return s.process3(rec_compute_old(), bitdepth, sbitdepth); // automatic bit-depth parameters
-    default:
-      assert(0);
+  case Instruction::LOAD:
+  case Instruction::CALL0: // may not be pure
+    return false;
+
+  case Instruction::ABS:
+  case Instruction::CALL1:
+  case Instruction::SCALE:
+    if (n >= 2 && is_constant_load(last[-1])) {
+      double &value = registers[last[-1].slot];
+      if (last->opcode == Instruction::ABS) value = mtmabs(value);
+      else if (last->opcode == Instruction::CALL1) value = last->process1(value);
+      else value = last->processScale(value, last->target_bitdepth, last->source_bitdepth);
+      n--;
+      return true;
+    }
+    return false;
+
+  case Instruction::TERNARY:
+  case Instruction::CLIP:
+  case Instruction::CALL3:
+    if (n >= 4 && is_constant_load(last[-1]) && is_constant_load(last[-2]) && is_constant_load(last[-3])) {
+      double &value = registers[last[-3].slot];
+      const double y = registers[last[-2].slot], z = registers[last[-1].slot];
+      if (last->opcode == Instruction::TERNARY) value = interrogation(value, y, z);
+      else if (last->opcode == Instruction::CLIP) value = mtclip(value, y, z);
+      else value = last->process3(value, y, z);
+      n -= 3;
+      return true;
     }
+    return false;
 
-  default:
-    switch (s.nParameter)
+  case Instruction::DUP:
+    if (n >= 2 && is_constant_load(last[-1])) {
+      last->opcode = Instruction::LOAD;
+      last->slot = add_constant(registers[last[-1].slot]);
+      return true;
+    }
+    return false;
+
+  case Instruction::SWAP:
+    if (n >= 3 && is_constant_load(last[-1]) && is_constant_load(last[-2])) {
+      const int slot = last[-1].slot;
+      last[-1].slot = last[-2].slot;
+      last[-2].slot = slot;
+      n--;
+      return true;
+    }
+    if (n >= 2 && last[-1].opcode == Instruction::DUP) { // both values are the same
+      n--;
+      return true;
+    }
+    if (n >= 2 && last[-1].opcode == Instruction::SWAP) {
+      n -= 2;
+      return true;
+    }
+    return false;
+
+  default: // binary operators
+    if (last->slot >= 0) {
+      if (last->slot >= 4 && n >= 2 && is_constant_load(last[-1])) {
+        double &value = registers[last[-1].slot];
+        value = apply_binary(*last, value, registers[last->slot]);
+        n--;
+        return true;
+      }
+      if (last->opcode == Instruction::DIV && last->slot >= 4 && is_power_of_two(registers[last->slot])) {
+        registers[last->slot] = 1.0 / registers[last->slot];
+        last->opcode = Instruction::MUL;
+        last->process2 = multiplication;
+        return true;
+      }
+      return false;
+    }
+    if (n >= 3 && is_constant_load(last[-1]) && is_constant_load(last[-2])) {
+      double &value = registers[last[-2].slot];
+      value = apply_binary(*last, value, registers[last[-1].slot]);
+      n -= 2;
+      return true;
+    }
+    if (n >= 2 && last[-1].opcode == Instruction::LOAD) { // operand became a load after folding
+      const int slot = last[-1].slot;
+      last[-1] = *last;
+      last[-1].slot = slot;
+      n--;
+      return true;
+    }
+    if (n >= 2 && last[-1].opcode == Instruction::SWAP && is_commutative(last->opcode)) {
+      last[-1] = *last;
+      n--;
+      return true;
+    }
+    return false;
+  }
+}
+
+// Constant folding (literals and bit depth dependent constants are all constant loads by now),
+// strength reduction and removal of stack no-ops. Rewrites are local, so even malformed
+// expressions evaluate exactly as before.
+void Context::optimize()
+{
+  int n = 0;
+  for (int i = 0; i < nInstructions; i++) {
+    program[n++] = program[i];
+    while (optimize_tail(n)) {}
+  }
+  nInstructions = n;
+}
+
+// right operand from the register file or the stack, left operand is the stack top or the one below
+#define BINARY_OPERATION(expr) \
+  { \
+    double lhs, rhs; \
+    if (ins->slot < 0) { lhs = *--sp; rhs = last; } \
+    else { lhs = last; rhs = reg[ins->slot]; } \
+    last = (expr); \
+    break; \
+  }
+
+double Context::execute()
+{
+  const double *reg = registers;
+  double *sp = exprstack;
+  double last = 0;
+
+  const Instruction *end = program + nInstructions;
+  for (const Instruction *ins = program; ins < end; ins++) {
+    switch (ins->opcode)
     {
-    case 2:
+    case Instruction::LOAD: *sp++ = last; last = reg[ins->slot]; break;
+    case Instruction::DUP: *sp++ = last; break;
+    case Instruction::SWAP:
     {
-      double yy = rec_compute_old();
-      double xx = rec_compute_old();
-      return s.process2(xx, yy);
+      double p1 = sp[-1];
+      sp[-1] = last;
+      last = p1;
+      break;
     }
-    case 1: return s.process1(rec_compute_old());
-    case 3:
+    case Instruction::ADD: BINARY_OPERATION(addition(lhs, rhs))
+    case Instruction::SUB: BINARY_OPERATION(substraction(lhs, rhs))
+    case Instruction::MUL: BINARY_OPERATION(multiplication(lhs, rhs))
+    case Instruction::DIV: BINARY_OPERATION(division(lhs, rhs))
+    case Instruction::MIN: BINARY_OPERATION(mtmin(lhs, rhs))
+    case Instruction::MAX: BINARY_OPERATION(mtmax(lhs, rhs))
+    case Instruction::EQUAL: BINARY_OPERATION(equal(lhs, rhs))
+    case Instruction::NOTEQUAL: BINARY_OPERATION(notEqual(lhs, rhs))
+    case Instruction::INFERIOR: BINARY_OPERATION(inferior(lhs, rhs))
+    case Instruction::INFERIORSTRICT: BINARY_OPERATION(inferiorStrict(lhs, rhs))
+    case Instruction::SUPERIOR: BINARY_OPERATION(superior(lhs, rhs))
+    case Instruction::SUPERIORSTRICT: BINARY_OPERATION(superiorStrict(lhs, rhs))
+    case Instruction::AND: BINARY_OPERATION(and(lhs, rhs))
+    case Instruction::OR: BINARY_OPERATION(or(lhs, rhs))
+    case Instruction::ANDNOT: BINARY_OPERATION(andNot(lhs, rhs))
+    case Instruction::XOR: BINARY_OPERATION(xor(lhs, rhs))
+    case Instruction::CALL2: BINARY_OPERATION(ins->process2(lhs, rhs))
+    case Instruction::ABS: last = mtmabs(last); break;
+    case Instruction::CALL1: last = ins->process1(last); break;
+    case Instruction::SCALE: last = ins->processScale(last, ins->target_bitdepth, ins->source_bitdepth); break;
+    case Instruction::TERNARY:
     {
-      double zz = rec_compute_old();
-      double yy = rec_compute_old();
-      double xx = rec_compute_old();
-      return s.process3(xx, yy, zz);
+      double yy = *--sp;
+      double xx = *--sp;
+      last = interrogation(xx, yy, last);
+      break;
     }
-    default: return s.process0();
+    case Instruction::CLIP:
+    {
+      double yy = *--sp;
+      double xx = *--sp;
+      last = mtclip(xx, yy, last);
+      break;
+    }
+    case Instruction::CALL3:
+    {
+      double yy = *--sp;
+      double xx = *--sp;
+      last = ins->process3(xx, yy, last);
+      break;
+    }
+    case Instruction::CALL0: *sp++ = last; last = ins->process0(); break;
     }
   }
+
+  return last;
 }
 
+#undef BINARY_OPERATION
+
 double Context::compute(double _x, double _y, double _z, double _a, int _bitdepth)
 {
-   nPos = nSymbols;
-   this->x = _x;
-   this->y = _y;
-   this->z = _z;
-   this->a = _a;
+   if (_bitdepth != bitdepth)
+     compile(_bitdepth);
+   registers[0] = _x;
+   registers[1] = _y;
+   registers[2] = _z;
+   registers[3] = _a;
+
+   return execute();
+}
+
+double Context::compute_4(double _x, double _y, double _z, double _a, int _bitdepth)
+{
+  if (_bitdepth != bitdepth)
+    compile(_bitdepth);
+  registers[0] = _x;
+  registers[1] = _y;
+  registers[2] = _z;
+  registers[3] = _a;
+
+  return execute();
+}
 
-   this->bitdepth = _bitdepth;
-   // all other expr constants are calculated from bitdepth
+double Context::compute_3(double _x, double _y, double _z, int _bitdepth)
+{
+  if (_bitdepth != bitdepth)
+    compile(_bitdepth);
+  registers[0] = _x;
+  registers[1] = _y;
+  registers[2] = _z;
 
-   return rec_compute(); // check x86 rec_compute_old with x,y,z,a is faster
+  return execute();
 }
 
-double Context::compute_4(double _x, double _y, double _z, double _a, int _bitdepth)
+double Context::compute_2(double _x, double _y, int _bitdepth)
 {
-  nPos = nSymbols;
-  this->x = _x;
-  this->y = _y;
-  this->z = _z;
-  this->a = _a;
+  if (_bitdepth != bitdepth)
+    compile(_bitdepth);
+  registers[0] = _x;
+  registers[1] = _y;
 
-  this->bitdepth = _bitdepth;
-  // all other expr constants are calculated from bitdepth
-  
-  return rec_compute(); // on x86 rec_compute_old is MUCH faster
+  return execute();
 }
 
-double Context::compute_3(double _x, double _y, double _z, int _bitdepth)
+double Context::compute_1(double _x, int _bitdepth)
 {
-  nPos = nSymbols;
-  this->x = _x;
-  this->y = _y;
-  this->z = _z;
+  if (_bitdepth != bitdepth)
+    compile(_bitdepth);
+  registers[0] = _x;
 
-  this->bitdepth = _bitdepth;
-  // all other expr constants are calculated from bitdepth
+  return execute();
+}
 
-  return rec_compute();
+/* vector versions of the operators, same results as the scalar ones */
+static MT_FORCEINLINE __m128d v_bool(__m128d mask) { return _mm_sub_pd(_mm_and_pd(mask, _mm_set1_pd(2.0)), _mm_set1_pd(1.0)); } // 1 or -1
+static MT_FORCEINLINE __m128d v_abs(__m128d x) { return _mm_and_pd(x, _mm_castsi128_pd(_mm_set1_epi64x(0x7FFFFFFFFFFFFFFFLL))); }
+static MT_FORCEINLINE __m128d v_positive(__m128d x) { return _mm_cmplt_pd(_mm_setzero_pd(), x); }
+
+static MT_FORCEINLINE __m128d v_addition(__m128d x, __m128d y) { return _mm_add_pd(x, y); }
+static MT_FORCEINLINE __m128d v_substraction(__m128d x, __m128d y) { return _mm_sub_pd(x, y); }
+static MT_FORCEINLINE __m128d v_multiplication(__m128d x, __m128d y) { return _mm_mul_pd(x, y); }
+static MT_FORCEINLINE __m128d v_division(__m128d x, __m128d y) { return _mm_div_pd(x, y); }
+static MT_FORCEINLINE __m128d v_min(__m128d x, __m128d y) { return _mm_min_pd(x, y); } // x < y ? x : y
+static MT_FORCEINLINE __m128d v_max(__m128d x, __m128d y) { return _mm_max_pd(x, y); } // x > y ? x : y
+static MT_FORCEINLINE __m128d v_equal(__m128d x, __m128d y) { return v_bool(_mm_cmplt_pd(v_abs(_mm_sub_pd(x, y)), _mm_set1_pd(0.000001))); }
+static MT_FORCEINLINE __m128d v_notEqual(__m128d x, __m128d y) { return v_bool(_mm_cmple_pd(_mm_set1_pd(0.000001), v_abs(_mm_sub_pd(x, y)))); }
+static MT_FORCEINLINE __m128d v_inferior(__m128d x, __m128d y) { return v_bool(_mm_cmple_pd(x, y)); }
+static MT_FORCEINLINE __m128d v_inferiorStrict(__m128d x, __m128d y) { return v_bool(_mm_cmplt_pd(x, y)); }
+static MT_FORCEINLINE __m128d v_superior(__m128d x, __m128d y) { return v_bool(_mm_cmple_pd(y, x)); }
+static MT_FORCEINLINE __m128d v_superiorStrict(__m128d x, __m128d y) { return v_bool(_mm_cmplt_pd(y, x)); }
+static MT_FORCEINLINE __m128d v_and(__m128d x, __m128d y) { return v_bool(_mm_and_pd(v_positive(x), v_positive(y))); }
+static MT_FORCEINLINE __m128d v_or(__m128d x, __m128d y) { return v_bool(_mm_or_pd(v_positive(x), v_positive(y))); }
+static MT_FORCEINLINE __m128d v_andNot(__m128d x, __m128d y) { return v_bool(_mm_and_pd(v_positive(x), _mm_cmple_pd(y, _mm_setzero_pd()))); }
+static MT_FORCEINLINE __m128d v_xor(__m128d x, __m128d y)
+{
+  const __m128d zero = _mm_setzero_pd();
+  return v_bool(_mm_or_pd(_mm_and_pd(v_positive(x), _mm_cmple_pd(y, zero)), _mm_and_pd(_mm_cmple_pd(x, zero), v_positive(y))));
 }
 
-double Context::compute_2(double _x, double _y, int _bitdepth)
+// lhs = lhs op rhs over n values, rhs is a row or a single constant
+template<__m128d (*op)(__m128d, __m128d)>
+static void batch_binary(double *lhs, const double *rhs, bool constant, int n)
+{
+  if (constant) {
+    const __m128d r = _mm_set1_pd(*rhs);
+    for (int i = 0; i < n; i += 2)
+      _mm_storeu_pd(lhs + i, op(_mm_loadu_pd(lhs + i), r));
+  }
+  else {
+    for (int i = 0; i < n; i += 2)
+      _mm_storeu_pd(lhs + i, op(_mm_loadu_pd(lhs + i), _mm_loadu_pd(rhs + i)));
+  }
+}
+
+#define BATCH_BINARY(op) \
+  { \
+    if (ins->slot < 0) { sp -= BATCH_SIZE; batch_binary<op>(sp - BATCH_SIZE, sp, false, n); } \
+    else batch_binary<op>(sp - BATCH_SIZE, operand(ins->slot), ins->slot >= 4, n); \
+    break; \
+  }
+
+// Vectorized interpreter: every instruction runs over the whole batch, two values per SSE2 operation.
+// The stack holds one row per entry. Needs a well formed program, returns the result row.
+const double *Context::execute_batch(int count)
+{
+  const int n = (count + 1) & ~1; // inputs and stack rows have room for the padding
+  double *sp = batch_stack;
+
+  // variable rows or constants from the register file
+  auto operand = [this](int slot) -> const double * { return slot < 4 ? batch + slot * BATCH_SIZE : registers + slot; };
+
+  const Instruction *end = program + nInstructions;
+  for (const Instruction *ins = program; ins < end; ins++) {
+    switch (ins->opcode)
+    {
+    case Instruction::LOAD:
+      if (ins->slot < 4)
+        memcpy(sp, operand(ins->slot), n * sizeof(double));
+      else {
+        const __m128d c = _mm_set1_pd(registers[ins->slot]);
+        for (int i = 0; i < n; i += 2)
+          _mm_storeu_pd(sp + i, c);
+      }
+      sp += BATCH_SIZE;
+      break;
+    case Instruction::DUP:
+      memcpy(sp, sp - BATCH_SIZE, n * sizeof(double));
+      sp += BATCH_SIZE;
+      break;
+    case Instruction::SWAP:
+    {
+      double *p1 = sp - BATCH_SIZE, *p2 = sp - 2 * BATCH_SIZE;
+      for (int i = 0; i < n; i += 2) {
+        __m128d t = _mm_loadu_pd(p1 + i);
+        _mm_storeu_pd(p1 + i, _mm_loadu_pd(p2 + i));
+        _mm_storeu_pd(p2 + i, t);
+      }
+      break;
+    }
+    case Instruction::ADD: BATCH_BINARY(v_addition)
+    case Instruction::SUB: BATCH_BINARY(v_substraction)
+    case Instruction::MUL: BATCH_BINARY(v_multiplication)
+    case Instruction::DIV: BATCH_BINARY(v_division)
+    case Instruction::MIN: BATCH_BINARY(v_min)
+    case Instruction::MAX: BATCH_BINARY(v_max)
+    case Instruction::EQUAL: BATCH_BINARY(v_equal)
+    case Instruction::NOTEQUAL: BATCH_BINARY(v_notEqual)
+    case Instruction::INFERIOR: BATCH_BINARY(v_inferior)
+    case Instruction::INFERIORSTRICT: BATCH_BINARY(v_inferiorStrict)
+    case Instruction::SUPERIOR: BATCH_BINARY(v_superior)
+    case Instruction::SUPERIORSTRICT: BATCH_BINARY(v_superiorStrict)
+    case Instruction::AND: BATCH_BINARY(v_and)
+    case Instruction::OR: BATCH_BINARY(v_or)
+    case Instruction::ANDNOT: BATCH_BINARY(v_andNot)
+    case Instruction::XOR: BATCH_BINARY(v_xor)
+    case Instruction::ABS:
+    {
+      double *p = sp - BATCH_SIZE;
+      for (int i = 0; i < n; i += 2)
+        _mm_storeu_pd(p + i, v_abs(_mm_loadu_pd(p + i)));
+      break;
+    }
+    case Instruction::TERNARY:
+    {
+      // x > 0 ? y : z
+      sp -= 2 * BATCH_SIZE;
+      double *px = sp - BATCH_SIZE, *py = sp, *pz = sp + BATCH_SIZE;
+      for (int i = 0; i < n; i += 2) {
+        __m128d mask = v_positive(_mm_loadu_pd(px + i));
+        _mm_storeu_pd(px + i, _mm_or_pd(_mm_and_pd(mask, _mm_loadu_pd(py + i)), _mm_andnot_pd(mask, _mm_loadu_pd(pz + i))));
+      }
+      break;
+    }
+    case Instruction::CLIP:
+    {
+      // min(z, max(y, x))
+      sp -= 2 * BATCH_SIZE;
+      double *px = sp - BATCH_SIZE, *py = sp, *pz = sp + BATCH_SIZE;
+      for (int i = 0; i < n; i += 2)
+        _mm_storeu_pd(px + i, _mm_min_pd(_mm_loadu_pd(pz + i), _mm_max_pd(_mm_loadu_pd(py + i), _mm_loadu_pd(px + i))));
+      break;
+    }
+    case Instruction::CALL0:
+      for (int i = 0; i < n; i++)
+        sp[i] = ins->process0();
+      sp += BATCH_SIZE;
+      break;
+    case Instruction::CALL1:
+    {
+      double *p = sp - BATCH_SIZE;
+      for (int i = 0; i < n; i++)
+        p[i] = ins->process1(p[i]);
+      break;
+    }
+    case Instruction::SCALE:
+    {
+      double *p = sp - BATCH_SIZE;
+      for (int i = 0; i < n; i++)
+        p[i] = ins->processScale(p[i], ins->target_bitdepth, ins->source_bitdepth);
+      break;
+    }
+    case Instruction::CALL2:
+    {
+      double *p = sp - 2 * BATCH_SIZE;
+      const double *rhs = sp - BATCH_SIZE;
+      if (ins->slot < 0)
+        sp -= BATCH_SIZE;
+      else {
+        p = sp - BATCH_SIZE;
+        rhs = operand(ins->slot);
+      }
+      const int stride = ins->slot >= 4 ? 0 : 1; // constant operand
+      for (int i = 0; i < n; i++)
+        p[i] = ins->process2(p[i], rhs[i * stride]);
+      break;
+    }
+    case Instruction::CALL3:
+    {
+      sp -= 2 * BATCH_SIZE;
+      double *px = sp - BATCH_SIZE, *py = sp, *pz = sp + BATCH_SIZE;
+      for (int i = 0; i < n; i++)
+        px[i] = ins->process3(px[i], py[i], pz[i]);
+      break;
+    }
+    }
+  }
+
+  return batch_stack;
+}
+
+#undef BATCH_BINARY
+
+void Context::compute_batch(double *dst, const double *const *vars, int nInputs, int count, int _bitdepth)
 {
-  nPos = nSymbols;
-  this->x = _x;
-  this->y = _y;
+  if (bitdepth != _bitdepth)
+    compile(_bitdepth);
 
-  this->bitdepth = _bitdepth;
-  // all other expr constants are calculated from bitdepth
+  for (int x0 = 0; x0 < count; x0 += BATCH_SIZE) {
+    const int n = min(count - x0, BATCH_SIZE);
+    for (int v = 0; v < nInputs; v++)
+      memcpy(batch + v * BATCH_SIZE, vars[v] + x0, n * sizeof(double));
 
-  return rec_compute();
+    const double *result = evaluate_batch(nInputs, n);
+    memcpy(dst + x0, result, n * sizeof(double));
+  }
 }
 
-double Context::compute_1(double _x, int _bitdepth)
+void Context::enable_jit(bool avx)
+{
+  jit_enabled = Jit::available();
+  jit_avx = avx;
+  bitdepth = 0; // recompile on next use
+}
+
+const double *Context::evaluate_batch(int nInputs, int count)
+{
+  double *result = batch + 4 * BATCH_SIZE;
+
+  if (jit) {
+    const double *vars[4] = { batch, batch + BATCH_SIZE, batch + 2 * BATCH_SIZE, batch + 3 * BATCH_SIZE };
+    // lanes past count compute garbage into the unused part of the result row
+    jit->function()(vars, result, (count + Jit::LANES - 1) & ~(Jit::LANES - 1));
+    return result;
+  }
+
+  if (well_formed)
+    return execute_batch(count);
+
+  // scalar fallback, keeps the exact behavior of malformed expressions
+  for (int i = 0; i < count; i++) {
+    for (int v = 0; v < nInputs; v++)
+      registers[v] = batch[v * BATCH_SIZE + i];
+    result[i] = execute();
+  }
+  return result;
+}
+
+void Context::compute_row_byte(Byte *dst, const Byte *const *src, int nInputs, int width)
 {
-  nPos = nSymbols;
-  this->x = _x;
+  if (bitdepth != 8)
+    compile(8);
+
+  for (int x0 = 0; x0 < width; x0 += BATCH_SIZE) {
+    const int count = min(width - x0, BATCH_SIZE);
+    for (int v = 0; v < nInputs; v++)
+      for (int i = 0; i < count; i++)
+        batch[v * BATCH_SIZE + i] = src[v][x0 + i];
+
+    const double *result = evaluate_batch(nInputs, count);
+    for (int i = 0; i < count; i++)
+      dst[x0 + i] = clip<Byte, double>(result[i]);
+  }
+}
 
-  this->bitdepth = _bitdepth;
-  // all other expr constants are calculated from bitdepth
+void Context::compute_row_word(Word *dst, const Word *const *src, int nInputs, int width, int bits_per_pixel)
+{
+  if (bitdepth != bits_per_pixel)
+    compile(bits_per_pixel);
+
+  const Word max_pixel_value = Word((1 << bits_per_pixel) - 1);
+  for (int x0 = 0; x0 < width; x0 += BATCH_SIZE) {
+    const int count = min(width - x0, BATCH_SIZE);
+    for (int v = 0; v < nInputs; v++)
+      for (int i = 0; i < count; i++)
+        batch[v * BATCH_SIZE + i] = min(src[v][x0 + i], max_pixel_value);
+
+    const double *result = evaluate_batch(nInputs, count);
+    for (int i = 0; i < count; i++)
+      dst[x0 + i] = min(clip<Word, double>(result[i]), max_pixel_value);
+  }
+}
 
-  return rec_compute();
+// same as compute_float_x..compute_float_xyza
+void Context::compute_row_float(Float *dst, const Float *const *src, int nInputs, int width)
+{
+  const bool autoscale = float_autoscale_bitdepth != 0 && float_autoscale_bitdepth != 32;
+  const int eval_bitdepth = autoscale ? float_autoscale_bitdepth : 32;
+  const double input_scale = autoscale ? float_input_scalefactor : 1.0;
+
+  if (bitdepth != eval_bitdepth)
+    compile(eval_bitdepth);
+
+  for (int x0 = 0; x0 < width; x0 += BATCH_SIZE) {
+    const int count = min(width - x0, BATCH_SIZE);
+    for (int v = 0; v < nInputs; v++)
+      for (int i = 0; i < count; i++)
+        batch[v * BATCH_SIZE + i] = autoscale ? input_scale * src[v][x0 + i] : (double)src[v][x0 + i];
+
+    const double *result = evaluate_batch(nInputs, count);
+    if (float_autoscale_bitdepth == 0) {
+      for (int i = 0; i < count; i++)
+        dst[x0 + i] = (float)result[i];
+    }
+    else if (float_autoscale_bitdepth == 32) {
+      // no scaling needed, but clamping is still on
+      for (int i = 0; i < count; i++)
+        dst[x0 + i] = max(min((float)result[i], 1.0f), 0.0f);
+    }
+    else {
+      // scale down the result of the fake bitdepth
+      for (int i = 0; i < count; i++)
+        dst[x0 + i] = max(min((float)(float_input_invscalefactor * result[i]), 1.0f), 0.0f);
+    }
+  }
 }
 
 String Context::rec_infix()
@@ -657,4 +1241,149 @@ String Context::infix()
 bool Context::check()
 {
    return true;
+}
+
+int Context::variable_mask() const
+{
+   int mask = 0;
+   for ( int i = 0; i < nSymbols; i++ )
+   {
+      if ( pSymbols[i].type != Symbol::VARIABLE )
+         continue;
+      switch ( pSymbols[i].vartype )
+      {
+      case Symbol::VARIABLE_X: mask |= 1; break;
+      case Symbol::VARIABLE_Y: mask |= 2; break;
+      case Symbol::VARIABLE_Z: mask |= 4; break;
+      case Symbol::VARIABLE_A: mask |= 8; break;
+      default: break;
+      }
+   }
+   return mask;
+}
+
+static const char *opcode_name(Instruction::Opcode opcode)
+{
+   switch ( opcode )
+   {
+   case Instruction::DUP: return "dup";
+   case Instruction::SWAP: return "swap";
+   case Instruction::ADD: return "+";
+   case Instruction::SUB: return "-";
+   case Instruction::MUL: return "*";
+   case Instruction::DIV: return "/";
+   case Instruction::MIN: return "min";
+   case Instruction::MAX: return "max";
+   case Instruction::EQUAL: return "==";
+   case Instruction::NOTEQUAL: return "!=";
+   case Instruction::INFERIOR: return "<=";
+   case Instruction::INFERIORSTRICT: return "<";
+   case Instruction::SUPERIOR: return ">=";
+   case Instruction::SUPERIORSTRICT: return ">";
+   case Instruction::AND: return "&";
+   case Instruction::OR: return "|";
+   case Instruction::ANDNOT: return "&!";
+   case Instruction::ABS: return "abs";
+   case Instruction::TERNARY: return "?";
+   case Instruction::CLIP: return "clip";
+   default: return NULL; // LOAD is matched by its slot, calls and scales never match
+   }
+}
+
+static String next_token(const char *&p)
+{
+   while ( *p == ' ' )
+      p++;
+   const char *start = p;
+   while ( *p && *p != ' ' )
+      p++;
+   return String(start, p);
+}
+
+bool Context::matches(const char *pattern, double *constants, int _bitdepth)
+{
+   if ( bitdepth != _bitdepth )
+      compile(_bitdepth);
+
+   if ( !well_formed || (bitdepth == 32 && float_autoscale_bitdepth != 0) )
+      return false;
+
+   static const char *variables[4] = { "x", "y", "z", "a" };
+   int nConstants = 0;
+   const char *p = pattern;
+
+   for ( int i = 0; i < nInstructions; i++ )
+   {
+      const Instruction &ins = program[i];
+
+      // fused operands are plain loads in the pattern
+      if ( ins.slot >= 0 )
+      {
+         const String token = next_token(p);
+         if ( ins.slot < 4 ? token != variables[ins.slot] : token != "c" )
+            return false;
+         if ( ins.slot >= 4 )
+            constants[nConstants++] = registers[ins.slot];
+      }
+      if ( ins.opcode == Instruction::LOAD )
+         continue;
+
+      const char *name = opcode_name(ins.opcode);
+      if ( !name || next_token(p) != name )
+         return false;
+   }
+
+   return next_token(p).empty();
+}
+
+// functions are named by their offset from this one: unlike the address it is the same in
+// every process loading the binary, so fingerprints can key tables kept on disk
+static long long function_id(const void *function)
+{
+   return (long long)((intptr_t)function - (intptr_t)(const void *)&function_id);
+}
+
+String Context::fingerprint(int _bitdepth)
+{
+   // float clips with clamp_f_i8..clamp_f_i16 run the program of that bit depth, on scaled inputs
+   const int eval_bitdepth = _bitdepth == 32 && float_autoscale_bitdepth >= 8 && float_autoscale_bitdepth <= 16 ? float_autoscale_bitdepth : _bitdepth;
+   if ( bitdepth != eval_bitdepth )
+      compile(eval_bitdepth);
+
+   char buffer[64];
+   String result;
+
+   // float autoscaling happens around the program
+   snprintf(buffer, sizeof(buffer), "%d %d %d %.17g;", _bitdepth, bitdepth, float_autoscale_bitdepth, float_input_scalefactor);
+   result += buffer;
+
+   for ( int i = 0; i < nInstructions; i++ )
+   {
+      const Instruction &ins = program[i];
+
+      snprintf(buffer, sizeof(buffer), "%d", int(ins.opcode));
+      result += buffer;
+      if ( ins.slot >= 4 )
+         snprintf(buffer, sizeof(buffer), " c%.17g", registers[ins.slot]);
+      else if ( ins.slot >= 0 )
+         snprintf(buffer, sizeof(buffer), " v%d", ins.slot);
+      else
+         buffer[0] = 0;
+      result += buffer;
+
+      // the function itself for the generic calls
+      switch ( ins.opcode )
+      {
+      case Instruction::SCALE: snprintf(buffer, sizeof(buffer), " %d %d f%lld", ins.target_bitdepth, ins.source_bitdepth, function_id((const void *)ins.processScale)); break;
+      case Instruction::CALL0: snprintf(buffer, sizeof(buffer), " f%lld", function_id((const void *)ins.process0)); break;
+      case Instruction::CALL1: snprintf(buffer, sizeof(buffer), " f%lld", function_id((const void *)ins.process1)); break;
+      case Instruction::CALL2: snprintf(buffer, sizeof(buffer), " f%lld", function_id((const void *)ins.process2)); break;
+      case Instruction::CALL3: snprintf(buffer, sizeof(buffer), " f%lld", function_id((const void *)ins.process3)); break;
+      default: buffer[0] = 0; break;
+      }
+      result += buffer;
+      result += ';';
+   }
+
+   return result;
 }
\ No newline at end of file
@@ -184,6 +184,56 @@ public:
    static Symbol Dup;
 };
 
+// One step of a compiled expression.
+// Operands are resolved when compiling: slot indexes the register file (x, y, z, a
+// followed by the constant pool), a negative slot means the operand is on the stack.
+struct Instruction {
+   typedef enum {
+      LOAD,
+      DUP,
+      SWAP,
+      ADD,
+      SUB,
+      MUL,
+      DIV,
+      MIN,
+      MAX,
+      EQUAL,
+      NOTEQUAL,
+      INFERIOR,
+      INFERIORSTRICT,
+      SUPERIOR,
+      SUPERIORSTRICT,
+      AND,
+      OR,
+      ANDNOT,
+      XOR,
+      ABS,
+      TERNARY,
+      CLIP,
+      SCALE,
+      CALL0,
+      CALL1,
+      CALL2,
+      CALL3
+   } Opcode;
+
+   Opcode opcode;
+   int slot;
+   // SCALE only: target and source bit depth, fixed at compile time
+   int target_bitdepth;
+   int source_bitdepth;
+   union {
+      Symbol::Process0 process0;
+      Symbol::Process1 process1;
+      Symbol::Process2 process2;
+      Symbol::Process3 process3;
+      Symbol::ProcessScale processScale;
+   };
+};
+
+class Jit;
+
 class Context {
 
    Symbol *pSymbols;
@@ -193,8 +243,7 @@ class Context {
    Symbol *pSymbols_control;
    int nSymbols_control;
 
-   double x, y, z, a;
-   int bitdepth; // bit depth
+   int bitdepth; // bit depth the program was compiled for, 0: not compiled yet
 
    int sbitdepth; // source bit depth of values to scale
    double sbitdepth_f; // source bit depth of values to scale, avoid conversions
@@ -218,6 +267,26 @@ class Context {
 
    double *exprstack;
 
+   // compiled form of pSymbols, bit depth dependent constants already folded in
+   Instruction *program;
+   int nInstructions;
+   // register file: x, y, z, a, then the constants referenced by the program
+   double *registers;
+   int nRegisters;
+
+   // native code of the program, only when enabled with enable_jit
+   Jit *jit;
+   bool jit_enabled;
+   bool jit_avx;
+
+   // row evaluation: x, y, z, a inputs then the results, BATCH_SIZE values each
+   static const int BATCH_SIZE = 256;
+   double *batch;
+   // one BATCH_SIZE row per stack entry for the vectorized interpreter
+   double *batch_stack;
+   // program does not underflow the stack and leaves exactly one value: usable for batches
+   bool well_formed;
+
    // helpers for float input autoscales
    // 0: none
    // 8, 10, 12, 14, 16: scale input 0..1 float to this range
@@ -226,19 +295,54 @@ class Context {
    double float_input_scalefactor;
    double float_input_invscalefactor;
    
-   double rec_compute();
-   double rec_compute_old();
+   double variable_value(Symbol::VarType vartype, int bitdepth) const;
+   int add_constant(double value);
+   void emit(Instruction::Opcode opcode, int slot = -1);
+   void emit_scale(bool stretch, int target_bitdepth, int source_bitdepth);
+   bool optimize_tail(int &n);
+   void optimize();
+   void compile(int bitdepth);
+   double execute();
+   const double *execute_batch(int count);
+   const double *evaluate_batch(int nInputs, int count);
    String rec_infix();
+   std::deque<Symbol> expression() const;
 
 public:
    
    Context(const std::deque<Symbol> &expression);
+   // same expression and jit setting, own evaluation state: one per thread
+   Context(const Context &other);
 
    ~Context();
 
    bool check();
    String infix();
 
+   // input variables the expression references, bit 0: x, 1: y, 2: z, 3: a
+   int variable_mask() const;
+
+   // true when the program compiled for bitdepth is exactly pattern, an rpn string of
+   // x, y, z, a, c and operator names. c matches any constant, the values are stored
+   // in order in constants. Autoscaled float expressions never match.
+   bool matches(const char *pattern, double *constants, int bitdepth);
+
+   // canonical text of the program run for bitdepth: equal for expressions that compute
+   // the same thing the same way ("x 2 *" and "x 2.0 *", "range_max" and "255" at 8 bit).
+   // At 32 bit with clamp_f_i8..clamp_f_i16 it is the program of the autoscale bit depth
+   String fingerprint(int bitdepth);
+
+   // use native code for the row functions when the platform allows it
+   void enable_jit(bool avx);
+
+   // count values at once, vars holds nInputs rows for x, y, z, a
+   void compute_batch(double *dst, const double *const *vars, int nInputs, int count, int bitdepth);
+
+   // whole row at once, src holds nInputs rows for x, y, z, a. dst may be the same as src[0]
+   void compute_row_byte(Byte *dst, const Byte *const *src, int nInputs, int width);
+   void compute_row_word(Word *dst, const Word *const *src, int nInputs, int width, int bits_per_pixel);
+   void compute_row_float(Float *dst, const Float *const *src, int nInputs, int width);
+
    double compute_1(double x, int bitdepth);
    double compute_2(double x, double y, int bitdepth);
    double compute_3(double x, double y, double z, int bitdepth);
@@ -20,6 +20,7 @@
 #include "../filters/morphologic/deflate/deflate.h"
 #include "../filters/blur/mappedblur.h"
 #include "../filters/gradient/gradient.h"
+#include "../filters/chain/chain.h"
 //
 #include "../filters/support/adddiff/adddiff.h"
 #include "../filters/support/makediff/makediff.h"
@@ -67,6 +68,7 @@ extern "C" __declspec(dllexport) const char* __stdcall AvisynthPluginInit3(IScri
    //Avisynth2x::Filter<Mask::Motion::MotionMask>::create( env ); // 8-32
    //Avisynth2x::Filter<Mask::Edge::EdgeMask>::create( env ); // 8-32
    //Avisynth2x::Filter<Mask::Hysteresis::Hysteresis>::create( env ); // 8-32
+   Avisynth2x::Filter<Chain::Chain>::create( env ); // 8-16
    //MaskTools::Avs2x::Helpers::DeclareHelpers(env);
 
    return("MaskTools: a set of tools to work with masks");
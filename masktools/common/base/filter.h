@@ -8,6 +8,8 @@
 #include "../../../common/utils/utils.h"
 #include "../../common/params/params.h"
 #include "../../common/clip/inputconfig.h"
+#include "stripe_pool.h"
+#include "stripe_chain.h"
 
 namespace Filtering { namespace MaskTools { 
 
@@ -33,6 +35,13 @@ protected:
     int nXOffset, nYOffset, nXOffsetUV, nYOffsetUV;
     int nCoreWidth, nCoreHeight, nCoreWidthUV, nCoreHeightUV;
 
+    // rows above and below its own that a stripe of a plane needs (1 for 3x3 kernels), set by the
+    // filters that can process a plane in parts. -1: whole planes only (plane statistics, absolute
+    // positions, propagation)
+    int nStripeHalo;
+    int nThreads;
+    std::shared_ptr<StripePool> stripePool;
+
    virtual void process(int n, const Plane<Byte> &dst, int nPlane, const Frame<const Byte> frames[4], const Constraint constraints[4], PNeoEnv env) = 0;
 
    static Signature &add_defaults(Signature &signature)
@@ -54,6 +63,8 @@ protected:
       signature.add( Parameter( 1.0f, "A", true)); // put it at the end, don't change original parameter order
       signature.add(Parameter(Value(String("")), "alpha", false)); // same function as "chroma", for alpha plane
       signature.add(Parameter(String("i8"), "paramscale", false)); // like in expressions + none
+      signature.add( Parameter( true, "avx512", false));
+      signature.add( Parameter( 1, "threads", false)); // stripes per plane, 0: one per core
 
       return signature;
    }
@@ -153,8 +164,15 @@ public:
         nXOffset(parameters["offx"].toInt()),
         nYOffset(parameters["offy"].toInt()),
         nCoreWidth(parameters["w"].toInt()),
-        nCoreHeight((parameters["stacked"].is_defined() && parameters["stacked"].toBool() && parameters["h"].toInt()>=0) ? (2 * parameters["h"].toInt()) : parameters["h"].toInt())
+        nCoreHeight((parameters["stacked"].is_defined() && parameters["stacked"].toBool() && parameters["h"].toInt()>=0) ? (2 * parameters["h"].toInt()) : parameters["h"].toInt()),
+        nStripeHalo(-1),
+        nThreads(parameters["threads"].is_defined() ? parameters["threads"].toInt() : 1)
     {
+        if (nThreads <= 0)
+            nThreads = int(std::thread::hardware_concurrency());
+        if (nThreads > 1)
+            stripePool = StripePool::shared();
+
         for (auto &param: parameters) {
             if (param.getType() == TYPE_CLIP) {
                 childs.push_back(param.getValue().toClip());
@@ -311,6 +329,9 @@ public:
         }
         if (!parameters["avx"].toBool()) flags &= ~CPU_AVX;
         if (!parameters["avx2"].toBool()) flags &= ~CPU_AVX2;
+        if (!parameters["avx512"].toBool() || !(flags & CPU_AVX2)) {
+            flags &= ~(CPU_AVX512F | CPU_AVX512BW | CPU_AVX512VL | CPU_AVX512VBMI);
+        }
 
         print(LOG_DEBUG, "using cpu flags : 0x%x\n", flags);
 
@@ -332,6 +353,64 @@ public:
             error = "masktools: unsupported colorspace, use Y8, YV12, YV16, YV24, YV411, greyscale, YUV(A)xxxP10-16/S, Planar RGB(A)";
     }
 
+    // the plane as horizontal stripes on the shared pool. Stripes start on multiples of 4 rows so
+    // that the planes of every clip (the luma of a 4:2:0 mask for a chroma plane) cut at the same
+    // place. A stripe is processed with nStripeHalo more rows on each side, and then the kernels
+    // see the same pixels as on the whole plane. The output rows of the halo belong to the neighbour
+    // stripes: with a halo the stripe goes to a scratch plane and only its own rows are copied back.
+    void process_stripes(int n, const Plane<Byte> &dst, int nPlane, const Frame<const Byte> frames[4], const Constraint constraints[4], PNeoEnv env)
+    {
+        const int height = dst.height();
+        const int nStripes = min(nThreads, height / 32);
+        if (nStripes < 2) {
+            process(n, dst, nPlane, frames, constraints, env);
+            return;
+        }
+
+        const int ratio = height_ratios[nPlane][C]; // plane rows to frame rows
+        const int clipcount = int(input_configuration().size());
+
+        stripePool->run(nStripes, [&](int k) {
+            const int y0 = (height * k / nStripes) & ~3;
+            const int y1 = k + 1 == nStripes ? height : (height * (k + 1) / nStripes) & ~3;
+            const int top = max(0, y0 - nStripeHalo) & ~3;
+            const int bottom = min(height, (y1 + nStripeHalo + 3) & ~3);
+            const int rows = bottom - top;
+
+            Frame<const Byte> stripe_frames[4];
+            for (int i = 0; i < clipcount; i++) {
+                stripe_frames[i] = frames[i].offset(0, top * ratio, frames[i].width(0), rows * ratio);
+            }
+
+            std::unique_ptr<Byte, decltype(&_aligned_free)> scratch(nullptr, &_aligned_free);
+            Plane<Byte> stripe_dst = dst.offset(0, top, dst.width(), rows);
+            if (nStripeHalo > 0) {
+                scratch.reset(reinterpret_cast<Byte*>(_aligned_malloc(dst.pitch() * rows, 64)));
+                if (!scratch)
+                    env->ThrowError("masktools: out of memory for the stripes of a plane");
+                stripe_dst = Plane<Byte>(scratch.get(), dst.pitch(), dst.width(), rows, dst.pixelsize(), dst.origheight());
+            }
+
+            Constraint stripe_constraints[4];
+            for (int j = 0; j < 4; j++) {
+                stripe_constraints[j] = constraints[j];
+            }
+            stripe_constraints[nPlane] = Constraint(flags, stripe_dst);
+            for (int i = 0; i < clipcount; i++) {
+                if (nPlane < plane_counts[frames[i].colorspace()])
+                    stripe_constraints[nPlane] = Constraint(stripe_constraints[nPlane], stripe_frames[i].plane(nPlane));
+            }
+
+            process(n, stripe_dst, nPlane, stripe_frames, stripe_constraints, env);
+
+            if (scratch) {
+                Functions::copy_plane(dst.data() + y0 * dst.pitch(), dst.pitch(),
+                    scratch.get() + (y0 - top) * dst.pitch(), dst.pitch(),
+                    dst.width() * dst.pixelsize(), y1 - y0, env);
+            }
+        });
+    }
+
     void process_plane(int n, const Plane<Byte> &output_plane, int nPlane, const Constraint constraints[4], const Frame<const byte> frames[4], PNeoEnv env)
     {
         bool isCUDA = ::IsCUDA(env);
@@ -445,7 +524,10 @@ public:
             }
         break;
         case PROCESS:
-            process(n, output_plane, nPlane, frames, constraints, env);
+            if (stripePool && nStripeHalo >= 0 && !isCUDA && !isStacked && !(nStripeHalo > 0 && is_in_place()))
+                process_stripes(n, output_plane, nPlane, frames, constraints, env);
+            else
+                process(n, output_plane, nPlane, frames, constraints, env);
             break;
         case NONE:
         default: break;
@@ -0,0 +1,136 @@
+#ifndef __Mt_StripeChain_H__
+#define __Mt_StripeChain_H__
+
+#include "EnvCommon.h"
+#include "../../../common/functions/functions.h"
+#include "stripe_pool.h"
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace Filtering { namespace MaskTools {
+
+// A sequence of plane kernels run over a plane stripe by stripe, in two buffers of a few dozen
+// rows that stay in the L2 cache, instead of a full plane written and read back between each of
+// them (kmt_chain, iterations of the morphologic filters). A stripe is read with the rows of the
+// halos of all the steps, and a step computes the rows the later steps still need plus its own
+// halo. The first and last rows of its window are wrong unless they are the edges of the plane,
+// and they are the ones not needed anymore, so the output is the same as with whole planes.
+class StripeChain {
+
+public:
+
+   // nStep, then the window of the step: in place kernels get pSrc == pDst
+   typedef std::function<void(int nStep, Byte *pDst, ptrdiff_t nDstPitch, const Byte *pSrc, ptrdiff_t nSrcPitch, int nWidth, int nHeight)> Kernel;
+
+private:
+
+   // bytes of a stripe buffer: the two of them and the source rows of the stripe stay in the L2 cache
+   static const int BUFFER_SIZE = 256 * 1024;
+
+   struct Step {
+      int nHalo; // rows above and below an output row that the kernel reads
+      bool isInPlace;
+   };
+
+   std::vector<Step> steps;
+   int nHalo; // sum of the halos of the steps
+
+   // rows [y0, y1) of dst. The buffers hold the plane rows from y0 - nHalo on
+   void process_stripe(const Plane<Byte> &dst, const Plane<const Byte> &src, int y0, int y1, Byte *const buffers[2], ptrdiff_t nBufferPitch, const Kernel &kernel, PNeoEnv env) const
+   {
+      const int width = dst.width();
+      const int height = dst.height();
+      const int rowsize = width * dst.pixelsize();
+      const int top = max(0, y0 - nHalo);
+
+      int current = -1; // buffer with the output of the last step, -1: still the source plane
+      auto row = [&](int buffer, int y) -> const Byte* {
+         return buffer < 0 ? src.data() + y * src.pitch() : buffers[buffer] + (y - top) * nBufferPitch;
+      };
+
+      int halo = nHalo; // rows the current step and the next ones need
+      for (int i = 0; i < int(steps.size()); i++) {
+         const Step &step = steps[i];
+         const bool last = i + 1 == int(steps.size());
+         const int first = max(0, y0 - halo);
+         const int rows = min(height, y1 + halo) - first;
+         const ptrdiff_t nCurrentPitch = current < 0 ? src.pitch() : nBufferPitch;
+
+         if (step.isInPlace) {
+            if (last) {
+               Byte *pDst = dst.data() + y0 * dst.pitch();
+               Functions::copy_plane(pDst, dst.pitch(), row(current, y0), nCurrentPitch, rowsize, y1 - y0, env);
+               kernel(i, pDst, dst.pitch(), pDst, dst.pitch(), width, y1 - y0);
+            }
+            else {
+               if (current < 0) {
+                  Functions::copy_plane(buffers[0] + (first - top) * nBufferPitch, nBufferPitch, row(current, first), nCurrentPitch, rowsize, rows, env);
+                  current = 0;
+               }
+               Byte *pDst = buffers[current] + (first - top) * nBufferPitch;
+               kernel(i, pDst, nBufferPitch, pDst, nBufferPitch, width, rows);
+            }
+         }
+         else {
+            const int next = current == 0 ? 1 : 0;
+            kernel(i, buffers[next] + (first - top) * nBufferPitch, nBufferPitch, row(current, first), nCurrentPitch, width, rows);
+            current = next;
+            halo -= step.nHalo;
+
+            if (last) {
+               Functions::copy_plane(dst.data() + y0 * dst.pitch(), dst.pitch(), row(current, y0), nBufferPitch, rowsize, y1 - y0, env);
+            }
+         }
+      }
+   }
+
+public:
+
+   StripeChain() : nHalo(0) { }
+
+   void add(int nStepHalo, bool isInPlace)
+   {
+      Step step = { nStepHalo, isInPlace };
+      steps.push_back(step);
+      nHalo += nStepHalo;
+   }
+
+   bool empty() const { return steps.empty(); }
+   int halo() const { return nHalo; }
+
+   // dst and src are different planes of the same size. With a pool, runs of neighbour stripes
+   // are processed on nThreads threads, one pair of buffers each
+   void process(const Plane<Byte> &dst, const Plane<const Byte> &src, const Kernel &kernel, StripePool *pool, int nThreads, PNeoEnv env) const
+   {
+      const int height = dst.height();
+      const ptrdiff_t nBufferPitch = (ptrdiff_t(dst.width()) * dst.pixelsize() + 63) & ~63;
+
+      // stripes of about the same height, a buffer holds one with the halo rows
+      const int stripe_rows = max(int(BUFFER_SIZE / nBufferPitch) - 2 * nHalo, 16);
+      const int nStripes = max(1, (height + stripe_rows - 1) / stripe_rows);
+      const int buffer_rows = min(height, (height + nStripes - 1) / nStripes + 2 * nHalo);
+
+      const int nRuns = pool ? min(nThreads, nStripes) : 1;
+      auto run = [&](int k) {
+         std::unique_ptr<Byte, decltype(&_aligned_free)> memory(
+            reinterpret_cast<Byte*>(_aligned_malloc(nBufferPitch * buffer_rows * 2, 64)), &_aligned_free);
+         if (!memory)
+            env->ThrowError("masktools: out of memory for the stripe buffers");
+         Byte *const buffers[2] = { memory.get(), memory.get() + nBufferPitch * buffer_rows };
+
+         for (int i = nStripes * k / nRuns; i < nStripes * (k + 1) / nRuns; i++) {
+            process_stripe(dst, src, height * i / nStripes, height * (i + 1) / nStripes, buffers, nBufferPitch, kernel, env);
+         }
+      };
+
+      if (nRuns > 1)
+         pool->run(nRuns, run);
+      else
+         run(0);
+   }
+};
+
+} } // namespace MaskTools, Filtering
+
+#endif
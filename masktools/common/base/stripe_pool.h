@@ -0,0 +1,152 @@
+#ifndef __Mt_StripePool_H__
+#define __Mt_StripePool_H__
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Filtering { namespace MaskTools {
+
+// Worker threads for the stripes of a plane, shared by every filter instance with threads > 1.
+// A job is a number of stripes handed out through an atomic counter: the calling thread and
+// any idle worker take the next stripe until none is left, so a fast thread steals the stripes
+// a slow one hasn't started, and the caller finishes its own job even when all workers are busy
+// with the planes of other frames.
+class StripePool {
+
+   struct Job {
+      const std::function<void(int)> &task;
+      const int count;
+      std::atomic<int> next;
+      std::atomic<int> done;
+
+      std::mutex mutex;
+      std::condition_variable finished;
+      std::exception_ptr error;
+
+      Job(const std::function<void(int)> &task, int count) : task(task), count(count), next(0), done(0) { }
+
+      void work()
+      {
+         int i;
+         while ((i = next.fetch_add(1)) < count) {
+            try {
+               task(i);
+            }
+            catch (...) {
+               std::lock_guard<std::mutex> lock(mutex);
+               if (!error)
+                  error = std::current_exception();
+            }
+            if (done.fetch_add(1) + 1 == count) {
+               std::lock_guard<std::mutex> lock(mutex);
+               finished.notify_all();
+            }
+         }
+      }
+   };
+
+   std::mutex mutex;
+   std::condition_variable wake;
+   std::deque<std::shared_ptr<Job>> jobs;
+   std::vector<std::thread> workers;
+   bool stopping;
+
+   void worker()
+   {
+      for (;;) {
+         std::shared_ptr<Job> job;
+         {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this] { return stopping || !jobs.empty(); });
+            if (stopping)
+               return;
+            job = jobs.front();
+            if (job->next.load() >= job->count) {
+               jobs.pop_front(); // all stripes taken, the caller waits for the running ones
+               continue;
+            }
+         }
+         job->work();
+      }
+   }
+
+   StripePool(const StripePool &);
+   StripePool &operator=(const StripePool &);
+
+public:
+
+   explicit StripePool(int nWorkers) : stopping(false)
+   {
+      for (int i = 0; i < nWorkers; i++)
+         workers.emplace_back(&StripePool::worker, this);
+   }
+
+   ~StripePool()
+   {
+      {
+         std::lock_guard<std::mutex> lock(mutex);
+         stopping = true;
+      }
+      wake.notify_all();
+      for (auto &thread : workers)
+         thread.join();
+   }
+
+   // runs task(0) .. task(count - 1) and returns once all of them are done. The first exception
+   // thrown by a stripe is rethrown here, on the calling thread.
+   void run(int count, const std::function<void(int)> &task)
+   {
+      auto job = std::make_shared<Job>(task, count);
+      {
+         std::lock_guard<std::mutex> lock(mutex);
+         jobs.push_back(job);
+      }
+      wake.notify_all();
+
+      job->work();
+      {
+         std::unique_lock<std::mutex> lock(job->mutex);
+         job->finished.wait(lock, [&job] { return job->done.load() == job->count; });
+      }
+      {
+         std::lock_guard<std::mutex> lock(mutex);
+         for (auto it = jobs.begin(); it != jobs.end(); ++it) {
+            if (*it == job) {
+               jobs.erase(it);
+               break;
+            }
+         }
+      }
+
+      if (job->error)
+         std::rethrow_exception(job->error);
+   }
+
+   // one pool for the whole process, alive while a filter holds it: the workers are joined when the
+   // last filter goes away with its script, not at dll unload where joining a thread would deadlock
+   static std::shared_ptr<StripePool> shared()
+   {
+      static std::mutex cache_mutex;
+      static std::weak_ptr<StripePool> cache;
+
+      std::lock_guard<std::mutex> lock(cache_mutex);
+      if (auto pool = cache.lock())
+         return pool;
+
+      const int nCores = int(std::thread::hardware_concurrency());
+      std::shared_ptr<StripePool> pool(new StripePool(nCores > 1 ? nCores - 1 : 1));
+      cache = pool;
+      return pool;
+   }
+};
+
+} } // namespace MaskTools, Filtering
+
+#endif
@@ -183,6 +183,27 @@ static MT_FORCEINLINE void simd256_store_ps(T *ptr, __m256 value) {
 
 
 
+template<MemoryMode mem_mode, typename T>
+static MT_FORCEINLINE __m512i simd512_load_si512(const T* ptr) {
+  if (mem_mode == MemoryMode::SSE2_ALIGNED) {
+    return _mm512_load_si512(reinterpret_cast<const void*>(ptr));
+  }
+  else {
+    return _mm512_loadu_si512(reinterpret_cast<const void*>(ptr));
+  }
+}
+
+template<MemoryMode mem_mode, typename T>
+static MT_FORCEINLINE void simd512_store_si512(T *ptr, __m512i value) {
+  if (mem_mode == MemoryMode::SSE2_ALIGNED) {
+    _mm512_store_si512(reinterpret_cast<void*>(ptr), value);
+  }
+  else {
+    _mm512_storeu_si512(reinterpret_cast<void*>(ptr), value);
+  }
+}
+
+
 static MT_FORCEINLINE int simd_bit_scan_forward(int value) {
 #ifdef __INTEL_COMPILER
     return _bit_scan_forward(value);
@@ -249,6 +270,27 @@ static MT_FORCEINLINE __m256i load_one_to_right_si256(const Byte *ptr) {
   }
 }
 
+// masked loads don't fault on the byte before (after) the row that they skip
+template<Border border_mode, MemoryMode mem_mode>
+static MT_FORCEINLINE __m512i load_one_to_left_si512(const Byte *ptr) {
+  if (border_mode == Border::Left) {
+    return _mm512_mask_loadu_epi8(_mm512_set1_epi8(ptr[0]), 0xFFFFFFFFFFFFFFFEULL, ptr - 1); // clone leftmost
+  }
+  else {
+    return simd512_load_si512<MemoryMode::SSE2_UNALIGNED>(ptr - 1);
+  }
+}
+
+template<Border border_mode, MemoryMode mem_mode>
+static MT_FORCEINLINE __m512i load_one_to_right_si512(const Byte *ptr) {
+  if (border_mode == Border::Right) {
+    return _mm512_mask_loadu_epi8(_mm512_set1_epi8(ptr[63]), 0x7FFFFFFFFFFFFFFFULL, ptr + 1); // clone rightmost
+  }
+  else {
+    return simd512_load_si512<MemoryMode::SSE2_UNALIGNED>(ptr + 1);
+  }
+}
+
 template<Border border_mode, MemoryMode mem_mode>
 static MT_FORCEINLINE __m256i load16_one_to_left_si256(const Byte *ptr) {
   if (border_mode == Border::Left) {
@@ -418,6 +460,14 @@ static MT_FORCEINLINE __m256i threshold_avx2(const __m256i &value, const __m256i
   return _mm256_or_si256(result, high);
 }
 
+static MT_FORCEINLINE __m512i threshold_avx512(const __m512i &value, const __m512i &lowThresh, const __m512i &highThresh, const __m512i &v128) {
+  auto sat = _mm512_sub_epi8(value, v128);
+  auto low = _mm512_cmpgt_epi8_mask(sat, lowThresh);
+  auto high = _mm512_cmpgt_epi8_mask(sat, highThresh);
+  auto result = _mm512_maskz_mov_epi8(low, value);
+  return _mm512_mask_mov_epi8(result, high, _mm512_set1_epi8(-1));
+}
+
 //  thresholds are decreased by half range in order to do signed comparison
 template<int bits_per_pixel>
 static MT_FORCEINLINE __m128i threshold16_sse2(const __m128i &value, const __m128i &lowThresh, const __m128i &highThresh, const __m128i &vHalf, const __m128i &maxMask) {
@@ -442,6 +492,41 @@ static MT_FORCEINLINE __m256i threshold16_avx2(const __m256i &value, const __m25
   return _mm256_or_si256(result, high);
 }
 
+// 16 lookups in a 256 entry Byte table held as 16 registers of 16 entries. With 0x70 added
+// (saturated), index - 16 * k keeps bit 7 clear only within table[k]: pshufb zeroes the rest
+static MT_FORCEINLINE __m128i lut8_shuffle_ssse3(const __m128i table[16], __m128i index) {
+  const auto bias = _mm_set1_epi8(0x70);
+  const auto step = _mm_set1_epi8(16);
+  auto result = _mm_shuffle_epi8(table[0], _mm_adds_epu8(index, bias));
+  for (int k = 1; k < 16; k++) {
+    index = _mm_sub_epi8(index, step);
+    result = _mm_or_si128(result, _mm_shuffle_epi8(table[k], _mm_adds_epu8(index, bias)));
+  }
+  return result;
+}
+
+// same for 32 pixels, table[k] broadcast to both 128 bit lanes
+static MT_FORCEINLINE __m256i lut8_shuffle_avx2(const __m256i table[16], __m256i index) {
+  const auto bias = _mm256_set1_epi8(0x70);
+  const auto step = _mm256_set1_epi8(16);
+  auto result = _mm256_shuffle_epi8(table[0], _mm256_adds_epu8(index, bias));
+  for (int k = 1; k < 16; k++) {
+    index = _mm256_sub_epi8(index, step);
+    result = _mm256_or_si256(result, _mm256_shuffle_epi8(table[k], _mm256_adds_epu8(index, bias)));
+  }
+  return result;
+}
+
+// 16 lookups in a Word table, indexes as two times 8 dwords. The dwords are gathered from lut - 1 and
+// the entry is their high half: the last entry of the table is read without going past its end, but
+// the Word before the table must be readable (LutData::padding)
+static MT_FORCEINLINE __m256i lut16_gather_avx2(const Word *lut, const __m256i &index_lo, const __m256i &index_hi) {
+  const int *base = reinterpret_cast<const int *>(lut - 1);
+  auto lo = _mm256_srli_epi32(_mm256_i32gather_epi32(base, index_lo, 2), 16);
+  auto hi = _mm256_srli_epi32(_mm256_i32gather_epi32(base, index_hi, 2), 16);
+  return _mm256_permute4x64_epi64(_mm256_packus_epi32(lo, hi), 0xD8); // packus works per 128 bit lane
+}
+
 template<CpuFlags flags>
 static MT_FORCEINLINE __m128 threshold32_sse2(const __m128 &value, const __m128 &lowThresh, const __m128 &highThresh) {
   // create final mask 0.0 or 1.0 or x if between
@@ -111,6 +111,7 @@ public:
    Binarize(const Parameters &parameters, CpuFlags cpuFlags, PNeoEnv env)
       : MaskTools::Filter(parameters, FilterProcessingType::INPLACE, (CpuFlags)cpuFlags)
    {
+     nStripeHalo = 0;
      UNUSED(env);
      bool isStacked = parameters["stacked"].toBool();
      bits_per_pixel = bit_depths[C];
@@ -61,6 +61,7 @@ public:
    MappedBlur(const Parameters &parameters, CpuFlags cpuFlags, PNeoEnv env)
       : MaskTools::Filter( parameters, FilterProcessingType::CHILD, (CpuFlags)cpuFlags)
    {
+      nStripeHalo = 1; // 3x3
       UNUSED(env);
       bits_per_pixel = bit_depths[C];
       bool isFloat = bits_per_pixel == 32;
@@ -0,0 +1,276 @@
+#include "chain.h"
+#include "../morphologic/expand/expand.h"
+#include "../morphologic/inpand/inpand.h"
+#include "../morphologic/inflate/inflate.h"
+#include "../morphologic/deflate/deflate.h"
+#include "../lut/lut_data.h"
+
+namespace Filtering { namespace MaskTools { namespace Filters { namespace Chain {
+
+static String trim(const String &str)
+{
+   const size_t first = str.find_first_not_of(" \t\r\n");
+   if (first == String::npos)
+      return String();
+   return str.substr(first, str.find_last_not_of(" \t\r\n") - first + 1);
+}
+
+template<typename pixel_t>
+static void compose_table(std::vector<Byte> &table, const Parser::Context &expr, int bits_per_pixel)
+{
+   const int depth = 1 << bits_per_pixel;
+   const int inputs[1] = { 0 };
+   std::vector<pixel_t> next(depth);
+   fill_lut(next.data(), expr, bits_per_pixel, inputs, 1);
+
+   pixel_t *pTable = reinterpret_cast<pixel_t*>(table.data() + LutData::padding);
+   for (int x = 0; x < depth; x++) {
+      pTable[x] = next[pTable[x]];
+   }
+}
+
+// after LutData::padding bytes like the tables of kmt_lut: lut16_avx2_native reads the Word
+// before each entry it looks up
+template<typename pixel_t>
+static void identity_table(std::vector<Byte> &table, int bits_per_pixel)
+{
+   const int depth = 1 << bits_per_pixel;
+   table.resize(LutData::padding + depth * sizeof(pixel_t));
+   pixel_t *pTable = reinterpret_cast<pixel_t*>(table.data() + LutData::padding);
+   for (int x = 0; x < depth; x++) {
+      pTable[x] = pixel_t(x);
+   }
+}
+
+#define ADD_PROCESSORS(ns, name) \
+   step.processors.push_back(Filtering::Processor<Morphologic::Processor>(Morphologic::ns::name##_c, Constraint(CPU_NONE, 1, 1, 1, 1), 0)); \
+   step.processors.push_back(Filtering::Processor<Morphologic::Processor>(Morphologic::ns::name##_sse2, Constraint(CPU_SSE2, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 16), 1)); \
+   step.processors.push_back(Filtering::Processor<Morphologic::Processor>(Morphologic::ns::name##_asse2, Constraint(CPU_SSE2, MODULO_NONE, MODULO_NONE, ALIGNMENT_16, 16), 2)); \
+   step.processors16.push_back(Filtering::Processor<Morphologic::Processor16>(Morphologic::ns::name##_native_c, Constraint(CPU_NONE, 1, 1, 1, 1), 0)); \
+   step.processors16.push_back(Filtering::Processor<Morphologic::Processor16>(Morphologic::ns::name##_sse4_16, Constraint(CPU_SSE4_1, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 16), 1)); \
+   step.processors16.push_back(Filtering::Processor<Morphologic::Processor16>(Morphologic::ns::name##_asse4_16, Constraint(CPU_SSE4_1, MODULO_NONE, MODULO_NONE, ALIGNMENT_16, 16), 2))
+
+void Chain::add_morphologic(const String &name, const String &mode)
+{
+   Step step;
+   step.isLut = false;
+   step.nHalo = 1;
+
+   if (name == "inflate" || name == "deflate") {
+      if (!mode.empty()) {
+         error = name + " takes no argument in the chain";
+         return;
+      }
+      if (name == "inflate") {
+         ADD_PROCESSORS(Inflate, inflate);
+         step.processors.push_back(Filtering::Processor<Morphologic::Processor>(Morphologic::Inflate::inflate_avx512, Constraint(CPU_AVX512F | CPU_AVX512BW, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 65), 3));
+      }
+      else {
+         ADD_PROCESSORS(Deflate, deflate);
+         step.processors.push_back(Filtering::Processor<Morphologic::Processor>(Morphologic::Deflate::deflate_avx512, Constraint(CPU_AVX512F | CPU_AVX512BW, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 65), 3));
+      }
+   }
+   else if (mode.empty() || mode == "square") {
+      if (name == "expand") { ADD_PROCESSORS(Expand, expand_square); }
+      else { ADD_PROCESSORS(Inpand, inpand_square); }
+   }
+   else if (mode == "horizontal") {
+      step.nHalo = 0;
+      if (name == "expand") { ADD_PROCESSORS(Expand, expand_horizontal); }
+      else { ADD_PROCESSORS(Inpand, inpand_horizontal); }
+   }
+   else if (mode == "vertical") {
+      if (name == "expand") { ADD_PROCESSORS(Expand, expand_vertical); }
+      else { ADD_PROCESSORS(Inpand, inpand_vertical); }
+   }
+   else if (mode == "both") {
+      if (name == "expand") { ADD_PROCESSORS(Expand, expand_both); }
+      else { ADD_PROCESSORS(Inpand, inpand_both); }
+   }
+   else {
+      error = "invalid mode for " + name + " in the chain, use square, horizontal, vertical or both";
+      return;
+   }
+
+   stripes.add(step.nHalo, false);
+   steps.push_back(std::move(step));
+}
+
+#undef ADD_PROCESSORS
+
+// consecutive point operations are one table: the image is read and written once for all of them
+void Chain::add_pointwise(std::vector<String> &expressions)
+{
+   if (expressions.empty())
+      return;
+
+   Step step;
+   step.isLut = true;
+   step.nHalo = 0;
+
+   if (bits_per_pixel == 8)
+      identity_table<Byte>(step.table, bits_per_pixel);
+   else
+      identity_table<Word>(step.table, bits_per_pixel);
+
+   for (auto &expression : expressions) {
+      Parser::Parser parser = Parser::getDefaultParser().addSymbol(Parser::Symbol::X);
+      parser.parse(expression, " ");
+      Parser::Context ctx(parser.getExpression());
+      if (!ctx.check()) {
+         error = "invalid expression in the chain: " + expression;
+         return;
+      }
+      if (bits_per_pixel == 8)
+         compose_table<Byte>(step.table, ctx, bits_per_pixel);
+      else
+         compose_table<Word>(step.table, ctx, bits_per_pixel);
+   }
+   expressions.clear();
+
+   step.luts.push_back(Filtering::Processor<Lut::Single::Processor>(Lut::Single::lut_c, Constraint(CPU_NONE, 1, 1, 1, 1), 0));
+   step.luts.push_back(Filtering::Processor<Lut::Single::Processor>(Lut::Single::lut_ssse3, Constraint(CPU_SSSE3, 1, 1, 1, 1), 1));
+   step.luts.push_back(Filtering::Processor<Lut::Single::Processor>(Lut::Single::lut_avx2, Constraint(CPU_AVX2, 1, 1, 1, 1), 2));
+   step.luts.push_back(Filtering::Processor<Lut::Single::Processor>(Lut::Single::lut_avx512vbmi, Constraint(CPU_AVX512F | CPU_AVX512BW | CPU_AVX512VBMI, 1, 1, 1, 1), 3));
+   step.luts16.push_back(Filtering::Processor<Lut::Single::Processor16>(Lut::Single::lut16_c_native, Constraint(CPU_NONE, 1, 1, 1, 1), 0));
+   step.luts16.push_back(Filtering::Processor<Lut::Single::Processor16>(Lut::Single::lut16_avx2_native, Constraint(CPU_AVX2, 1, 1, 1, 1), 1));
+
+   stripes.add(0, true);
+   steps.push_back(std::move(step));
+}
+
+Chain::Chain(const Parameters &parameters, CpuFlags cpuFlags, PNeoEnv env)
+   : MaskTools::Filter(parameters, FilterProcessingType::CHILD, cpuFlags)
+{
+   UNUSED(env);
+   bits_per_pixel = bit_depths[C];
+
+   if (bits_per_pixel == 32) {
+      error = "only 8-16 bit clips are supported";
+      return;
+   }
+
+   // the limit of the standalone filters when thY and thC are not given
+   nMaxDeviation = (1 << bits_per_pixel) - 1;
+
+   const String scalemode = parameters["paramscale"].toString();
+   const bool fullscale = planes_isRGB[C];
+
+   std::vector<String> expressions; // point operations not added yet
+   const String ops = parameters["ops"].toString();
+   size_t begin = 0;
+   while (begin <= ops.size()) {
+      size_t end = ops.find(';', begin);
+      if (end == String::npos)
+         end = ops.size();
+      const String op = trim(ops.substr(begin, end - begin));
+      begin = end + 1;
+
+      if (op.empty())
+         continue;
+
+      const size_t colon = op.find(':');
+      const String name = trim(op.substr(0, colon));
+      const String args = colon == String::npos ? String() : trim(op.substr(colon + 1));
+
+      if (name == "lut") {
+         if (args.empty()) {
+            error = "lut needs an expression in the chain, like lut:x 2 *";
+            return;
+         }
+         expressions.push_back(args);
+      }
+      else if (name == "invert") {
+         expressions.push_back("range_max x -");
+      }
+      else if (name == "binarize") {
+         // binarize[:threshold] [lower|upper], as mt_binarize
+         float threshold_f = 128.0f;
+         bool upper = false;
+         size_t pos = 0;
+         while (pos < args.size()) {
+            size_t next = args.find(' ', pos);
+            if (next == String::npos)
+               next = args.size();
+            const String arg = args.substr(pos, next - pos);
+            pos = next + 1;
+            if (arg.empty())
+               continue;
+            if (arg == "upper")
+               upper = true;
+            else if (arg == "lower")
+               upper = false;
+            else {
+              try {
+                threshold_f = std::stof(arg);
+              }
+              catch (...) {
+                error = "invalid threshold for binarize in the chain";
+                return;
+              }
+            }
+         }
+         int threshold;
+         if (!ScaleParam(scalemode, threshold_f, bits_per_pixel, threshold_f, threshold, fullscale, false)) {
+            error = "invalid parameter: paramscale. Use i8, i10, i12, i14, i16, f32 for scale or none/empty to disable scaling";
+            return;
+         }
+         char expression[64];
+         snprintf(expression, sizeof(expression), upper ? "x %d > 0 range_max ?" : "x %d > range_max 0 ?", threshold);
+         expressions.push_back(expression);
+      }
+      else if (name == "expand" || name == "inpand" || name == "inflate" || name == "deflate") {
+         add_pointwise(expressions);
+         if (is_error())
+            return;
+         add_morphologic(name, args);
+      }
+      else {
+         error = "unknown operation in the chain: " + name + ", use expand, inpand, inflate, deflate, lut, binarize or invert";
+         return;
+      }
+      if (is_error())
+         return;
+   }
+
+   add_pointwise(expressions);
+   if (is_error())
+      return;
+
+   if (steps.empty())
+      error = "no operation in ops";
+}
+
+void Chain::process_step(const Step &step, Byte *pDst, ptrdiff_t nDstPitch, const Byte *pSrc, ptrdiff_t nSrcPitch, int nWidth, int nHeight) const
+{
+   const int pixelsize = bits_per_pixel == 8 ? 1 : 2;
+   const Constraint constraint(Constraint(flags, Plane<Byte>(pDst, nDstPitch, nWidth, nHeight, pixelsize, nHeight)),
+      Plane<const Byte>(pSrc, nSrcPitch, nWidth, nHeight, pixelsize, nHeight));
+
+   if (step.isLut) {
+      // in place, pSrc == pDst
+      if (bits_per_pixel == 8)
+         step.luts.best_processor(constraint)(pDst, nDstPitch, nWidth, nHeight, step.table.data() + LutData::padding);
+      else
+         step.luts16.best_processor(constraint)(pDst, nDstPitch, nWidth, nHeight,
+            reinterpret_cast<const Word*>(step.table.data() + LutData::padding), (1 << bits_per_pixel) - 1);
+   }
+   else if (bits_per_pixel == 8) {
+      step.processors.best_processor(constraint)(pDst, nDstPitch, pSrc, nSrcPitch, nMaxDeviation, nullptr, 0, nWidth, nHeight);
+   }
+   else {
+      step.processors16.best_processor(constraint)(reinterpret_cast<Word*>(pDst), nDstPitch / sizeof(Word),
+         reinterpret_cast<const Word*>(pSrc), nSrcPitch / sizeof(Word), nMaxDeviation, nullptr, 0, nWidth, nHeight, nHeight);
+   }
+}
+
+void Chain::process(int n, const Plane<Byte> &dst, int nPlane, const Frame<const Byte> frames[4], const Constraint constraints[4], PNeoEnv env)
+{
+   UNUSED(n); UNUSED(constraints);
+   stripes.process(dst, frames[0].plane(nPlane),
+      [this](int nStep, Byte *pDst, ptrdiff_t nDstPitch, const Byte *pSrc, ptrdiff_t nSrcPitch, int nWidth, int nHeight) {
+         process_step(steps[nStep], pDst, nDstPitch, pSrc, nSrcPitch, nWidth, nHeight);
+      }, stripePool.get(), nThreads, env);
+}
+
+} } } } // namespace Chain, Filters, MaskTools, Filtering
@@ -0,0 +1,62 @@
+#ifndef __Mt_Chain_H__
+#define __Mt_Chain_H__
+
+#include "../../common/base/filter.h"
+#include "../morphologic/morphologic.h"
+#include "../lut/lut/lut.h"
+
+namespace Filtering { namespace MaskTools { namespace Filters { namespace Chain {
+
+// an operation of the chain: a morphologic kernel from one stripe buffer to the other, or the
+// table of consecutive point operations (lut, binarize, invert) applied in place
+struct Step {
+   bool isLut;
+   int nHalo; // rows above and below an output row that the kernel reads
+
+   ProcessorList<Morphologic::Processor> processors;
+   ProcessorList<Morphologic::Processor16> processors16;
+
+   std::vector<Byte> table; // Byte entries for 8 bit, Word for 10-16 bit, after LutData::padding bytes
+   ProcessorList<Lut::Single::Processor> luts;
+   ProcessorList<Lut::Single::Processor16> luts16;
+};
+
+// kmt_chain: "expand; inpand; inflate; lut:x 2 *; binarize:128" in one filter, the plane goes
+// through all the operations as a stripe chain instead of a frame written between each of them
+class Chain : public MaskTools::Filter
+{
+   std::vector<Step> steps;
+   StripeChain stripes;
+   int nMaxDeviation;
+   int bits_per_pixel;
+
+   void add_morphologic(const String &name, const String &mode);
+   void add_pointwise(std::vector<String> &expressions);
+
+   void process_step(const Step &step, Byte *pDst, ptrdiff_t nDstPitch, const Byte *pSrc, ptrdiff_t nSrcPitch, int nWidth, int nHeight) const;
+
+protected:
+
+   virtual void process(int n, const Plane<Byte> &dst, int nPlane, const Frame<const Byte> frames[4], const Constraint constraints[4], PNeoEnv env) override;
+
+public:
+
+   Chain(const Parameters &parameters, CpuFlags cpuFlags, PNeoEnv env);
+
+   InputConfiguration &input_configuration() const { return OneFrame(); }
+
+   static Signature filter_signature()
+   {
+      Signature signature = "kmt_chain";
+
+      signature.add(Parameter(TYPE_CLIP, "", false));
+      signature.add(Parameter(String(""), "ops", false));
+
+      add_defaults(signature);
+      return signature;
+   }
+};
+
+} } } } // namespace Chain, Filters, MaskTools, Filtering
+
+#endif
@@ -1,4 +1,4 @@
-#include "convolution.h"
+#include "convolution_simd.h"
 
 using namespace Filtering;
 
@@ -135,25 +135,6 @@ public:
    }
 };
 
-template<class Type> bool isNull(Type val) { UNUSED(val); return false; }
-template<> bool isNull<double>(double val) { return val < 0.001f && val > -0.001f; }
-template<> bool isNull<float>(float val) { return val < 0.001f && val > -0.001f; }
-template<> bool isNull<int>(int val) { return val == 0; }
-
-template<class Type>
-Type compute_norm_t(const Type *horizontal, const Type *vertical, int nHorizontal, int nVertical)
-{
-   Type nSum = 0;
-   for ( int i = 0; i < nVertical; i++ )
-      for ( int j = 0; j < nHorizontal; j++ )
-         nSum += horizontal[j] * vertical[i];
-
-   if ( isNull<Type>(nSum) )
-      return 1;
-
-   return nSum;
-}
-
 
 template<class Type, class SaturateOp, class pixel_t, int bits_per_pixel>
 void convolution_t(pixel_t *pDst, ptrdiff_t nDstPitch, const pixel_t *pSrc, ptrdiff_t nSrcPitch, 
@@ -236,4 +217,48 @@ Processor32 *convolution_f_s_32_c = &::convolution_t<float, struct NOP<float>, f
 //Processor32 *convolution_i_m_32_c = &::convolution_t<int, struct MIRROR<int>, float, 32 >;
 Processor32 *convolution_f_m_32_c = &::convolution_t<float, struct MIRROR<float>, float, 32>;
 
-} } } }
\ No newline at end of file
+Processor *convolution_i_s_sse2 = &convolution_simd_t<ConvolutionSse<CPU_SSE2>, int, false, Byte, 8>;
+Processor *convolution_f_s_sse2 = &convolution_simd_t<ConvolutionSse<CPU_SSE2>, float, false, Byte, 8>;
+Processor *convolution_i_m_sse2 = &convolution_simd_t<ConvolutionSse<CPU_SSE2>, int, true, Byte, 8>;
+Processor *convolution_f_m_sse2 = &convolution_simd_t<ConvolutionSse<CPU_SSE2>, float, true, Byte, 8>;
+
+Processor16 *convolution_i_s_10_sse2 = &convolution_simd_t<ConvolutionSse<CPU_SSE2>, int, false, Word, 10>;
+Processor16 *convolution_f_s_10_sse2 = &convolution_simd_t<ConvolutionSse<CPU_SSE2>, float, false, Word, 10>;
+Processor16 *convolution_i_m_10_sse2 = &convolution_simd_t<ConvolutionSse<CPU_SSE2>, int, true, Word, 10>;
+Processor16 *convolution_f_m_10_sse2 = &convolution_simd_t<ConvolutionSse<CPU_SSE2>, float, true, Word, 10>;
+
+Processor16 *convolution_i_s_12_sse2 = &convolution_simd_t<ConvolutionSse<CPU_SSE2>, int, false, Word, 12>;
+Processor16 *convolution_f_s_12_sse2 = &convolution_simd_t<ConvolutionSse<CPU_SSE2>, float, false, Word, 12>;
+Processor16 *convolution_i_m_12_sse2 = &convolution_simd_t<ConvolutionSse<CPU_SSE2>, int, true, Word, 12>;
+Processor16 *convolution_f_m_12_sse2 = &convolution_simd_t<ConvolutionSse<CPU_SSE2>, float, true, Word, 12>;
+
+Processor16 *convolution_i_s_14_sse2 = &convolution_simd_t<ConvolutionSse<CPU_SSE2>, int, false, Word, 14>;
+Processor16 *convolution_f_s_14_sse2 = &convolution_simd_t<ConvolutionSse<CPU_SSE2>, float, false, Word, 14>;
+Processor16 *convolution_i_m_14_sse2 = &convolution_simd_t<ConvolutionSse<CPU_SSE2>, int, true, Word, 14>;
+Processor16 *convolution_f_m_14_sse2 = &convolution_simd_t<ConvolutionSse<CPU_SSE2>, float, true, Word, 14>;
+
+Processor16 *convolution_i_s_16_sse2 = &convolution_simd_t<ConvolutionSse<CPU_SSE2>, int, false, Word, 16>;
+Processor16 *convolution_f_s_16_sse2 = &convolution_simd_t<ConvolutionSse<CPU_SSE2>, float, false, Word, 16>;
+Processor16 *convolution_i_m_16_sse2 = &convolution_simd_t<ConvolutionSse<CPU_SSE2>, int, true, Word, 16>;
+Processor16 *convolution_f_m_16_sse2 = &convolution_simd_t<ConvolutionSse<CPU_SSE2>, float, true, Word, 16>;
+
+Processor32 *convolution_f_s_32_sse2 = &convolution_simd_t<ConvolutionSse<CPU_SSE2>, float, false, Float, 32>;
+Processor32 *convolution_f_m_32_sse2 = &convolution_simd_t<ConvolutionSse<CPU_SSE2>, float, true, Float, 32>;
+
+// sse4.1: the integer coefficients, for its 32 bit multiplication
+Processor *convolution_i_s_sse4 = &convolution_simd_t<ConvolutionSse<CPU_SSE4_1>, int, false, Byte, 8>;
+Processor *convolution_i_m_sse4 = &convolution_simd_t<ConvolutionSse<CPU_SSE4_1>, int, true, Byte, 8>;
+
+Processor16 *convolution_i_s_10_sse4 = &convolution_simd_t<ConvolutionSse<CPU_SSE4_1>, int, false, Word, 10>;
+Processor16 *convolution_i_m_10_sse4 = &convolution_simd_t<ConvolutionSse<CPU_SSE4_1>, int, true, Word, 10>;
+
+Processor16 *convolution_i_s_12_sse4 = &convolution_simd_t<ConvolutionSse<CPU_SSE4_1>, int, false, Word, 12>;
+Processor16 *convolution_i_m_12_sse4 = &convolution_simd_t<ConvolutionSse<CPU_SSE4_1>, int, true, Word, 12>;
+
+Processor16 *convolution_i_s_14_sse4 = &convolution_simd_t<ConvolutionSse<CPU_SSE4_1>, int, false, Word, 14>;
+Processor16 *convolution_i_m_14_sse4 = &convolution_simd_t<ConvolutionSse<CPU_SSE4_1>, int, true, Word, 14>;
+
+Processor16 *convolution_i_s_16_sse4 = &convolution_simd_t<ConvolutionSse<CPU_SSE4_1>, int, false, Word, 16>;
+Processor16 *convolution_i_m_16_sse4 = &convolution_simd_t<ConvolutionSse<CPU_SSE4_1>, int, true, Word, 16>;
+
+} } } }
@@ -38,6 +38,77 @@ extern Processor16 *convolution_i_m_16_c;
 extern Processor32 *convolution_f_s_32_c;
 extern Processor32 *convolution_f_m_32_c;
 
+extern Processor *convolution_f_s_sse2;
+extern Processor *convolution_i_s_sse2;
+extern Processor *convolution_f_m_sse2;
+extern Processor *convolution_i_m_sse2;
+
+extern Processor16 *convolution_f_s_10_sse2;
+extern Processor16 *convolution_i_s_10_sse2;
+extern Processor16 *convolution_f_m_10_sse2;
+extern Processor16 *convolution_i_m_10_sse2;
+
+extern Processor16 *convolution_f_s_12_sse2;
+extern Processor16 *convolution_i_s_12_sse2;
+extern Processor16 *convolution_f_m_12_sse2;
+extern Processor16 *convolution_i_m_12_sse2;
+
+extern Processor16 *convolution_f_s_14_sse2;
+extern Processor16 *convolution_i_s_14_sse2;
+extern Processor16 *convolution_f_m_14_sse2;
+extern Processor16 *convolution_i_m_14_sse2;
+
+extern Processor16 *convolution_f_s_16_sse2;
+extern Processor16 *convolution_i_s_16_sse2;
+extern Processor16 *convolution_f_m_16_sse2;
+extern Processor16 *convolution_i_m_16_sse2;
+
+extern Processor32 *convolution_f_s_32_sse2;
+extern Processor32 *convolution_f_m_32_sse2;
+
+extern Processor *convolution_i_s_sse4;
+extern Processor *convolution_i_m_sse4;
+
+extern Processor16 *convolution_i_s_10_sse4;
+extern Processor16 *convolution_i_m_10_sse4;
+
+extern Processor16 *convolution_i_s_12_sse4;
+extern Processor16 *convolution_i_m_12_sse4;
+
+extern Processor16 *convolution_i_s_14_sse4;
+extern Processor16 *convolution_i_m_14_sse4;
+
+extern Processor16 *convolution_i_s_16_sse4;
+extern Processor16 *convolution_i_m_16_sse4;
+
+extern Processor *convolution_f_s_avx2;
+extern Processor *convolution_i_s_avx2;
+extern Processor *convolution_f_m_avx2;
+extern Processor *convolution_i_m_avx2;
+
+extern Processor16 *convolution_f_s_10_avx2;
+extern Processor16 *convolution_i_s_10_avx2;
+extern Processor16 *convolution_f_m_10_avx2;
+extern Processor16 *convolution_i_m_10_avx2;
+
+extern Processor16 *convolution_f_s_12_avx2;
+extern Processor16 *convolution_i_s_12_avx2;
+extern Processor16 *convolution_f_m_12_avx2;
+extern Processor16 *convolution_i_m_12_avx2;
+
+extern Processor16 *convolution_f_s_14_avx2;
+extern Processor16 *convolution_i_s_14_avx2;
+extern Processor16 *convolution_f_m_14_avx2;
+extern Processor16 *convolution_i_m_14_avx2;
+
+extern Processor16 *convolution_f_s_16_avx2;
+extern Processor16 *convolution_i_s_16_avx2;
+extern Processor16 *convolution_f_m_16_avx2;
+extern Processor16 *convolution_i_m_16_avx2;
+
+extern Processor32 *convolution_f_s_32_avx2;
+extern Processor32 *convolution_f_m_32_avx2;
+
 class Convolution : public MaskTools::Filter
 {
    int *i_horizontal, *i_vertical;
@@ -77,6 +148,16 @@ protected:
         horizontal, vertical, total, nHorizontal, nVertical, dst.width(), dst.height());
     }
   }
+
+  template<class T>
+  static void add_processors(ProcessorList<T> &list, T *c, T *sse2, T *avx2, T *sse4 = nullptr)
+  {
+    list.push_back(Filtering::Processor<T>(c, Constraint(CPU_NONE, 1, 1, 1, 1), 0));
+    list.push_back(Filtering::Processor<T>(sse2, Constraint(CPU_SSE2, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 1), 1));
+    if (sse4)
+      list.push_back(Filtering::Processor<T>(sse4, Constraint(CPU_SSE4_1, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 1), 2));
+    list.push_back(Filtering::Processor<T>(avx2, Constraint(CPU_AVX2, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 1), 3));
+  }
 public:
    Convolution(const Parameters &parameters, CpuFlags cpuFlags, PNeoEnv env)
       : MaskTools::Filter( parameters, FilterProcessingType::CHILD, (CpuFlags)cpuFlags)
@@ -91,6 +172,7 @@ public:
       auto vcoeffs = Parser::getDefaultParser().parse(parameters["vertical"].toString(), " ").getExpression();
       nHorizontal = hcoeffs.size();
       nVertical = vcoeffs.size();
+      nStripeHalo = nVertical / 2;
       
       /* search for float values */
       bool isFloat = false;
@@ -140,43 +222,43 @@ public:
          vcoeffs.pop_front();
       }
 
-      /* adds the processor */
+      /* adds the processors: c, sse2, avx2, and sse4.1 for the integer coefficients */
       bool isSaturate = parameters["saturate"].toBool();
       if ( isFloat )
          if ( isSaturate )
            switch (bits_per_pixel) {
-           case 8: processors.push_back(Filtering::Processor<Processor>(convolution_f_s_c, Constraint(CPU_NONE, 1, 1, 1, 1), 0)); break;
-           case 10: processors16.push_back(Filtering::Processor<Processor16>(convolution_f_s_10_c, Constraint(CPU_NONE, 1, 1, 1, 1), 0)); break;
-           case 12: processors16.push_back(Filtering::Processor<Processor16>(convolution_f_s_12_c, Constraint(CPU_NONE, 1, 1, 1, 1), 0)); break;
-           case 14: processors16.push_back(Filtering::Processor<Processor16>(convolution_f_s_14_c, Constraint(CPU_NONE, 1, 1, 1, 1), 0)); break;
-           case 16: processors16.push_back(Filtering::Processor<Processor16>(convolution_f_s_16_c, Constraint(CPU_NONE, 1, 1, 1, 1), 0)); break;
-           case 32: processors32.push_back(Filtering::Processor<Processor32>(convolution_f_s_32_c, Constraint(CPU_NONE, 1, 1, 1, 1), 0)); break;
+           case 8: add_processors(processors, convolution_f_s_c, convolution_f_s_sse2, convolution_f_s_avx2); break;
+           case 10: add_processors(processors16, convolution_f_s_10_c, convolution_f_s_10_sse2, convolution_f_s_10_avx2); break;
+           case 12: add_processors(processors16, convolution_f_s_12_c, convolution_f_s_12_sse2, convolution_f_s_12_avx2); break;
+           case 14: add_processors(processors16, convolution_f_s_14_c, convolution_f_s_14_sse2, convolution_f_s_14_avx2); break;
+           case 16: add_processors(processors16, convolution_f_s_16_c, convolution_f_s_16_sse2, convolution_f_s_16_avx2); break;
+           case 32: add_processors(processors32, convolution_f_s_32_c, convolution_f_s_32_sse2, convolution_f_s_32_avx2); break;
            }
          else
            switch (bits_per_pixel) {
-           case 8:  processors.push_back(Filtering::Processor<Processor>(convolution_f_m_c, Constraint(CPU_NONE, 1, 1, 1, 1), 0)); break;
-           case 10:  processors16.push_back(Filtering::Processor<Processor16>(convolution_f_m_10_c, Constraint(CPU_NONE, 1, 1, 1, 1), 0)); break;
-           case 12:  processors16.push_back(Filtering::Processor<Processor16>(convolution_f_m_12_c, Constraint(CPU_NONE, 1, 1, 1, 1), 0)); break;
-           case 14:  processors16.push_back(Filtering::Processor<Processor16>(convolution_f_m_14_c, Constraint(CPU_NONE, 1, 1, 1, 1), 0)); break;
-           case 16:  processors16.push_back(Filtering::Processor<Processor16>(convolution_f_m_16_c, Constraint(CPU_NONE, 1, 1, 1, 1), 0)); break;
-           case 32:  processors32.push_back(Filtering::Processor<Processor32>(convolution_f_m_32_c, Constraint(CPU_NONE, 1, 1, 1, 1), 0)); break;
+           case 8: add_processors(processors, convolution_f_m_c, convolution_f_m_sse2, convolution_f_m_avx2); break;
+           case 10: add_processors(processors16, convolution_f_m_10_c, convolution_f_m_10_sse2, convolution_f_m_10_avx2); break;
+           case 12: add_processors(processors16, convolution_f_m_12_c, convolution_f_m_12_sse2, convolution_f_m_12_avx2); break;
+           case 14: add_processors(processors16, convolution_f_m_14_c, convolution_f_m_14_sse2, convolution_f_m_14_avx2); break;
+           case 16: add_processors(processors16, convolution_f_m_16_c, convolution_f_m_16_sse2, convolution_f_m_16_avx2); break;
+           case 32: add_processors(processors32, convolution_f_m_32_c, convolution_f_m_32_sse2, convolution_f_m_32_avx2); break;
            }
       else
          if ( isSaturate )
            switch (bits_per_pixel) {
-           case 8: processors.push_back(Filtering::Processor<Processor>(convolution_i_s_c, Constraint(CPU_NONE, 1, 1, 1, 1), 0)); break;
-           case 10: processors16.push_back(Filtering::Processor<Processor16>(convolution_i_s_10_c, Constraint(CPU_NONE, 1, 1, 1, 1), 0)); break;
-           case 12: processors16.push_back(Filtering::Processor<Processor16>(convolution_i_s_12_c, Constraint(CPU_NONE, 1, 1, 1, 1), 0)); break;
-           case 14: processors16.push_back(Filtering::Processor<Processor16>(convolution_i_s_14_c, Constraint(CPU_NONE, 1, 1, 1, 1), 0)); break;
-           case 16: processors16.push_back(Filtering::Processor<Processor16>(convolution_i_s_16_c, Constraint(CPU_NONE, 1, 1, 1, 1), 0)); break;
+           case 8: add_processors(processors, convolution_i_s_c, convolution_i_s_sse2, convolution_i_s_avx2, convolution_i_s_sse4); break;
+           case 10: add_processors(processors16, convolution_i_s_10_c, convolution_i_s_10_sse2, convolution_i_s_10_avx2, convolution_i_s_10_sse4); break;
+           case 12: add_processors(processors16, convolution_i_s_12_c, convolution_i_s_12_sse2, convolution_i_s_12_avx2, convolution_i_s_12_sse4); break;
+           case 14: add_processors(processors16, convolution_i_s_14_c, convolution_i_s_14_sse2, convolution_i_s_14_avx2, convolution_i_s_14_sse4); break;
+           case 16: add_processors(processors16, convolution_i_s_16_c, convolution_i_s_16_sse2, convolution_i_s_16_avx2, convolution_i_s_16_sse4); break;
            }
          else
            switch (bits_per_pixel) {
-           case 8: processors.push_back(Filtering::Processor<Processor>(convolution_i_m_c, Constraint(CPU_NONE, 1, 1, 1, 1), 0)); break;
-           case 10: processors16.push_back(Filtering::Processor<Processor16>(convolution_i_m_10_c, Constraint(CPU_NONE, 1, 1, 1, 1), 0)); break;
-           case 12: processors16.push_back(Filtering::Processor<Processor16>(convolution_i_m_12_c, Constraint(CPU_NONE, 1, 1, 1, 1), 0)); break;
-           case 14: processors16.push_back(Filtering::Processor<Processor16>(convolution_i_m_14_c, Constraint(CPU_NONE, 1, 1, 1, 1), 0)); break;
-           case 16: processors16.push_back(Filtering::Processor<Processor16>(convolution_i_m_16_c, Constraint(CPU_NONE, 1, 1, 1, 1), 0)); break;
+           case 8: add_processors(processors, convolution_i_m_c, convolution_i_m_sse2, convolution_i_m_avx2, convolution_i_m_sse4); break;
+           case 10: add_processors(processors16, convolution_i_m_10_c, convolution_i_m_10_sse2, convolution_i_m_10_avx2, convolution_i_m_10_sse4); break;
+           case 12: add_processors(processors16, convolution_i_m_12_c, convolution_i_m_12_sse2, convolution_i_m_12_avx2, convolution_i_m_12_sse4); break;
+           case 14: add_processors(processors16, convolution_i_m_14_c, convolution_i_m_14_sse2, convolution_i_m_14_avx2, convolution_i_m_14_sse4); break;
+           case 16: add_processors(processors16, convolution_i_m_16_c, convolution_i_m_16_sse2, convolution_i_m_16_avx2, convolution_i_m_16_sse4); break;
            }
    }
 
@@ -0,0 +1,98 @@
+#include "convolution_simd.h"
+
+namespace Filtering { namespace MaskTools { namespace Filters { namespace Convolution {
+
+/* avx2 policy of convolution_simd_t, 8 pixels. The packs work within each 128 bit lane, so the
+   halves of the results are packed together */
+struct ConvolutionAvx2 {
+   static const int count = 8;
+
+   static MT_FORCEINLINE __m256i load(const Byte *ptr, int) { return _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(ptr))); }
+   static MT_FORCEINLINE __m256i load(const Word *ptr, int) { return _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr))); }
+   static MT_FORCEINLINE __m256 load(const Byte *ptr, float) { return _mm256_cvtepi32_ps(load(ptr, 0)); }
+   static MT_FORCEINLINE __m256 load(const Word *ptr, float) { return _mm256_cvtepi32_ps(load(ptr, 0)); }
+   static MT_FORCEINLINE __m256 load(const Float *ptr, float) { return _mm256_loadu_ps(ptr); }
+
+   static MT_FORCEINLINE __m256i load_line(const int *ptr) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ptr)); }
+   static MT_FORCEINLINE __m256 load_line(const float *ptr) { return _mm256_loadu_ps(ptr); }
+   static MT_FORCEINLINE void store_line(int *ptr, __m256i value) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(ptr), value); }
+   static MT_FORCEINLINE void store_line(float *ptr, __m256 value) { _mm256_storeu_ps(ptr, value); }
+
+   static MT_FORCEINLINE __m256i set1(int value) { return _mm256_set1_epi32(value); }
+   static MT_FORCEINLINE __m256 set1(float value) { return _mm256_set1_ps(value); }
+   static MT_FORCEINLINE __m256i add(__m256i a, __m256i b) { return _mm256_add_epi32(a, b); }
+   static MT_FORCEINLINE __m256 add(__m256 a, __m256 b) { return _mm256_add_ps(a, b); }
+   static MT_FORCEINLINE __m256i mul(__m256i a, __m256i b) { return _mm256_mullo_epi32(a, b); }
+   static MT_FORCEINLINE __m256 mul(__m256 a, __m256 b) { return _mm256_mul_ps(a, b); }
+
+   static MT_FORCEINLINE __m256i mirror(__m256i value) { return _mm256_abs_epi32(value); }
+   static MT_FORCEINLINE __m256 mirror(__m256 value) {
+      const auto sign = _mm256_and_ps(_mm256_cmp_ps(value, _mm256_setzero_ps(), _CMP_LT_OQ), _mm256_set1_ps(-0.0f));
+      return _mm256_xor_ps(value, sign);
+   }
+
+   static MT_FORCEINLINE __m256i divide(__m256i value, int nNormalization, int nShift) {
+      if ( nShift >= 0 )
+         return _mm256_sra_epi32(value, _mm_cvtsi32_si128(nShift));
+      const auto divisor = _mm256_set1_pd(Double(nNormalization));
+      auto lo = _mm256_cvttpd_epi32(_mm256_div_pd(_mm256_cvtepi32_pd(_mm256_castsi256_si128(value)), divisor));
+      auto hi = _mm256_cvttpd_epi32(_mm256_div_pd(_mm256_cvtepi32_pd(_mm256_extracti128_si256(value, 1)), divisor));
+      return _mm256_set_m128i(hi, lo);
+   }
+   static MT_FORCEINLINE __m256 divide(__m256 value, float nNormalization, int nShift) { UNUSED(nShift); return _mm256_div_ps(value, _mm256_set1_ps(nNormalization)); }
+
+   template<int bits_per_pixel>
+   static MT_FORCEINLINE __m256i round(__m256 value) {
+      value = _mm256_min_ps(_mm256_max_ps(value, _mm256_setzero_ps()), _mm256_set1_ps(Float((1 << bits_per_pixel) - 1)));
+      auto result = _mm256_cvttps_epi32(value);
+      auto fraction = _mm256_sub_ps(value, _mm256_cvtepi32_ps(result));
+      return _mm256_sub_epi32(result, _mm256_castps_si256(_mm256_cmp_ps(fraction, _mm256_set1_ps(0.5f), _CMP_GE_OQ)));
+   }
+
+   template<int bits_per_pixel>
+   static MT_FORCEINLINE void store(Byte *ptr, __m256i value) {
+      auto words = _mm_packs_epi32(_mm256_castsi256_si128(value), _mm256_extracti128_si256(value, 1));
+      _mm_storel_epi64(reinterpret_cast<__m128i*>(ptr), _mm_packus_epi16(words, words));
+   }
+   template<int bits_per_pixel>
+   static MT_FORCEINLINE void store(Word *ptr, __m256i value) {
+      value = _mm256_min_epi32(_mm256_max_epi32(value, _mm256_setzero_si256()), _mm256_set1_epi32((1 << bits_per_pixel) - 1));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(ptr), _mm_packus_epi32(_mm256_castsi256_si128(value), _mm256_extracti128_si256(value, 1)));
+   }
+   template<int bits_per_pixel>
+   static MT_FORCEINLINE void store(Byte *ptr, __m256 value) { store<bits_per_pixel>(ptr, round<bits_per_pixel>(value)); }
+   template<int bits_per_pixel>
+   static MT_FORCEINLINE void store(Word *ptr, __m256 value) { store<bits_per_pixel>(ptr, round<bits_per_pixel>(value)); }
+   template<int bits_per_pixel>
+   static MT_FORCEINLINE void store(Float *ptr, __m256 value) { _mm256_storeu_ps(ptr, value); }
+};
+
+Processor *convolution_i_s_avx2 = &convolution_simd_t<ConvolutionAvx2, int, false, Byte, 8>;
+Processor *convolution_f_s_avx2 = &convolution_simd_t<ConvolutionAvx2, float, false, Byte, 8>;
+Processor *convolution_i_m_avx2 = &convolution_simd_t<ConvolutionAvx2, int, true, Byte, 8>;
+Processor *convolution_f_m_avx2 = &convolution_simd_t<ConvolutionAvx2, float, true, Byte, 8>;
+
+Processor16 *convolution_i_s_10_avx2 = &convolution_simd_t<ConvolutionAvx2, int, false, Word, 10>;
+Processor16 *convolution_f_s_10_avx2 = &convolution_simd_t<ConvolutionAvx2, float, false, Word, 10>;
+Processor16 *convolution_i_m_10_avx2 = &convolution_simd_t<ConvolutionAvx2, int, true, Word, 10>;
+Processor16 *convolution_f_m_10_avx2 = &convolution_simd_t<ConvolutionAvx2, float, true, Word, 10>;
+
+Processor16 *convolution_i_s_12_avx2 = &convolution_simd_t<ConvolutionAvx2, int, false, Word, 12>;
+Processor16 *convolution_f_s_12_avx2 = &convolution_simd_t<ConvolutionAvx2, float, false, Word, 12>;
+Processor16 *convolution_i_m_12_avx2 = &convolution_simd_t<ConvolutionAvx2, int, true, Word, 12>;
+Processor16 *convolution_f_m_12_avx2 = &convolution_simd_t<ConvolutionAvx2, float, true, Word, 12>;
+
+Processor16 *convolution_i_s_14_avx2 = &convolution_simd_t<ConvolutionAvx2, int, false, Word, 14>;
+Processor16 *convolution_f_s_14_avx2 = &convolution_simd_t<ConvolutionAvx2, float, false, Word, 14>;
+Processor16 *convolution_i_m_14_avx2 = &convolution_simd_t<ConvolutionAvx2, int, true, Word, 14>;
+Processor16 *convolution_f_m_14_avx2 = &convolution_simd_t<ConvolutionAvx2, float, true, Word, 14>;
+
+Processor16 *convolution_i_s_16_avx2 = &convolution_simd_t<ConvolutionAvx2, int, false, Word, 16>;
+Processor16 *convolution_f_s_16_avx2 = &convolution_simd_t<ConvolutionAvx2, float, false, Word, 16>;
+Processor16 *convolution_i_m_16_avx2 = &convolution_simd_t<ConvolutionAvx2, int, true, Word, 16>;
+Processor16 *convolution_f_m_16_avx2 = &convolution_simd_t<ConvolutionAvx2, float, true, Word, 16>;
+
+Processor32 *convolution_f_s_32_avx2 = &convolution_simd_t<ConvolutionAvx2, float, false, Float, 32>;
+Processor32 *convolution_f_m_32_avx2 = &convolution_simd_t<ConvolutionAvx2, float, true, Float, 32>;
+
+} } } }
@@ -0,0 +1,228 @@
+#ifndef __Mt_ConvolutionSimd_H__
+#define __Mt_ConvolutionSimd_H__
+
+#include "convolution.h"
+#include "../../common/simd.h"
+
+#include <vector>
+
+template<class Type> bool isNull(Type val) { UNUSED(val); return false; }
+template<> inline bool isNull<double>(double val) { return val < 0.001f && val > -0.001f; }
+template<> inline bool isNull<float>(float val) { return val < 0.001f && val > -0.001f; }
+template<> inline bool isNull<int>(int val) { return val == 0; }
+
+template<class Type>
+Type compute_norm_t(const Type *horizontal, const Type *vertical, int nHorizontal, int nVertical)
+{
+   Type nSum = 0;
+   for ( int i = 0; i < nVertical; i++ )
+      for ( int j = 0; j < nHorizontal; j++ )
+         nSum += horizontal[j] * vertical[i];
+
+   if ( isNull<Type>(nSum) )
+      return 1;
+
+   return nSum;
+}
+
+namespace Filtering { namespace MaskTools { namespace Filters { namespace Convolution {
+
+/* The vector kernels compute one pixel per 32 bit lane, with the products summed in the order of
+   the coefficients like convolution_t does: integer products wrap the same way, float ones are not
+   fused, so that both give the same results. The policies overload their operations on int and
+   float vectors, P::load converts the pixels to the type of the coefficients. */
+
+/* A horizontal line of the convolution, the source row is padded with its first and last pixels */
+template<class P, class Type, class pixel_t>
+static void convolution_line(Type *pLine, pixel_t *pPadded, const pixel_t *pSrc, const Type *horizontal, int nHorizontal, int nWidth, int nVectors)
+{
+   const int nLeft = nHorizontal / 2;
+   for ( int i = 0; i < nLeft; i++ )
+      pPadded[i] = pSrc[0];
+   memcpy(pPadded + nLeft, pSrc, nWidth * sizeof(pixel_t));
+   for ( int i = nLeft + nWidth; i < nVectors + nHorizontal; i++ )
+      pPadded[i] = pSrc[nWidth - 1];
+
+   for ( int x = 0; x < nVectors; x += P::count )
+   {
+      auto sum = P::set1(Type(0));
+      for ( int k = 0; k < nHorizontal; k++ )
+         sum = P::add(sum, P::mul(P::load(pPadded + x + k, Type()), P::set1(horizontal[k])));
+      P::store_line(pLine + x, sum);
+   }
+}
+
+/* integer normalizations by a power of 2 are shifts: the quotients only differ when they are negative,
+   and those pixels are 0 either way */
+static MT_FORCEINLINE int normalization_shift(int nNormalization)
+{
+   if ( nNormalization <= 0 || (nNormalization & (nNormalization - 1)) )
+      return -1;
+   int nShift = 0;
+   while ( (1 << nShift) < nNormalization )
+      nShift++;
+   return nShift;
+}
+
+static MT_FORCEINLINE int normalization_shift(float nNormalization) { UNUSED(nNormalization); return -1; }
+
+/* the lines are readable past the end, not the destination */
+template<class P, int bits_per_pixel, class pixel_t, class V>
+static MT_FORCEINLINE void convolution_store(pixel_t *pDst, int x, int nWidth, V result)
+{
+   if ( x + P::count <= nWidth )
+      P::template store<bits_per_pixel>(pDst + x, result);
+   else
+   {
+      pixel_t tail[P::count];
+      P::template store<bits_per_pixel>(tail, result);
+      memcpy(pDst + x, tail, (nWidth - x) * sizeof(pixel_t));
+   }
+}
+
+/* The ring holds the horizontal lines of nVertical source rows, the line t being the one of the row
+   t clamped to the plane. Like convolution_t, the rows below the plane repeat the last one for an
+   odd vertical, and the one above it for an even vertical. */
+template<class P, class Type, bool isMirror, class pixel_t, int bits_per_pixel>
+void convolution_simd_t(pixel_t *pDst, ptrdiff_t nDstPitch, const pixel_t *pSrc, ptrdiff_t nSrcPitch,
+                        void *_horizontal, void *_vertical, void *_total, const int nHorizontal, const int nVertical,
+                        int nWidth, int nHeight)
+{
+   nDstPitch /= sizeof(pixel_t);
+   nSrcPitch /= sizeof(pixel_t);
+
+   const Type *horizontal = static_cast<const Type*>(_horizontal);
+   const Type *vertical   = static_cast<const Type*>(_vertical);
+   const Type nNormalization = _total ? *static_cast<const Type*>(_total) : compute_norm_t<Type>(horizontal, vertical, nHorizontal, nVertical);
+
+   const int nShift = normalization_shift(nNormalization);
+   const int nVectors = (nWidth + P::count - 1) / P::count * P::count;
+   const int nLastRow = max<int>(0, nHeight - 1 - (nVertical % 2 ? 0 : 1));
+
+   std::vector<pixel_t> padded(nVectors + nHorizontal);
+   std::vector<Type> lines(size_t(nVectors) * nVertical);
+   std::vector<const Type*> rows(nVertical);
+
+   auto ring = [&](int t) { return &lines[size_t(((t % nVertical) + nVertical) % nVertical) * nVectors]; };
+   auto compute_line = [&](int t) {
+      const int nRow = t < 0 ? 0 : (t > nLastRow ? nLastRow : t);
+      convolution_line<P, Type, pixel_t>(ring(t), padded.data(), pSrc + nRow * nSrcPitch, horizontal, nHorizontal, nWidth, nVectors);
+   };
+
+   for ( int t = -(nVertical / 2); t < nVertical - 1 - nVertical / 2; t++ )
+      compute_line(t);
+
+   const auto half = P::set1(Type(sizeof(pixel_t) == 4 ? 0 : nNormalization / 2));
+   for ( int y = 0; y < nHeight; y++ )
+   {
+      const int nTop = y - nVertical / 2;
+      compute_line(nTop + nVertical - 1);
+      for ( int j = 0; j < nVertical; j++ )
+         rows[j] = ring(nTop + j);
+
+      for ( int x = 0; x < nVectors; x += P::count )
+      {
+         auto sum = P::set1(Type(0));
+         for ( int j = 0; j < nVertical; j++ )
+            sum = P::add(sum, P::mul(P::load_line(rows[j] + x), P::set1(vertical[j])));
+         if ( isMirror )
+            sum = P::mirror(sum);
+         sum = P::add(sum, half);
+         sum = P::divide(sum, nNormalization, nShift);
+         convolution_store<P, bits_per_pixel>(pDst, x, nWidth, sum);
+      }
+      pDst += nDstPitch;
+   }
+}
+
+/* sse2 and sse4.1, 4 pixels */
+template<CpuFlags flags>
+struct ConvolutionSse {
+   static const int count = 4;
+
+   static MT_FORCEINLINE __m128i load(const Byte *ptr, int) {
+      const __m128i zero = _mm_setzero_si128();
+      int value;
+      memcpy(&value, ptr, sizeof(value));
+      return _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(value), zero), zero);
+   }
+   static MT_FORCEINLINE __m128i load(const Word *ptr, int) {
+      return _mm_unpacklo_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(ptr)), _mm_setzero_si128());
+   }
+   static MT_FORCEINLINE __m128 load(const Byte *ptr, float) { return _mm_cvtepi32_ps(load(ptr, 0)); }
+   static MT_FORCEINLINE __m128 load(const Word *ptr, float) { return _mm_cvtepi32_ps(load(ptr, 0)); }
+   static MT_FORCEINLINE __m128 load(const Float *ptr, float) { return _mm_loadu_ps(ptr); }
+
+   static MT_FORCEINLINE __m128i load_line(const int *ptr) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr)); }
+   static MT_FORCEINLINE __m128 load_line(const float *ptr) { return _mm_loadu_ps(ptr); }
+   static MT_FORCEINLINE void store_line(int *ptr, __m128i value) { _mm_storeu_si128(reinterpret_cast<__m128i*>(ptr), value); }
+   static MT_FORCEINLINE void store_line(float *ptr, __m128 value) { _mm_storeu_ps(ptr, value); }
+
+   static MT_FORCEINLINE __m128i set1(int value) { return _mm_set1_epi32(value); }
+   static MT_FORCEINLINE __m128 set1(float value) { return _mm_set1_ps(value); }
+   static MT_FORCEINLINE __m128i add(__m128i a, __m128i b) { return _mm_add_epi32(a, b); }
+   static MT_FORCEINLINE __m128 add(__m128 a, __m128 b) { return _mm_add_ps(a, b); }
+   static MT_FORCEINLINE __m128i mul(__m128i a, __m128i b) { return simd_mullo_epi32<flags>(a, b); }
+   static MT_FORCEINLINE __m128 mul(__m128 a, __m128 b) { return _mm_mul_ps(a, b); }
+
+   static MT_FORCEINLINE __m128i mirror(__m128i value) {
+      const auto sign = _mm_srai_epi32(value, 31);
+      return _mm_sub_epi32(_mm_xor_si128(value, sign), sign);
+   }
+   static MT_FORCEINLINE __m128 mirror(__m128 value) {
+      const auto sign = _mm_and_ps(_mm_cmplt_ps(value, _mm_setzero_ps()), _mm_set1_ps(-0.0f));
+      return _mm_xor_ps(value, sign);
+   }
+
+   /* the quotients of 32 bit integers in double never cross an integer, their truncation is exact */
+   static MT_FORCEINLINE __m128i divide(__m128i value, int nNormalization, int nShift) {
+      if ( nShift >= 0 )
+         return _mm_sra_epi32(value, _mm_cvtsi32_si128(nShift));
+      const auto divisor = _mm_set1_pd(Double(nNormalization));
+      auto lo = _mm_cvttpd_epi32(_mm_div_pd(_mm_cvtepi32_pd(value), divisor));
+      auto hi = _mm_cvttpd_epi32(_mm_div_pd(_mm_cvtepi32_pd(_mm_unpackhi_epi64(value, value)), divisor));
+      return _mm_unpacklo_epi64(lo, hi);
+   }
+   static MT_FORCEINLINE __m128 divide(__m128 value, float nNormalization, int nShift) { UNUSED(nShift); return _mm_div_ps(value, _mm_set1_ps(nNormalization)); }
+
+   /* clamped, then rounded half up: the fraction of a float below 2^24 is exact */
+   template<int bits_per_pixel>
+   static MT_FORCEINLINE __m128i round(__m128 value) {
+      value = _mm_min_ps(_mm_max_ps(value, _mm_setzero_ps()), _mm_set1_ps(Float((1 << bits_per_pixel) - 1)));
+      auto result = _mm_cvttps_epi32(value);
+      auto fraction = _mm_sub_ps(value, _mm_cvtepi32_ps(result));
+      return _mm_sub_epi32(result, _mm_castps_si128(_mm_cmpge_ps(fraction, _mm_set1_ps(0.5f))));
+   }
+   template<int bits_per_pixel>
+   static MT_FORCEINLINE __m128i clamp(__m128i value) {
+      if ( flags >= CPU_SSE4_1 )
+         return _mm_min_epi32(_mm_max_epi32(value, _mm_setzero_si128()), _mm_set1_epi32((1 << bits_per_pixel) - 1));
+      const auto highest = _mm_set1_epi32((1 << bits_per_pixel) - 1);
+      value = _mm_andnot_si128(_mm_srai_epi32(value, 31), value);
+      const auto above = _mm_cmpgt_epi32(value, highest);
+      return _mm_or_si128(_mm_andnot_si128(above, value), _mm_and_si128(above, highest));
+   }
+
+   /* the saturations of the packs clamp to [0, 255] */
+   template<int bits_per_pixel>
+   static MT_FORCEINLINE void store(Byte *ptr, __m128i value) {
+      value = _mm_packs_epi32(value, value);
+      const int result = _mm_cvtsi128_si32(_mm_packus_epi16(value, value));
+      memcpy(ptr, &result, sizeof(result));
+   }
+   template<int bits_per_pixel>
+   static MT_FORCEINLINE void store(Word *ptr, __m128i value) {
+      value = clamp<bits_per_pixel>(value);
+      _mm_storel_epi64(reinterpret_cast<__m128i*>(ptr), simd_packus_epi32<flags>(value, value));
+   }
+   template<int bits_per_pixel>
+   static MT_FORCEINLINE void store(Byte *ptr, __m128 value) { store<bits_per_pixel>(ptr, round<bits_per_pixel>(value)); }
+   template<int bits_per_pixel>
+   static MT_FORCEINLINE void store(Word *ptr, __m128 value) { store<bits_per_pixel>(ptr, round<bits_per_pixel>(value)); }
+   template<int bits_per_pixel>
+   static MT_FORCEINLINE void store(Float *ptr, __m128 value) { _mm_storeu_ps(ptr, value); }
+};
+
+} } } }
+
+#endif
@@ -38,6 +38,7 @@ public:
   Invert(const Parameters &parameters, CpuFlags cpuFlags, PNeoEnv env)
      : MaskTools::Filter(parameters, FilterProcessingType::INPLACE, (CpuFlags)cpuFlags)
   {
+     nStripeHalo = 0;
      UNUSED(env);
     int bits_per_pixel = bit_depths[C];
 
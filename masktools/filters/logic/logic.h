@@ -14,7 +14,8 @@ typedef void(Processor32)(Float *pDst, ptrdiff_t nDstPitch, const Float *pSrc1,
    extern Processor *name##_sse2; \
    extern Processor *name##_asse2; \
    extern Processor *name##_avx2; \
-   extern Processor *name##_aavx2;
+   extern Processor *name##_aavx2; \
+   extern Processor *name##_avx512;
 
 DEFINE_PROCESSOR(and);
 DEFINE_PROCESSOR(or);
@@ -44,7 +45,8 @@ DEFINE_NINE(max);
    extern Processor16 *name##_native_c; \
    extern Processor16 *name##_stacked_sse2; \
    extern Processor16 *name##_native_sse2; \
-   extern Processor16 *name##_native_avx2;
+   extern Processor16 *name##_native_avx2; \
+   extern Processor16 *name##_native_avx512;
 
 DEFINE_PROCESSOR(and16);
 DEFINE_PROCESSOR(or16 );
@@ -147,6 +149,7 @@ public:
   Logic(const Parameters &parameters, CpuFlags cpuFlags, PNeoEnv env)
      : MaskTools::Filter(parameters, FilterProcessingType::INPLACE, (CpuFlags)cpuFlags)
   {
+     nStripeHalo = 0;
      UNUSED(env);
     isStacked = parameters["stacked"].toBool();
     bits_per_pixel = bit_depths[C];
@@ -196,6 +199,7 @@ public:
       processors.push_back( Filtering::Processor<Processor>( mode##_asse2, Constraint( CPU_SSE2 , 1, 1, 16, 16 ), 2 ) ); \
       processors.push_back( Filtering::Processor<Processor>( mode##_avx2, Constraint( CPU_AVX2 , 1, 1, 1, 1 ), 3 ) ); \
       processors.push_back( Filtering::Processor<Processor>( mode##_aavx2, Constraint( CPU_AVX2 , 1, 1, 32, 32 ), 4 ) ); \
+      processors.push_back( Filtering::Processor<Processor>( mode##_avx512, Constraint( CPU_AVX512F | CPU_AVX512BW , 1, 1, 1, 1 ), 5 ) ); \
    } while(0)
       
       if (parameters["mode"].toString() == "and")
@@ -260,7 +264,8 @@ public:
           processors16.push_back( Filtering::Processor<Processor16>( mode##_native_sse2, Constraint( CPU_SSE4_1 , 1, 1, 1, 1 ), 1 ) ); \
         else \
           processors16.push_back( Filtering::Processor<Processor16>( mode##_native_sse2, Constraint( CPU_SSE2 , 1, 1, 1, 1 ), 1 ) ); \
-        processors16.push_back( Filtering::Processor<Processor16>( mode##_native_avx2, Constraint( CPU_AVX2 , 1, 1, 1, 1 ), 1 ) ); \
+        processors16.push_back( Filtering::Processor<Processor16>( mode##_native_avx2, Constraint( CPU_AVX2 , 1, 1, 1, 1 ), 2 ) ); \
+        processors16.push_back( Filtering::Processor<Processor16>( mode##_native_avx512, Constraint( CPU_AVX512F | CPU_AVX512BW , 1, 1, 1, 1 ), 3 ) ); \
     }
 
       // modes containing min, max, add require SSE4
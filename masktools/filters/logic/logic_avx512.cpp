@@ -0,0 +1,127 @@
+#include "logic.h"
+#include "../../common/simd.h"
+
+using namespace Filtering;
+
+static MT_FORCEINLINE Byte add(Byte a, Byte b) { return clip<Byte, int>(a + (int)b); }
+static MT_FORCEINLINE Byte sub(Byte a, Byte b) { return clip<Byte, int>(a - (int)b); }
+static MT_FORCEINLINE Byte nop(Byte a, Byte b) { UNUSED(b); return a; }
+
+static MT_FORCEINLINE Byte and(Byte a, Byte b, Byte th1, Byte th2) { UNUSED(th1); UNUSED(th2); return a & b; }
+static MT_FORCEINLINE Byte or(Byte a, Byte b, Byte th1, Byte th2) { UNUSED(th1); UNUSED(th2); return a | b; }
+static MT_FORCEINLINE Byte andn(Byte a, Byte b, Byte th1, Byte th2) { UNUSED(th1); UNUSED(th2); return a & ~b; }
+static MT_FORCEINLINE Byte xor(Byte a, Byte b, Byte th1, Byte th2) { UNUSED(th1); UNUSED(th2); return a ^ b; }
+
+template <decltype(add) opa, decltype(add) opb>
+static MT_FORCEINLINE Byte min_t(Byte a, Byte b, Byte th1, Byte th2) { 
+    return min<Byte>(opa(a, th1), opb(b, th2)); 
+}
+
+template <decltype(add) opa, decltype(add) opb>
+static MT_FORCEINLINE Byte max_t(Byte a, Byte b, Byte th1, Byte th2) { 
+    return max<Byte>(opa(a, th1), opb(b, th2)); 
+}
+
+template <decltype(and) op>
+static void logic_t(Byte *pDst, ptrdiff_t nDstPitch, const Byte *pSrc, ptrdiff_t nSrcPitch, int nWidth, int nHeight, Byte nThresholdDestination, Byte nThresholdSource)
+{
+   for ( int y = 0; y < nHeight; y++ )
+   {
+      for ( int x = 0; x < nWidth; x++ )
+         pDst[x] = op(pDst[x], pSrc[x], nThresholdDestination, nThresholdSource);
+      pDst += nDstPitch;
+      pSrc += nSrcPitch;
+   }
+}
+
+/* avx512 */
+
+static MT_FORCEINLINE __m512i add_avx512(__m512i a, __m512i b) { return _mm512_adds_epu8(a, b); }
+static MT_FORCEINLINE __m512i sub_avx512(__m512i a, __m512i b) { return _mm512_subs_epu8(a, b); }
+static MT_FORCEINLINE __m512i nop_avx512(__m512i a, __m512i) { return a; }
+
+static MT_FORCEINLINE __m512i and_avx512_op(const __m512i &a, const __m512i &b, const __m512i&, const __m512i&) { 
+    return _mm512_and_si512(a, b); 
+}
+
+static MT_FORCEINLINE __m512i or_avx512_op(const __m512i &a, const __m512i &b, const __m512i&, const __m512i&) { 
+    return _mm512_or_si512(a, b); 
+}
+
+static MT_FORCEINLINE __m512i andn_avx512_op(const __m512i &a, const __m512i &b, const __m512i&, const __m512i&) { 
+    return _mm512_andnot_si512(a, b); 
+}
+
+static MT_FORCEINLINE __m512i xor_avx512_op(const __m512i &a, const __m512i &b, const __m512i&, const __m512i&) { 
+    return _mm512_xor_si512(a, b); 
+}
+
+template <decltype(add_avx512) opa, decltype(add_avx512) opb>
+static MT_FORCEINLINE __m512i min_t_avx512(const __m512i &a, const __m512i &b, const __m512i& th1, const __m512i& th2) { 
+    return _mm512_min_epu8(opa(a, th1), opb(b, th2));
+}
+
+template <decltype(add_avx512) opa, decltype(add_avx512) opb>
+static MT_FORCEINLINE __m512i max_t_avx512(const __m512i &a, const __m512i &b, const __m512i& th1, const __m512i& th2) { 
+    return _mm512_max_epu8(opa(a, th1), opb(b, th2));
+}
+
+
+template<MemoryMode mem_mode, decltype(and_avx512_op) op, decltype(and) op_c>
+    static void logic_t_avx512(Byte *pDst, ptrdiff_t nDstPitch, const Byte *pSrc, ptrdiff_t nSrcPitch, int nWidth, int nHeight, Byte nThresholdDestination, Byte nThresholdSource)
+{
+    int wMod64 = (nWidth / 64) * 64;
+    auto pDst2 = pDst;
+    auto pSrc2 = pSrc;
+    auto tDest = _mm512_set1_epi8(Byte(nThresholdDestination));
+    auto tSource = _mm512_set1_epi8(Byte(nThresholdSource));
+
+    for ( int j = 0; j < nHeight; ++j ) {
+        for ( int i = 0; i < wMod64; i+=64 ) {
+            auto dst = simd512_load_si512<mem_mode>(pDst+i);
+            auto src = simd512_load_si512<mem_mode>(pSrc+i);
+
+            auto result = op(dst, src, tDest, tSource);
+
+            simd512_store_si512<mem_mode>(pDst+i, result);
+        }
+        pDst += nDstPitch;
+        pSrc += nSrcPitch;
+    }
+
+    if (nWidth > wMod64) {
+        logic_t<op_c>(pDst2 + wMod64, nDstPitch, pSrc2 + wMod64, nSrcPitch, nWidth - wMod64, nHeight, nThresholdDestination, nThresholdSource);
+    }
+    _mm256_zeroupper();
+}
+
+
+
+namespace Filtering { namespace MaskTools { namespace Filters { namespace Logic {
+
+#define DEFINE_AVX512_VERSIONS(name, mem_mode) \
+Processor *and_##name  = &logic_t_avx512<mem_mode, and_avx512_op, and>; \
+Processor *or_##name   = &logic_t_avx512<mem_mode, or_avx512_op, or>; \
+Processor *andn_##name = &logic_t_avx512<mem_mode, andn_avx512_op, andn>; \
+Processor *xor_##name  = &logic_t_avx512<mem_mode, xor_avx512_op, xor>;
+
+DEFINE_AVX512_VERSIONS(avx512, MemoryMode::SSE2_UNALIGNED)
+
+#define DEFINE_SILLY_AVX512_VERSIONS(mode, name, mem_mode) \
+Processor *mode##_##name         = &logic_t_avx512<mem_mode, mode##_t_avx512<nop_avx512, nop_avx512>, mode##_t<nop, nop>>;   \
+Processor *mode##sub_##name      = &logic_t_avx512<mem_mode, mode##_t_avx512<nop_avx512, sub_avx512>, mode##_t<nop, sub>>;   \
+Processor *mode##add_##name      = &logic_t_avx512<mem_mode, mode##_t_avx512<nop_avx512, add_avx512>, mode##_t<nop, add>>;   \
+Processor *sub##mode##_##name    = &logic_t_avx512<mem_mode, mode##_t_avx512<sub_avx512, nop_avx512>, mode##_t<sub, nop>>;   \
+Processor *sub##mode##sub_##name = &logic_t_avx512<mem_mode, mode##_t_avx512<sub_avx512, sub_avx512>, mode##_t<sub, sub>>;   \
+Processor *sub##mode##add_##name = &logic_t_avx512<mem_mode, mode##_t_avx512<sub_avx512, add_avx512>, mode##_t<sub, add>>;   \
+Processor *add##mode##_##name    = &logic_t_avx512<mem_mode, mode##_t_avx512<add_avx512, nop_avx512>, mode##_t<add, nop>>;   \
+Processor *add##mode##sub_##name = &logic_t_avx512<mem_mode, mode##_t_avx512<add_avx512, sub_avx512>, mode##_t<add, sub>>;   \
+Processor *add##mode##add_##name = &logic_t_avx512<mem_mode, mode##_t_avx512<add_avx512, add_avx512>, mode##_t<add, add>>;
+
+DEFINE_SILLY_AVX512_VERSIONS(min, avx512, MemoryMode::SSE2_UNALIGNED)
+DEFINE_SILLY_AVX512_VERSIONS(max, avx512, MemoryMode::SSE2_UNALIGNED)
+
+#undef DEFINE_SILLY_AVX512_VERSIONS
+#undef DEFINE_AVX512_VERSIONS
+
+} } } }
\ No newline at end of file
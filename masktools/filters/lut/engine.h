@@ -0,0 +1,35 @@
+#ifndef __Mt_Lut_Engine_H__
+#define __Mt_Lut_Engine_H__
+
+#include "../../../common/utils/utils.h"
+
+namespace Filtering { namespace MaskTools { namespace Filters { namespace Lut {
+
+// how the lut filters evaluate their expressions, "engine" parameter
+typedef enum {
+
+   ENGINE_DEFAULT = 0, // dedicated filter kernel for common expressions, otherwise precomputed lut when possible (tiled for two inputs at 14-16 bit), otherwise jit
+   ENGINE_LUT,         // precomputed lut, same as realtime = false, kept on disk when MASKTOOLS_LUT_CACHE names a directory
+   ENGINE_INTERPRETER, // realtime, parser interpreter only
+   ENGINE_JIT,         // realtime, native code when available (MASKTOOLS_DISABLE_JIT not set), interpreter otherwise
+
+} ENGINE;
+
+static inline bool EngineFromString(const String &engine, ENGINE &result)
+{
+   if ( engine == "" )
+      result = ENGINE_DEFAULT;
+   else if ( engine == "lut" )
+      result = ENGINE_LUT;
+   else if ( engine == "interpreter" )
+      result = ENGINE_INTERPRETER;
+   else if ( engine == "jit" )
+      result = ENGINE_JIT;
+   else
+      return false;
+   return true;
+}
+
+} } } }
+
+#endif
@@ -1,7 +1,9 @@
 #ifndef __Mt_Lut_Functions_H__
 #define __Mt_Lut_Functions_H__
 
+#include <algorithm>
 #include <limits>
+#include <vector>
 
 namespace Filtering { namespace MaskTools { namespace Filters { namespace Lut {
 
@@ -63,6 +65,9 @@ typedef enum {
 
 #define MPROCESSOR16_SINGLE( base, realtime, bits_per_pixel )     MPROCESSOR16( realtime, bits_per_pixel, EXPRESSION16_SINGLE, base, )
 #define MPROCESSOR16_DUAL( base, mode, realtime, bits_per_pixel ) MPROCESSOR16( realtime, bits_per_pixel, EXPRESSION16_DUAL, base, mode )
+// tiled lut: no realtime variant
+#define EXPRESSION16_TILED( realtime, bits_per_pixel, base, mode1, mode2 ) &base< bits_per_pixel, mode2 >
+#define MPROCESSOR16_TILED( base, bits_per_pixel ) MPROCESSOR16( false, bits_per_pixel, EXPRESSION16_TILED, base, )
 
 /* 32 bit float */
 #define EXPRESSION32_SINGLE( base, mode1, mode2 ) &base< mode2 >
@@ -313,7 +318,8 @@ public:
    // 3840 x 2180 = 8371200, just below limit
    // 4096 x 2180 = 8929280 pixels, over limit!
    // unsigned int32 is OK, but is not enough for 8K videos
-   Byte finalize() const { return static_cast<Byte>(rounded_division<T>( nSum, nCount )); }
+   Byte finalize() const { return finalize( nSum, nCount ); }
+   static Byte finalize(T nSum, T nCount) { return static_cast<Byte>(rounded_division<T>( nSum, nCount )); }
 
    void reset_w() { fSum = 0.0; fWeightSum = 0.0f; }
    void add_w(int nValue, float nWeight) { fSum += nValue*nWeight; fWeightSum += nWeight; }
@@ -335,7 +341,8 @@ public:
    void reset() { nSum = 0; nSum2 = 0; nCount = 0; }
    void reset(int nValue) { nSum = nValue; nSum2 = nValue * nValue; nCount = 1; }
    void add(int nValue) { nSum += nValue; nSum2 += nValue * nValue; nCount++; }
-   Byte finalize() const { return clip<Byte, Double>(sqrt((Double(nSum2) * nCount - Double(nSum) * Double(nSum)) / (Double(nCount) * nCount))); }
+   Byte finalize() const { return finalize(Double(nSum), Double(nSum2), Double(nCount)); }
+   static Byte finalize(Double dSum, Double dSum2, Double dCount) { return clip<Byte, Double>(sqrt((dSum2 * dCount - dSum * dSum) / (dCount * dCount))); }
 
    void reset_w() { fSum = 0.0; fSum2 = 0.0; fWeightSum = 0.0f; }
    void reset_w(int nValue, float nWeight) { fSum = nValue*nWeight; fSum2 = fSum * fSum; fWeightSum = nWeight; }
@@ -416,89 +423,88 @@ public:
 
 };
 
-// no bits_per_pixel template
-class Medianizer16 {
+/* median of Word values without a histogram of the whole range to clear for each pixel: the
+   values are kept and selected in place, up to 64 of them (neighbourhoods up to 8x8). Past that, a
+   256 bucket histogram of their high byte finds the bucket of the median, and only the values of
+   that bucket are selected from. Same results as a histogram. */
+class WordMedian {
 
-  int nSize;
-  int elements[65536]; // really 1 << bits_per_pixel, but avoid overflow
+  static const int nSmall = 64;
+  mutable std::vector<Word> values;
+  mutable std::vector<Word> bucket;
 
 public:
 
-  Medianizer16(const String &mode) { UNUSED(mode); }
-  void reset() { memset(elements, 0, sizeof(elements)); nSize = 0; }
-  void reset(int nValue) { reset(); add(nValue); }
-  void add(int nValue) { elements[nValue]++; nSize++; }
-  Word finalize() const
+  void reset() { values.clear(); }
+  void add(int nValue) { values.push_back(static_cast<Word>(nValue)); }
+
+  /* the value of rank (n - 1) / 2 and, for an even count, the next one */
+  void middle(int &nLow, int &nHigh) const
   {
-    int nCount = 0;
-    int nIdx = -1;
-    const int nLowHalf = (nSize + 1) >> 1;
-    while (nCount < nLowHalf)
-      nCount += elements[++nIdx];
-
-    if (nSize & 1) /* nSize odd -> median belong to the middle class */
-      return static_cast<Word>(nIdx);
-    else
-    {
-      if (nCount >= nLowHalf + 1) /* nSize even, but middle class owns both median elements */
-        return static_cast<Word>(nIdx);
-      else /* nSize even, middle class owns only one element, it's the lowest, so we search for the next one */
-      {
-        int nSndIdx = nIdx;
-        while (!elements[++nSndIdx]) {}
-        return static_cast<Word>((nIdx + nSndIdx + 1) >> 1); /* and we return the average */
-      }
+    const int nSize = int(values.size());
+    const int nRank = (nSize - 1) >> 1;
+    if (nSize == 0) {
+      nLow = nHigh = 0;
+      return;
     }
-  }
 
-  void reset_w() { reset(); }
-  void add_w(int nValue, float nWeight) { add(clip<Word, Float>(nValue*nWeight)); }
-  Word finalize_w() const { return finalize(); }
+    if (nSize <= nSmall) {
+      std::nth_element(values.begin(), values.begin() + nRank, values.end());
+      nLow = values[nRank];
+      nHigh = (nSize & 1) ? nLow : *std::min_element(values.begin() + nRank + 1, values.end());
+      return;
+    }
 
+    int counts[256] = { 0 };
+    for (auto nValue : values)
+      counts[nValue >> 8]++;
+
+    int nBucket = 0;
+    int nBefore = 0;
+    while (nBefore + counts[nBucket] <= nRank)
+      nBefore += counts[nBucket++];
+
+    bucket.clear();
+    for (auto nValue : values)
+      if ((nValue >> 8) == nBucket)
+        bucket.push_back(nValue);
+
+    const int nInner = nRank - nBefore;
+    std::nth_element(bucket.begin(), bucket.begin() + nInner, bucket.end());
+    nLow = bucket[nInner];
+    if (nSize & 1)
+      nHigh = nLow;
+    else if (nInner + 1 < int(bucket.size()))
+      nHigh = *std::min_element(bucket.begin() + nInner + 1, bucket.end());
+    else {
+      /* the next value is the smallest of the next non empty bucket */
+      int nNext = nBucket + 1;
+      while (!counts[nNext])
+        nNext++;
+      nHigh = 65535;
+      for (auto nValue : values)
+        if ((nValue >> 8) == nNext)
+          nHigh = min<int>(nHigh, nValue);
+    }
+  }
 };
 
 // no bits_per_pixel template
-template<int n>
-class MedianizerBetter16
-{
-  int nSize;
-  int elements[65536];
-  int elements2[65536 >> n];
+class Medianizer16 {
+
+  WordMedian values;
 
 public:
-  MedianizerBetter16(const String &mode) { UNUSED(mode); }
-  void reset() { nSize = 0; memset(elements, 0, sizeof(elements)); memset(elements2, 0, sizeof(elements2)); }
-  void add(int nValue) { elements[nValue]++; elements2[nValue >> n]++; nSize++; }
 
+  Medianizer16(const String &mode) { UNUSED(mode); }
+  void reset() { values.reset(); }
+  void reset(int nValue) { reset(); add(nValue); }
+  void add(int nValue) { values.add(nValue); }
   Word finalize() const
   {
-    int nCount = 0;
-    int nIdx = -1;
-    const int nLowHalf = (nSize + 1) >> 1;
-
-    while (nCount < nLowHalf)
-      nCount += elements2[++nIdx]; /* low resolution search */
-
-    nCount -= elements2[nIdx];
-    nIdx <<= n;
-    nIdx--;
-
-    while (nCount < nLowHalf)
-      nCount += elements[++nIdx]; /* high resolution search */
-
-    if (nSize & 1) /* nSize odd -> median belong to the middle class */
-      return static_cast<Word>(nIdx);
-    else
-    {
-      if (nCount >= nLowHalf + 1) /* nSize even, but middle class owns both median elements */
-        return static_cast<Word>(nIdx);
-      else /* nSize even, middle class owns only one element, it's the lowest, so we search for the next one */
-      {
-        int nSndIdx = nIdx;
-        while (!elements[++nSndIdx]) {}
-        return static_cast<Word>((nIdx + nSndIdx + 1) >> 1); /* and we return the average */
-      }
-    }
+    int nLow, nHigh;
+    values.middle(nLow, nHigh);
+    return static_cast<Word>((nLow + nHigh + 1) >> 1); /* the average of both middle values for an even count */
   }
 
   void reset_w() { reset(); }
@@ -507,6 +513,10 @@ public:
 
 };
 
+// the coarse histogram of 65536 >> n entries has no use without the fine one
+template<int n>
+using MedianizerBetter16 = Medianizer16;
+
 // no bits_per_pixel template
 class Maximizer16 {
 
@@ -559,7 +569,8 @@ public:
   Averager16(const String &mode) { UNUSED(mode); }
   void reset() { nSum = 0; nCount = 0; }
   void add(int nValue) { nSum += nValue; nCount++; }
-  Word finalize() const { return static_cast<Word>(rounded_division<int64_t>(nSum, nCount)); }
+  Word finalize() const { return finalize(nSum, nCount); }
+  static Word finalize(int64_t nSum, int64_t nCount) { return static_cast<Word>(rounded_division<int64_t>(nSum, nCount)); }
 
   void reset_w() { fSum = 0.0; fWeightSum = 0.0f; }
   void add_w(int nValue, float nWeight) { fSum += nValue*nWeight; fWeightSum += nWeight; }
@@ -580,9 +591,10 @@ public:
 
   Deviater16(const String &mode) { UNUSED(mode); }
   void reset() { nSum = 0; nSum2 = 0; nCount = 0; }
-  void reset(int nValue) { nSum = nValue; nSum2 = nValue * nValue; nCount = 1; }
-  void add(int nValue) { nSum += nValue; nSum2 += nValue * nValue; nCount++; }
-  Word finalize() const { return convert<Word, Double>(sqrt((Double(nSum2) * nCount - Double(nSum) * Double(nSum)) / (Double(nCount) * nCount))); }
+  void reset(int nValue) { nSum = nValue; nSum2 = Int64(nValue) * nValue; nCount = 1; }
+  void add(int nValue) { nSum += nValue; nSum2 += Int64(nValue) * nValue; nCount++; } // 16 bit squares overflow an int
+  Word finalize() const { return finalize(Double(nSum), Double(nSum2), Double(nCount)); }
+  static Word finalize(Double dSum, Double dSum2, Double dCount) { return convert<Word, Double>(sqrt((dSum2 * dCount - dSum * dSum) / (dCount * dCount))); }
   
   void reset_w() { fSum = 0.0; fSum2 = 0.0; fWeightSum = 0.0f; }
   void reset_w(int nValue, float nWeight) { fSum = nValue*nWeight; fSum2 = fSum * fSum; fWeightSum = nWeight; }
@@ -663,37 +675,20 @@ public:
 
 class Medianizer32 {
 
-  int nSize;
   // fake median, we simulate median as float quantized to 16 bit, then scale back the result
-  int elements[65536]; 
+  WordMedian values;
 
 public:
 
   Medianizer32(const String &mode) { UNUSED(mode); }
-  void reset() { memset(elements, 0, sizeof(elements)); nSize = 0; }
+  void reset() { values.reset(); }
   void reset(Float nValue) { reset(); add(nValue); }
-  void add(Float nValue) { elements[nValue <= 0.0f ? 0 : (nValue>=1.0f ? 65535 : Word(nValue * 65535))]++; nSize++; }
+  void add(Float nValue) { values.add(nValue <= 0.0f ? 0 : (nValue>=1.0f ? 65535 : Word(nValue * 65535))); }
   Float finalize() const
   {
-    int nCount = 0;
-    int nIdx = -1;
-    const int nLowHalf = (nSize + 1) >> 1;
-    while (nCount < nLowHalf)
-      nCount += elements[++nIdx];
-
-    if (nSize & 1) /* nSize odd -> median belong to the middle class */
-      return nIdx / 65535.0f;
-    else
-    {
-      if (nCount >= nLowHalf + 1) /* nSize even, but middle class owns both median elements */
-        return nIdx / 65535.0f;
-      else /* nSize even, middle class owns only one element, it's the lowest, so we search for the next one */
-      {
-        int nSndIdx = nIdx;
-        while (!elements[++nSndIdx]) {}
-        return (nIdx + nSndIdx)/2.0f / 65535.0f; /* and we return the average, and scale back to float */
-      }
-    }
+    int nLow, nHigh;
+    values.middle(nLow, nHigh);
+    return (nLow + nHigh) / 2.0f / 65535.0f; /* the average for an even count, and scale back to float */
   }
 
   void reset_w() { reset(); }
@@ -703,53 +698,7 @@ public:
 };
 
 template<int n>
-class MedianizerBetter32
-{
-  int nSize;
-  // fake median, we simulate median as float quantized to 16 bit, then scale back the result
-  int elements[65536];
-  int elements2[65536 >> n];
-
-public:
-  MedianizerBetter32(const String &mode) { UNUSED(mode); }
-  void reset() { nSize = 0; memset(elements, 0, sizeof(elements)); memset(elements2, 0, sizeof(elements2)); }
-  void add(Float nValue) { int nValueNew = nValue < 0.0f ? 0 : (nValue >= 1.0f ? 65535 : Word(nValue * 65535));  elements[nValueNew]++; elements2[nValueNew >> n]++; nSize++; }
-
-  Float finalize() const
-  {
-    int nCount = 0;
-    int nIdx = -1;
-    const int nLowHalf = (nSize + 1) >> 1;
-
-    while (nCount < nLowHalf)
-      nCount += elements2[++nIdx]; /* low resolution search */
-
-    nCount -= elements2[nIdx];
-    nIdx <<= n;
-    nIdx--;
-
-    while (nCount < nLowHalf)
-      nCount += elements[++nIdx]; /* high resolution search */
-
-    if (nSize & 1) /* nSize odd -> median belong to the middle class */
-      return nIdx / 65535.0f; // scale back
-    else
-    {
-      if (nCount >= nLowHalf + 1) /* nSize even, but middle class owns both median elements */
-        return nIdx / 65535.0f;
-      else /* nSize even, middle class owns only one element, it's the lowest, so we search for the next one */
-      {
-        int nSndIdx = nIdx;
-        while (!elements[++nSndIdx]) {}
-        return (nIdx + nSndIdx) / 2.0f / 65535.0f; /* and we return the average */
-      }
-    }
-  }
-
-  void reset_w() { reset(); }
-  void add_w(float nValue, float nWeight) { add(nValue*nWeight); }
-  Float finalize_w() const { return finalize(); }
-};
+using MedianizerBetter32 = Medianizer32;
 
 class Maximizer32 {
 
@@ -1,4 +1,5 @@
 #include "lut.h"
+#include "../../../common/simd.h"
 
 using namespace Filtering;
 
@@ -13,13 +14,35 @@ void Filtering::MaskTools::Filters::Lut::Single::lut_c(Byte *dstp, ptrdiff_t dst
     }
 }
 
+void Filtering::MaskTools::Filters::Lut::Single::lut_ssse3(Byte *dstp, ptrdiff_t dst_pitch, int width, int height, const Byte lut[256])
+{
+    __m128i table[16];
+    for (int k = 0; k < 16; k++) {
+        table[k] = simd_load_si128<MemoryMode::SSE2_UNALIGNED>(lut + k * 16);
+    }
+
+    const int wMod16 = (width / 16) * 16;
+    auto dstp2 = dstp;
+
+    for (int y = 0; y < height; y++)
+    {
+        for (int x = 0; x < wMod16; x += 16) {
+            auto index = simd_load_si128<MemoryMode::SSE2_UNALIGNED>(dstp + x);
+            simd_store_si128<MemoryMode::SSE2_UNALIGNED>(dstp + x, lut8_shuffle_ssse3(table, index));
+        }
+        dstp += dst_pitch;
+    }
+    if (width > wMod16) {
+        lut_c(dstp2 + wMod16, dst_pitch, width - wMod16, height, lut);
+    }
+}
+
 void Filtering::MaskTools::Filters::Lut::Single::realtime8_c(Byte *dstp, ptrdiff_t dst_pitch, int width, int height, Parser::Context &ctx)
 {
   for (int y = 0; y < height; y++)
   {
-    for (int x = 0; x < width; x++) {
-      dstp[x] = ctx.compute_byte_x(dstp[x]);
-    }
+    const Byte *src[1] = { dstp };
+    ctx.compute_row_byte(dstp, src, 1, width);
     dstp += dst_pitch;
   }
 }
@@ -27,17 +50,11 @@ void Filtering::MaskTools::Filters::Lut::Single::realtime8_c(Byte *dstp, ptrdiff
 template<int bits_per_pixel>
 void realtime16_t_c(Byte *dstp, ptrdiff_t dst_pitch, int width, int height, Parser::Context &ctx)
 {
-  const Word max_pixel_value = (1 << bits_per_pixel) - 1;
   for (int y = 0; y < height; y++)
   {
-    for (int x = 0; x < width; x++) {
-      Word pixel = reinterpret_cast<uint16_t *>(dstp)[x] ;
-      if (bits_per_pixel != 16) pixel = min(pixel, max_pixel_value);
-
-      Word result = ctx.compute_word_x<bits_per_pixel>(pixel);
-
-      reinterpret_cast<uint16_t *>(dstp)[x] = result;
-    }
+    // input clamped below 16 bit
+    const Word *src[1] = { reinterpret_cast<const Word *>(dstp) };
+    ctx.compute_row_word(reinterpret_cast<Word *>(dstp), src, 1, width, bits_per_pixel);
     dstp += dst_pitch;
   }
 }
@@ -46,9 +63,8 @@ void Filtering::MaskTools::Filters::Lut::Single::realtime32_c(Byte *dstp, ptrdif
 {
   for (int y = 0; y < height; y++)
   {
-    for (int x = 0; x < width; x++) {
-      reinterpret_cast<Float *>(dstp)[x] = ctx.compute_float_x(reinterpret_cast<Float *>(dstp)[x]);
-    }
+    const Float *src[1] = { reinterpret_cast<const Float *>(dstp) };
+    ctx.compute_row_float(reinterpret_cast<Float *>(dstp), src, 1, width);
     dstp += dst_pitch;
   }
 }
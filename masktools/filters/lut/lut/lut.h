@@ -3,8 +3,11 @@
 
 #include "../../../common/base/filter.h"
 #include "../../../../common/parser/parser.h"
+#include "../../../../common/parser/context_pool.h"
 #include "../lut_data.h"
 #include "../lut_kernel.h"
+#include "../engine.h"
+#include "../native.h"
 
 namespace Filtering { namespace MaskTools { namespace Filters { namespace Lut { namespace Single {
 
@@ -13,8 +16,12 @@ typedef void(Processor16)(Byte *pDst, ptrdiff_t nDstPitch, int nWidth, int nHeig
 typedef void(ProcessorCtx)(Byte *pDst, ptrdiff_t nDstPitch, int nWidth, int nHeight, Parser::Context &ctx);
 
 Processor lut_c;
+Processor lut_ssse3;
+Processor lut_avx2;
+Processor lut_avx512vbmi;
 
 Processor16 lut16_c_native;
+Processor16 lut16_avx2_native;
 Processor16 lut16_c_stacked;
 
 ProcessorCtx realtime8_c;
@@ -26,31 +33,45 @@ ProcessorCtx realtime32_c;
 
 class Lut : public MaskTools::Filter
 {
-   std::unique_ptr<LutData> luts;
+   std::shared_ptr<LutData> luts;
    int planeMap[4];
+   std::vector<std::unique_ptr<Native>> natives; // by planeMap, null when no kernel matches
 
-   Processor *processor;
-   Processor16 *processor16;
+   // for realtime
+   std::deque<Filtering::Parser::Symbol> *parsed_expressions[4];
+   std::shared_ptr<Parser::ContextPool> contexts[4]; // reused by the realtime processors
+
+   ProcessorList<Processor> processors;
+   ProcessorList<Processor16> processors16;
+   ProcessorCtx *processorCtx;
    int bits_per_pixel;
    bool isStacked;
    bool realtime;
+   bool use_jit;
 
 protected:
     virtual void process(int n, const Plane<Byte> &dst, int nPlane, const ::Filtering::Frame<const Byte> frames[4], const Constraint constraints[4], PNeoEnv env) override
     {
         UNUSED(n);
-        UNUSED(constraints);
         UNUSED(frames);
-        if (::IsCUDA(env)) {
+        if (natives[planeMap[nPlane]] && !::IsCUDA(env)) {
+          natives[planeMap[nPlane]]->process(dst.data(), dst.pitch(), nullptr, 0, dst.width(), dst.height(), dst.origheight(), constraints[nPlane]);
+        }
+        else if (realtime) {
+          // thread safety: a context is used by one thread at a time
+          auto ctx = contexts[nPlane]->acquire();
+          processorCtx(dst.data(), dst.pitch(), dst.width(), dst.height(), *ctx);
+        }
+        else if (::IsCUDA(env)) {
            const uint8_t* const pSrc[1] = { frames[0].plane(nPlane).data() };
            lut_cuda(bits_per_pixel, 1, dst.data(), pSrc, (int)dst.pitch(), dst.width(), dst.height(),
               luts->GetTable(planeMap[nPlane], env), env);
         }
         else if (bits_per_pixel == 8)
-           lut_c(dst.data(), dst.pitch(), dst.width(), dst.height(),
+           processors.best_processor(constraints[nPlane])(dst.data(), dst.pitch(), dst.width(), dst.height(),
             (const uint8_t*)luts->GetTable(planeMap[nPlane], env));
         else if (bits_per_pixel <= 16)
-           lut16_c_native(dst.data(), dst.pitch(), dst.width(), dst.height(),
+           processors16.best_processor(constraints[nPlane])(dst.data(), dst.pitch(), dst.width(), dst.height(),
             (const uint16_t*)luts->GetTable(planeMap[nPlane], env), (1 << bits_per_pixel) - 1);
     }
 
@@ -58,6 +79,7 @@ public:
    Lut(const Parameters &parameters, CpuFlags cpuFlags, PNeoEnv env)
       : MaskTools::Filter( parameters, FilterProcessingType::INPLACE, (CpuFlags)cpuFlags)
    {
+      nStripeHalo = 0;
       static const char *expr_strs[] = { "yExpr", "uExpr", "vExpr", "aExpr" };
 
       Parser::Parser parser = Parser::getDefaultParser().addSymbol(Parser::Symbol::X);
@@ -70,19 +92,47 @@ public:
          return;
       }
 
+      for (int i = 0; i < 4; i++) {
+        parsed_expressions[i] = nullptr;
+      }
+
       realtime = parameters["realtime"].toBool();
 
+      ENGINE engine;
+      if (!EngineFromString(parameters["engine"].toString(), engine)) {
+        error = "invalid engine, use lut, interpreter or jit";
+        return;
+      }
+
+      if (engine == ENGINE_LUT) {
+        if (bits_per_pixel == 32) {
+          error = "lut engine is not available for 32 bit clips";
+          return;
+        }
+        realtime = false;
+      }
+      else if (engine != ENGINE_DEFAULT) {
+        realtime = true;
+      }
+
       if (bits_per_pixel == 32) { // no lookup for float
         realtime = true;
       }
 
-      if (realtime) {
-         error = "realtime is not supported";
-         return;
+      use_jit = realtime && engine != ENGINE_INTERPRETER;
+
+      switch (bits_per_pixel) {
+      case 8: processorCtx = realtime8_c; break;
+      case 10: processorCtx = realtime10_c; break;
+      case 12: processorCtx = realtime12_c; break;
+      case 14: processorCtx = realtime14_c; break;
+      case 16: processorCtx = realtime16_c; break;
+      case 32: processorCtx = realtime32_c; break;
       }
 
       std::vector<std::unique_ptr<Parser::Context>> exprs;
       int firstGeneric = -1;
+      int firstGenericPlane = -1;
 
       /* compute the luts16 */
       for (int i = 0; i < 4; i++)
@@ -103,10 +153,13 @@ public:
         }
         else if (firstGeneric != -1) {
            planeMap[i] = firstGeneric;
+           if (realtime)
+             parsed_expressions[i] = new std::deque<Parser::Symbol>(*parsed_expressions[firstGenericPlane]);
            continue;
         }
         else {
            firstGeneric = (int)exprs.size();
+           firstGenericPlane = i;
            parser.parse(parameters["expr"].toString(), " ");
         }
 
@@ -118,14 +171,46 @@ public:
           error = "invalid expression in the lut";
           return;
         }
+
+        if (realtime) {
+          parsed_expressions[i] = new std::deque<Parser::Symbol>(parser.getExpression());
+        }
+      }
+
+      // invert and binarize have their own kernels, the lut stays for cuda
+      for (auto &expr : exprs) {
+        double threshold = 0;
+        NATIVE kind = engine == ENGINE_DEFAULT ? Native::recognize(*expr, 1, bits_per_pixel, threshold) : NATIVE_NONE;
+        natives.emplace_back(kind != NATIVE_NONE ? new Native(kind, bits_per_pixel, threshold) : nullptr);
+      }
+
+      if (realtime) {
+        for (int i = 0; i < 4; i++) {
+          if (parsed_expressions[i])
+            contexts[i] = Parser::ContextPool::shared(*parsed_expressions[i], bits_per_pixel, use_jit, (flags & CPU_AVX) != 0);
+        }
+      }
+      else {
+        luts = make_lut_data(bits_per_pixel, 1, exprs, env);
+        processors.push_back(Filtering::Processor<Processor>(lut_c, Constraint(CPU_NONE, 1, 1, 1, 1), 0));
+        processors.push_back(Filtering::Processor<Processor>(lut_ssse3, Constraint(CPU_SSSE3, 1, 1, 1, 1), 1));
+        processors.push_back(Filtering::Processor<Processor>(lut_avx2, Constraint(CPU_AVX2, 1, 1, 1, 1), 2));
+        processors.push_back(Filtering::Processor<Processor>(lut_avx512vbmi, Constraint(CPU_AVX512F | CPU_AVX512BW | CPU_AVX512VBMI, 1, 1, 1, 1), 3));
+        processors16.push_back(Filtering::Processor<Processor16>(lut16_c_native, Constraint(CPU_NONE, 1, 1, 1, 1), 0));
+        processors16.push_back(Filtering::Processor<Processor16>(lut16_avx2_native, Constraint(CPU_AVX2, 1, 1, 1, 1), 1));
       }
+   }
 
-      luts = make_lut_data(bits_per_pixel, 1, exprs, env);
+   ~Lut()
+   {
+      for (int i = 0; i < 4; i++) {
+        delete parsed_expressions[i];
+      }
    }
 
    InputConfiguration &input_configuration() const { return InPlaceOneFrame(); }
    InputConfiguration &input_configuration_cuda() const { return OneFrame(); }
-   bool is_cuda_available() { return true; }
+   bool is_cuda_available() { return !realtime; }
 
    static Signature filter_signature()
    {
@@ -142,6 +227,7 @@ public:
 
       signature.add(Parameter(false, "stacked", false));
       signature.add(Parameter(false, "realtime", false));
+      signature.add(Parameter(String(""), "engine", false));
       return signature;
    }
 };
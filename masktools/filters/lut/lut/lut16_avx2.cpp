@@ -0,0 +1,26 @@
+#include "lut.h"
+#include "../../../common/simd.h"
+
+using namespace Filtering;
+
+void Filtering::MaskTools::Filters::Lut::Single::lut16_avx2_native(Byte *pDst, ptrdiff_t nDstPitch, int nWidth, int nHeight, const Word* lut, int mask)
+{
+    const int wMod16 = (nWidth / 16) * 16;
+    auto pDst2 = pDst;
+    auto vMask = _mm256_set1_epi16((short)mask);
+
+    for (int y = 0; y < nHeight; y++) {
+        Word *pDst16 = reinterpret_cast<Word *>(pDst);
+        for (int x = 0; x < wMod16; x += 16) {
+            auto index = _mm256_and_si256(simd256_load_si256<MemoryMode::SSE2_UNALIGNED>(reinterpret_cast<const __m256i*>(pDst16 + x)), vMask);
+            auto index_lo = _mm256_cvtepu16_epi32(_mm256_castsi256_si128(index));
+            auto index_hi = _mm256_cvtepu16_epi32(_mm256_extracti128_si256(index, 1));
+            simd256_store_si256<MemoryMode::SSE2_UNALIGNED>(reinterpret_cast<__m256i*>(pDst16 + x), lut16_gather_avx2(lut, index_lo, index_hi));
+        }
+        pDst += nDstPitch;
+    }
+    if (nWidth > wMod16) {
+        lut16_c_native(pDst2 + wMod16 * sizeof(Word), nDstPitch, nWidth - wMod16, nHeight, lut, mask);
+    }
+    _mm256_zeroupper();
+}
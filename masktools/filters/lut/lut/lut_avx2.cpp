@@ -0,0 +1,27 @@
+#include "lut.h"
+#include "../../../common/simd.h"
+
+using namespace Filtering;
+
+void Filtering::MaskTools::Filters::Lut::Single::lut_avx2(Byte *dstp, ptrdiff_t dst_pitch, int width, int height, const Byte lut[256])
+{
+    __m256i table[16];
+    for (int k = 0; k < 16; k++) {
+        table[k] = _mm256_broadcastsi128_si256(simd_load_si128<MemoryMode::SSE2_UNALIGNED>(lut + k * 16));
+    }
+
+    const int wMod32 = (width / 32) * 32;
+    auto dstp2 = dstp;
+
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < wMod32; x += 32) {
+            auto index = simd256_load_si256<MemoryMode::SSE2_UNALIGNED>(dstp + x);
+            simd256_store_si256<MemoryMode::SSE2_UNALIGNED>(dstp + x, lut8_shuffle_avx2(table, index));
+        }
+        dstp += dst_pitch;
+    }
+    if (width > wMod32) {
+        lut_c(dstp2 + wMod32, dst_pitch, width - wMod32, height, lut);
+    }
+    _mm256_zeroupper();
+}
@@ -0,0 +1,35 @@
+#include "lut.h"
+#include "../../../common/simd.h"
+
+using namespace Filtering;
+
+// the whole table fits in four registers: vpermi2b looks up the 7 low bits of the index
+// in two of them at a time and bit 7 picks which pair
+void Filtering::MaskTools::Filters::Lut::Single::lut_avx512vbmi(Byte *dstp, ptrdiff_t dst_pitch, int width, int height, const Byte lut[256])
+{
+    const auto table0 = simd512_load_si512<MemoryMode::SSE2_UNALIGNED>(lut);
+    const auto table1 = simd512_load_si512<MemoryMode::SSE2_UNALIGNED>(lut + 64);
+    const auto table2 = simd512_load_si512<MemoryMode::SSE2_UNALIGNED>(lut + 128);
+    const auto table3 = simd512_load_si512<MemoryMode::SSE2_UNALIGNED>(lut + 192);
+
+    const int wMod64 = (width / 64) * 64;
+    // masked loads and stores don't touch the bytes past the row end
+    const __mmask64 tail = (width > wMod64) ? ~0ULL >> (64 - (width - wMod64)) : 0;
+
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < wMod64; x += 64) {
+            auto index = simd512_load_si512<MemoryMode::SSE2_UNALIGNED>(dstp + x);
+            auto lo = _mm512_permutex2var_epi8(table0, index, table1);
+            auto hi = _mm512_permutex2var_epi8(table2, index, table3);
+            simd512_store_si512<MemoryMode::SSE2_UNALIGNED>(dstp + x, _mm512_mask_blend_epi8(_mm512_movepi8_mask(index), lo, hi));
+        }
+        if (tail) {
+            auto index = _mm512_maskz_loadu_epi8(tail, dstp + wMod64);
+            auto lo = _mm512_permutex2var_epi8(table0, index, table1);
+            auto hi = _mm512_permutex2var_epi8(table2, index, table3);
+            _mm512_mask_storeu_epi8(dstp + wMod64, tail, _mm512_mask_blend_epi8(_mm512_movepi8_mask(index), lo, hi));
+        }
+        dstp += dst_pitch;
+    }
+    _mm256_zeroupper();
+}
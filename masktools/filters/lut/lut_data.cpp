@@ -1,106 +1,299 @@
 #pragma once
 
 #include "lut_data.h"
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <thread>
 
 namespace Filtering {
 
-template <int bits_per_pixel>
-std::unique_ptr<LutData> make_lut_data(int num_input,
-   const std::vector<std::unique_ptr<Parser::Context>>& exprs, PNeoEnv env)
+// live tables by key, an entry expires with the last filter using it
+static std::mutex lut_cache_mutex;
+static std::map<String, std::weak_ptr<LutData>> lut_cache;
+
+static String lut_cache_key(const char *kind, int bits_per_pixel, int inputs,
+   const std::vector<std::unique_ptr<Parser::Context>>& exprs)
 {
-   int num_planes = (int)exprs.size();
-   int depth = (1 << bits_per_pixel);
-   size_t size_per_plane = (size_t(1) << (bits_per_pixel * num_input));
-   std::vector<uint16_t> data(size_per_plane * num_planes);
-   for (int i = 0; i < num_planes; ++i) {
-      if (exprs[i]) {
-         auto ptr = data.begin() + size_per_plane * i;
-         switch (num_input) {
-         case 1:
-            for (int x = 0; x < depth; ++x) {
-               ptr[x] = exprs[i]->compute_word_x<bits_per_pixel>(x);
-            }
-            break;
-         case 2:
-            for (int x = 0; x < depth; ++x) {
-               for (int y = 0; y < depth; ++y) {
-                  int idx = (x << bits_per_pixel) + y;
-                  ptr[idx] = exprs[i]->compute_word_xy<bits_per_pixel>(x, y);
-               }
-            }
-            break;
-         //case 3:
-         //   for (int x = 0; x < depth; ++x) {
-         //      for (int y = 0; y < depth; ++y) {
-         //         for (int z = 0; z < depth; ++z) {
-         //            int idx = (x << (bits_per_pixel * 2)) + (y << bits_per_pixel) + z;
-         //            ptr[idx] = exprs[i]->compute_word_xyz<bits_per_pixel>(x, y, z);
-         //         }
-         //      }
-         //   }
-         //   break;
+   char buffer[32];
+   snprintf(buffer, sizeof(buffer), "%s %d %d\n", kind, bits_per_pixel, inputs);
+   String key = buffer;
+   for (auto& expr : exprs) {
+      key += expr ? expr->fingerprint(bits_per_pixel) : String("-");
+      key += '\n';
+   }
+   return key;
+}
+
+template <typename Make>
+static std::shared_ptr<LutData> cached_lut_data(const String &key, Make make)
+{
+   {
+      std::lock_guard<std::mutex> lock(lut_cache_mutex);
+      auto it = lut_cache.find(key);
+      if (it != lut_cache.end()) {
+         if (auto lut = it->second.lock()) {
+            return lut;
          }
       }
    }
-   return std::unique_ptr<LutData>(new LutData(data.data(), size_per_plane, sizeof(uint16_t), num_planes, env));
+
+   // built without the lock, tables of other expressions can be computed meanwhile
+   std::shared_ptr<LutData> lut(make());
+
+   std::lock_guard<std::mutex> lock(lut_cache_mutex);
+   for (auto it = lut_cache.begin(); it != lut_cache.end(); ) {
+      if (it->second.expired()) {
+         it = lut_cache.erase(it);
+      }
+      else {
+         ++it;
+      }
+   }
+   // someone else built the same table at the same time: keep a single copy
+   auto& entry = lut_cache[key];
+   if (auto existing = entry.lock()) {
+      return existing;
+   }
+   entry = lut;
+   return lut;
 }
 
-template <>
-std::unique_ptr<LutData> make_lut_data<8>(int num_input,
+std::shared_ptr<LutData> make_lut_data(int bits_per_pixel, int num_input,
    const std::vector<std::unique_ptr<Parser::Context>>& exprs, PNeoEnv env)
 {
-   int num_planes = (int)exprs.size();
-   int depth = (1 << 8);
-   size_t size_per_plane = (size_t(1) << (8 * num_input));
-   std::vector<uint8_t> data(size_per_plane * num_planes);
-   for (int i = 0; i < num_planes; ++i) {
-      auto ptr = data.begin() + size_per_plane * i;
-      switch (num_input) {
-      case 1:
-         for (int x = 0; x < depth; ++x) {
-            ptr[x] = exprs[i]->compute_byte_x(x);
-         }
-         break;
-      case 2:
-         for (int x = 0; x < depth; ++x) {
-            for (int y = 0; y < depth; ++y) {
-               int idx = (x << 8) + y;
-               ptr[idx] = exprs[i]->compute_byte_xy(x, y);
-            }
+   // same layout as a reduced table over the first num_input variables
+   return make_reduced_lut_data(bits_per_pixel, (1 << num_input) - 1, exprs, env);
+}
+
+int lut_input_mask(const std::vector<std::unique_ptr<Parser::Context>>& exprs)
+{
+   int mask = 0;
+   for (auto& expr : exprs) {
+      if (expr) {
+         mask |= expr->variable_mask();
+      }
+   }
+   return mask ? mask : 1;
+}
+
+int lut_input_count(int input_mask)
+{
+   int count = 0;
+   for (int v = 0; v < 4; ++v) {
+      if (input_mask & (1 << v)) {
+         ++count;
+      }
+   }
+   return count;
+}
+
+template <typename pixel_t>
+static MT_FORCEINLINE pixel_t lut_value(double value, int bits_per_pixel)
+{
+   pixel_t result = clip<pixel_t, double>(value);
+   if (sizeof(pixel_t) == 2 && bits_per_pixel != 16) {
+      result = min(result, (pixel_t)((1 << bits_per_pixel) - 1));
+   }
+   return result;
+}
+
+template <>
+MT_FORCEINLINE Float lut_value<Float>(double value, int)
+{
+   return Float(value);
+}
+
+template <typename pixel_t>
+void fill_lut(pixel_t *table, const Parser::Context &expr, int bits_per_pixel, const int *inputs, int num_input)
+{
+   const int depth = 1 << bits_per_pixel;
+   const size_t num_rows = size_t(1) << (bits_per_pixel * (num_input - 1));
+   int num_vars = 0;
+   for (int k = 0; k < num_input; ++k) {
+      num_vars = max(num_vars, inputs[k] + 1);
+   }
+
+   // the last input runs along a row, the others are constant within it
+   auto fill_rows = [&](Parser::Context &ctx, size_t first_row, size_t last_row) {
+      std::vector<double> rows(depth * (num_input + 1), 0.0);
+      std::vector<double> out(depth);
+      const double *zero = &rows[depth * num_input];
+      const double *vars[4] = { zero, zero, zero, zero };
+      for (int k = 0; k < num_input; ++k) {
+         vars[inputs[k]] = &rows[depth * k];
+      }
+      for (int v = 0; v < depth; ++v) {
+         rows[depth * (num_input - 1) + v] = v;
+      }
+
+      for (size_t r = first_row; r < last_row; ++r) {
+         size_t rest = r;
+         for (int k = num_input - 2; k >= 0; --k) {
+            std::fill(rows.begin() + depth * k, rows.begin() + depth * (k + 1), double(rest & (depth - 1)));
+            rest >>= bits_per_pixel;
          }
-         break;
-      case 3:
-         for (int x = 0; x < depth; ++x) {
-            for (int y = 0; y < depth; ++y) {
-               for (int z = 0; z < depth; ++z) {
-                  int idx = (x << (8 * 2)) + (y << 8) + z;
-                  ptr[idx] = exprs[i]->compute_byte_xyz(x, y, z);
-               }
-            }
+         ctx.compute_batch(out.data(), vars, num_vars, depth, bits_per_pixel);
+         pixel_t *ptr = table + (r << bits_per_pixel);
+         for (int v = 0; v < depth; ++v) {
+            ptr[v] = lut_value<pixel_t>(out[v], bits_per_pixel);
          }
-         break;
+      }
+   };
+
+   // slices of about 64K entries, handed out to the workers one at a time
+   const size_t rows_per_slice = max(size_t(1), (size_t(1) << 16) >> bits_per_pixel);
+   const size_t num_slices = (num_rows + rows_per_slice - 1) / rows_per_slice;
+   const size_t num_threads = min(size_t(std::thread::hardware_concurrency()), num_slices);
+
+   if (num_threads <= 1) {
+      Parser::Context ctx(expr);
+      fill_rows(ctx, 0, num_rows);
+      return;
+   }
+
+   std::atomic<size_t> next_slice(0);
+   auto worker = [&]() {
+      Parser::Context ctx(expr); // contexts are not thread safe
+      for (size_t slice = next_slice++; slice < num_slices; slice = next_slice++) {
+         fill_rows(ctx, slice * rows_per_slice, min(num_rows, (slice + 1) * rows_per_slice));
+      }
+   };
+
+   std::vector<std::thread> threads;
+   for (size_t t = 1; t < num_threads; ++t) {
+      threads.emplace_back(worker);
+   }
+   worker();
+   for (auto& thread : threads) {
+      thread.join();
+   }
+}
+
+template void fill_lut<Byte>(Byte *table, const Parser::Context &expr, int bits_per_pixel, const int *inputs, int num_input);
+template void fill_lut<Word>(Word *table, const Parser::Context &expr, int bits_per_pixel, const int *inputs, int num_input);
+template void fill_lut<Float>(Float *table, const Parser::Context &expr, int bits_per_pixel, const int *inputs, int num_input);
+
+template <typename pixel_t>
+void fill_lut_rect(pixel_t *table, Parser::Context &ctx, int bits_per_pixel, int x0, int nx, int y0, int ny)
+{
+   std::vector<double> xs(ny), ys(ny), out(ny);
+   const double *vars[2] = { xs.data(), ys.data() };
+   for (int v = 0; v < ny; ++v) {
+      ys[v] = y0 + v;
+   }
+
+   for (int r = 0; r < nx; ++r) {
+      std::fill(xs.begin(), xs.end(), double(x0 + r));
+      ctx.compute_batch(out.data(), vars, 2, ny, bits_per_pixel);
+      pixel_t *ptr = table + (size_t)r * ny;
+      for (int v = 0; v < ny; ++v) {
+         ptr[v] = lut_value<pixel_t>(out[v], bits_per_pixel);
       }
    }
-   return std::unique_ptr<LutData>(new LutData(data.data(), size_per_plane, sizeof(uint8_t), num_planes, env));
 }
 
-std::unique_ptr<LutData> make_lut_data(int bits_per_pixel, int num_input,
+template void fill_lut_rect<Word>(Word *table, Parser::Context &ctx, int bits_per_pixel, int x0, int nx, int y0, int ny);
+template void fill_lut_rect<Float>(Float *table, Parser::Context &ctx, int bits_per_pixel, int x0, int nx, int y0, int ny);
+
+// the tables of all planes after LutData::padding bytes
+template <typename pixel_t>
+static std::vector<Byte> make_reduced_lut_data_t(int bits_per_pixel, int input_mask,
+   const std::vector<std::unique_ptr<Parser::Context>>& exprs)
+{
+   int inputs[4];
+   int num_input = 0;
+   for (int v = 0; v < 4; ++v) {
+      if (input_mask & (1 << v)) {
+         inputs[num_input++] = v;
+      }
+   }
+
+   int num_planes = (int)exprs.size();
+   size_t size_per_plane = (size_t(1) << (bits_per_pixel * num_input));
+   std::vector<Byte> data(LutData::padding + size_per_plane * num_planes * sizeof(pixel_t));
+   pixel_t *table = reinterpret_cast<pixel_t *>(data.data() + LutData::padding);
+
+   for (int i = 0; i < num_planes; ++i) {
+      if (exprs[i]) {
+         fill_lut(table + size_per_plane * i, *exprs[i], bits_per_pixel, inputs, num_input);
+      }
+   }
+   return data;
+}
+
+std::shared_ptr<LutData> make_reduced_lut_data(int bits_per_pixel, int input_mask,
    const std::vector<std::unique_ptr<Parser::Context>>& exprs, PNeoEnv env)
 {
-   if (bits_per_pixel * num_input > 24) {
-      env->ThrowError("[kmt_lut] %d bit %d input is not supported");
+   if (bits_per_pixel * lut_input_count(input_mask) > 24) {
+      env->ThrowError("[kmt_lut] %d bit %d input is not supported", bits_per_pixel, lut_input_count(input_mask));
    }
 
-   switch (bits_per_pixel) {
-   case 8: return make_lut_data<8>(num_input, exprs, env);
-   case 10: return make_lut_data<10>(num_input, exprs, env);
-   case 12: return make_lut_data<12>(num_input, exprs, env);
-   case 14: return make_lut_data<14>(num_input, exprs, env);
-   case 16: return make_lut_data<16>(num_input, exprs, env);
+   const String key = lut_cache_key("lut", bits_per_pixel, input_mask, exprs);
+   const int element_size = bits_per_pixel == 8 ? 1 : 2;
+   const size_t size_per_plane = size_t(1) << (bits_per_pixel * lut_input_count(input_mask));
+   const int num_planes = (int)exprs.size();
+
+   return cached_lut_data(key, [&]() {
+      // computed by an earlier script load
+      if (auto file = LutFile::open(key, size_per_plane * element_size * num_planes)) {
+         return std::unique_ptr<LutData>(new LutData(std::move(file), size_per_plane, element_size, num_planes));
+      }
+
+      std::vector<Byte> data = bits_per_pixel == 8
+         ? make_reduced_lut_data_t<uint8_t>(bits_per_pixel, input_mask, exprs)
+         : make_reduced_lut_data_t<uint16_t>(bits_per_pixel, input_mask, exprs);
+      LutFile::store(key, data.data() + LutData::padding, data.size() - LutData::padding);
+      return std::unique_ptr<LutData>(new LutData(std::move(data), size_per_plane, element_size, num_planes));
+   });
+}
+
+template <typename pixel_t, int num_input>
+static void reduced_lut_c(Byte *pDst, ptrdiff_t nDstPitch, const Byte *const *pSrc, const ptrdiff_t *nSrcPitch,
+   int nWidth, int nHeight, int bits_per_pixel, const void *lut)
+{
+   const pixel_t max_pixel_value = (pixel_t)((1 << bits_per_pixel) - 1);
+   const pixel_t *table = reinterpret_cast<const pixel_t *>(lut);
+   const Byte *src[num_input];
+   for (int k = 0; k < num_input; ++k) {
+      src[k] = pSrc[k];
    }
 
-   // never come here
-   return std::unique_ptr<LutData>();
+   for (int y = 0; y < nHeight; y++)
+   {
+      for (int x = 0; x < nWidth; x++) {
+         size_t idx = 0;
+         for (int k = 0; k < num_input; ++k) {
+            pixel_t value = reinterpret_cast<const pixel_t *>(src[k])[x];
+            if (sizeof(pixel_t) == 2 && bits_per_pixel != 16) value = min(value, max_pixel_value);
+            idx = (idx << bits_per_pixel) + value;
+         }
+         reinterpret_cast<pixel_t *>(pDst)[x] = table[idx];
+      }
+      pDst += nDstPitch;
+      for (int k = 0; k < num_input; ++k) {
+         src[k] += nSrcPitch[k];
+      }
+   }
+}
+
+ReducedLutProcessor *get_reduced_lut_processor(int bits_per_pixel, int num_input)
+{
+   if (bits_per_pixel == 8) {
+      switch (num_input) {
+      case 1: return &reduced_lut_c<uint8_t, 1>;
+      case 2: return &reduced_lut_c<uint8_t, 2>;
+      case 3: return &reduced_lut_c<uint8_t, 3>;
+      }
+   }
+   else {
+      switch (num_input) {
+      case 1: return &reduced_lut_c<uint16_t, 1>;
+      case 2: return &reduced_lut_c<uint16_t, 2>;
+      }
+   }
+   return nullptr;
 }
 
 } // namespace Filtering
@@ -1,34 +1,103 @@
 #pragma once
 
 #include <memory>
+#include <mutex>
 #include <vector>
 #include <cassert>
 #include "DeviceLocalData.h"
+#include "EnvCommon.h"
+#include "lut_file.h"
 #include "../../../common/parser/parser.h"
 
 namespace Filtering {
 
-class LutData : DeviceLocalBase
+class LutData
 {
+   // copy on the gpu, made the first time a cuda frame needs it
+   class DeviceData : public DeviceLocalBase
+   {
+   public:
+      DeviceData(const void* data, size_t length, PNeoEnv env) : DeviceLocalBase(data, length, env) { }
+      void* GetData(PNeoEnv env) { return GetData_(env); }
+   };
+
    size_t size_per_plane; // num elements
    int element_size;   // in bytes
    int num_planes;
 
+   std::vector<Byte> memory;      // computed tables
+   std::unique_ptr<LutFile> file; // or tables mapped from the disk cache
+   const Byte *host;
+
+   std::mutex device_mutex;
+   std::unique_ptr<DeviceData> device;
+
 public:
-   LutData(void* datq, size_t size_per_plane, int element_size, int num_planes, PNeoEnv env)
-      : DeviceLocalBase(datq, size_per_plane * element_size * num_planes, env)
-      , size_per_plane(size_per_plane)
+   // readable bytes before the first table: lut16_gather_avx2 reads the entry before the one it
+   // looks up. Tables mapped from a file have the file header there
+   static const size_t padding = 16;
+
+   // memory starts with padding bytes, then the tables
+   LutData(std::vector<Byte> &&memory, size_t size_per_plane, int element_size, int num_planes)
+      : size_per_plane(size_per_plane)
+      , element_size(element_size)
+      , num_planes(num_planes)
+      , memory(std::move(memory))
+      , host(this->memory.data() + padding)
+   { }
+
+   LutData(std::unique_ptr<LutFile> &&file, size_t size_per_plane, int element_size, int num_planes)
+      : size_per_plane(size_per_plane)
       , element_size(element_size)
       , num_planes(num_planes)
+      , file(std::move(file))
+      , host((const Byte *)this->file->data())
    { }
 
    const void* GetTable(int plane, PNeoEnv env) {
       assert(plane >= 0 && plane < num_planes);
-      return (uint8_t*)GetData_(env) + size_per_plane * element_size * plane;
+      const size_t offset = size_per_plane * element_size * plane;
+      if (!::IsCUDA(env)) {
+         return host + offset;
+      }
+      std::lock_guard<std::mutex> lock(device_mutex);
+      if (!device) {
+         device.reset(new DeviceData(host, size_per_plane * element_size * num_planes, env));
+      }
+      return (uint8_t*)device->GetData(env) + offset;
    }
 };
 
-std::unique_ptr<LutData> make_lut_data(int bits_per_pixel, int num_input,
+// Fills the table of expr over the listed inputs (0: x .. 3: a), the first one is the most
+// significant part of the index. Values are clipped to the pixel range, Float is not clipped.
+// Rows are computed with the batch evaluator, large tables in parallel slices on all cores.
+template <typename pixel_t>
+void fill_lut(pixel_t *table, const Parser::Context &expr, int bits_per_pixel, const int *inputs, int num_input);
+
+// Fills the nx * ny part of a (x, y) table starting at (x0, y0), rows of y, with ctx on the calling thread
+template <typename pixel_t>
+void fill_lut_rect(pixel_t *table, Parser::Context &ctx, int bits_per_pixel, int x0, int nx, int y0, int ny);
+
+// tables are shared process wide between the filters with the same compiled expressions,
+// bit depth and inputs: a second kmt_lutxy with the same expression gets the first one's table.
+// With MASKTOOLS_LUT_CACHE set they are also kept on disk for the next script loads (lut_file.h)
+std::shared_ptr<LutData> make_lut_data(int bits_per_pixel, int num_input,
    const std::vector<std::unique_ptr<Parser::Context>>& exprs, PNeoEnv env);
 
+// union of the input variables referenced by the expressions (bit 0: x .. bit 3: a),
+// at least x so that constant expressions still get a one dimensional table
+int lut_input_mask(const std::vector<std::unique_ptr<Parser::Context>>& exprs);
+int lut_input_count(int input_mask);
+
+// table over the referenced inputs only, in x, y, z, a order: a lutxyz expression
+// of x and z gets the same 2D layout as a lutxy one
+std::shared_ptr<LutData> make_reduced_lut_data(int bits_per_pixel, int input_mask,
+   const std::vector<std::unique_ptr<Parser::Context>>& exprs, PNeoEnv env);
+
+// lookup in a reduced table, pSrc holds the planes of the referenced inputs and may contain pDst
+typedef void(ReducedLutProcessor)(Byte *pDst, ptrdiff_t nDstPitch, const Byte *const *pSrc, const ptrdiff_t *nSrcPitch,
+   int nWidth, int nHeight, int bits_per_pixel, const void *lut);
+
+ReducedLutProcessor *get_reduced_lut_processor(int bits_per_pixel, int num_input);
+
 } // namespace Filtering
@@ -0,0 +1,204 @@
+#include "lut_file.h"
+#include <atomic>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <process.h>
+#else
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Filtering {
+
+// file layout: header, key, padding up to a page, table
+static const char lut_file_magic[8] = { 'M', 'T', 'L', 'U', 'T', 0, 0, 1 };
+static const size_t lut_file_alignment = 4096;
+
+struct LutFileHeader {
+   char magic[8];
+   Uint64 key_size;
+   Uint64 data_size;
+};
+
+static const char *cache_directory()
+{
+   static const char *directory = getenv("MASKTOOLS_LUT_CACHE");
+   return directory != NULL && *directory != '\0' ? directory : NULL;
+}
+
+// function pointers in the fingerprints are offsets in the binary:
+// tables written by another build are never picked up
+static String module_stamp()
+{
+   char buffer[64];
+#ifdef _WIN32
+   HMODULE module = NULL;
+   if (!GetModuleHandleExA(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS | GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT,
+      (LPCSTR)&module_stamp, &module)) {
+      return String();
+   }
+   const IMAGE_DOS_HEADER *dos = (const IMAGE_DOS_HEADER *)module;
+   const IMAGE_NT_HEADERS *nt = (const IMAGE_NT_HEADERS *)((const Byte *)module + dos->e_lfanew);
+   snprintf(buffer, sizeof(buffer), "%08lx %08lx", (unsigned long)nt->FileHeader.TimeDateStamp, (unsigned long)nt->OptionalHeader.SizeOfImage);
+#else
+   Dl_info info;
+   struct stat st;
+   if (!dladdr((void *)&module_stamp, &info) || info.dli_fname == NULL || stat(info.dli_fname, &st) != 0) {
+      return String();
+   }
+   snprintf(buffer, sizeof(buffer), "%llx %llx", (unsigned long long)st.st_mtime, (unsigned long long)st.st_size);
+#endif
+   return buffer;
+}
+
+static bool file_key(const String &key, String &full_key, String &path)
+{
+   const char *directory = cache_directory();
+   if (directory == NULL) {
+      return false;
+   }
+   static const String stamp = module_stamp();
+   if (stamp.empty()) {
+      return false;
+   }
+   full_key = stamp + '\n' + key;
+
+   // FNV-1a
+   Uint64 hash = 14695981039346656037ULL;
+   for (size_t i = 0; i < full_key.size(); ++i) {
+      hash = (hash ^ (Byte)full_key[i]) * 1099511628211ULL;
+   }
+
+   char name[32];
+   snprintf(name, sizeof(name), "%016llx.mtlut", hash);
+   path = directory;
+   if (path.back() != '/' && path.back() != '\\') {
+      path += '/';
+   }
+   path += name;
+   return true;
+}
+
+static size_t table_offset(size_t key_size)
+{
+   return (sizeof(LutFileHeader) + key_size + lut_file_alignment - 1) / lut_file_alignment * lut_file_alignment;
+}
+
+LutFile::~LutFile()
+{
+#ifdef _WIN32
+   UNUSED(view_size);
+   UnmapViewOfFile(view);
+#else
+   munmap((void *)view, view_size);
+#endif
+}
+
+std::unique_ptr<LutFile> LutFile::open(const String &key, size_t data_size)
+{
+   String full_key, path;
+   if (!file_key(key, full_key, path)) {
+      return nullptr;
+   }
+
+   const size_t offset = table_offset(full_key.size());
+   const size_t view_size = offset + data_size;
+   const Byte *view = NULL;
+
+#ifdef _WIN32
+   HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+   if (file == INVALID_HANDLE_VALUE) {
+      return nullptr;
+   }
+   LARGE_INTEGER file_size;
+   if (GetFileSizeEx(file, &file_size) && (Uint64)file_size.QuadPart == view_size) {
+      // the view keeps the mapping alive once the handles are closed
+      HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+      if (mapping != NULL) {
+         view = (const Byte *)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+         CloseHandle(mapping);
+      }
+   }
+   CloseHandle(file);
+#else
+   int fd = ::open(path.c_str(), O_RDONLY);
+   if (fd < 0) {
+      return nullptr;
+   }
+   struct stat st;
+   if (fstat(fd, &st) == 0 && (Uint64)st.st_size == view_size) {
+      void *p = mmap(NULL, view_size, PROT_READ, MAP_SHARED, fd, 0);
+      view = p == MAP_FAILED ? NULL : (const Byte *)p;
+   }
+   close(fd);
+#endif
+
+   if (view == NULL) {
+      return nullptr;
+   }
+
+   std::unique_ptr<LutFile> lut(new LutFile(view, view_size, offset));
+
+   const LutFileHeader *header = (const LutFileHeader *)view;
+   if (memcmp(header->magic, lut_file_magic, sizeof(lut_file_magic)) != 0
+      || header->key_size != full_key.size() || header->data_size != data_size
+      || memcmp(view + sizeof(LutFileHeader), full_key.data(), full_key.size()) != 0) {
+      return nullptr;
+   }
+   return lut;
+}
+
+void LutFile::store(const String &key, const void *data, size_t data_size)
+{
+   String full_key, path;
+   if (!file_key(key, full_key, path)) {
+      return;
+   }
+
+   // written aside and renamed: readers see either no file or a complete one
+   static std::atomic<unsigned> counter(0);
+   char suffix[48];
+#ifdef _WIN32
+   snprintf(suffix, sizeof(suffix), ".%d.%u.tmp", _getpid(), counter++);
+#else
+   snprintf(suffix, sizeof(suffix), ".%d.%u.tmp", (int)getpid(), counter++);
+#endif
+   const String temp = path + suffix;
+
+   FILE *file = fopen(temp.c_str(), "wb");
+   if (file == NULL) {
+      return;
+   }
+
+   LutFileHeader header;
+   memcpy(header.magic, lut_file_magic, sizeof(lut_file_magic));
+   header.key_size = full_key.size();
+   header.data_size = data_size;
+
+   const size_t padding = table_offset(full_key.size()) - sizeof(header) - full_key.size();
+   const std::vector<Byte> zeros(padding, 0);
+
+   bool ok = fwrite(&header, sizeof(header), 1, file) == 1
+      && fwrite(full_key.data(), 1, full_key.size(), file) == full_key.size()
+      && fwrite(zeros.data(), 1, padding, file) == padding
+      && fwrite(data, 1, data_size, file) == data_size;
+   ok = fclose(file) == 0 && ok;
+
+#ifdef _WIN32
+   // fails while another process has the old file mapped, it stays in use then
+   ok = ok && MoveFileExA(temp.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING);
+#else
+   ok = ok && rename(temp.c_str(), path.c_str()) == 0;
+#endif
+   if (!ok) {
+      remove(temp.c_str());
+   }
+}
+
+} // namespace Filtering
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <memory>
+#include "../../../common/utils/utils.h"
+
+namespace Filtering {
+
+// Table stored in the directory named by MASKTOOLS_LUT_CACHE, mapped read only.
+// The pages are shared with the other processes mapping the same file, a script loading
+// the same expressions again maps the tables instead of computing them.
+// Files are named by a hash of the table key (the compiled expressions, bit depth and
+// inputs) and of the plugin binary, and hold the whole key to rule out collisions.
+class LutFile
+{
+   const Byte *view;
+   size_t view_size;
+   size_t data_offset;
+
+   LutFile(const Byte *view, size_t view_size, size_t data_offset)
+      : view(view), view_size(view_size), data_offset(data_offset) { }
+
+public:
+   ~LutFile();
+
+   const void *data() const { return view + data_offset; }
+
+   // nullptr when the cache is disabled or has no valid table of data_size bytes for key
+   static std::unique_ptr<LutFile> open(const String &key, size_t data_size);
+
+   // best effort, a table that can't be written is computed again next time
+   static void store(const String &key, const void *data, size_t data_size);
+};
+
+} // namespace Filtering
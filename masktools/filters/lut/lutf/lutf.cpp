@@ -1,27 +1,14 @@
 #include "lutf.h"
 #include "../functions.h"
+#include "../neighbourhood.h"
 
 using namespace Filtering;
 
-template<bool realtime, class T>
-static void frame_c(Byte *dstp, ptrdiff_t dst_pitch, const Byte *srcp, ptrdiff_t src_pitch, const Byte *lutp, Parser::Context *ctx, int width, int height)
+// lutf: treat it as if the first frame was constant, result of avg/min/max, etc...
+template<bool realtime>
+static void frame_lut_c(Byte *dstp, ptrdiff_t dst_pitch, const Byte *srcp, ptrdiff_t src_pitch, const Byte *lutp, Parser::Context *ctx, int width, int height, Byte X)
 {
-    T processor("");
-
-    processor.reset();
-
-    for (int j = 0; j < height; j++) {
-        for (int i = 0; i < width; i++) {
-            processor.add(dstp[i]);
-        }
-        dstp += dst_pitch;
-    }
-
-    dstp -= dst_pitch * height;
-
-    // lutf: treat it as if the first frame was constant, result of avg/min/max, etc...
     if (realtime) {
-      const Byte X = processor.finalize();
       // no 2D lut needed, X is constant
       // speedwise (expr = "x ymin - ymax ymin - / range_max *")
       // real lut: 180fps, 
@@ -39,7 +26,7 @@ static void frame_c(Byte *dstp, ptrdiff_t dst_pitch, const Byte *srcp, ptrdiff_t
       }
     }
     else {
-      const Byte *lut = lutp + (processor.finalize() << 8);
+      const Byte *lut = lutp + (X << 8);
 
       for (int j = 0; j < height; j++) {
         for (int i = 0; i < width; i++) {
@@ -51,30 +38,41 @@ static void frame_c(Byte *dstp, ptrdiff_t dst_pitch, const Byte *srcp, ptrdiff_t
     }
 }
 
-template<bool realtime, int bits_per_pixel, class T>
-static void frame16_c(Word *dstp, ptrdiff_t dst_pitch, const Word *srcp, ptrdiff_t src_pitch, const Word *lutp, Parser::Context *ctx, int width, int height)
+template<bool realtime, class T>
+static void frame_c(Byte *dstp, ptrdiff_t dst_pitch, const Byte *srcp, ptrdiff_t src_pitch, const Byte *lutp, Parser::Context *ctx, int width, int height)
 {
-  dst_pitch /= sizeof(uint16_t);
-  src_pitch /= sizeof(uint16_t);
-
-  T processor("");
+    T processor("");
 
-  processor.reset();
+    processor.reset();
 
-  for (int j = 0; j < height; j++) {
-    for (int i = 0; i < width; i++) {
-      processor.add(dstp[i]);
+    for (int j = 0; j < height; j++) {
+        for (int i = 0; i < width; i++) {
+            processor.add(dstp[i]);
+        }
+        dstp += dst_pitch;
     }
-    dstp += dst_pitch;
-  }
 
-  dstp -= dst_pitch * height;
+    dstp -= dst_pitch * height;
+
+    frame_lut_c<realtime>(dstp, dst_pitch, srcp, src_pitch, lutp, ctx, width, height, processor.finalize());
+}
+
+// the first frame reduced a vector of pixels at a time
+template<bool realtime, int nMode, MaskTools::Filters::Lut::NeighbourhoodPlane *reduce>
+static void frame_network_c(Byte *dstp, ptrdiff_t dst_pitch, const Byte *srcp, ptrdiff_t src_pitch, const Byte *lutp, Parser::Context *ctx, int width, int height)
+{
+    const Byte X = reduce(dstp, dst_pitch, width, height, nMode, 8);
+    frame_lut_c<realtime>(dstp, dst_pitch, srcp, src_pitch, lutp, ctx, width, height, X);
+}
 
+// pitches in pixels
+template<bool realtime, int bits_per_pixel>
+static void frame16_lut_c(Word *dstp, ptrdiff_t dst_pitch, const Word *srcp, ptrdiff_t src_pitch, const Word *lutp, Parser::Context *ctx, int width, int height, Word X)
+{
   const Word max_pixel_value = (1 << bits_per_pixel) - 1;
 
   // lutf: treat it as if the first frame was constant, result of avg/min/max, etc...
   if (realtime) {
-    const Word X = processor.finalize();
     // no 2D lut needed, X is constant
     // speedwise (expr = "x ymin - ymax ymin - / range_max *")
     // real lut: 180fps, 
@@ -96,7 +94,7 @@ static void frame16_c(Word *dstp, ptrdiff_t dst_pitch, const Word *srcp, ptrdiff
     }
   }
   else {
-    const Word *lut = lutp + (min(processor.finalize(),max_pixel_value) << bits_per_pixel);
+    const Word *lut = lutp + (min(X,max_pixel_value) << bits_per_pixel);
 
     for (int j = 0; j < height; j++) {
       for (int i = 0; i < width; i++) {
@@ -108,12 +106,61 @@ static void frame16_c(Word *dstp, ptrdiff_t dst_pitch, const Word *srcp, ptrdiff
   }
 }
 
+template<bool realtime, int bits_per_pixel, class T>
+static void frame16_c(Word *dstp, ptrdiff_t dst_pitch, const Word *srcp, ptrdiff_t src_pitch, const Word *lutp, Parser::Context *ctx, int width, int height)
+{
+  dst_pitch /= sizeof(uint16_t);
+  src_pitch /= sizeof(uint16_t);
+
+  T processor("");
 
-template<class T>
-static void frame32_c(Float *dstp, ptrdiff_t dst_pitch, const Float *srcp, ptrdiff_t src_pitch, Parser::Context *ctx, int width, int height)
+  processor.reset();
+
+  for (int j = 0; j < height; j++) {
+    for (int i = 0; i < width; i++) {
+      processor.add(dstp[i]);
+    }
+    dstp += dst_pitch;
+  }
+
+  dstp -= dst_pitch * height;
+
+  frame16_lut_c<realtime, bits_per_pixel>(dstp, dst_pitch, srcp, src_pitch, lutp, ctx, width, height, processor.finalize());
+}
+
+template<bool realtime, int bits_per_pixel, int nMode, MaskTools::Filters::Lut::NeighbourhoodPlane16 *reduce>
+static void frame16_network_c(Word *dstp, ptrdiff_t dst_pitch, const Word *srcp, ptrdiff_t src_pitch, const Word *lutp, Parser::Context *ctx, int width, int height)
 {
-  dst_pitch /= sizeof(Float);
-  src_pitch /= sizeof(Float);
+  dst_pitch /= sizeof(uint16_t);
+  src_pitch /= sizeof(uint16_t);
+
+  const Word X = reduce(dstp, dst_pitch, width, height, nMode, bits_per_pixel);
+  frame16_lut_c<realtime, bits_per_pixel>(dstp, dst_pitch, srcp, src_pitch, lutp, ctx, width, height, X);
+}
+
+// pitches in pixels
+template<int bits_per_pixel>
+static void frame16_tiled_lut_c(Word *dstp, ptrdiff_t dst_pitch, const Word *srcp, ptrdiff_t src_pitch, TiledLut<Word> *lutp, int width, int height, Word X)
+{
+  const Word max_pixel_value = (1 << bits_per_pixel) - 1;
+
+  // only the row of X is needed
+  const Word *lut = lutp->row(min(X, max_pixel_value));
+
+  for (int j = 0; j < height; j++) {
+    for (int i = 0; i < width; i++) {
+      dstp[i] = bits_per_pixel == 16 ? lut[srcp[i]] : lut[srcp[i] > max_pixel_value ? max_pixel_value : srcp[i]];
+    }
+    srcp += src_pitch;
+    dstp += dst_pitch;
+  }
+}
+
+template<int bits_per_pixel, class T>
+static void frame16_tiled_c(Word *dstp, ptrdiff_t dst_pitch, const Word *srcp, ptrdiff_t src_pitch, TiledLut<Word> *lutp, int width, int height)
+{
+  dst_pitch /= sizeof(uint16_t);
+  src_pitch /= sizeof(uint16_t);
 
   T processor("");
 
@@ -128,9 +175,22 @@ static void frame32_c(Float *dstp, ptrdiff_t dst_pitch, const Float *srcp, ptrdi
 
   dstp -= dst_pitch * height;
 
-  // lutf: treat it as if the first frame was constant, result of avg/min/max, etc...
-  const Float X = processor.finalize();
+  frame16_tiled_lut_c<bits_per_pixel>(dstp, dst_pitch, srcp, src_pitch, lutp, width, height, processor.finalize());
+}
+
+template<int bits_per_pixel, int nMode, MaskTools::Filters::Lut::NeighbourhoodPlane16 *reduce>
+static void frame16_tiled_network_c(Word *dstp, ptrdiff_t dst_pitch, const Word *srcp, ptrdiff_t src_pitch, TiledLut<Word> *lutp, int width, int height)
+{
+  dst_pitch /= sizeof(uint16_t);
+  src_pitch /= sizeof(uint16_t);
+
+  const Word X = reduce(dstp, dst_pitch, width, height, nMode, bits_per_pixel);
+  frame16_tiled_lut_c<bits_per_pixel>(dstp, dst_pitch, srcp, src_pitch, lutp, width, height, X);
+}
 
+// pitches in pixels
+static void frame32_lut_c(Float *dstp, ptrdiff_t dst_pitch, const Float *srcp, ptrdiff_t src_pitch, Parser::Context *ctx, int width, int height, Float X)
+{
   // always full realtime
   for (int j = 0; j < height; j++) {
     for (int i = 0; i < width; i++) {
@@ -141,6 +201,47 @@ static void frame32_c(Float *dstp, ptrdiff_t dst_pitch, const Float *srcp, ptrdi
   }
 }
 
+template<class T>
+static void frame32_c(Float *dstp, ptrdiff_t dst_pitch, const Float *srcp, ptrdiff_t src_pitch, Parser::Context *ctx, int width, int height)
+{
+  dst_pitch /= sizeof(Float);
+  src_pitch /= sizeof(Float);
+
+  T processor("");
+
+  processor.reset();
+
+  for (int j = 0; j < height; j++) {
+    for (int i = 0; i < width; i++) {
+      processor.add(dstp[i]);
+    }
+    dstp += dst_pitch;
+  }
+
+  dstp -= dst_pitch * height;
+
+  // lutf: treat it as if the first frame was constant, result of avg/min/max, etc...
+  frame32_lut_c(dstp, dst_pitch, srcp, src_pitch, ctx, width, height, processor.finalize());
+}
+
+template<int nMode, MaskTools::Filters::Lut::NeighbourhoodPlane32 *reduce>
+static void frame32_network_c(Float *dstp, ptrdiff_t dst_pitch, const Float *srcp, ptrdiff_t src_pitch, Parser::Context *ctx, int width, int height)
+{
+  dst_pitch /= sizeof(Float);
+  src_pitch /= sizeof(Float);
+
+  const Float X = reduce(dstp, dst_pitch, width, height, nMode, 32);
+  frame32_lut_c(dstp, dst_pitch, srcp, src_pitch, ctx, width, height, X);
+}
+
+// the vector modes, in the order of the modes: none, average, min, max, std, range
+#define NETWORK_MODES(base, reduce, ...) \
+{ nullptr, &base< __VA_ARGS__ AVERAGER, reduce >, &base< __VA_ARGS__ MINIMIZER, reduce >, &base< __VA_ARGS__ MAXIMIZER, reduce >, \
+  &base< __VA_ARGS__ DEVIATER, reduce >, &base< __VA_ARGS__ RANGIZER, reduce >, nullptr, nullptr, nullptr, nullptr }
+// float: min, max and range only
+#define NETWORK_MODES32(base, reduce) \
+{ nullptr, nullptr, &base< MINIMIZER, reduce >, &base< MAXIMIZER, reduce >, nullptr, &base< RANGIZER, reduce >, nullptr, nullptr, nullptr, nullptr }
+
 namespace Filtering { namespace MaskTools { namespace Filters { namespace Lut { namespace Frame {
 
 Processor *processors_array[NUM_MODES] = MPROCESSOR_SINGLE(frame_c, false);
@@ -151,12 +252,26 @@ Processor16 *processors10_array[NUM_MODES] = MPROCESSOR16_SINGLE(frame16_c, fals
 Processor16 *processors10Ctx_array[NUM_MODES] = MPROCESSOR16_SINGLE(frame16_c, true, 10);
 Processor16 *processors12_array[NUM_MODES] = MPROCESSOR16_SINGLE(frame16_c, false, 12);
 Processor16 *processors12Ctx_array[NUM_MODES] = MPROCESSOR16_SINGLE(frame16_c, true, 12);
-Processor16 *processors14_array[NUM_MODES] = MPROCESSOR16_SINGLE(frame16_c, false, 14);
+ProcessorTiled *processors14Tiled_array[NUM_MODES] = MPROCESSOR16_TILED(frame16_tiled_c, 14);
 Processor16 *processors14Ctx_array[NUM_MODES] = MPROCESSOR16_SINGLE(frame16_c, true, 14);
-Processor16 *processors16_array[NUM_MODES] = MPROCESSOR16_SINGLE(frame16_c, false, 16);
+ProcessorTiled *processors16Tiled_array[NUM_MODES] = MPROCESSOR16_TILED(frame16_tiled_c, 16);
 Processor16 *processors16Ctx_array[NUM_MODES] = MPROCESSOR16_SINGLE(frame16_c, true, 16);
 
 Processor32 *processors32Ctx_array[NUM_MODES] = MPROCESSOR32_SINGLE(frame32_c);
 
+Processor *network_array[2][NUM_MODES] = { NETWORK_MODES(frame_network_c, network_plane_sse2, false,), NETWORK_MODES(frame_network_c, network_plane_avx2, false,) };
+Processor *networkCtx_array[2][NUM_MODES] = { NETWORK_MODES(frame_network_c, network_plane_sse2, true,), NETWORK_MODES(frame_network_c, network_plane_avx2, true,) };
+
+Processor16 *network10_array[2][NUM_MODES] = { NETWORK_MODES(frame16_network_c, network_plane_sse4_16, false, 10,), NETWORK_MODES(frame16_network_c, network_plane_avx2_16, false, 10,) };
+Processor16 *network10Ctx_array[2][NUM_MODES] = { NETWORK_MODES(frame16_network_c, network_plane_sse4_16, true, 10,), NETWORK_MODES(frame16_network_c, network_plane_avx2_16, true, 10,) };
+Processor16 *network12_array[2][NUM_MODES] = { NETWORK_MODES(frame16_network_c, network_plane_sse4_16, false, 12,), NETWORK_MODES(frame16_network_c, network_plane_avx2_16, false, 12,) };
+Processor16 *network12Ctx_array[2][NUM_MODES] = { NETWORK_MODES(frame16_network_c, network_plane_sse4_16, true, 12,), NETWORK_MODES(frame16_network_c, network_plane_avx2_16, true, 12,) };
+ProcessorTiled *network14Tiled_array[2][NUM_MODES] = { NETWORK_MODES(frame16_tiled_network_c, network_plane_sse4_16, 14,), NETWORK_MODES(frame16_tiled_network_c, network_plane_avx2_16, 14,) };
+Processor16 *network14Ctx_array[2][NUM_MODES] = { NETWORK_MODES(frame16_network_c, network_plane_sse4_16, true, 14,), NETWORK_MODES(frame16_network_c, network_plane_avx2_16, true, 14,) };
+ProcessorTiled *network16Tiled_array[2][NUM_MODES] = { NETWORK_MODES(frame16_tiled_network_c, network_plane_sse4_16, 16,), NETWORK_MODES(frame16_tiled_network_c, network_plane_avx2_16, 16,) };
+Processor16 *network16Ctx_array[2][NUM_MODES] = { NETWORK_MODES(frame16_network_c, network_plane_sse4_16, true, 16,), NETWORK_MODES(frame16_network_c, network_plane_avx2_16, true, 16,) };
+
+Processor32 *network32Ctx_array[2][NUM_MODES] = { NETWORK_MODES32(frame32_network_c, network_plane32_sse2), NETWORK_MODES32(frame32_network_c, network_plane32_avx2) };
+
 } } } } }
 
@@ -3,14 +3,19 @@
 
 #include "../../../common/base/filter.h"
 #include "../../../../common/parser/parser.h"
+#include "../../../../common/parser/context_pool.h"
+#include "../lut_data.h"
+#include "../tiled_lut.h"
 
 #include "../functions.h"
+#include "../neighbourhood.h"
 
 namespace Filtering { namespace MaskTools { namespace Filters { namespace Lut { namespace Frame {
 
 typedef void(Processor)(Byte *pDst, ptrdiff_t nDstPitch, const Byte *pSrc, ptrdiff_t nSrcPitch, const Byte lut[65536], Parser::Context *ctx, int nWidth, int nHeight); // common lut/realtime, templatized
 typedef void(Processor16)(Word *pDst, ptrdiff_t nDstPitch, const Word *pSrc, ptrdiff_t nSrcPitch, const Word *lut, Parser::Context *ctx, int nWidth, int nHeight); // common lut/realtime, templatized
 typedef void(Processor32)(Float *pDst, ptrdiff_t nDstPitch, const Float *pSrc, ptrdiff_t nSrcPitch, Parser::Context *ctx, int nWidth, int nHeight); // realtime only
+typedef void(ProcessorTiled)(Word *pDst, ptrdiff_t nDstPitch, const Word *pSrc, ptrdiff_t nSrcPitch, TiledLut<Word> *lut, int nWidth, int nHeight); // 14-16 bit lut
 
 extern Processor *processors_array[NUM_MODES];
 extern Processor *processorsCtx_array[NUM_MODES];
@@ -19,11 +24,24 @@ extern Processor16 *processors10_array[NUM_MODES];
 extern Processor16 *processors10Ctx_array[NUM_MODES];
 extern Processor16 *processors12_array[NUM_MODES];
 extern Processor16 *processors12Ctx_array[NUM_MODES];
-extern Processor16 *processors14_array[NUM_MODES];
 extern Processor16 *processors14Ctx_array[NUM_MODES];
-extern Processor16 *processors16_array[NUM_MODES];
 extern Processor16 *processors16Ctx_array[NUM_MODES];
 extern Processor32 *processors32Ctx_array[NUM_MODES];
+extern ProcessorTiled *processors14Tiled_array[NUM_MODES];
+extern ProcessorTiled *processors16Tiled_array[NUM_MODES];
+// the first frame reduced by vectors in the average, min, max, std and range modes (float: min, max
+// and range), nullptr in the others: sse2 (sse4.1 at 10-16 bit), avx2
+extern Processor *network_array[2][NUM_MODES];
+extern Processor *networkCtx_array[2][NUM_MODES];
+extern Processor16 *network10_array[2][NUM_MODES];
+extern Processor16 *network10Ctx_array[2][NUM_MODES];
+extern Processor16 *network12_array[2][NUM_MODES];
+extern Processor16 *network12Ctx_array[2][NUM_MODES];
+extern Processor16 *network14Ctx_array[2][NUM_MODES];
+extern Processor16 *network16Ctx_array[2][NUM_MODES];
+extern Processor32 *network32Ctx_array[2][NUM_MODES];
+extern ProcessorTiled *network14Tiled_array[2][NUM_MODES];
+extern ProcessorTiled *network16Tiled_array[2][NUM_MODES];
 
 class Lutf : public MaskTools::Filter
 {
@@ -35,52 +53,35 @@ class Lutf : public MaskTools::Filter
 
   Lut luts[4+1]; // max plane count + 1
 
+  // 14-16 bit: one row of the lut per frame, computed when first needed
+  std::shared_ptr<TiledLut<Word>> tiled_luts[4+1];
+
   static Byte *calculateLut(const std::deque<Filtering::Parser::Symbol> &expr, int bits_per_pixel) {
     Parser::Context ctx(expr);
     int pixelsize = bits_per_pixel == 8 ? 1 : 2; // byte / uint16_t
     size_t buffer_size = ((size_t)1 << bits_per_pixel) * ((size_t)1 << bits_per_pixel) *pixelsize;
     Byte *lut = new Byte[buffer_size];
 
-    switch (bits_per_pixel) {
-    case 8:
-      for (int x = 0; x < 256; x++)
-        for (int y = 0; y < 256; y++)
-          lut[(x << 8) + y] = ctx.compute_byte_xy(x, y);
-      break;
-    case 10:
-      for (int x = 0; x < 1024; x++)
-        for (int y = 0; y < 1024; y++)
-          reinterpret_cast<Word *>(lut)[(x << 10) + y] = ctx.compute_word_xy<10>(x, y);
-      break;
-    case 12:
-      for (int x = 0; x < 4096; x++)
-        for (int y = 0; y < 4096; y++)
-          reinterpret_cast<Word *>(lut)[(x << 12) + y] = ctx.compute_word_xy<12>(x, y);
-      break;
-    case 14:
-      for (int x = 0; x < 16384; x++)
-        for (int y = 0; y < 16384; y++)
-          reinterpret_cast<Word *>(lut)[(x << 14) + y] = ctx.compute_word_xy<14>(x, y);
-      break;
-    case 16:
-      // 64bit only
-      for (int x = 0; x < 65536; x++)
-        for (int y = 0; y < 65536; y++)
-          reinterpret_cast<Word *>(lut)[((size_t)x << 16) + y] = ctx.compute_word_xy<16>(x, y);
-      break;
-    }
+    static const int inputs[2] = { 0, 1 }; // (x << bits_per_pixel) + y
+    if (bits_per_pixel == 8)
+      fill_lut(lut, ctx, bits_per_pixel, inputs, 2);
+    else
+      fill_lut(reinterpret_cast<Word *>(lut), ctx, bits_per_pixel, inputs, 2);
     return lut;
   }
 
   // for realtime
   std::deque<Filtering::Parser::Symbol> *parsed_expressions[4];
+  std::shared_ptr<Parser::ContextPool> contexts[4]; // reused by the realtime processors
 
   ProcessorList<Processor> processors;
   ProcessorList<Processor16> processors16;
   ProcessorList<Processor32> processors32;
+  ProcessorList<ProcessorTiled> processorsTiled;
 
   int bits_per_pixel;
   bool realtime;
+  bool tiled;
 
 protected:
     virtual void process(int n, const Plane<Byte> &dst, int nPlane, const Filtering::Frame<const Byte> frames[4], const Constraint constraints[4], PNeoEnv env) override
@@ -88,20 +89,26 @@ protected:
         UNUSED(n); UNUSED(env);
         
         if (realtime) {
-          // thread safety
-          Parser::Context ctx(*parsed_expressions[nPlane]);
+          // thread safety: a context is used by one thread at a time
+          auto ctx = contexts[nPlane]->acquire();
           if (bits_per_pixel == 8)
             processors.best_processor(constraints[nPlane])(dst.data(), dst.pitch(),
               frames[0].plane(nPlane).data(), frames[0].plane(nPlane).pitch(),
-              nullptr, &ctx, dst.width(), dst.height());
+              nullptr, ctx.get(), dst.width(), dst.height());
           else if (bits_per_pixel <= 16)
             processors16.best_processor(constraints[nPlane])((Word *)dst.data(), dst.pitch(),
               (Word *)frames[0].plane(nPlane).data(), frames[0].plane(nPlane).pitch(),
-              nullptr, &ctx, dst.width(), dst.height());
+              nullptr, ctx.get(), dst.width(), dst.height());
           else
             processors32.best_processor(constraints[nPlane])((Float *)dst.data(), dst.pitch(),
               (Float *)frames[0].plane(nPlane).data(), frames[0].plane(nPlane).pitch(),
-              &ctx, dst.width(), dst.height());
+              ctx.get(), dst.width(), dst.height());
+        }
+        else if (tiled) {
+          auto reader = tiled_luts[nPlane]->read();
+          processorsTiled.best_processor(constraints[nPlane])((Word *)dst.data(), dst.pitch(),
+            (Word *)frames[0].plane(nPlane).data(), frames[0].plane(nPlane).pitch(),
+            tiled_luts[nPlane].get(), dst.width(), dst.height());
         }
         else {
           // lut
@@ -138,26 +145,18 @@ public:
       bits_per_pixel = bit_depths[C];
       realtime = parameters["realtime"].toBool();
 
-      // 14, 16 bit and float: default realtime, 
-      // hardcore users on x64 with 8GB memory and plenty of time can override 16 bit lutxy with realtime=false :)
       // lut sizes
       // 10 bits: 2 MBytes (2*1024*1024) per expression 
       // 12 bits: 32 MBytes (2*4096*4096) per expression 
       // 14 bits: 512 MBytes (2*16384*16384) per expression 
       // 16 bits: 8 GBytes (2*65536*65536) per expression 
-      if (bits_per_pixel >= 14 && !parameters["realtime"].is_defined()) {
-        realtime = true;
-      }
+      // 14 and 16 bits: tiled lut, only the rows of the x values met are computed
+      // float: always realtime
+      tiled = bits_per_pixel == 14 || bits_per_pixel == 16;
 
       if (bits_per_pixel == 32)
         realtime = true;
 
-      if (bits_per_pixel == 16) {
-        if ((uint64_t)std::numeric_limits<size_t>::max() <= 0xFFFFFFFFull && bits_per_pixel == 16) {
-          realtime = true; // not even possible a real 16 bit lutxy on 32 bit environment
-        }
-      }
-
       /* compute the luts */
       for ( int i = 0; i < 4; i++ )
       {
@@ -195,6 +194,18 @@ public:
 
           // pure lut, no realtime
 
+          if (tiled) {
+            // one lut row per frame
+            if (customExpressionDefined)
+              tiled_luts[i].reset(new TiledLut<Word>(parser.getExpression(), bits_per_pixel, 0, bits_per_pixel, tiled_lut_budget));
+            else {
+              if (!tiled_luts[4])
+                tiled_luts[4].reset(new TiledLut<Word>(parser.getExpression(), bits_per_pixel, 0, bits_per_pixel, tiled_lut_budget));
+              tiled_luts[i] = tiled_luts[4];
+            }
+            continue;
+          }
+
           // save memory, reuse luts, like in xyz
           if (customExpressionDefined) {
             luts[i].used = true;
@@ -217,6 +228,10 @@ public:
         case 16: processors16.push_back(processors16Ctx_array[ModeToInt(parameters["mode"].toString())]); break;
         case 32: processors32.push_back(processors32Ctx_array[ModeToInt(parameters["mode"].toString())]); break;
         }
+        for (int i = 0; i < 4; i++) {
+          if (parsed_expressions[i])
+            contexts[i] = Parser::ContextPool::shared(*parsed_expressions[i], bits_per_pixel, false, false);
+        }
       }
       else {
         // real lut
@@ -234,16 +249,45 @@ public:
           //processor16 = lut12_c;
           break;
         case 14:
-          processors16.push_back(processors14_array[ModeToInt(parameters["mode"].toString())]);
-          //processor16 = lut14_c;
+          processorsTiled.push_back(processors14Tiled_array[ModeToInt(parameters["mode"].toString())]);
           break;
         case 16:
-          // 64bit only
-          processors16.push_back(processors16_array[ModeToInt(parameters["mode"].toString())]);
-          //processor16 = lut16_c;
+          processorsTiled.push_back(processors16Tiled_array[ModeToInt(parameters["mode"].toString())]);
           break;
         }
       }
+
+      // the reduction of the first frame by vectors
+      const int nMode = ModeToInt(parameters["mode"].toString());
+      Processor *(*network)[NUM_MODES] = nullptr;
+      Processor16 *(*network16)[NUM_MODES] = nullptr;
+      Processor32 *(*network32)[NUM_MODES] = nullptr;
+      ProcessorTiled *(*networkTiled)[NUM_MODES] = nullptr;
+      switch (bits_per_pixel) {
+      case 8: network = realtime ? networkCtx_array : network_array; break;
+      case 10: network16 = realtime ? network10Ctx_array : network10_array; break;
+      case 12: network16 = realtime ? network12Ctx_array : network12_array; break;
+      case 14: if (realtime) network16 = network14Ctx_array; else networkTiled = network14Tiled_array; break;
+      case 16: if (realtime) network16 = network16Ctx_array; else networkTiled = network16Tiled_array; break;
+      case 32: network32 = network32Ctx_array; break;
+      }
+      const CpuFlags cpu = bits_per_pixel == 8 || bits_per_pixel == 32 ? CPU_SSE2 : CPU_SSE4_1;
+      if (network && network[0][nMode]) {
+        processors.push_back(Filtering::Processor<Processor>(network[0][nMode], Constraint(cpu, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 1), 2));
+        processors.push_back(Filtering::Processor<Processor>(network[1][nMode], Constraint(CPU_AVX2, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 1), 3));
+      }
+      if (network16 && network16[0][nMode]) {
+        processors16.push_back(Filtering::Processor<Processor16>(network16[0][nMode], Constraint(cpu, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 1), 2));
+        processors16.push_back(Filtering::Processor<Processor16>(network16[1][nMode], Constraint(CPU_AVX2, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 1), 3));
+      }
+      if (network32 && network32[0][nMode]) {
+        processors32.push_back(Filtering::Processor<Processor32>(network32[0][nMode], Constraint(cpu, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 1), 2));
+        processors32.push_back(Filtering::Processor<Processor32>(network32[1][nMode], Constraint(CPU_AVX2, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 1), 3));
+      }
+      if (networkTiled && networkTiled[0][nMode]) {
+        processorsTiled.push_back(Filtering::Processor<ProcessorTiled>(networkTiled[0][nMode], Constraint(cpu, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 1), 2));
+        processorsTiled.push_back(Filtering::Processor<ProcessorTiled>(networkTiled[1][nMode], Constraint(CPU_AVX2, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 1), 3));
+      }
    }
 
    ~Lutf()
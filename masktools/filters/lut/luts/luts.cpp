@@ -1,8 +1,21 @@
 #include "luts.h"
 #include "../functions.h"
+#include "../sliding_median.h"
+#include "../neighbourhood.h"
+#include <vector>
 
 using namespace Filtering;
 
+// The neighbours are read from rows padded with their border pixels: no coordinate is clamped, and
+// the neighbour k of pixel i is at pRows[k][i]. 10-14 bit rows are clamped like x when they are padded
+template<int bits_per_pixel>
+static void clamp_row(Word *pRow, const Word *pSrcRow, int nWidth)
+{
+  const int max_pixel_value = (1 << bits_per_pixel) - 1;
+  for (int i = 0; i < nWidth; i++)
+    pRow[i] = bits_per_pixel < 16 ? Word(min<int>(pSrcRow[i], max_pixel_value)) : pSrcRow[i];
+}
+
 //similar template to lutf
 template<bool realtime, class T>
 static void custom_c(Byte *pDst, ptrdiff_t nDstPitch, const Byte *pSrc, ptrdiff_t nSrcPitch, const Byte *pLut, const Float *pLut_w, Parser::Context *ctx, Parser::Context *ctx_w, const int *pCoordinates, int nCoordinates, int nWidth, int nHeight, const String &mode)
@@ -11,23 +24,18 @@ static void custom_c(Byte *pDst, ptrdiff_t nDstPitch, const Byte *pSrc, ptrdiff_
    UNUSED(ctx_w);
 
    T new_value( mode );
+   MaskTools::Filters::Lut::NeighbourhoodRows<Byte> rows(pCoordinates, nCoordinates, nWidth, nHeight);
+   const int nCount = nCoordinates / 2;
    for ( int j = 0; j < nHeight; j++ )
    {
+      const Byte *const *pRows = rows.get(j, pSrc, nSrcPitch, MaskTools::Filters::Lut::copy_row<Byte>);
       for ( int i = 0; i < nWidth; i++ )
       {
          new_value.reset();
-         for ( int k = 0; k < nCoordinates; k+=2 )
+         const int PixelX = pDst[i];
+         for ( int k = 0; k < nCount; k++ )
          {
-            int x = pCoordinates[k] + i;
-            int y = pCoordinates[k+1] + j;
-
-            if ( x < 0 ) x = 0;
-            if ( x >= nWidth ) x = nWidth - 1;
-            if ( y < 0 ) y = 0;
-            if ( y >= nHeight ) y = nHeight - 1;
-
-            int PixelX = pDst[i];
-            int PixelY = pSrc[x + (y - j) * nSrcPitch];
+            const int PixelY = pRows[k][i];
 
             if (realtime) {
               new_value.add(ctx->compute_byte_xy(PixelX, PixelY));
@@ -38,7 +46,6 @@ static void custom_c(Byte *pDst, ptrdiff_t nDstPitch, const Byte *pSrc, ptrdiff_
          }
          pDst[i] = new_value.finalize();
       }
-      pSrc += nSrcPitch;
       pDst += nDstPitch;
    }
 }
@@ -47,23 +54,18 @@ template<bool realtime, class T>
 static void custom_weight_c(Byte *pDst, ptrdiff_t nDstPitch, const Byte *pSrc, ptrdiff_t nSrcPitch, const Byte *pLut, const Float *pLut_w, Parser::Context *ctx, Parser::Context *ctx_w, const int *pCoordinates, int nCoordinates, int nWidth, int nHeight, const String &mode)
 {
   T new_value(mode);
+  MaskTools::Filters::Lut::NeighbourhoodRows<Byte> rows(pCoordinates, nCoordinates, nWidth, nHeight);
+  const int nCount = nCoordinates / 2;
   for (int j = 0; j < nHeight; j++)
   {
+    const Byte *const *pRows = rows.get(j, pSrc, nSrcPitch, MaskTools::Filters::Lut::copy_row<Byte>);
     for (int i = 0; i < nWidth; i++)
     {
       new_value.reset_w(); // different from non-weight version
-      for (int k = 0; k < nCoordinates; k += 2)
+      const int PixelX = pDst[i];
+      for (int k = 0; k < nCount; k++)
       {
-        int x = pCoordinates[k] + i;
-        int y = pCoordinates[k + 1] + j;
-
-        if (x < 0) x = 0;
-        if (x >= nWidth) x = nWidth - 1;
-        if (y < 0) y = 0;
-        if (y >= nHeight) y = nHeight - 1;
-
-        int PixelX = pDst[i];
-        int PixelY = pSrc[x + (y - j) * nSrcPitch];
+        const int PixelY = pRows[k][i];
 
         // different from non-weight version
         float weight;
@@ -78,7 +80,6 @@ static void custom_weight_c(Byte *pDst, ptrdiff_t nDstPitch, const Byte *pSrc, p
       }
       pDst[i] = new_value.finalize_w(); // different from non-weight version
     }
-    pSrc += nSrcPitch;
     pDst += nDstPitch;
   }
 }
@@ -97,28 +98,18 @@ static void custom16_c(Byte *pDst8, ptrdiff_t nDstPitch, const Byte *pSrc8, ptrd
   nDstPitch /= sizeof(uint16_t);
   const int max_pixel_value = (1 << bits_per_pixel) - 1;
 
+  MaskTools::Filters::Lut::NeighbourhoodRows<Word> rows(pCoordinates, nCoordinates, nWidth, nHeight);
+  const int nCount = nCoordinates / 2;
   for (int j = 0; j < nHeight; j++)
   {
+    const Word *const *pRows = rows.get(j, pSrc, nSrcPitch, clamp_row<bits_per_pixel>);
     for (int i = 0; i < nWidth; i++)
     {
       new_value.reset();
-      for (int k = 0; k < nCoordinates; k += 2)
+      const int PixelX = bits_per_pixel < 16 ? min<int>(pDst[i], max_pixel_value) : pDst[i];
+      for (int k = 0; k < nCount; k++)
       {
-        int x = pCoordinates[k] + i;
-        int y = pCoordinates[k + 1] + j;
-
-        if (x < 0) x = 0;
-        if (x >= nWidth) x = nWidth - 1;
-        if (y < 0) y = 0;
-        if (y >= nHeight) y = nHeight - 1;
-
-        int PixelX = pDst[i];
-        int PixelY = pSrc[x + (y - j) * nSrcPitch];
-
-        if (bits_per_pixel < 16) {
-          PixelX = min(PixelX, max_pixel_value);
-          PixelY = min(PixelY, max_pixel_value);
-        }
+        const int PixelY = pRows[k][i];
 
         if (realtime) {
           new_value.add(ctx->compute_word_xy<bits_per_pixel>(PixelX, PixelY));
@@ -129,7 +120,6 @@ static void custom16_c(Byte *pDst8, ptrdiff_t nDstPitch, const Byte *pSrc8, ptrd
       }
       pDst[i] = new_value.finalize(); // cannot overflow
     }
-    pSrc += nSrcPitch;
     pDst += nDstPitch;
   }
 }
@@ -146,28 +136,18 @@ static void custom16_weight_c(Byte *pDst8, ptrdiff_t nDstPitch, const Byte *pSrc
   nDstPitch /= sizeof(uint16_t);
   const int max_pixel_value = (1 << bits_per_pixel) - 1;
 
+  MaskTools::Filters::Lut::NeighbourhoodRows<Word> rows(pCoordinates, nCoordinates, nWidth, nHeight);
+  const int nCount = nCoordinates / 2;
   for (int j = 0; j < nHeight; j++)
   {
+    const Word *const *pRows = rows.get(j, pSrc, nSrcPitch, clamp_row<bits_per_pixel>);
     for (int i = 0; i < nWidth; i++)
     {
       new_value.reset_w(); // different from non-weight version
-      for (int k = 0; k < nCoordinates; k += 2)
+      const int PixelX = bits_per_pixel < 16 ? min<int>(pDst[i], max_pixel_value) : pDst[i];
+      for (int k = 0; k < nCount; k++)
       {
-        int x = pCoordinates[k] + i;
-        int y = pCoordinates[k + 1] + j;
-
-        if (x < 0) x = 0;
-        if (x >= nWidth) x = nWidth - 1;
-        if (y < 0) y = 0;
-        if (y >= nHeight) y = nHeight - 1;
-
-        int PixelX = pDst[i];
-        int PixelY = pSrc[x + (y - j) * nSrcPitch];
-
-        if (bits_per_pixel < 16) {
-          PixelX = min(PixelX, max_pixel_value);
-          PixelY = min(PixelY, max_pixel_value);
-        }
+        const int PixelY = pRows[k][i];
 
         // different from non-weight version
         float weight;
@@ -190,11 +170,73 @@ static void custom16_weight_c(Byte *pDst8, ptrdiff_t nDstPitch, const Byte *pSrc
       else
         pDst[i] = min(new_value.finalize_w(), (Word)max_pixel_value);
     }
-    pSrc += nSrcPitch;
     pDst += nDstPitch;
   }
 }
 
+template<int bits_per_pixel, class T>
+static void custom16_tiled_c(Byte *pDst8, ptrdiff_t nDstPitch, const Byte *pSrc8, ptrdiff_t nSrcPitch, TiledLut<Word> *pLut, TiledLut<Float> *pLut_w, const int *pCoordinates, int nCoordinates, int nWidth, int nHeight, const String &mode)
+{
+  UNUSED(pLut_w);
+
+  T new_value(mode);
+
+  const uint16_t *pSrc = reinterpret_cast<const uint16_t *>(pSrc8);
+  uint16_t *pDst = reinterpret_cast<uint16_t *>(pDst8);
+  nSrcPitch /= sizeof(uint16_t);
+  nDstPitch /= sizeof(uint16_t);
+  const int max_pixel_value = (1 << bits_per_pixel) - 1;
+
+  MaskTools::Filters::Lut::NeighbourhoodRows<Word> rows(pCoordinates, nCoordinates, nWidth, nHeight);
+  const int nCount = nCoordinates / 2;
+  for (int j = 0; j < nHeight; j++)
+  {
+    const Word *const *pRows = rows.get(j, pSrc, nSrcPitch, clamp_row<bits_per_pixel>);
+    for (int i = 0; i < nWidth; i++)
+    {
+      new_value.reset();
+      const int PixelX = bits_per_pixel < 16 ? min<int>(pDst[i], max_pixel_value) : pDst[i];
+      for (int k = 0; k < nCount; k++)
+        new_value.add((*pLut)(PixelX, pRows[k][i]));
+      pDst[i] = new_value.finalize(); // cannot overflow
+    }
+    pDst += nDstPitch;
+  }
+}
+
+template<int bits_per_pixel, class T>
+static void custom16_weight_tiled_c(Byte *pDst8, ptrdiff_t nDstPitch, const Byte *pSrc8, ptrdiff_t nSrcPitch, TiledLut<Word> *pLut, TiledLut<Float> *pLut_w, const int *pCoordinates, int nCoordinates, int nWidth, int nHeight, const String &mode)
+{
+  T new_value(mode);
+
+  const uint16_t *pSrc = reinterpret_cast<const uint16_t *>(pSrc8);
+  uint16_t *pDst = reinterpret_cast<uint16_t *>(pDst8);
+  nSrcPitch /= sizeof(uint16_t);
+  nDstPitch /= sizeof(uint16_t);
+  const int max_pixel_value = (1 << bits_per_pixel) - 1;
+
+  MaskTools::Filters::Lut::NeighbourhoodRows<Word> rows(pCoordinates, nCoordinates, nWidth, nHeight);
+  const int nCount = nCoordinates / 2;
+  for (int j = 0; j < nHeight; j++)
+  {
+    const Word *const *pRows = rows.get(j, pSrc, nSrcPitch, clamp_row<bits_per_pixel>);
+    for (int i = 0; i < nWidth; i++)
+    {
+      new_value.reset_w();
+      const int PixelX = bits_per_pixel < 16 ? min<int>(pDst[i], max_pixel_value) : pDst[i];
+      for (int k = 0; k < nCount; k++)
+      {
+        const int PixelY = pRows[k][i];
+        new_value.add_w((*pLut)(PixelX, PixelY), (*pLut_w)(PixelX, PixelY));
+      }
+      if(bits_per_pixel == 16)
+        pDst[i] = new_value.finalize_w();
+      else
+        pDst[i] = min(new_value.finalize_w(), (Word)max_pixel_value);
+    }
+    pDst += nDstPitch;
+  }
+}
 
 //similar template to lutf
 template<class T>
@@ -211,30 +253,22 @@ static void custom32_c(Byte *pDst8, ptrdiff_t nDstPitch, const Byte *pSrc8, ptrd
   nSrcPitch /= sizeof(float);
   nDstPitch /= sizeof(float);
 
+  MaskTools::Filters::Lut::NeighbourhoodRows<Float> rows(pCoordinates, nCoordinates, nWidth, nHeight);
+  const int nCount = nCoordinates / 2;
   for (int j = 0; j < nHeight; j++)
   {
+    const Float *const *pRows = rows.get(j, pSrc, nSrcPitch, MaskTools::Filters::Lut::copy_row<Float>);
     for (int i = 0; i < nWidth; i++)
     {
       new_value.reset();
-      for (int k = 0; k < nCoordinates; k += 2)
+      const float PixelX = pDst[i];
+      for (int k = 0; k < nCount; k++)
       {
-        int x = pCoordinates[k] + i;
-        int y = pCoordinates[k + 1] + j;
-
-        if (x < 0) x = 0;
-        if (x >= nWidth) x = nWidth - 1;
-        if (y < 0) y = 0;
-        if (y >= nHeight) y = nHeight - 1;
-
-        float PixelX = pDst[i];
-        float PixelY = pSrc[x + (y - j) * nSrcPitch];
-
         // float is always realtime
-        new_value.add(ctx->compute_float_xy(PixelX, PixelY));
+        new_value.add(ctx->compute_float_xy(PixelX, pRows[k][i]));
       }
       pDst[i] = new_value.finalize();
     }
-    pSrc += nSrcPitch;
     pDst += nDstPitch;
   }
 }
@@ -252,23 +286,18 @@ static void custom32_weight_c(Byte *pDst8, ptrdiff_t nDstPitch, const Byte *pSrc
   nSrcPitch /= sizeof(float);
   nDstPitch /= sizeof(float);
 
+  MaskTools::Filters::Lut::NeighbourhoodRows<Float> rows(pCoordinates, nCoordinates, nWidth, nHeight);
+  const int nCount = nCoordinates / 2;
   for (int j = 0; j < nHeight; j++)
   {
+    const Float *const *pRows = rows.get(j, pSrc, nSrcPitch, MaskTools::Filters::Lut::copy_row<Float>);
     for (int i = 0; i < nWidth; i++)
     {
       new_value.reset_w(); // different from non-weight version
-      for (int k = 0; k < nCoordinates; k += 2)
+      const float PixelX = pDst[i];
+      for (int k = 0; k < nCount; k++)
       {
-        int x = pCoordinates[k] + i;
-        int y = pCoordinates[k + 1] + j;
-
-        if (x < 0) x = 0;
-        if (x >= nWidth) x = nWidth - 1;
-        if (y < 0) y = 0;
-        if (y >= nHeight) y = nHeight - 1;
-
-        float PixelX = pDst[i];
-        float PixelY = pSrc[x + (y - j) * nSrcPitch];
+        const float PixelY = pRows[k][i];
 
         // different from non-weight version
         float weight = ctx_w->compute_float_xy(PixelX, PixelY);
@@ -278,24 +307,144 @@ static void custom32_weight_c(Byte *pDst8, ptrdiff_t nDstPitch, const Byte *pSrc
       }
       pDst[i] = new_value.finalize_w(); // different from non-weight version
     }
-    pSrc += nSrcPitch;
     pDst += nDstPitch;
   }
 }
 
+// median of a rectangle when the expression doesn't use x: the values only depend on the neighbour
+template<bool realtime>
+static void sliding_median_c(Byte *pDst, ptrdiff_t nDstPitch, const Byte *pSrc, ptrdiff_t nSrcPitch, const Byte *pLut, const Float *pLut_w, Parser::Context *ctx, Parser::Context *ctx_w, const int *pCoordinates, int nCoordinates, int nWidth, int nHeight, const String &mode)
+{
+   UNUSED(pLut_w);
+   UNUSED(ctx_w);
+
+   Byte table[256];
+   for ( int i = 0; i < 256; i++ )
+      table[i] = realtime ? ctx->compute_byte_xy(0, i) : pLut[i];
+
+   MaskTools::Filters::Lut::SlidingMedian median( mode );
+   for ( int j = 0; j < nHeight; j++ )
+   {
+      median.process_row(pDst, pSrc, nSrcPitch, table, pCoordinates, nCoordinates, j, nWidth, nHeight);
+      pDst += nDstPitch;
+   }
+}
+
+// the vector modes when the expression doesn't use x: the value of a neighbour only depends on it, so
+// each row is mapped once and the rows are reduced a vector of pixels at a time
+template<bool realtime, MaskTools::Filters::Lut::NeighbourhoodRow *reduce>
+static void network_c(Byte *pDst, ptrdiff_t nDstPitch, const Byte *pSrc, ptrdiff_t nSrcPitch, const Byte *pLut, const Float *pLut_w, Parser::Context *ctx, Parser::Context *ctx_w, const int *pCoordinates, int nCoordinates, int nWidth, int nHeight, const String &mode)
+{
+   UNUSED(pLut_w);
+   UNUSED(ctx_w);
+
+   Byte table[256];
+   for ( int i = 0; i < 256; i++ )
+      table[i] = realtime ? ctx->compute_byte_xy(0, i) : pLut[i];
+
+   auto map = [&](Byte *pRow, const Byte *pSrcRow, int n) {
+      for ( int i = 0; i < n; i++ )
+         pRow[i] = table[pSrcRow[i]];
+   };
+
+   MaskTools::Filters::Lut::NeighbourhoodRows<Byte> rows(pCoordinates, nCoordinates, nWidth, nHeight);
+   const int nMode = MaskTools::Filters::Lut::ModeToInt(mode);
+   for ( int j = 0; j < nHeight; j++ )
+   {
+      reduce(pDst, rows.get(j, pSrc, nSrcPitch, map), nCoordinates / 2, nWidth, nMode, 8);
+      pDst += nDstPitch;
+   }
+}
+
+template<int bits_per_pixel, MaskTools::Filters::Lut::NeighbourhoodRow16 *reduce, class Map>
+static void network16(Byte *pDst8, ptrdiff_t nDstPitch, const Byte *pSrc8, ptrdiff_t nSrcPitch, Map map, const int *pCoordinates, int nCoordinates, int nWidth, int nHeight, const String &mode)
+{
+   const uint16_t *pSrc = reinterpret_cast<const uint16_t *>(pSrc8);
+   uint16_t *pDst = reinterpret_cast<uint16_t *>(pDst8);
+   nSrcPitch /= sizeof(uint16_t);
+   nDstPitch /= sizeof(uint16_t);
+
+   MaskTools::Filters::Lut::NeighbourhoodRows<Word> rows(pCoordinates, nCoordinates, nWidth, nHeight);
+   const int nMode = MaskTools::Filters::Lut::ModeToInt(mode);
+   for ( int j = 0; j < nHeight; j++ )
+   {
+      reduce(pDst, rows.get(j, pSrc, nSrcPitch, map), nCoordinates / 2, nWidth, nMode, bits_per_pixel);
+      pDst += nDstPitch;
+   }
+}
+
+template<bool realtime, int bits_per_pixel, MaskTools::Filters::Lut::NeighbourhoodRow16 *reduce>
+static void network16_c(Byte *pDst, ptrdiff_t nDstPitch, const Byte *pSrc, ptrdiff_t nSrcPitch, const Byte *pLut, const Float *pLut_w, Parser::Context *ctx, Parser::Context *ctx_w, const int *pCoordinates, int nCoordinates, int nWidth, int nHeight, const String &mode)
+{
+   UNUSED(pLut_w);
+   UNUSED(ctx_w);
+
+   const int max_pixel_value = (1 << bits_per_pixel) - 1;
+   std::vector<Word> table(max_pixel_value + 1);
+   for ( int i = 0; i <= max_pixel_value; i++ )
+      table[i] = realtime ? ctx->compute_word_xy<bits_per_pixel>(0, i) : reinterpret_cast<const uint16_t *>(pLut)[i];
+
+   auto map = [&](Word *pRow, const Word *pSrcRow, int n) {
+      for ( int i = 0; i < n; i++ )
+         pRow[i] = table[min<int>(pSrcRow[i], max_pixel_value)];
+   };
+   network16<bits_per_pixel, reduce>(pDst, nDstPitch, pSrc, nSrcPitch, map, pCoordinates, nCoordinates, nWidth, nHeight, mode);
+}
+
+// a whole column of the tiled lut would compute every tile of x = 0, the pixels met only need some
+template<int bits_per_pixel, MaskTools::Filters::Lut::NeighbourhoodRow16 *reduce>
+static void network16_tiled_c(Byte *pDst, ptrdiff_t nDstPitch, const Byte *pSrc, ptrdiff_t nSrcPitch, TiledLut<Word> *pLut, TiledLut<Float> *pLut_w, const int *pCoordinates, int nCoordinates, int nWidth, int nHeight, const String &mode)
+{
+   UNUSED(pLut_w);
+
+   const int max_pixel_value = (1 << bits_per_pixel) - 1;
+   auto map = [&](Word *pRow, const Word *pSrcRow, int n) {
+      for ( int i = 0; i < n; i++ )
+         pRow[i] = (*pLut)(0, min<int>(pSrcRow[i], max_pixel_value));
+   };
+   network16<bits_per_pixel, reduce>(pDst, nDstPitch, pSrc, nSrcPitch, map, pCoordinates, nCoordinates, nWidth, nHeight, mode);
+}
+
+// float: mapped through the expression, a pixel at a time
+template<MaskTools::Filters::Lut::NeighbourhoodRow32 *reduce>
+static void network32_c(Byte *pDst8, ptrdiff_t nDstPitch, const Byte *pSrc8, ptrdiff_t nSrcPitch, const Byte *pLut, const Float *pLut_w, Parser::Context *ctx, Parser::Context *ctx_w, const int *pCoordinates, int nCoordinates, int nWidth, int nHeight, const String &mode)
+{
+   UNUSED(pLut);
+   UNUSED(pLut_w);
+   UNUSED(ctx_w);
+
+   const float *pSrc = reinterpret_cast<const float *>(pSrc8);
+   float *pDst = reinterpret_cast<float *>(pDst8);
+   nSrcPitch /= sizeof(float);
+   nDstPitch /= sizeof(float);
+
+   auto map = [&](Float *pRow, const Float *pSrcRow, int n) {
+      for ( int i = 0; i < n; i++ )
+         pRow[i] = ctx->compute_float_xy(0, pSrcRow[i]);
+   };
+
+   MaskTools::Filters::Lut::NeighbourhoodRows<Float> rows(pCoordinates, nCoordinates, nWidth, nHeight);
+   const int nMode = MaskTools::Filters::Lut::ModeToInt(mode);
+   for ( int j = 0; j < nHeight; j++ )
+   {
+      reduce(pDst, rows.get(j, pSrc, nSrcPitch, map), nCoordinates / 2, nWidth, nMode, 32);
+      pDst += nDstPitch;
+   }
+}
+
 namespace Filtering { namespace MaskTools { namespace Filters { namespace Lut { namespace Spatial {
 
 Processor *processors_array[NUM_MODES] = MPROCESSOR_SINGLE( custom_c, false );
 Processor *processors_10_array[NUM_MODES] = MPROCESSOR16_SINGLE(custom16_c, false, 10);
 Processor *processors_12_array[NUM_MODES] = MPROCESSOR16_SINGLE(custom16_c, false, 12);
-Processor *processors_14_array[NUM_MODES] = MPROCESSOR16_SINGLE(custom16_c, false, 14);
-Processor *processors_16_array[NUM_MODES] = MPROCESSOR16_SINGLE(custom16_c, false, 16);
+ProcessorTiled *processors_tiled_14_array[NUM_MODES] = MPROCESSOR16_TILED(custom16_tiled_c, 14);
+ProcessorTiled *processors_tiled_16_array[NUM_MODES] = MPROCESSOR16_TILED(custom16_tiled_c, 16);
 
 Processor *processors_weight_array[NUM_MODES] = MPROCESSOR_SINGLE(custom_weight_c, false);
 Processor *processors_weight_10_array[NUM_MODES] = MPROCESSOR16_SINGLE(custom16_weight_c, false, 10);
 Processor *processors_weight_12_array[NUM_MODES] = MPROCESSOR16_SINGLE(custom16_weight_c, false, 12);
-Processor *processors_weight_14_array[NUM_MODES] = MPROCESSOR16_SINGLE(custom16_weight_c, false, 14);
-Processor *processors_weight_16_array[NUM_MODES] = MPROCESSOR16_SINGLE(custom16_weight_c, false, 16);
+ProcessorTiled *processors_weight_tiled_14_array[NUM_MODES] = MPROCESSOR16_TILED(custom16_weight_tiled_c, 14);
+ProcessorTiled *processors_weight_tiled_16_array[NUM_MODES] = MPROCESSOR16_TILED(custom16_weight_tiled_c, 16);
 
 
 Processor *processors_realtime_8_array[NUM_MODES] = MPROCESSOR_SINGLE(custom_c, true);
@@ -312,5 +461,20 @@ Processor *processors_weight_realtime_14_array[NUM_MODES] = MPROCESSOR16_SINGLE(
 Processor *processors_weight_realtime_16_array[NUM_MODES] = MPROCESSOR16_SINGLE(custom16_weight_c, true, 16);
 Processor *processors_weight_realtime_32_array[NUM_MODES] = MPROCESSOR32_SINGLE(custom32_weight_c);
 
+Processor *sliding_median_8 = &sliding_median_c<false>;
+Processor *sliding_median_realtime_8 = &sliding_median_c<true>;
+
+Processor *network_8_array[2] = { &network_c<false, network_row_sse2>, &network_c<false, network_row_avx2> };
+Processor *network_10_array[2] = { &network16_c<false, 10, network_row_sse4_16>, &network16_c<false, 10, network_row_avx2_16> };
+Processor *network_12_array[2] = { &network16_c<false, 12, network_row_sse4_16>, &network16_c<false, 12, network_row_avx2_16> };
+ProcessorTiled *network_tiled_14_array[2] = { &network16_tiled_c<14, network_row_sse4_16>, &network16_tiled_c<14, network_row_avx2_16> };
+ProcessorTiled *network_tiled_16_array[2] = { &network16_tiled_c<16, network_row_sse4_16>, &network16_tiled_c<16, network_row_avx2_16> };
+Processor *network_realtime_8_array[2] = { &network_c<true, network_row_sse2>, &network_c<true, network_row_avx2> };
+Processor *network_realtime_10_array[2] = { &network16_c<true, 10, network_row_sse4_16>, &network16_c<true, 10, network_row_avx2_16> };
+Processor *network_realtime_12_array[2] = { &network16_c<true, 12, network_row_sse4_16>, &network16_c<true, 12, network_row_avx2_16> };
+Processor *network_realtime_14_array[2] = { &network16_c<true, 14, network_row_sse4_16>, &network16_c<true, 14, network_row_avx2_16> };
+Processor *network_realtime_16_array[2] = { &network16_c<true, 16, network_row_sse4_16>, &network16_c<true, 16, network_row_avx2_16> };
+Processor *network_realtime_32_array[2] = { &network32_c<network_row32_sse2>, &network32_c<network_row32_avx2> };
+
 } } } } }
 
@@ -3,25 +3,32 @@
 
 #include "../../../common/base/filter.h"
 #include "../../../../common/parser/parser.h"
+#include "../../../../common/parser/context_pool.h"
+#include "../lut_data.h"
+#include "../tiled_lut.h"
 
 #include "../functions.h"
+#include "../sliding_median.h"
+#include "../neighbourhood.h"
 
 namespace Filtering { namespace MaskTools { namespace Filters { namespace Lut { namespace Spatial {
 
 typedef void(Processor)(Byte *pDst, ptrdiff_t nDstPitch, const Byte *pSrc, ptrdiff_t nSrcPitch, const Byte lut[65536], const Float lut_w[65536], Parser::Context *ctx, Parser::Context *ctx_w, const int *pCoordinates, int nCoordinates, int nWidth, int nHeight, const String &mode);
+typedef void(ProcessorTiled)(Byte *pDst, ptrdiff_t nDstPitch, const Byte *pSrc, ptrdiff_t nSrcPitch, TiledLut<Word> *lut, TiledLut<Float> *lut_w, const int *pCoordinates, int nCoordinates, int nWidth, int nHeight, const String &mode);
 
 // lut 8-16
 extern Processor *processors_array[NUM_MODES];
 extern Processor *processors_10_array[NUM_MODES];
 extern Processor *processors_12_array[NUM_MODES];
-extern Processor *processors_14_array[NUM_MODES];
-extern Processor *processors_16_array[NUM_MODES];
 
 extern Processor *processors_weight_array[NUM_MODES];
 extern Processor *processors_weight_10_array[NUM_MODES];
 extern Processor *processors_weight_12_array[NUM_MODES];
-extern Processor *processors_weight_14_array[NUM_MODES];
-extern Processor *processors_weight_16_array[NUM_MODES];
+// tiled lut 14-16
+extern ProcessorTiled *processors_tiled_14_array[NUM_MODES];
+extern ProcessorTiled *processors_tiled_16_array[NUM_MODES];
+extern ProcessorTiled *processors_weight_tiled_14_array[NUM_MODES];
+extern ProcessorTiled *processors_weight_tiled_16_array[NUM_MODES];
 // realtime 8-32
 extern Processor *processors_realtime_8_array[NUM_MODES];
 extern Processor *processors_realtime_10_array[NUM_MODES];
@@ -36,6 +43,22 @@ extern Processor *processors_weight_realtime_12_array[NUM_MODES];
 extern Processor *processors_weight_realtime_14_array[NUM_MODES];
 extern Processor *processors_weight_realtime_16_array[NUM_MODES];
 extern Processor *processors_weight_realtime_32_array[NUM_MODES];
+// 8 bit median of a rectangle of pixels, expressions of y only
+extern Processor *sliding_median_8;
+extern Processor *sliding_median_realtime_8;
+// min, max, range, avg and std of any neighbourhood, median of 3x3, cross and 5x5 pixels, expressions
+// of y only: sse2 (sse4.1 at 10-16 bit), avx2
+extern Processor *network_8_array[2];
+extern Processor *network_10_array[2];
+extern Processor *network_12_array[2];
+extern ProcessorTiled *network_tiled_14_array[2];
+extern ProcessorTiled *network_tiled_16_array[2];
+extern Processor *network_realtime_8_array[2];
+extern Processor *network_realtime_10_array[2];
+extern Processor *network_realtime_12_array[2];
+extern Processor *network_realtime_14_array[2];
+extern Processor *network_realtime_16_array[2];
+extern Processor *network_realtime_32_array[2];
 
 class Luts : public MaskTools::Filter
 {
@@ -44,13 +67,18 @@ class Luts : public MaskTools::Filter
 
    ProcessorList<Processor> processors;
    ProcessorList<Processor> processors_weight;
+   ProcessorList<ProcessorTiled> processors_tiled;
+   ProcessorList<ProcessorTiled> processors_weight_tiled;
 
    // for realtime
    std::deque<Filtering::Parser::Symbol> *parsed_expressions[4];
    std::deque<Filtering::Parser::Symbol> *parsed_expressions_w[4];
+   std::shared_ptr<Parser::ContextPool> contexts[4]; // reused by the realtime processors
+   std::shared_ptr<Parser::ContextPool> contexts_w[4];
 
    int bits_per_pixel;
    bool realtime;
+   bool tiled;
 
    String mode;
 
@@ -69,42 +97,21 @@ class Luts : public MaskTools::Filter
 
    Lut_w luts_weight[4+1]; // max planes + 1
 
+   // 14-16 bit: tiles computed when first needed
+   std::shared_ptr<TiledLut<Word>> tiled_luts[4+1];
+   std::shared_ptr<TiledLut<Float>> tiled_luts_weight[4+1];
+
    static Byte *calculateLut(const std::deque<Filtering::Parser::Symbol> &expr, int bits_per_pixel) {
      Parser::Context ctx(expr);
      int pixelsize = bits_per_pixel == 8 ? 1 : 2; // byte / uint16_t
      size_t buffer_size = ((size_t)1 << bits_per_pixel) * ((size_t)1 << bits_per_pixel) *pixelsize;
      Byte *lut = new Byte[buffer_size];
 
-     const int size = 1 << bits_per_pixel;
-
-     switch (bits_per_pixel) {
-     case 8:
-       for (int x = 0; x < 256; x++)
-         for (int y = 0; y < 256; y++)
-           lut[(x << 8) + y] = ctx.compute_byte_xy(x, y);
-       break;
-     case 10:
-       for (int x = 0; x < size; x++)
-         for (int y = 0; y < size; y++)
-           reinterpret_cast<Word *>(lut)[(x << 10) + y] = ctx.compute_word_xy<10>(x, y);
-       break;
-     case 12:
-       for (int x = 0; x < size; x++)
-         for (int y = 0; y < size; y++)
-           reinterpret_cast<Word *>(lut)[(x << 12) + y] = ctx.compute_word_xy<12>(x, y);
-       break;
-     case 14:
-       for (int x = 0; x < size; x++)
-         for (int y = 0; y < size; y++)
-           reinterpret_cast<Word *>(lut)[(x << 14) + y] = ctx.compute_word_xy<14>(x, y);
-       break;
-     case 16:
-       // 64bit only
-       for (int x = 0; x < 65536; x++)
-         for (int y = 0; y < 65536; y++)
-           reinterpret_cast<Word *>(lut)[((size_t)x << 16) + y] = ctx.compute_word_xy<16>(x, y);
-       break;
-     }
+     static const int inputs[2] = { 0, 1 }; // (x << bits_per_pixel) + y
+     if (bits_per_pixel == 8)
+       fill_lut(lut, ctx, bits_per_pixel, inputs, 2);
+     else
+       fill_lut(reinterpret_cast<Word *>(lut), ctx, bits_per_pixel, inputs, 2);
      return lut;
    }
 
@@ -117,9 +124,8 @@ class Luts : public MaskTools::Filter
      size_t buffer_size = ((size_t)size) * ((size_t)size);
      Float *lut = new Float[buffer_size];
 
-     for (int x = 0; x < size; x++)
-       for (int y = 0; y < size; y++)
-         lut[(x << bits_per_pixel) + y] = ctx.compute_float_xy_intinput<bits_per_pixel>(x, y);
+     static const int inputs[2] = { 0, 1 }; // (x << bits_per_pixel) + y
+     fill_lut(lut, ctx, bits_per_pixel, inputs, 2);
      return lut;
    }
 
@@ -143,19 +149,33 @@ protected:
     {
         UNUSED(n); UNUSED(env);
         if (realtime) {
-          // thread safety
-          Parser::Context ctx(*parsed_expressions[nPlane]);
+          // thread safety: a context is used by one thread at a time
+          auto ctx = contexts[nPlane]->acquire();
           if (!parsed_expressions_w[nPlane]) {
             // no weights
             processors.best_processor(constraints[nPlane])(dst.data(), dst.pitch(),
               frames[0].plane(nPlane).data(), frames[0].plane(nPlane).pitch(),
-              nullptr, nullptr, &ctx, nullptr, pCoordinates, nCoordinates, dst.width(), dst.height(), mode);
+              nullptr, nullptr, ctx.get(), nullptr, pCoordinates, nCoordinates, dst.width(), dst.height(), mode);
           }
           else {
-            Parser::Context ctx_w(*parsed_expressions_w[nPlane]);
+            auto ctx_w = contexts_w[nPlane]->acquire();
             processors_weight.best_processor(constraints[nPlane])(dst.data(), dst.pitch(),
               frames[0].plane(nPlane).data(), frames[0].plane(nPlane).pitch(),
-              nullptr, nullptr, &ctx, &ctx_w, pCoordinates, nCoordinates, dst.width(), dst.height(), mode);
+              nullptr, nullptr, ctx.get(), ctx_w.get(), pCoordinates, nCoordinates, dst.width(), dst.height(), mode);
+          }
+        }
+        else if (tiled) {
+          auto reader = tiled_luts[nPlane]->read();
+          if (!tiled_luts_weight[nPlane]) {
+            processors_tiled.best_processor(constraints[nPlane])(dst.data(), dst.pitch(),
+              frames[0].plane(nPlane).data(), frames[0].plane(nPlane).pitch(),
+              tiled_luts[nPlane].get(), nullptr, pCoordinates, nCoordinates, dst.width(), dst.height(), mode);
+          }
+          else {
+            auto reader_w = tiled_luts_weight[nPlane]->read();
+            processors_weight_tiled.best_processor(constraints[nPlane])(dst.data(), dst.pitch(),
+              frames[0].plane(nPlane).data(), frames[0].plane(nPlane).pitch(),
+              tiled_luts[nPlane].get(), tiled_luts_weight[nPlane].get(), pCoordinates, nCoordinates, dst.width(), dst.height(), mode);
           }
         }
         else {
@@ -199,27 +219,20 @@ public:
      realtime = parameters["realtime"].toBool();
 
      // same as in lut_xy
-     // 14, 16 bit and float: default realtime, 
-     // hardcore users on x64 with 8GB memory and plenty of time can override 16 bit lutxy with realtime=false :)
      // lut sizes
      // 10 bits: 2 MBytes (2*1024*1024) per expression 
      // 12 bits: 32 MBytes (2*4096*4096) per expression 
      // 14 bits: 512 MBytes (2*16384*16384) per expression 
      // 16 bits: 8 GBytes (2*65536*65536) per expression 
-     if (bits_per_pixel >= 14 && !parameters["realtime"].is_defined()) {
-       realtime = true;
-     }
+     // 14 and 16 bits: tiled lut, only the tiles of the (x, y) pairs met are computed
+     // float: always realtime
+     tiled = bits_per_pixel == 14 || bits_per_pixel == 16;
 
      if (bits_per_pixel == 32)
        realtime = true;
 
-     if (bits_per_pixel == 16) {
-       if ((uint64_t)std::numeric_limits<size_t>::max() <= 0xFFFFFFFFull) {
-         realtime = true; // not even possible a real 16 bit lutxy on 32 bit environment
-       }
-     }
-
      bool hasWeights = false;
+     bool usesX = false;
 
      /* compute the luts */
      for (int i = 0; i < 4; i++)
@@ -250,12 +263,22 @@ public:
          error = "invalid expression in the lut";
          return;
        }
+       usesX |= (ctx.variable_mask() & 1) != 0;
 
        // store expression on compute lut
        if (realtime) {
          parsed_expressions[i] = new std::deque<Parser::Symbol>(parser.getExpression());
          // fallthough to optimal weigth mode
        }
+       else if (tiled) {
+         if (customExpressionDefined)
+           tiled_luts[i].reset(new TiledLut<Word>(parser.getExpression(), bits_per_pixel, 8, 8, tiled_lut_budget));
+         else {
+           if (!tiled_luts[4])
+             tiled_luts[4].reset(new TiledLut<Word>(parser.getExpression(), bits_per_pixel, 8, 8, tiled_lut_budget));
+           tiled_luts[i] = tiled_luts[4];
+         }
+       }
        else {
          // pure lut, no realtime
          // save memory, reuse luts, like in xyz
@@ -301,6 +324,15 @@ public:
          parsed_expressions_w[i] = new std::deque<Parser::Symbol>(parser.getExpression());
          continue;
        }
+       else if (tiled) {
+         if (customExpressionDefined_w)
+           tiled_luts_weight[i].reset(new TiledLut<Float>(parser.getExpression(), bits_per_pixel, 8, 8, tiled_lut_budget));
+         else {
+           if (!tiled_luts_weight[4])
+             tiled_luts_weight[4].reset(new TiledLut<Float>(parser.getExpression(), bits_per_pixel, 8, 8, tiled_lut_budget));
+           tiled_luts_weight[i] = tiled_luts_weight[4];
+         }
+       }
        else {
          // pure lut, no realtime
          // save memory, reuse luts, like in xyz
@@ -310,10 +342,6 @@ public:
            case 8: luts_weight[i].ptr = calculateLut_w<8>(parser.getExpression()); break;
            case 10: luts_weight[i].ptr = calculateLut_w<10>(parser.getExpression()); break;
            case 12: luts_weight[i].ptr = calculateLut_w<12>(parser.getExpression()); break;
-           case 14: luts_weight[i].ptr = calculateLut_w<14>(parser.getExpression()); break;
-#if defined(_M_X64) || defined(__amd64__)
-           case 16: luts_weight[i].ptr = calculateLut_w<16>(parser.getExpression()); break;
-#endif
            }
          }
          else {
@@ -323,10 +351,6 @@ public:
              case 8: luts_weight[4].ptr = calculateLut_w<8>(parser.getExpression()); break;
              case 10: luts_weight[4].ptr = calculateLut_w<10>(parser.getExpression()); break;
              case 12: luts_weight[4].ptr = calculateLut_w<12>(parser.getExpression()); break;
-             case 14: luts_weight[4].ptr = calculateLut_w<14>(parser.getExpression()); break;
-#if defined(_M_X64) || defined(__amd64__)
-             case 16: luts_weight[4].ptr = calculateLut_w<16>(parser.getExpression()); break;
-#endif
              }
            }
            luts_weight[i].ptr = luts_weight[4].ptr;
@@ -348,16 +372,48 @@ public:
        case 16:  processors.push_back(processors_realtime_16_array[ModeToInt(mode)]); break;
        case 32:  processors.push_back(processors_realtime_32_array[ModeToInt(mode)]); break;
        }
+       for (int i = 0; i < 4; i++) {
+         if (parsed_expressions[i])
+           contexts[i] = Parser::ContextPool::shared(*parsed_expressions[i], bits_per_pixel, false, false);
+         if (parsed_expressions_w[i])
+           contexts_w[i] = Parser::ContextPool::shared(*parsed_expressions_w[i], bits_per_pixel, false, false);
+       }
      }
      else {
        switch (bits_per_pixel) {
        case 8:  processors.push_back(processors_array[ModeToInt(mode)]); break;
        case 10:  processors.push_back(processors_10_array[ModeToInt(mode)]); break;
        case 12:  processors.push_back(processors_12_array[ModeToInt(mode)]); break;
-       case 14:  processors.push_back(processors_14_array[ModeToInt(mode)]); break;
-       case 16:  processors.push_back(processors_16_array[ModeToInt(mode)]); break;
+       case 14:  processors_tiled.push_back(processors_tiled_14_array[ModeToInt(mode)]); break;
+       case 16:  processors_tiled.push_back(processors_tiled_16_array[ModeToInt(mode)]); break;
        }
      };
+     if (bits_per_pixel == 8 && !usesX && ModeToInt(mode) == MEDIANIZER4 && SlidingMedian::is_rectangle(pCoordinates, nCoordinates)) {
+       // the neighbours of the next pixel are mostly the same: sliding histogram
+       processors.push_back(Filtering::Processor<Processor>(realtime ? sliding_median_realtime_8 : sliding_median_8, Constraint(CPU_NONE, 1, 1, 1, 1), 1));
+     }
+     if (!usesX && is_network_reducible(ModeToInt(mode), pCoordinates, nCoordinates)) {
+       // the rows are mapped once, then reduced a vector of pixels at a time
+       Processor **network = nullptr;
+       ProcessorTiled **network_tiled = nullptr;
+       switch (bits_per_pixel) {
+       case 8: network = realtime ? network_realtime_8_array : network_8_array; break;
+       case 10: network = realtime ? network_realtime_10_array : network_10_array; break;
+       case 12: network = realtime ? network_realtime_12_array : network_12_array; break;
+       case 14: if (realtime) network = network_realtime_14_array; else network_tiled = network_tiled_14_array; break;
+       case 16: if (realtime) network = network_realtime_16_array; else network_tiled = network_tiled_16_array; break;
+       case 32: network = network_realtime_32_array; break;
+       }
+       const CpuFlags cpu = bits_per_pixel == 8 || bits_per_pixel == 32 ? CPU_SSE2 : CPU_SSE4_1;
+       if (network) {
+         processors.push_back(Filtering::Processor<Processor>(network[0], Constraint(cpu, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 1), 2));
+         processors.push_back(Filtering::Processor<Processor>(network[1], Constraint(CPU_AVX2, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 1), 3));
+       }
+       else {
+         processors_tiled.push_back(Filtering::Processor<ProcessorTiled>(network_tiled[0], Constraint(cpu, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 1), 2));
+         processors_tiled.push_back(Filtering::Processor<ProcessorTiled>(network_tiled[1], Constraint(CPU_AVX2, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 1), 3));
+       }
+     }
      if (hasWeights) {
        if (realtime) {
          switch (bits_per_pixel) {
@@ -374,8 +430,8 @@ public:
          case 8:  processors_weight.push_back(processors_weight_array[ModeToInt(mode)]); break;
          case 10:  processors_weight.push_back(processors_weight_10_array[ModeToInt(mode)]); break;
          case 12:  processors_weight.push_back(processors_weight_12_array[ModeToInt(mode)]); break;
-         case 14:  processors_weight.push_back(processors_weight_14_array[ModeToInt(mode)]); break;
-         case 16:  processors_weight.push_back(processors_weight_16_array[ModeToInt(mode)]); break;
+         case 14:  processors_weight_tiled.push_back(processors_weight_tiled_14_array[ModeToInt(mode)]); break;
+         case 16:  processors_weight_tiled.push_back(processors_weight_tiled_16_array[ModeToInt(mode)]); break;
          }
        };
      }
@@ -1,36 +1,37 @@
 #include "lutsx.h"
 #include "../functions.h"
+#include "../sliding_median.h"
+#include "../neighbourhood.h"
+#include <vector>
 
 using namespace Filtering;
 
+// one of the reductions of a row, over the rows of its clip padded with their border pixels
+template<typename T, class A>
+static void reduce_row(T *pValues, const T *const *pRows, int nCount, int nWidth, A &new_value)
+{
+   for ( int i = 0; i < nWidth; i++ )
+   {
+      new_value.reset();
+      for ( int k = 0; k < nCount; k++ )
+         new_value.add( pRows[k][i] );
+      pValues[i] = new_value.finalize();
+   }
+}
+
 template<class T, class U>
 static void custom_c(Byte *pDst, ptrdiff_t nDstPitch, const Byte *pSrc1, ptrdiff_t nSrc1Pitch, const Byte *pSrc2, ptrdiff_t nSrc2Pitch, const Byte *pLut, const int *pCoordinates, int nCoordinates, int nWidth, int nHeight, const String &mode1, const String &mode2)
 {
    T new_value1( mode1 );
    U new_value2( mode2 );
+   MaskTools::Filters::Lut::NeighbourhoodRows<Byte> rows1(pCoordinates, nCoordinates, nWidth, nHeight), rows2(pCoordinates, nCoordinates, nWidth, nHeight);
+   std::vector<Byte> values1(nWidth), values2(nWidth);
    for ( int j = 0; j < nHeight; j++ )
    {
+      reduce_row(values1.data(), rows1.get(j, pSrc1, nSrc1Pitch, MaskTools::Filters::Lut::copy_row<Byte>), nCoordinates / 2, nWidth, new_value1);
+      reduce_row(values2.data(), rows2.get(j, pSrc2, nSrc2Pitch, MaskTools::Filters::Lut::copy_row<Byte>), nCoordinates / 2, nWidth, new_value2);
       for ( int i = 0; i < nWidth; i++ )
-      {
-         new_value1.reset();
-         new_value2.reset();
-         for ( int k = 0; k < nCoordinates; k+=2 )
-         {
-            int x = pCoordinates[k] + i;
-            int y = pCoordinates[k+1] + j;
-
-            if ( x < 0 ) x = 0;
-            if ( x >= nWidth ) x = nWidth - 1;
-            if ( y < 0 ) y = 0;
-            if ( y >= nHeight ) y = nHeight - 1;
-
-            new_value1.add( pSrc1[x + ( y - j ) * nSrc1Pitch] );
-            new_value2.add( pSrc2[x + ( y - j ) * nSrc2Pitch] );
-         }
-         pDst[i] = pLut[ (new_value2.finalize() << 16) + (pDst[ i ] << 8) + new_value1.finalize() ]; // ZXY order at lut fill-up: x=pDst, Y=val1 Z=val2
-      }
-      pSrc1 += nSrc1Pitch;
-      pSrc2 += nSrc2Pitch;
+         pDst[i] = pLut[ (values2[i] << 16) + (pDst[ i ] << 8) + values1[i] ]; // ZXY order at lut fill-up: x=pDst, Y=val1 Z=val2
       pDst += nDstPitch;
    }
 }
@@ -40,29 +41,14 @@ static void custom_realtime_8_c(Byte *pDst, ptrdiff_t nDstPitch, const Byte *pSr
 {
   T new_value1(mode1);
   U new_value2(mode2);
+  MaskTools::Filters::Lut::NeighbourhoodRows<Byte> rows1(pCoordinates, nCoordinates, nWidth, nHeight), rows2(pCoordinates, nCoordinates, nWidth, nHeight);
+  std::vector<Byte> values1(nWidth), values2(nWidth);
   for (int j = 0; j < nHeight; j++)
   {
-    for (int i = 0; i < nWidth; i++)
-    {
-      new_value1.reset();
-      new_value2.reset();
-      for (int k = 0; k < nCoordinates; k += 2)
-      {
-        int x = pCoordinates[k] + i;
-        int y = pCoordinates[k + 1] + j;
-
-        if (x < 0) x = 0;
-        if (x >= nWidth) x = nWidth - 1;
-        if (y < 0) y = 0;
-        if (y >= nHeight) y = nHeight - 1;
-
-        new_value1.add(pSrc1[x + (y - j) * nSrc1Pitch]);
-        new_value2.add(pSrc2[x + (y - j) * nSrc2Pitch]);
-      }
-      pDst[i] = ctx->compute_byte_xyz(pDst[i], new_value1.finalize(), new_value2.finalize());
-    }
-    pSrc1 += nSrc1Pitch;
-    pSrc2 += nSrc2Pitch;
+    reduce_row(values1.data(), rows1.get(j, pSrc1, nSrc1Pitch, MaskTools::Filters::Lut::copy_row<Byte>), nCoordinates / 2, nWidth, new_value1);
+    reduce_row(values2.data(), rows2.get(j, pSrc2, nSrc2Pitch, MaskTools::Filters::Lut::copy_row<Byte>), nCoordinates / 2, nWidth, new_value2);
+    const Byte *src[3] = { pDst, values1.data(), values2.data() };
+    ctx->compute_row_byte(pDst, src, 3, nWidth);
     pDst += nDstPitch;
   }
 }
@@ -79,30 +65,14 @@ static void custom_realtime_uint16_c(Byte *pDst, ptrdiff_t nDstPitch, const Byte
   nSrc1Pitch /= sizeof(uint16_t);
   nSrc2Pitch /= sizeof(uint16_t);
   nDstPitch /= sizeof(uint16_t);
-  const uint16_t max_pixel_value = (1 << bits_per_pixel) - 1;
+  MaskTools::Filters::Lut::NeighbourhoodRows<Word> rows1(pCoordinates, nCoordinates, nWidth, nHeight), rows2(pCoordinates, nCoordinates, nWidth, nHeight);
+  std::vector<Word> values1(nWidth), values2(nWidth);
   for (int j = 0; j < nHeight; j++)
   {
-    for (int i = 0; i < nWidth; i++)
-    {
-      new_value1.reset();
-      new_value2.reset();
-      for (int k = 0; k < nCoordinates; k += 2)
-      {
-        int x = pCoordinates[k] + i;
-        int y = pCoordinates[k + 1] + j;
-
-        if (x < 0) x = 0;
-        if (x >= nWidth) x = nWidth - 1;
-        if (y < 0) y = 0;
-        if (y >= nHeight) y = nHeight - 1;
-
-        new_value1.add(pSrc1_16[x + (y - j) * nSrc1Pitch]);
-        new_value2.add(pSrc2_16[x + (y - j) * nSrc2Pitch]);
-      }
-      pDst_16[i] = ctx->compute_word_xyz<bits_per_pixel>(pDst_16[i], new_value1.finalize(), new_value2.finalize());
-    }
-    pSrc1_16 += nSrc1Pitch;
-    pSrc2_16 += nSrc2Pitch;
+    reduce_row(values1.data(), rows1.get(j, pSrc1_16, nSrc1Pitch, MaskTools::Filters::Lut::copy_row<Word>), nCoordinates / 2, nWidth, new_value1);
+    reduce_row(values2.data(), rows2.get(j, pSrc2_16, nSrc2Pitch, MaskTools::Filters::Lut::copy_row<Word>), nCoordinates / 2, nWidth, new_value2);
+    const Word *src[3] = { pDst_16, values1.data(), values2.data() };
+    ctx->compute_row_word(pDst_16, src, 3, nWidth, bits_per_pixel);
     pDst_16 += nDstPitch;
   }
 }
@@ -118,34 +88,120 @@ static void custom_realtime_32_c(Byte *pDst, ptrdiff_t nDstPitch, const Byte *pS
   nSrc1Pitch /= sizeof(float);
   nSrc2Pitch /= sizeof(float);  
   nDstPitch /= sizeof(float);
+  MaskTools::Filters::Lut::NeighbourhoodRows<Float> rows1(pCoordinates, nCoordinates, nWidth, nHeight), rows2(pCoordinates, nCoordinates, nWidth, nHeight);
+  std::vector<Float> values1(nWidth), values2(nWidth);
   for (int j = 0; j < nHeight; j++)
   {
-    for (int i = 0; i < nWidth; i++)
-    {
-      new_value1.reset();
-      new_value2.reset();
-      for (int k = 0; k < nCoordinates; k += 2)
-      {
-        int x = pCoordinates[k] + i;
-        int y = pCoordinates[k + 1] + j;
-
-        if (x < 0) x = 0;
-        if (x >= nWidth) x = nWidth - 1;
-        if (y < 0) y = 0;
-        if (y >= nHeight) y = nHeight - 1;
-
-        new_value1.add(pSrc1_32[x + (y - j) * nSrc1Pitch]);
-        new_value2.add(pSrc2_32[x + (y - j) * nSrc2Pitch]);
-      }
-      pDst_32[i] = (float)ctx->compute_float_xyz(pDst_32[i], new_value1.finalize(), new_value2.finalize());
-    }
-    pSrc1_32 += nSrc1Pitch;
-    pSrc2_32 += nSrc2Pitch;
+    reduce_row(values1.data(), rows1.get(j, pSrc1_32, nSrc1Pitch, MaskTools::Filters::Lut::copy_row<Float>), nCoordinates / 2, nWidth, new_value1);
+    reduce_row(values2.data(), rows2.get(j, pSrc2_32, nSrc2Pitch, MaskTools::Filters::Lut::copy_row<Float>), nCoordinates / 2, nWidth, new_value2);
+    const Float *src[3] = { pDst_32, values1.data(), values2.data() };
+    ctx->compute_row_float(pDst_32, src, 3, nWidth);
     pDst_32 += nDstPitch;
   }
 }
 
 
+// one of the reductions of a row for rectangle pixels, pSrc at the top of the plane
+template<class T>
+static void reduce_row(Byte *pValues, const Byte *pSrc, ptrdiff_t nSrcPitch, MaskTools::Filters::Lut::NeighbourhoodRows<Byte> &rows, T &new_value, const int *pCoordinates, int nCoordinates, int j, int nWidth, int nHeight)
+{
+   UNUSED(pCoordinates);
+   UNUSED(nHeight);
+   reduce_row(pValues, rows.get(j, pSrc, nSrcPitch, MaskTools::Filters::Lut::copy_row<Byte>), nCoordinates / 2, nWidth, new_value);
+}
+
+static void reduce_row(Byte *pValues, const Byte *pSrc, ptrdiff_t nSrcPitch, MaskTools::Filters::Lut::NeighbourhoodRows<Byte> &rows, MaskTools::Filters::Lut::SlidingMedian &median, const int *pCoordinates, int nCoordinates, int j, int nWidth, int nHeight)
+{
+   static const struct Identity {
+      Byte table[256];
+      Identity() { for ( int i = 0; i < 256; i++ ) table[i] = Byte(i); }
+   } identity;
+   UNUSED(rows);
+   median.process_row(pValues, pSrc, nSrcPitch, identity.table, pCoordinates, nCoordinates, j, nWidth, nHeight);
+}
+
+// rectangle pixels with a median mode: the rows are reduced first, the median ones by sliding histogram
+template<class T, class U>
+static void rectangle_c(Byte *pDst, ptrdiff_t nDstPitch, const Byte *pSrc1, ptrdiff_t nSrc1Pitch, const Byte *pSrc2, ptrdiff_t nSrc2Pitch, const Byte *pLut, const int *pCoordinates, int nCoordinates, int nWidth, int nHeight, const String &mode1, const String &mode2)
+{
+   typename MaskTools::Filters::Lut::RectangleAggregator<T>::type new_value1( mode1 );
+   typename MaskTools::Filters::Lut::RectangleAggregator<U>::type new_value2( mode2 );
+   MaskTools::Filters::Lut::NeighbourhoodRows<Byte> rows1(pCoordinates, nCoordinates, nWidth, nHeight), rows2(pCoordinates, nCoordinates, nWidth, nHeight);
+   std::vector<Byte> values1(nWidth), values2(nWidth);
+   for ( int j = 0; j < nHeight; j++ )
+   {
+      reduce_row(values1.data(), pSrc1, nSrc1Pitch, rows1, new_value1, pCoordinates, nCoordinates, j, nWidth, nHeight);
+      reduce_row(values2.data(), pSrc2, nSrc2Pitch, rows2, new_value2, pCoordinates, nCoordinates, j, nWidth, nHeight);
+      for ( int i = 0; i < nWidth; i++ )
+         pDst[i] = pLut[ (values2[i] << 16) + (pDst[ i ] << 8) + values1[i] ];
+      pDst += nDstPitch;
+   }
+}
+
+template<class T, class U>
+static void rectangle_realtime_8_c(Byte *pDst, ptrdiff_t nDstPitch, const Byte *pSrc1, ptrdiff_t nSrc1Pitch, const Byte *pSrc2, ptrdiff_t nSrc2Pitch, Parser::Context *ctx, const int *pCoordinates, int nCoordinates, int nWidth, int nHeight, const String &mode1, const String &mode2)
+{
+  typename MaskTools::Filters::Lut::RectangleAggregator<T>::type new_value1(mode1);
+  typename MaskTools::Filters::Lut::RectangleAggregator<U>::type new_value2(mode2);
+  MaskTools::Filters::Lut::NeighbourhoodRows<Byte> rows1(pCoordinates, nCoordinates, nWidth, nHeight), rows2(pCoordinates, nCoordinates, nWidth, nHeight);
+  std::vector<Byte> values1(nWidth), values2(nWidth);
+  for (int j = 0; j < nHeight; j++)
+  {
+    reduce_row(values1.data(), pSrc1, nSrc1Pitch, rows1, new_value1, pCoordinates, nCoordinates, j, nWidth, nHeight);
+    reduce_row(values2.data(), pSrc2, nSrc2Pitch, rows2, new_value2, pCoordinates, nCoordinates, j, nWidth, nHeight);
+    const Byte *src[3] = { pDst, values1.data(), values2.data() };
+    ctx->compute_row_byte(pDst, src, 3, nWidth);
+    pDst += nDstPitch;
+  }
+}
+
+// both modes among the vector ones: each reduction of a row is done a vector of pixels at a time over
+// the padded rows of its clip
+template<MaskTools::Filters::Lut::NeighbourhoodRow *reduce>
+static void network_c(Byte *pDst, ptrdiff_t nDstPitch, const Byte *pSrc1, ptrdiff_t nSrc1Pitch, const Byte *pSrc2, ptrdiff_t nSrc2Pitch, const Byte *pLut, const int *pCoordinates, int nCoordinates, int nWidth, int nHeight, const String &mode1, const String &mode2)
+{
+   MaskTools::Filters::Lut::NeighbourhoodRows<Byte> rows1(pCoordinates, nCoordinates, nWidth, nHeight), rows2(pCoordinates, nCoordinates, nWidth, nHeight);
+   const int nMode1 = MaskTools::Filters::Lut::ModeToInt(mode1);
+   const int nMode2 = MaskTools::Filters::Lut::ModeToInt(mode2);
+   std::vector<Byte> values1(nWidth), values2(nWidth);
+   for ( int j = 0; j < nHeight; j++ )
+   {
+      reduce(values1.data(), rows1.get(j, pSrc1, nSrc1Pitch, MaskTools::Filters::Lut::copy_row<Byte>), nCoordinates / 2, nWidth, nMode1, 8);
+      reduce(values2.data(), rows2.get(j, pSrc2, nSrc2Pitch, MaskTools::Filters::Lut::copy_row<Byte>), nCoordinates / 2, nWidth, nMode2, 8);
+      for ( int i = 0; i < nWidth; i++ )
+         pDst[i] = pLut[ (values2[i] << 16) + (pDst[ i ] << 8) + values1[i] ];
+      pDst += nDstPitch;
+   }
+}
+
+static void compute_row(Parser::Context *ctx, Byte *pDst, const Byte *const *src, int nWidth, int bits_per_pixel) { UNUSED(bits_per_pixel); ctx->compute_row_byte(pDst, src, 3, nWidth); }
+static void compute_row(Parser::Context *ctx, Word *pDst, const Word *const *src, int nWidth, int bits_per_pixel) { ctx->compute_row_word(pDst, src, 3, nWidth, bits_per_pixel); }
+static void compute_row(Parser::Context *ctx, Float *pDst, const Float *const *src, int nWidth, int bits_per_pixel) { UNUSED(bits_per_pixel); ctx->compute_row_float(pDst, src, 3, nWidth); }
+
+template<typename T, int bits_per_pixel, void reduce(T *, const T *const *, int, int, int, int)>
+static void network_realtime_c(Byte *pDst8, ptrdiff_t nDstPitch, const Byte *pSrc1, ptrdiff_t nSrc1Pitch, const Byte *pSrc2, ptrdiff_t nSrc2Pitch, Parser::Context *ctx, const int *pCoordinates, int nCoordinates, int nWidth, int nHeight, const String &mode1, const String &mode2)
+{
+  const T *pSrc1_T = reinterpret_cast<const T *>(pSrc1);
+  const T *pSrc2_T = reinterpret_cast<const T *>(pSrc2);
+  T *pDst = reinterpret_cast<T *>(pDst8);
+  nSrc1Pitch /= sizeof(T);
+  nSrc2Pitch /= sizeof(T);
+  nDstPitch /= sizeof(T);
+
+  MaskTools::Filters::Lut::NeighbourhoodRows<T> rows1(pCoordinates, nCoordinates, nWidth, nHeight), rows2(pCoordinates, nCoordinates, nWidth, nHeight);
+  const int nMode1 = MaskTools::Filters::Lut::ModeToInt(mode1);
+  const int nMode2 = MaskTools::Filters::Lut::ModeToInt(mode2);
+  std::vector<T> values1(nWidth), values2(nWidth);
+  for (int j = 0; j < nHeight; j++)
+  {
+    reduce(values1.data(), rows1.get(j, pSrc1_T, nSrc1Pitch, MaskTools::Filters::Lut::copy_row<T>), nCoordinates / 2, nWidth, nMode1, bits_per_pixel);
+    reduce(values2.data(), rows2.get(j, pSrc2_T, nSrc2Pitch, MaskTools::Filters::Lut::copy_row<T>), nCoordinates / 2, nWidth, nMode2, bits_per_pixel);
+    const T *src[3] = { pDst, values1.data(), values2.data() };
+    compute_row(ctx, pDst, src, nWidth, bits_per_pixel);
+    pDst += nDstPitch;
+  }
+}
+
 namespace Filtering { namespace MaskTools { namespace Filters { namespace Lut { namespace SpatialExtended {
 
 Processor *processors_array[NUM_MODES][NUM_MODES] = 
@@ -246,5 +302,41 @@ ProcessorCtx *processors_realtime_32_array[NUM_MODES][NUM_MODES] =
   MPROCESSOR32_DUAL(custom_realtime_32_c, MedianizerBetter32<2>),
 };
 
+Processor *processors_rectangle_array[NUM_MODES][NUM_MODES] =
+{
+   MPROCESSOR_DUAL( rectangle_c, Nonizer ),
+   MPROCESSOR_DUAL( rectangle_c, Averager<int> ),
+   MPROCESSOR_DUAL( rectangle_c, Minimizer ),
+   MPROCESSOR_DUAL( rectangle_c, Maximizer ),
+   MPROCESSOR_DUAL( rectangle_c, Deviater<int> ),
+   MPROCESSOR_DUAL( rectangle_c, Rangizer ),
+   MPROCESSOR_DUAL( rectangle_c, Medianizer ),
+   MPROCESSOR_DUAL( rectangle_c, MedianizerBetter<4> ),
+   MPROCESSOR_DUAL( rectangle_c, MedianizerBetter<6> ),
+   MPROCESSOR_DUAL( rectangle_c, MedianizerBetter<2> ),
+};
+
+ProcessorCtx *processors_rectangle_realtime_8_array[NUM_MODES][NUM_MODES] =
+{
+  MPROCESSOR_DUAL(rectangle_realtime_8_c, Nonizer),
+  MPROCESSOR_DUAL(rectangle_realtime_8_c, Averager<int>),
+  MPROCESSOR_DUAL(rectangle_realtime_8_c, Minimizer),
+  MPROCESSOR_DUAL(rectangle_realtime_8_c, Maximizer),
+  MPROCESSOR_DUAL(rectangle_realtime_8_c, Deviater<int>),
+  MPROCESSOR_DUAL(rectangle_realtime_8_c, Rangizer),
+  MPROCESSOR_DUAL(rectangle_realtime_8_c, Medianizer),
+  MPROCESSOR_DUAL(rectangle_realtime_8_c, MedianizerBetter<4>),
+  MPROCESSOR_DUAL(rectangle_realtime_8_c, MedianizerBetter<6>),
+  MPROCESSOR_DUAL(rectangle_realtime_8_c, MedianizerBetter<2>),
+};
+
+Processor *network_array[2] = { &network_c<network_row_sse2>, &network_c<network_row_avx2> };
+ProcessorCtx *network_realtime_8_array[2] = { &network_realtime_c<Byte, 8, network_row_sse2>, &network_realtime_c<Byte, 8, network_row_avx2> };
+ProcessorCtx *network_realtime_10_array[2] = { &network_realtime_c<Word, 10, network_row_sse4_16>, &network_realtime_c<Word, 10, network_row_avx2_16> };
+ProcessorCtx *network_realtime_12_array[2] = { &network_realtime_c<Word, 12, network_row_sse4_16>, &network_realtime_c<Word, 12, network_row_avx2_16> };
+ProcessorCtx *network_realtime_14_array[2] = { &network_realtime_c<Word, 14, network_row_sse4_16>, &network_realtime_c<Word, 14, network_row_avx2_16> };
+ProcessorCtx *network_realtime_16_array[2] = { &network_realtime_c<Word, 16, network_row_sse4_16>, &network_realtime_c<Word, 16, network_row_avx2_16> };
+ProcessorCtx *network_realtime_32_array[2] = { &network_realtime_c<Float, 32, network_row32_sse2>, &network_realtime_c<Float, 32, network_row32_avx2> };
+
 } } } } }
 
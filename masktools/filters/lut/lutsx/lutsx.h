@@ -3,8 +3,13 @@
 
 #include "../../../common/base/filter.h"
 #include "../../../../common/parser/parser.h"
+#include "../../../../common/parser/context_pool.h"
+#include "../lut_data.h"
 
 #include "../functions.h"
+#include "../sliding_median.h"
+#include "../neighbourhood.h"
+#include "../engine.h"
 
 namespace Filtering { namespace MaskTools { namespace Filters { namespace Lut { namespace SpatialExtended {
 
@@ -18,6 +23,18 @@ extern ProcessorCtx *processors_realtime_12_array[NUM_MODES][NUM_MODES];
 extern ProcessorCtx *processors_realtime_14_array[NUM_MODES][NUM_MODES];
 extern ProcessorCtx *processors_realtime_16_array[NUM_MODES][NUM_MODES];
 extern ProcessorCtx *processors_realtime_32_array[NUM_MODES][NUM_MODES];
+// 8 bit, rectangle pixels: the median modes use a sliding histogram
+extern Processor *processors_rectangle_array[NUM_MODES][NUM_MODES];
+extern ProcessorCtx *processors_rectangle_realtime_8_array[NUM_MODES][NUM_MODES];
+// both modes among the vector ones (median of 3x3, cross and 5x5 pixels only): sse2 (sse4.1 at 10-16
+// bit), avx2
+extern Processor *network_array[2];
+extern ProcessorCtx *network_realtime_8_array[2];
+extern ProcessorCtx *network_realtime_10_array[2];
+extern ProcessorCtx *network_realtime_12_array[2];
+extern ProcessorCtx *network_realtime_14_array[2];
+extern ProcessorCtx *network_realtime_16_array[2];
+extern ProcessorCtx *network_realtime_32_array[2];
 
 class Lutsx : public MaskTools::Filter
 {
@@ -32,9 +49,11 @@ class Lutsx : public MaskTools::Filter
 
    // for realtime
    std::deque<Filtering::Parser::Symbol> *parsed_expressions[4];
+   std::shared_ptr<Parser::ContextPool> contexts[4]; // reused by the realtime processors
 
    int bits_per_pixel;
    bool realtime;
+   bool use_jit;
 
    
    String mode1, mode2;
@@ -57,13 +76,8 @@ class Lutsx : public MaskTools::Filter
        Parser::Context ctx(expr);
        Byte *lut = new Byte[256 * 256 * 256];
 
-       for ( int x = 0; x < 256; x++ ) {
-           for ( int y = 0; y < 256; y++ ) {
-               for ( int z = 0; z < 256; z++ ) {
-                   lut[(z<<16)+(x<<8)+y] = ctx.compute_byte_xyz(x, y, z);  // ZXY order!
-               }
-           }
-       }
+       static const int inputs[3] = { 2, 0, 1 }; // (z<<16)+(x<<8)+y, ZXY order!
+       fill_lut(lut, ctx, 8, inputs, 3);
        return lut;
    }
 
@@ -72,12 +86,12 @@ protected:
     {
         UNUSED(n); UNUSED(env);
         if (realtime) {
-          // thread safety
-          Parser::Context ctx(*parsed_expressions[nPlane]);
+          // thread safety: a context is used by one thread at a time
+          auto ctx = contexts[nPlane]->acquire();
           processorsCtx.best_processor(constraints[nPlane])(dst.data(), dst.pitch(),
             frames[0].plane(nPlane).data(), frames[0].plane(nPlane).pitch(),
             frames[1].plane(nPlane).data(), frames[1].plane(nPlane).pitch(),
-            &ctx, pCoordinates, nCoordinates, dst.width(), dst.height(), mode1, mode2);
+            ctx.get(), pCoordinates, nCoordinates, dst.width(), dst.height(), mode1, mode2);
         }
         else if (bits_per_pixel == 8) {
           processors.best_processor(constraints[nPlane])(dst.data(), dst.pitch(),
@@ -99,9 +113,28 @@ public:
      bits_per_pixel = bit_depths[C];
      realtime = parameters["realtime"].toBool();
 
+     ENGINE engine;
+     if (!EngineFromString(parameters["engine"].toString(), engine)) {
+       error = "invalid engine, use lut, interpreter or jit";
+       return;
+     }
+
+     if (engine == ENGINE_LUT) {
+       if (bits_per_pixel > 8) {
+         error = "lut engine is available for 8 bit clips only";
+         return;
+       }
+       realtime = false;
+     }
+     else if (engine != ENGINE_DEFAULT) {
+       realtime = true;
+     }
+
      if (bits_per_pixel > 8)
        realtime = true;
 
+     use_jit = realtime && engine != ENGINE_INTERPRETER;
+
       static const char *expr_strs[] = { "yExpr", "uExpr", "vExpr", "aExpr" };
 
       for (int i = 0; i < 4+1; ++i) {
@@ -173,10 +206,40 @@ public:
         case 16: processorsCtx.push_back(processors_realtime_16_array[ModeToInt(mode1)][ModeToInt(mode2)]); break;
         case 32: processorsCtx.push_back(processors_realtime_32_array[ModeToInt(mode1)][ModeToInt(mode2)]); break;
         }
+        for (int i = 0; i < 4; i++) {
+          if (parsed_expressions[i])
+            contexts[i] = Parser::ContextPool::shared(*parsed_expressions[i], bits_per_pixel, use_jit, (flags & CPU_AVX) != 0);
+        }
       }
       else {
         processors.push_back(processors_array[ModeToInt(mode1)][ModeToInt(mode2)]);
       }
+      if (bits_per_pixel == 8 && (ModeToInt(mode1) == MEDIANIZER4 || ModeToInt(mode2) == MEDIANIZER4) && SlidingMedian::is_rectangle(pCoordinates, nCoordinates)) {
+        if (realtime)
+          processorsCtx.push_back(Filtering::Processor<ProcessorCtx>(processors_rectangle_realtime_8_array[ModeToInt(mode1)][ModeToInt(mode2)], Constraint(CPU_NONE, 1, 1, 1, 1), 1));
+        else
+          processors.push_back(Filtering::Processor<Processor>(processors_rectangle_array[ModeToInt(mode1)][ModeToInt(mode2)], Constraint(CPU_NONE, 1, 1, 1, 1), 1));
+      }
+      if (is_network_reducible(ModeToInt(mode1), pCoordinates, nCoordinates) && is_network_reducible(ModeToInt(mode2), pCoordinates, nCoordinates)) {
+        const CpuFlags cpu = bits_per_pixel == 8 || bits_per_pixel == 32 ? CPU_SSE2 : CPU_SSE4_1;
+        if (realtime) {
+          ProcessorCtx **network = nullptr;
+          switch (bits_per_pixel) {
+          case 8: network = network_realtime_8_array; break;
+          case 10: network = network_realtime_10_array; break;
+          case 12: network = network_realtime_12_array; break;
+          case 14: network = network_realtime_14_array; break;
+          case 16: network = network_realtime_16_array; break;
+          case 32: network = network_realtime_32_array; break;
+          }
+          processorsCtx.push_back(Filtering::Processor<ProcessorCtx>(network[0], Constraint(cpu, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 1), 2));
+          processorsCtx.push_back(Filtering::Processor<ProcessorCtx>(network[1], Constraint(CPU_AVX2, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 1), 3));
+        }
+        else {
+          processors.push_back(Filtering::Processor<Processor>(network_array[0], Constraint(cpu, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 1), 2));
+          processors.push_back(Filtering::Processor<Processor>(network_array[1], Constraint(CPU_AVX2, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 1), 3));
+        }
+      }
    }
 
    ~Lutsx()
@@ -213,6 +276,7 @@ public:
 
       signature.add(Parameter(false, "realtime", false));
       signature.add(Parameter(String("y"), "aExpr", false));
+      signature.add(Parameter(String(""), "engine", false));
       return signature;
    }
 };
@@ -34,13 +34,30 @@ static void lut16_t_c(Byte *dstp, ptrdiff_t nDstPitch, const Byte *srcp, ptrdiff
   }
 }
 
+template<int bits_per_pixel>
+static void tiled16_t_c(Byte *dstp, ptrdiff_t nDstPitch, const Byte *srcp, ptrdiff_t nSrcPitch, int nWidth, int nHeight, TiledLut<Word> &lut)
+{
+  const Word max_pixel_value = (1 << bits_per_pixel) - 1;
+  for (int y = 0; y < nHeight; y++)
+  {
+    for (int x = 0; x < nWidth; x++) {
+      Word pixelX = reinterpret_cast<uint16_t *>(dstp)[x];
+      if (bits_per_pixel != 16) pixelX = min(pixelX, max_pixel_value);
+      Word pixelY = reinterpret_cast<const uint16_t *>(srcp)[x];
+      if (bits_per_pixel != 16) pixelY = min(pixelY, max_pixel_value);
+      reinterpret_cast<uint16_t *>(dstp)[x] = lut(pixelX, pixelY);
+    }
+    dstp += nDstPitch;
+    srcp += nSrcPitch;
+  }
+}
+
 void Filtering::MaskTools::Filters::Lut::Dual::realtime8_c(Byte *dstp, ptrdiff_t dst_pitch, const Byte *srcp, ptrdiff_t nSrcPitch, int width, int height, Parser::Context &ctx)
 {
   for (int y = 0; y < height; y++)
   {
-    for (int x = 0; x < width; x++) {
-      dstp[x] = ctx.compute_byte_xy(dstp[x], srcp[x]);
-    }
+    const Byte *src[2] = { dstp, srcp };
+    ctx.compute_row_byte(dstp, src, 2, width);
     dstp += dst_pitch;
     srcp += nSrcPitch;
   }
@@ -49,19 +66,11 @@ void Filtering::MaskTools::Filters::Lut::Dual::realtime8_c(Byte *dstp, ptrdiff_t
 template<int bits_per_pixel>
 static void realtime16_t_c(Byte *dstp, ptrdiff_t dst_pitch, const Byte *srcp, ptrdiff_t nSrcPitch, int width, int height, Parser::Context &ctx)
 {
-  const Word max_pixel_value = (1 << bits_per_pixel) - 1;
   for (int y = 0; y < height; y++)
   {
-    for (int x = 0; x < width; x++) {
-      Word pixelX = reinterpret_cast<uint16_t *>(dstp)[x];
-      if (bits_per_pixel != 16) pixelX = min(pixelX, max_pixel_value); // clamp input below 16 bit
-      Word pixelY = reinterpret_cast<const uint16_t *>(srcp)[x];
-      if (bits_per_pixel != 16) pixelY = min(pixelY, max_pixel_value); // clamp input below 16 bit
-
-      Word result = ctx.compute_word_xy<bits_per_pixel>(pixelX, pixelY);
-
-      reinterpret_cast<uint16_t *>(dstp)[x] = result;
-    }
+    // inputs clamped below 16 bit
+    const Word *src[2] = { reinterpret_cast<const Word *>(dstp), reinterpret_cast<const Word *>(srcp) };
+    ctx.compute_row_word(reinterpret_cast<Word *>(dstp), src, 2, width, bits_per_pixel);
     dstp += dst_pitch;
     srcp += nSrcPitch;
   }
@@ -71,9 +80,8 @@ void Filtering::MaskTools::Filters::Lut::Dual::realtime32_c(Byte *dstp, ptrdiff_
 {
   for (int y = 0; y < height; y++)
   {
-    for (int x = 0; x < width; x++) {
-      reinterpret_cast<Float *>(dstp)[x] = ctx.compute_float_xy(reinterpret_cast<Float *>(dstp)[x], reinterpret_cast<const Float *>(srcp)[x]);
-    }
+    const Float *src[2] = { reinterpret_cast<const Float *>(dstp), reinterpret_cast<const Float *>(srcp) };
+    ctx.compute_row_float(reinterpret_cast<Float *>(dstp), src, 2, width);
     dstp += dst_pitch;
     srcp += nSrcPitch;
   }
@@ -99,6 +107,9 @@ namespace Filtering {
           Processor16 *lut14_c = &lut16_t_c<14>;
           Processor16 *lut16_c = &lut16_t_c<16>;
 
+          ProcessorTiled *tiled14_c = &tiled16_t_c<14>;
+          ProcessorTiled *tiled16_c = &tiled16_t_c<16>;
+
           ProcessorCtx *realtime10_c = &realtime16_t_c<10>;
           ProcessorCtx *realtime12_c = &realtime16_t_c<12>;
           ProcessorCtx *realtime14_c = &realtime16_t_c<14>;
@@ -3,20 +3,29 @@
 
 #include "../../../common/base/filter.h"
 #include "../../../../common/parser/parser.h"
+#include "../../../../common/parser/context_pool.h"
 #include "../lut_data.h"
+#include "../tiled_lut.h"
 #include "../lut_kernel.h"
+#include "../engine.h"
+#include "../native.h"
 
 namespace Filtering { namespace MaskTools { namespace Filters { namespace Lut { namespace Dual {
 
 typedef void(Processor)(Byte *pDst, ptrdiff_t nDstPitch, const Byte *pSrc, ptrdiff_t nSrcPitch, int nWidth, int nHeight, const Byte lut[65536]);
 typedef void(Processor16)(Byte *pDst, ptrdiff_t nDstPitch, const Byte *pSrc, ptrdiff_t nSrcPitch, int nWidth, int nHeight, const Word *lut);
 typedef void(ProcessorCtx)(Byte *pDst, ptrdiff_t nDstPitch, const Byte *pSrc, ptrdiff_t nSrcPitch, int nWidth, int nHeight, Parser::Context &ctx);
+typedef void(ProcessorTiled)(Byte *pDst, ptrdiff_t nDstPitch, const Byte *pSrc, ptrdiff_t nSrcPitch, int nWidth, int nHeight, TiledLut<Word> &lut);
 
 Processor lut_c;
 extern Processor16 *lut10_c;
 extern Processor16 *lut12_c;
 extern Processor16 *lut14_c;
 extern Processor16 *lut16_c;
+extern Processor16 *lut10_avx2;
+extern Processor16 *lut12_avx2;
+extern ProcessorTiled *tiled14_c;
+extern ProcessorTiled *tiled16_c;
 
 ProcessorCtx realtime8_c;
 extern ProcessorCtx *realtime10_c;
@@ -28,29 +37,67 @@ ProcessorCtx realtime32_c;
 
 class Lutxy : public MaskTools::Filter
 {
-   std::unique_ptr<LutData> luts;
+   std::shared_ptr<LutData> luts;
    int planeMap[4];
+   std::vector<std::unique_ptr<Native>> natives; // by planeMap, null when no kernel matches
+   std::vector<std::unique_ptr<TiledLut<Word>>> tiled_luts; // by planeMap, 14 and 16 bit two input luts
+
+   // for realtime
+   std::deque<Filtering::Parser::Symbol> *parsed_expressions[4];
+   std::shared_ptr<Parser::ContextPool> contexts[4]; // reused by the realtime processors
 
    Processor *processor;
-   Processor16 *processor16;
+   ProcessorList<Processor16> processors16;
+   ProcessorCtx *processorCtx;
+   ProcessorTiled *processorTiled;
+   ReducedLutProcessor *reducedProcessor;
+   int input_mask; // variables referenced by the expressions, the lut only spans those
+   int num_input;
    int bits_per_pixel;
    bool realtime;
+   bool tiled; // lut computed on demand, too large to be computed upfront
+   bool use_jit;
 
 protected:
     virtual void process(int n, const Plane<Byte> &dst, int nPlane, const ::Filtering::Frame<const Byte> frames[4], const Constraint constraints[4], PNeoEnv env) override
     {
         UNUSED(n);
-        UNUSED(constraints);
-        if (::IsCUDA(env)) {
-           const uint8_t* const pSrc[2] = { frames[0].plane(nPlane).data(), frames[1].plane(nPlane).data() };
-           lut_cuda(bits_per_pixel, 2, dst.data(), pSrc, (int)dst.pitch(), dst.width(), dst.height(),
+        if (natives[planeMap[nPlane]] && !::IsCUDA(env)) {
+          natives[planeMap[nPlane]]->process(dst.data(), dst.pitch(), frames[0].plane(nPlane).data(), frames[0].plane(nPlane).pitch(),
+           dst.width(), dst.height(), dst.origheight(), constraints[nPlane]);
+        }
+        else if (realtime) {
+          // thread safety: a context is used by one thread at a time
+          auto ctx = contexts[nPlane]->acquire();
+          processorCtx(dst.data(), dst.pitch(), frames[0].plane(nPlane).data(), frames[0].plane(nPlane).pitch(), dst.width(), dst.height(), *ctx);
+        }
+        else if (tiled) {
+          TiledLut<Word> &lut = *tiled_luts[planeMap[nPlane]];
+          auto reader = lut.read();
+          processorTiled(dst.data(), dst.pitch(), frames[0].plane(nPlane).data(), frames[0].plane(nPlane).pitch(), dst.width(), dst.height(), lut);
+        }
+        else if (::IsCUDA(env)) {
+           const uint8_t* const pFrames[2] = { frames[0].plane(nPlane).data(), frames[1].plane(nPlane).data() };
+           const uint8_t* pSrc[2];
+           for (int i = 0, k = 0; i < 2; i++) {
+              if (input_mask & (1 << i))
+                 pSrc[k++] = pFrames[i];
+           }
+           lut_cuda(bits_per_pixel, num_input, dst.data(), pSrc, (int)dst.pitch(), dst.width(), dst.height(),
               luts->GetTable(planeMap[nPlane], env), env);
         }
+        else if (input_mask != 3) {
+          // one dimensional lut, x is the destination plane
+          const Byte *pSrc[1] = { input_mask == 1 ? dst.data() : frames[0].plane(nPlane).data() };
+          const ptrdiff_t nSrcPitch[1] = { input_mask == 1 ? dst.pitch() : frames[0].plane(nPlane).pitch() };
+          reducedProcessor(dst.data(), dst.pitch(), pSrc, nSrcPitch, dst.width(), dst.height(), bits_per_pixel,
+           luts->GetTable(planeMap[nPlane], env));
+        }
         else if (bits_per_pixel == 8)
           processor(dst.data(), dst.pitch(), frames[0].plane(nPlane).data(), frames[0].plane(nPlane).pitch(), dst.width(), dst.height(), 
            (const uint8_t*)luts->GetTable(planeMap[nPlane], env));
         else if (bits_per_pixel <= 16)
-          processor16(dst.data(), dst.pitch(), frames[0].plane(nPlane).data(), frames[0].plane(nPlane).pitch(), dst.width(), dst.height(), 
+          processors16.best_processor(constraints[nPlane])(dst.data(), dst.pitch(), frames[0].plane(nPlane).data(), frames[0].plane(nPlane).pitch(), dst.width(), dst.height(), 
            (const uint16_t*)luts->GetTable(planeMap[nPlane], env));
     }
 
@@ -58,20 +105,45 @@ public:
    Lutxy(const Parameters &parameters, CpuFlags cpuFlags, PNeoEnv env)
       : MaskTools::Filter( parameters, FilterProcessingType::INPLACE, (CpuFlags)cpuFlags)
    {
+      nStripeHalo = 0;
       static const char *expr_strs[] = { "yExpr", "uExpr", "vExpr", "aExpr" };
 
       Parser::Parser parser = Parser::getDefaultParser().addSymbol(Parser::Symbol::X).addSymbol(Parser::Symbol::Y);
 
+      for (int i = 0; i < 4; i++) {
+        parsed_expressions[i] = nullptr;
+      }
+
       bits_per_pixel = bit_depths[C];
       realtime = parameters["realtime"].toBool();
 
-      if (realtime) {
-         error = "realtime is not supported";
-         return;
+      ENGINE engine;
+      if (!EngineFromString(parameters["engine"].toString(), engine)) {
+        error = "invalid engine, use lut, interpreter or jit";
+        return;
+      }
+
+      switch (bits_per_pixel) {
+      case 8: processor = lut_c; processorCtx = realtime8_c; break;
+      case 10:
+        processors16.push_back(Filtering::Processor<Processor16>(lut10_c, Constraint(CPU_NONE, 1, 1, 1, 1), 0));
+        processors16.push_back(Filtering::Processor<Processor16>(lut10_avx2, Constraint(CPU_AVX2, 1, 1, 1, 1), 1));
+        processorCtx = realtime10_c;
+        break;
+      case 12:
+        processors16.push_back(Filtering::Processor<Processor16>(lut12_c, Constraint(CPU_NONE, 1, 1, 1, 1), 0));
+        processors16.push_back(Filtering::Processor<Processor16>(lut12_avx2, Constraint(CPU_AVX2, 1, 1, 1, 1), 1));
+        processorCtx = realtime12_c;
+        break;
+      // two input luts are tiled above 12 bits, the table index would not fit the gather's 32 bit either
+      case 14: processors16.push_back(Filtering::Processor<Processor16>(lut14_c, Constraint(CPU_NONE, 1, 1, 1, 1), 0)); processorTiled = tiled14_c; processorCtx = realtime14_c; break;
+      case 16: processors16.push_back(Filtering::Processor<Processor16>(lut16_c, Constraint(CPU_NONE, 1, 1, 1, 1), 0)); processorTiled = tiled16_c; processorCtx = realtime16_c; break;
+      case 32: processorCtx = realtime32_c; break;
       }
 
       std::vector<std::unique_ptr<Parser::Context>> exprs;
       int firstGeneric = -1;
+      int firstGenericPlane = -1;
 
       /* compute the luts */
       for ( int i = 0; i < 4; i++ )
@@ -92,10 +164,12 @@ public:
          }
          else if (firstGeneric != -1) {
             planeMap[i] = firstGeneric;
+            parsed_expressions[i] = new std::deque<Parser::Symbol>(*parsed_expressions[firstGenericPlane]);
             continue;
          }
          else {
             firstGeneric = (int)exprs.size();
+            firstGenericPlane = i;
             parser.parse(parameters["expr"].toString(), " ");
          }
 
@@ -107,14 +181,75 @@ public:
             error = "invalid expression in the lut";
             return;
          }
+
+         parsed_expressions[i] = new std::deque<Parser::Symbol>(parser.getExpression());
+      }
+
+      // expressions of x or y only get a one dimensional lut
+      input_mask = lut_input_mask(exprs);
+      num_input = lut_input_count(input_mask);
+
+      // two dimensional luts above 12 bits are tiled, no lut for float
+      const bool lut_available = bits_per_pixel != 32;
+      tiled = bits_per_pixel * num_input > 24;
+
+      if (engine == ENGINE_LUT) {
+        if (!lut_available) {
+          error = "lut engine is not available for float";
+          return;
+        }
+        realtime = false;
+      }
+      else if (engine != ENGINE_DEFAULT) {
+        realtime = true;
       }
 
-      luts = make_lut_data(bits_per_pixel, 2, exprs, env);
+      if (!lut_available)
+        realtime = true;
+
+      use_jit = realtime && engine != ENGINE_INTERPRETER;
+
+      if (realtime) {
+        for (int i = 0; i < 4; i++) {
+          if (parsed_expressions[i])
+            contexts[i] = Parser::ContextPool::shared(*parsed_expressions[i], bits_per_pixel, use_jit, (flags & CPU_AVX) != 0);
+        }
+      }
+
+      // min, max, average, makediff, adddiff and absdiff have their own kernels, the lut stays for cuda
+      for (auto &expr : exprs) {
+        double threshold = 0;
+        NATIVE kind = engine == ENGINE_DEFAULT ? Native::recognize(*expr, 2, bits_per_pixel, threshold) : NATIVE_NONE;
+        natives.emplace_back(kind != NATIVE_NONE ? new Native(kind, bits_per_pixel, threshold) : nullptr);
+      }
+
+      if (!realtime && tiled) {
+        tiled_luts.resize(exprs.size());
+        for (int i = 0; i < 4; i++) {
+          if (planeMap[i] >= 0 && !tiled_luts[planeMap[i]])
+            tiled_luts[planeMap[i]].reset(new TiledLut<Word>(*parsed_expressions[i], bits_per_pixel, 8, 8, tiled_lut_budget));
+        }
+      }
+      else if (!realtime) {
+        if (input_mask == 3)
+          luts = make_lut_data(bits_per_pixel, 2, exprs, env);
+        else {
+          luts = make_reduced_lut_data(bits_per_pixel, input_mask, exprs, env);
+          reducedProcessor = get_reduced_lut_processor(bits_per_pixel, num_input);
+        }
+      }
+   }
+
+   ~Lutxy()
+   {
+      for (int i = 0; i < 4; i++) {
+        delete parsed_expressions[i];
+      }
    }
 
    InputConfiguration &input_configuration() const { return InPlaceTwoFrame(); }
 	InputConfiguration &input_configuration_cuda() const { return TwoFrame(); }
-   bool is_cuda_available() { return true; }
+   bool is_cuda_available() { return !realtime && !tiled; }
 
    static Signature filter_signature()
    {
@@ -131,6 +266,7 @@ public:
 
       signature.add(Parameter(false, "realtime", false));
       signature.add(Parameter(String("x"), "aExpr", false));
+      signature.add(Parameter(String(""), "engine", false));
       return signature;
    }
 };
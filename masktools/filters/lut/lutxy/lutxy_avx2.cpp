@@ -0,0 +1,47 @@
+#include "lutxy.h"
+#include "../../../common/simd.h"
+
+using namespace Filtering;
+
+// (x << bits_per_pixel) + y for 8 pixels
+template<int bits_per_pixel>
+static MT_FORCEINLINE __m256i index_avx2(const __m128i &x, const __m128i &y)
+{
+    return _mm256_add_epi32(_mm256_slli_epi32(_mm256_cvtepu16_epi32(x), bits_per_pixel), _mm256_cvtepu16_epi32(y));
+}
+
+template<int bits_per_pixel>
+static void lut16_t_avx2(Byte *dstp, ptrdiff_t nDstPitch, const Byte *srcp, ptrdiff_t nSrcPitch, int nWidth, int nHeight, const Word *lut)
+{
+    const int wMod16 = (nWidth / 16) * 16;
+    const Word max_pixel_value = (1 << bits_per_pixel) - 1;
+    auto vMax = _mm256_set1_epi16((short)max_pixel_value);
+
+    for (int y = 0; y < nHeight; y++)
+    {
+        Word *pDst = reinterpret_cast<Word *>(dstp);
+        const Word *pSrc = reinterpret_cast<const Word *>(srcp);
+        for (int x = 0; x < wMod16; x += 16) {
+            auto pixelX = _mm256_min_epu16(simd256_load_si256<MemoryMode::SSE2_UNALIGNED>(reinterpret_cast<const __m256i*>(pDst + x)), vMax);
+            auto pixelY = _mm256_min_epu16(simd256_load_si256<MemoryMode::SSE2_UNALIGNED>(reinterpret_cast<const __m256i*>(pSrc + x)), vMax);
+            auto index_lo = index_avx2<bits_per_pixel>(_mm256_castsi256_si128(pixelX), _mm256_castsi256_si128(pixelY));
+            auto index_hi = index_avx2<bits_per_pixel>(_mm256_extracti128_si256(pixelX, 1), _mm256_extracti128_si256(pixelY, 1));
+            simd256_store_si256<MemoryMode::SSE2_UNALIGNED>(reinterpret_cast<__m256i*>(pDst + x), lut16_gather_avx2(lut, index_lo, index_hi));
+        }
+        for (int x = wMod16; x < nWidth; x++) {
+            Word pixelX = min(pDst[x], max_pixel_value);
+            Word pixelY = min(pSrc[x], max_pixel_value);
+            pDst[x] = lut[(pixelX << bits_per_pixel) + pixelY];
+        }
+        dstp += nDstPitch;
+        srcp += nSrcPitch;
+    }
+    _mm256_zeroupper();
+}
+
+namespace Filtering { namespace MaskTools { namespace Filters { namespace Lut { namespace Dual {
+
+Processor16 *lut10_avx2 = &lut16_t_avx2<10>;
+Processor16 *lut12_avx2 = &lut16_t_avx2<12>;
+
+} } } } }
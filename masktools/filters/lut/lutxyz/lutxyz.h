@@ -3,7 +3,9 @@
 
 #include "../../../common/base/filter.h"
 #include "../../../../common/parser/parser.h"
+#include "../../../../common/parser/context_pool.h"
 #include "../lut_data.h"
+#include "../engine.h"
 
 namespace Filtering { namespace MaskTools { namespace Filters { namespace Lut { namespace Trial {
 
@@ -21,55 +23,54 @@ ProcessorCtx realtime32_c;
 
 class Lutxyz : public MaskTools::Filter
 {
-    struct Lut {
-        bool used;
-        Byte *ptr;
-    };
-
-   Lut luts[4+1];
-
-   static Byte *calculateLut(const std::deque<Filtering::Parser::Symbol> &expr) {
-       Parser::Context ctx(expr);
-       Byte *lut = new Byte[256 * 256 * 256];
-
-       for ( int x = 0; x < 256; x++ ) {
-           for ( int y = 0; y < 256; y++ ) {
-               for ( int z = 0; z < 256; z++ ) {
-                   lut[(x<<16)+(y<<8)+z] = ctx.compute_byte_xyz(x, y, z); 
-               }
-           }
-       }
-       return lut;
-   }
+   std::shared_ptr<LutData> luts; // (x<<16)+(y<<8)+z when all of them are used
+   int planeMap[4];
 
    // for realtime
    std::deque<Filtering::Parser::Symbol> *parsed_expressions[4];
+   std::shared_ptr<Parser::ContextPool> contexts[4]; // reused by the realtime processors
 
    ProcessorCtx *processorCtx;
    ProcessorCtx *processorCtx16;
    ProcessorCtx *processorCtx32;
+   ReducedLutProcessor *reducedProcessor;
+   int input_mask; // variables referenced by the expressions, the lut only spans those
    int bits_per_pixel;
    bool realtime;
+   bool use_jit;
 
 protected:
     virtual void process(int n, const Plane<Byte> &dst, int nPlane, const Filtering::Frame<const Byte> frames[4], const Constraint constraints[4], PNeoEnv env) override
     {
         UNUSED(n);
         UNUSED(constraints);
-        UNUSED(env);
         if (realtime) {
-          // thread safety
-          Parser::Context ctx(*parsed_expressions[nPlane]);
+          // thread safety: a context is used by one thread at a time
+          auto ctx = contexts[nPlane]->acquire();
           processorCtx(dst.data(), dst.pitch(), 
             frames[0].plane(nPlane).data(), frames[0].plane(nPlane).pitch(), 
             frames[1].plane(nPlane).data(), frames[1].plane(nPlane).pitch(),
-            dst.width(), dst.height(), ctx);
+            dst.width(), dst.height(), *ctx);
+        }
+        else if (input_mask != 7) {
+          const Byte *pPlanes[3] = { dst.data(), frames[0].plane(nPlane).data(), frames[1].plane(nPlane).data() };
+          const ptrdiff_t nPitches[3] = { dst.pitch(), frames[0].plane(nPlane).pitch(), frames[1].plane(nPlane).pitch() };
+          const Byte *pSrc[3];
+          ptrdiff_t nSrcPitch[3];
+          for (int i = 0, k = 0; i < 3; i++) {
+            if (input_mask & (1 << i)) {
+              pSrc[k] = pPlanes[i];
+              nSrcPitch[k++] = nPitches[i];
+            }
+          }
+          reducedProcessor(dst.data(), dst.pitch(), pSrc, nSrcPitch, dst.width(), dst.height(), bits_per_pixel,
+            luts->GetTable(planeMap[nPlane], env));
         }
-        else if (bits_per_pixel == 8) {
+        else {
           lut_c(dst.data(), dst.pitch(),
             frames[0].plane(nPlane).data(), frames[0].plane(nPlane).pitch(),
             frames[1].plane(nPlane).data(), frames[1].plane(nPlane).pitch(),
-            dst.width(), dst.height(), luts[nPlane].ptr);
+            dst.width(), dst.height(), (const Byte *)luts->GetTable(planeMap[nPlane], env));
         }
     }
 
@@ -77,29 +78,33 @@ public:
    Lutxyz(const Parameters &parameters, CpuFlags cpuFlags, PNeoEnv env)
       : MaskTools::Filter( parameters, FilterProcessingType::INPLACE, (CpuFlags)cpuFlags)
    {
-      UNUSED(env);
+      nStripeHalo = 0;
       for (int i = 0; i < 4; i++) {
         parsed_expressions[i] = nullptr;
       }
 
-      for (int i = 0; i < 4+1; ++i) {
-          luts[i].used = false;
-          luts[i].ptr = nullptr;
-      }
-
       bits_per_pixel = bit_depths[C];
       realtime = parameters["realtime"].toBool();
-      
-      if (bits_per_pixel > 8)
-        realtime = true;
+
+      ENGINE engine;
+      if (!EngineFromString(parameters["engine"].toString(), engine)) {
+        error = "invalid engine, use lut, interpreter or jit";
+        return;
+      }
 
       static const char *expr_strs[] = { "yExpr", "uExpr", "vExpr", "aExpr" };
 
       Parser::Parser parser = Parser::getDefaultParser().addSymbol(Parser::Symbol::X).addSymbol(Parser::Symbol::Y).addSymbol(Parser::Symbol::Z);
 
-      /* compute the luts */
+      std::vector<std::unique_ptr<Parser::Context>> exprs;
+      int firstGeneric = -1;
+      int firstGenericPlane = -1;
+
+      /* parse the expressions */
       for ( int i = 0; i < 4; i++ )
       {
+          planeMap[i] = -1;
+
           if (operators[i] != PROCESS) {
               continue;
           }
@@ -109,58 +114,78 @@ public:
               continue;
           }
 
-          bool customExpressionDefined = false;
           if (parameters[expr_strs[i]].is_defined()) {
             parser.parse(parameters[expr_strs[i]].toString(), " ");
-            customExpressionDefined = true;
           }
-          else
+          else if (firstGeneric != -1) {
+            planeMap[i] = firstGeneric;
+            parsed_expressions[i] = new std::deque<Parser::Symbol>(*parsed_expressions[firstGenericPlane]);
+            continue;
+          }
+          else {
+            firstGeneric = (int)exprs.size();
+            firstGenericPlane = i;
             parser.parse(parameters["expr"].toString(), " ");
+          }
 
-          // for check:
-          Parser::Context ctx(parser.getExpression());
+          planeMap[i] = (int)exprs.size();
+          exprs.emplace_back(new Parser::Context(parser.getExpression()));
 
-          if (!ctx.check())
+          if (!exprs.back()->check())
           {
             error = "invalid expression in the lut";
             return;
           }
 
-          if (realtime) {
-            parsed_expressions[i] = new std::deque<Parser::Symbol>(parser.getExpression());
+          parsed_expressions[i] = new std::deque<Parser::Symbol>(parser.getExpression());
+      }
 
-            switch (bits_per_pixel) {
-            case 8: processorCtx = realtime8_c; break;
-            case 10: processorCtx = realtime10_c; break;
-            case 12: processorCtx = realtime12_c; break;
-            case 14: processorCtx = realtime14_c; break;
-            case 16: processorCtx = realtime16_c; break;
-            case 32: processorCtx = realtime32_c; break;
-            }
-            continue;
-          }
+      // expressions ignoring some of x, y and z get a smaller lut, up to 12 bits for two inputs
+      input_mask = lut_input_mask(exprs);
+      const int num_input = lut_input_count(input_mask);
+      const bool lut_available = input_mask == 7 ? bits_per_pixel == 8 : bits_per_pixel != 32 && bits_per_pixel * num_input <= 24;
 
-          if (customExpressionDefined) {
-              luts[i].used = true;
-              luts[i].ptr = calculateLut(parser.getExpression()); // 8 bit always
-          }
-          else {
-              if (luts[4].ptr == nullptr) {
-                  luts[4].used = true;
-                  luts[4].ptr = calculateLut(parser.getExpression());
-              }
-              luts[i].ptr = luts[4].ptr;
-          }
+      if (engine == ENGINE_LUT) {
+        if (!lut_available) {
+          error = "lut engine is not available for this bit depth";
+          return;
+        }
+        realtime = false;
+      }
+      else if (engine != ENGINE_DEFAULT) {
+        realtime = true;
+      }
+
+      if (!lut_available)
+        realtime = true;
+
+      use_jit = realtime && engine != ENGINE_INTERPRETER;
+
+      if (realtime) {
+        switch (bits_per_pixel) {
+        case 8: processorCtx = realtime8_c; break;
+        case 10: processorCtx = realtime10_c; break;
+        case 12: processorCtx = realtime12_c; break;
+        case 14: processorCtx = realtime14_c; break;
+        case 16: processorCtx = realtime16_c; break;
+        case 32: processorCtx = realtime32_c; break;
+        }
+        for (int i = 0; i < 4; i++) {
+          if (parsed_expressions[i])
+            contexts[i] = Parser::ContextPool::shared(*parsed_expressions[i], bits_per_pixel, use_jit, (flags & CPU_AVX) != 0);
+        }
+      }
+      else {
+        if (exprs.empty())
+          return;
+        /* 8 bit always for the full xyz lut, it goes through the table cache like the reduced ones */
+        luts = make_reduced_lut_data(bits_per_pixel, input_mask, exprs, env);
+        reducedProcessor = get_reduced_lut_processor(bits_per_pixel, num_input);
       }
    }
 
    ~Lutxyz()
    {
-       for (int i = 0; i < 4+1; ++i) {
-           if (luts[i].used) {
-               delete[] luts[i].ptr;
-           }
-       }
        for (int i = 0; i < 4; i++) {
          delete parsed_expressions[i];
        }
@@ -185,6 +210,7 @@ public:
 
       signature.add(Parameter(false, "realtime", false));
       signature.add(Parameter(String("x"), "aExpr", false));
+      signature.add(Parameter(String(""), "engine", false));
       return signature;
    }
 };
@@ -23,9 +23,8 @@ void Filtering::MaskTools::Filters::Lut::Quad::realtime8_c(Byte *dstp, ptrdiff_t
 {
   for (int y = 0; y < height; y++)
   {
-    for (int x = 0; x < width; x++) {
-      dstp[x] = ctx.compute_byte_xyza(dstp[x], srcp[x], srcp2[x], srcp3[x]);
-    }
+    const Byte *src[4] = { dstp, srcp, srcp2, srcp3 };
+    ctx.compute_row_byte(dstp, src, 4, width);
     dstp += dst_pitch;
     srcp += nSrcPitch;
     srcp2 += nSrc2Pitch;
@@ -37,23 +36,12 @@ template<int bits_per_pixel>
 static void realtime16_t_c(Byte *dstp, ptrdiff_t dst_pitch, const Byte *srcp, ptrdiff_t nSrcPitch, 
   const Byte *srcp2, ptrdiff_t nSrc2Pitch, const Byte *srcp3, ptrdiff_t nSrc3Pitch, int width, int height, Parser::Context &ctx)
 {
-  const Word max_pixel_value = (1 << bits_per_pixel) - 1;
   for (int y = 0; y < height; y++)
   {
-    for (int x = 0; x < width; x++) {
-      Word pixelX = reinterpret_cast<uint16_t *>(dstp)[x];
-      if (bits_per_pixel != 16) pixelX = min(pixelX, max_pixel_value); // clamp input below 16 bit
-      Word pixelY = reinterpret_cast<const uint16_t *>(srcp)[x];
-      if (bits_per_pixel != 16) pixelY = min(pixelY, max_pixel_value); // clamp input below 16 bit
-      Word pixelZ = reinterpret_cast<const uint16_t *>(srcp2)[x];
-      if (bits_per_pixel != 16) pixelZ = min(pixelZ, max_pixel_value); // clamp input below 16 bit
-      Word pixelA = reinterpret_cast<const uint16_t *>(srcp3)[x];
-      if (bits_per_pixel != 16) pixelA = min(pixelA, max_pixel_value); // clamp input below 16 bit
-
-      Word result = ctx.compute_word_xyza<bits_per_pixel>(pixelX, pixelY, pixelZ, pixelA);
-
-      reinterpret_cast<uint16_t *>(dstp)[x] = result;
-    }
+    // inputs clamped below 16 bit
+    const Word *src[4] = { reinterpret_cast<const Word *>(dstp), reinterpret_cast<const Word *>(srcp),
+      reinterpret_cast<const Word *>(srcp2), reinterpret_cast<const Word *>(srcp3) };
+    ctx.compute_row_word(reinterpret_cast<Word *>(dstp), src, 4, width, bits_per_pixel);
     dstp += dst_pitch;
     srcp += nSrcPitch;
     srcp2 += nSrc2Pitch;
@@ -66,12 +54,9 @@ void Filtering::MaskTools::Filters::Lut::Quad::realtime32_c(Byte *dstp, ptrdiff_
 {
   for (int y = 0; y < height; y++)
   {
-    for (int x = 0; x < width; x++) {
-      reinterpret_cast<Float *>(dstp)[x] = ctx.compute_float_xyza(reinterpret_cast<Float *>(dstp)[x],
-        reinterpret_cast<const Float *>(srcp)[x],
-        reinterpret_cast<const Float *>(srcp2)[x],
-        reinterpret_cast<const Float *>(srcp3)[x]);
-    }
+    const Float *src[4] = { reinterpret_cast<const Float *>(dstp), reinterpret_cast<const Float *>(srcp),
+      reinterpret_cast<const Float *>(srcp2), reinterpret_cast<const Float *>(srcp3) };
+    ctx.compute_row_float(reinterpret_cast<Float *>(dstp), src, 4, width);
     dstp += dst_pitch;
     srcp += nSrcPitch;
     srcp2 += nSrc2Pitch;
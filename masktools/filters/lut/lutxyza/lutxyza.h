@@ -3,6 +3,9 @@
 
 #include "../../../common/base/filter.h"
 #include "../../../../common/parser/parser.h"
+#include "../../../../common/parser/context_pool.h"
+#include "../lut_data.h"
+#include "../engine.h"
 
 namespace Filtering { namespace MaskTools { namespace Filters { namespace Lut { namespace Quad {
 
@@ -25,53 +28,65 @@ class Lutxyza : public MaskTools::Filter
         Byte *ptr;
     };
 
-   Lut luts[4+1];
+   Lut luts[4];
+   std::shared_ptr<LutData> reduced_luts;
+   int planeMap[4];
 
    static Byte *calculateLut(const std::deque<Filtering::Parser::Symbol> &expr, int bits_per_pixel) {
        Parser::Context ctx(expr);
        size_t bufsize = ((size_t)1 << bits_per_pixel);
        bufsize = bufsize * bufsize*bufsize*bufsize;
        Byte *lut = new Byte[bufsize];
-       // expr = "x y + z + a + 4 /" -> 2 min lut calculation time on i7-3770
+       // expr = "x y + z + a + 4 /" -> 2 min lut calculation time on i7-3770, single threaded and one pixel at a time
        // When is it worth? LUT or realtime?
        // Lut calculation takes 256*256*256*256 expr.evaluation
        // This equals to 2071 frames in 1920x1080 (one plane)
-       for ( int x = 0; x < 256; x++ ) {
-           for ( int y = 0; y < 256; y++ ) {
-               for ( int z = 0; z < 256; z++ ) {
-                 for (int a = 0; a < 256; a++) {
-                   lut[((size_t)x << 24) + (y << 16) + (z << 8) + a] = ctx.compute_byte_xyza(x, y, z, a);
-                 }
-               }
-           }
-       }
+       static const int inputs[4] = { 0, 1, 2, 3 }; // (x<<24)+(y<<16)+(z<<8)+a
+       fill_lut(lut, ctx, 8, inputs, 4);
        return lut;
    }
 
    // for realtime
    std::deque<Filtering::Parser::Symbol> *parsed_expressions[4];
+   std::shared_ptr<Parser::ContextPool> contexts[4]; // reused by the realtime processors
 
    Processor *processor;
    ProcessorCtx *processorCtx;
    ProcessorCtx *processorCtx16;
    ProcessorCtx *processorCtx32;
+   ReducedLutProcessor *reducedProcessor;
+   int input_mask; // variables referenced by the expressions, the lut only spans those
    int bits_per_pixel;
    bool realtime;
+   bool use_jit;
 
 protected:
     virtual void process(int n, const Plane<Byte> &dst, int nPlane, const Filtering::Frame<const Byte> frames[4], const Constraint constraints[4], PNeoEnv env) override
     {
         UNUSED(n);
         UNUSED(constraints);
-        UNUSED(env);
         if (realtime) {
-          // thread safety
-          Parser::Context ctx(*parsed_expressions[nPlane]);
+          // thread safety: a context is used by one thread at a time
+          auto ctx = contexts[nPlane]->acquire();
           processorCtx(dst.data(), dst.pitch(), 
             frames[0].plane(nPlane).data(), frames[0].plane(nPlane).pitch(), 
             frames[1].plane(nPlane).data(), frames[1].plane(nPlane).pitch(),
             frames[2].plane(nPlane).data(), frames[2].plane(nPlane).pitch(),
-            dst.width(), dst.height(), ctx);
+            dst.width(), dst.height(), *ctx);
+        }
+        else if (input_mask != 15) {
+          const Byte *pPlanes[4] = { dst.data(), frames[0].plane(nPlane).data(), frames[1].plane(nPlane).data(), frames[2].plane(nPlane).data() };
+          const ptrdiff_t nPitches[4] = { dst.pitch(), frames[0].plane(nPlane).pitch(), frames[1].plane(nPlane).pitch(), frames[2].plane(nPlane).pitch() };
+          const Byte *pSrc[4];
+          ptrdiff_t nSrcPitch[4];
+          for (int i = 0, k = 0; i < 4; i++) {
+            if (input_mask & (1 << i)) {
+              pSrc[k] = pPlanes[i];
+              nSrcPitch[k++] = nPitches[i];
+            }
+          }
+          reducedProcessor(dst.data(), dst.pitch(), pSrc, nSrcPitch, dst.width(), dst.height(), bits_per_pixel,
+            reduced_luts->GetTable(planeMap[nPlane], env));
         }
         else {
           // 4D lut! 8 bit only
@@ -87,33 +102,38 @@ public:
    Lutxyza(const Parameters &parameters, CpuFlags cpuFlags, PNeoEnv env)
       : MaskTools::Filter( parameters, FilterProcessingType::INPLACE, (CpuFlags)cpuFlags)
    {
-      UNUSED(env);
+      nStripeHalo = 0;
       for (int i = 0; i < 4; i++) {
         parsed_expressions[i] = nullptr;
       }
 
-      for (int i = 0; i < 4+1; ++i) {
+      for (int i = 0; i < 4; ++i) {
         luts[i].used = false;
         luts[i].ptr = nullptr;
       }
 
       bits_per_pixel = bit_depths[C];
       realtime = parameters["realtime"].toBool();
-     
-      // once, when a 4 GByte lut memory is nothing, allow 8 bit 4D real lut by default :)
-      if(bits_per_pixel>8)
-        realtime = true;
-      else if ((uint64_t)std::numeric_limits<size_t>::max() <= 0xFFFFFFFFull) {
-        realtime = true; // 4D lut is not possible on 32 bit environment
+
+      ENGINE engine;
+      if (!EngineFromString(parameters["engine"].toString(), engine)) {
+        error = "invalid engine, use lut, interpreter or jit";
+        return;
       }
 
       static const char *expr_strs[] = { "yExpr", "uExpr", "vExpr", "aExpr" };
 
       Parser::Parser parser = Parser::getDefaultParser().addSymbol(Parser::Symbol::X).addSymbol(Parser::Symbol::Y).addSymbol(Parser::Symbol::Z).addSymbol(Parser::Symbol::A);
 
-      /* compute the luts */
+      std::vector<std::unique_ptr<Parser::Context>> exprs;
+      int firstGeneric = -1;
+      int firstGenericPlane = -1;
+
+      /* parse the expressions */
       for ( int i = 0; i < 4; i++ )
       {
+          planeMap[i] = -1;
+
           if (operators[i] != PROCESS) {
               continue;
           }
@@ -123,57 +143,105 @@ public:
               continue;
           }
 
-          bool customExpressionDefined = false;
           if (parameters[expr_strs[i]].is_defined()) {
             parser.parse(parameters[expr_strs[i]].toString(), " ");
-            customExpressionDefined = true;
           }
-          else
+          else if (firstGeneric != -1) {
+            planeMap[i] = firstGeneric;
+            parsed_expressions[i] = new std::deque<Parser::Symbol>(*parsed_expressions[firstGenericPlane]);
+            continue;
+          }
+          else {
+            firstGeneric = (int)exprs.size();
+            firstGenericPlane = i;
             parser.parse(parameters["expr"].toString(), " ");
+          }
 
-          // for check:
-          Parser::Context ctx(parser.getExpression());
+          planeMap[i] = (int)exprs.size();
+          exprs.emplace_back(new Parser::Context(parser.getExpression()));
 
-          if (!ctx.check())
+          if (!exprs.back()->check())
           {
             error = "invalid expression in the lut";
             return;
           }
 
-          if (realtime) {
-            parsed_expressions[i] = new std::deque<Parser::Symbol>(parser.getExpression());
+          parsed_expressions[i] = new std::deque<Parser::Symbol>(parser.getExpression());
+      }
 
-            switch (bits_per_pixel) {
-            case 8: processorCtx = realtime8_c; break;
-            case 10: processorCtx = realtime10_c; break;
-            case 12: processorCtx = realtime12_c; break;
-            case 14: processorCtx = realtime14_c; break;
-            case 16: processorCtx = realtime16_c; break;
-            case 32: processorCtx = realtime32_c; break;
-            }
-            continue;
-          }
+      // expressions ignoring some of x, y, z and a get a smaller lut: 8 bit 3D, up to 12 bit 2D, 16 bit 1D
+      input_mask = lut_input_mask(exprs);
+      const int num_input = lut_input_count(input_mask);
+      // 4D lut is not possible on 32 bit environment
+      // once, when a 4 GByte lut memory is nothing, allow 8 bit 4D real lut by default :)
+      const bool is_64bit = (uint64_t)std::numeric_limits<size_t>::max() > 0xFFFFFFFFull;
+      const bool lut_available = input_mask == 15 ? bits_per_pixel == 8 && is_64bit : bits_per_pixel != 32 && bits_per_pixel * num_input <= 24;
 
-          // 4D lut only 8 bits
-          processor = lut_c;
+      if (engine == ENGINE_LUT) {
+        if (!lut_available) {
+          error = "lut engine is not available for this bit depth, 4D lut is available for 8 bit clips on 64 bit systems only";
+          return;
+        }
+        realtime = false;
+      }
+      else if (engine != ENGINE_DEFAULT) {
+        realtime = true;
+      }
+      else if (!parameters["realtime"].is_defined() && input_mask != 15) {
+        realtime = false; // default realtime is only there for the 4 GByte 4D lut
+      }
+
+      if (!lut_available)
+        realtime = true;
+
+      use_jit = realtime && engine != ENGINE_INTERPRETER;
+
+      if (realtime) {
+        switch (bits_per_pixel) {
+        case 8: processorCtx = realtime8_c; break;
+        case 10: processorCtx = realtime10_c; break;
+        case 12: processorCtx = realtime12_c; break;
+        case 14: processorCtx = realtime14_c; break;
+        case 16: processorCtx = realtime16_c; break;
+        case 32: processorCtx = realtime32_c; break;
+        }
+        for (int i = 0; i < 4; i++) {
+          if (parsed_expressions[i])
+            contexts[i] = Parser::ContextPool::shared(*parsed_expressions[i], bits_per_pixel, use_jit, (flags & CPU_AVX) != 0);
+        }
+      }
+      else if (input_mask != 15) {
+        if (exprs.empty())
+          return;
+        reduced_luts = make_reduced_lut_data(bits_per_pixel, input_mask, exprs, env);
+        reducedProcessor = get_reduced_lut_processor(bits_per_pixel, num_input);
+      }
+      else {
+        // 4D lut only 8 bits
+        processor = lut_c;
 
-          if (customExpressionDefined) {
-              luts[i].used = true;
-              luts[i].ptr = calculateLut(parser.getExpression(), 8);
+        for ( int i = 0; i < 4; i++ )
+        {
+          if (planeMap[i] < 0) {
+            continue;
           }
-          else {
-              if (luts[4].ptr == nullptr) {
-                  luts[4].used = true;
-                  luts[4].ptr = calculateLut(parser.getExpression(), 8);
-              }
-              luts[i].ptr = luts[4].ptr;
+          for (int j = 0; j < i; j++) {
+            if (planeMap[j] == planeMap[i]) {
+              luts[i].ptr = luts[j].ptr;
+              break;
+            }
           }
+          if (luts[i].ptr == nullptr) {
+            luts[i].used = true;
+            luts[i].ptr = calculateLut(*parsed_expressions[i], 8);
+          }
+        }
       }
    }
 
    ~Lutxyza()
    {
-       for (int i = 0; i < 4+1; ++i) {
+       for (int i = 0; i < 4; ++i) {
            if (luts[i].used) {
                delete[] luts[i].ptr;
            }
@@ -203,6 +271,7 @@ public:
 
       signature.add(Parameter(true, "realtime", false)); // 4D lut: default realtime calc.
       signature.add(Parameter(String("x"), "aExpr", false));
+      signature.add(Parameter(String(""), "engine", false));
       return signature;
    }
 };
@@ -0,0 +1,374 @@
+#include "native.h"
+#include "../../common/simd.h"
+
+namespace Filtering { namespace MaskTools { namespace Filters { namespace Lut {
+
+void absdiff_c(Byte *pDst, ptrdiff_t dst_pitch, const Byte *pSrc, ptrdiff_t src_pitch, int width, int height)
+{
+   for (int y = 0; y < height; y++) {
+      for (int x = 0; x < width; x++) {
+         pDst[x] = Byte(abs(int(pDst[x]) - pSrc[x]));
+      }
+      pDst += dst_pitch;
+      pSrc += src_pitch;
+   }
+}
+
+void absdiff_sse2(Byte *pDst, ptrdiff_t dst_pitch, const Byte *pSrc, ptrdiff_t src_pitch, int width, int height)
+{
+   int mod16_width = (width / 16) * 16;
+   auto pDst2 = pDst;
+   auto pSrc2 = pSrc;
+
+   for (int j = 0; j < height; ++j) {
+      for (int i = 0; i < mod16_width; i += 16) {
+         auto dst = simd_load_si128<MemoryMode::SSE2_UNALIGNED>(pDst + i);
+         auto src = simd_load_si128<MemoryMode::SSE2_UNALIGNED>(pSrc + i);
+
+         auto result = _mm_or_si128(_mm_subs_epu8(dst, src), _mm_subs_epu8(src, dst));
+
+         simd_store_si128<MemoryMode::SSE2_UNALIGNED>(pDst + i, result);
+      }
+      pDst += dst_pitch;
+      pSrc += src_pitch;
+   }
+
+   if (width > mod16_width) {
+      absdiff_c(pDst2 + mod16_width, dst_pitch, pSrc2 + mod16_width, src_pitch, width - mod16_width, height);
+   }
+}
+
+// same for every bit depth: the difference of two valid pixels is a valid pixel
+static void absdiff16_native_c_t(Byte *pDst, ptrdiff_t nDstPitch, const Byte *pSrc, ptrdiff_t nSrcPitch, int nWidth, int nHeight, int)
+{
+   for (int y = 0; y < nHeight; y++) {
+      auto pDstWord = reinterpret_cast<Word*>(pDst);
+      auto pSrcWord = reinterpret_cast<const Word*>(pSrc);
+
+      for (int x = 0; x < nWidth; x++) {
+         pDstWord[x] = Word(abs(int(pDstWord[x]) - pSrcWord[x]));
+      }
+      pDst += nDstPitch;
+      pSrc += nSrcPitch;
+   }
+}
+
+static void absdiff16_native_sse2_t(Byte *pDst, ptrdiff_t nDstPitch, const Byte *pSrc, ptrdiff_t nSrcPitch, int nWidth, int nHeight, int nOrigHeight)
+{
+   nWidth *= 2; // rowsize
+
+   int wMod16 = (nWidth / 16) * 16;
+   auto pDst2 = pDst;
+   auto pSrc2 = pSrc;
+
+   for (int j = 0; j < nHeight; ++j) {
+      for (int i = 0; i < wMod16; i += 16) {
+         auto dst = simd_load_si128<MemoryMode::SSE2_UNALIGNED>(pDst + i);
+         auto src = simd_load_si128<MemoryMode::SSE2_UNALIGNED>(pSrc + i);
+
+         auto result = _mm_or_si128(_mm_subs_epu16(dst, src), _mm_subs_epu16(src, dst));
+
+         simd_store_si128<MemoryMode::SSE2_UNALIGNED>(pDst + i, result);
+      }
+      pDst += nDstPitch;
+      pSrc += nSrcPitch;
+   }
+
+   if (nWidth > wMod16) {
+      absdiff16_native_c_t(pDst2 + wMod16, nDstPitch, pSrc2 + wMod16, nSrcPitch, (nWidth - wMod16) / sizeof(uint16_t), nHeight, nOrigHeight);
+   }
+}
+
+Support::MakeDiff::Processor16 *absdiff16_native_c = &absdiff16_native_c_t;
+Support::MakeDiff::Processor16 *absdiff16_native_sse2 = &absdiff16_native_sse2_t;
+
+void absdiff32_c(Byte *pDst, ptrdiff_t dst_pitch, const Byte *pSrc, ptrdiff_t src_pitch, int width, int height)
+{
+   for (int y = 0; y < height; y++) {
+      for (int x = 0; x < width; x++) {
+         reinterpret_cast<Float *>(pDst)[x] = fabsf(reinterpret_cast<Float *>(pDst)[x] - reinterpret_cast<const Float *>(pSrc)[x]);
+      }
+      pDst += dst_pitch;
+      pSrc += src_pitch;
+   }
+}
+
+void absdiff32_sse2(Byte *pDst, ptrdiff_t dst_pitch, const Byte *pSrc, ptrdiff_t src_pitch, int width, int height)
+{
+   width *= sizeof(Float);
+
+   int mod16_width = (width / 16) * 16;
+   auto pDst2 = pDst;
+   auto pSrc2 = pSrc;
+   auto absmask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+
+   for (int j = 0; j < height; ++j) {
+      for (int i = 0; i < mod16_width; i += 16) {
+         auto dst = simd_load_ps<MemoryMode::SSE2_UNALIGNED>(pDst + i);
+         auto src = simd_load_ps<MemoryMode::SSE2_UNALIGNED>(pSrc + i);
+
+         auto result = _mm_and_ps(_mm_sub_ps(dst, src), absmask);
+
+         simd_store_ps<MemoryMode::SSE2_UNALIGNED>(pDst + i, result);
+      }
+      pDst += dst_pitch;
+      pSrc += src_pitch;
+   }
+
+   if (width > mod16_width) {
+      absdiff32_c(pDst2 + mod16_width, dst_pitch, pSrc2 + mod16_width, src_pitch, (width - mod16_width) / sizeof(Float), height);
+   }
+}
+
+NATIVE Native::recognize(Parser::Context &ctx, int nInputs, int bits_per_pixel, double &threshold)
+{
+   const double range_half = bits_per_pixel == 32 ? 0.5 : double(1 << (bits_per_pixel - 1));
+   const double range_max = bits_per_pixel == 32 ? 1.0 : double((1 << bits_per_pixel) - 1);
+   double c[3];
+
+   if (nInputs == 2) {
+      if (ctx.matches("x y min", c, bits_per_pixel) || ctx.matches("y x min", c, bits_per_pixel))
+         return NATIVE_MIN;
+      if (ctx.matches("x y max", c, bits_per_pixel) || ctx.matches("y x max", c, bits_per_pixel))
+         return NATIVE_MAX;
+      // 2 / is already a multiplication in the compiled program
+      if ((ctx.matches("x y + c *", c, bits_per_pixel) || ctx.matches("y x + c *", c, bits_per_pixel)) && c[0] == 0.5)
+         return NATIVE_AVERAGE;
+      if (ctx.matches("x y - c +", c, bits_per_pixel) && c[0] == range_half)
+         return NATIVE_MAKEDIFF;
+      if ((ctx.matches("x y + c -", c, bits_per_pixel) || ctx.matches("y x + c -", c, bits_per_pixel)) && c[0] == range_half)
+         return NATIVE_ADDDIFF;
+      if (ctx.matches("x y - abs", c, bits_per_pixel) || ctx.matches("y x - abs", c, bits_per_pixel))
+         return NATIVE_ABSDIFF;
+      return NATIVE_NONE;
+   }
+
+   if ((ctx.matches("c x -", c, bits_per_pixel) || ctx.matches("x c swap -", c, bits_per_pixel)) && c[0] == range_max)
+      return NATIVE_INVERT;
+
+   if (ctx.matches("x c > c c ?", c, bits_per_pixel)) {
+      // the kernels compare with a threshold of the pixel type
+      const bool exact = bits_per_pixel == 32 ? double(float(c[0])) == c[0] : c[0] == floor(c[0]) && c[0] >= 0 && c[0] <= range_max;
+      threshold = c[0];
+      if (exact && c[1] == range_max && c[2] == 0)
+         return NATIVE_BINARIZE_LOWER;
+      if (exact && c[1] == 0 && c[2] == range_max)
+         return NATIVE_BINARIZE_UPPER;
+   }
+   return NATIVE_NONE;
+}
+
+Native::Native(NATIVE kind, int bits_per_pixel, double threshold)
+   : kind(kind), bits_per_pixel(bits_per_pixel), nThreshold(int(threshold)), nThreshold_f(Float(threshold))
+{
+   switch (kind) {
+   case NATIVE_MIN:
+   case NATIVE_MAX:
+#define SET_MODE(mode) \
+      if (bits_per_pixel == 8) { \
+         logic.push_back(Filtering::Processor<Logic::Processor>(Logic::mode##_c, Constraint(CPU_NONE, 1, 1, 1, 1), 0)); \
+         logic.push_back(Filtering::Processor<Logic::Processor>(Logic::mode##_sse2, Constraint(CPU_SSE2, 1, 1, 1, 1), 1)); \
+         logic.push_back(Filtering::Processor<Logic::Processor>(Logic::mode##_asse2, Constraint(CPU_SSE2, 1, 1, 16, 16), 2)); \
+         logic.push_back(Filtering::Processor<Logic::Processor>(Logic::mode##_avx2, Constraint(CPU_AVX2, 1, 1, 1, 1), 3)); \
+         logic.push_back(Filtering::Processor<Logic::Processor>(Logic::mode##_aavx2, Constraint(CPU_AVX2, 1, 1, 32, 32), 4)); \
+         logic.push_back(Filtering::Processor<Logic::Processor>(Logic::mode##_avx512, Constraint(CPU_AVX512F | CPU_AVX512BW, 1, 1, 1, 1), 5)); \
+      } \
+      else if (bits_per_pixel <= 16) { \
+         logic16.push_back(Filtering::Processor<Logic::Processor16>(Logic::mode##_native_c, Constraint(CPU_NONE, 1, 1, 1, 1), 0)); \
+         logic16.push_back(Filtering::Processor<Logic::Processor16>(Logic::mode##_native_sse2, Constraint(CPU_SSE4_1, 1, 1, 1, 1), 1)); \
+         logic16.push_back(Filtering::Processor<Logic::Processor16>(Logic::mode##_native_avx2, Constraint(CPU_AVX2, 1, 1, 1, 1), 2)); \
+         logic16.push_back(Filtering::Processor<Logic::Processor16>(Logic::mode##_native_avx512, Constraint(CPU_AVX512F | CPU_AVX512BW, 1, 1, 1, 1), 3)); \
+      } \
+      else { \
+         logic32.push_back(Filtering::Processor<Logic::Processor32>(Logic::mode##_32_c, Constraint(CPU_NONE, 1, 1, 1, 1), 0)); \
+         logic32.push_back(Filtering::Processor<Logic::Processor32>(Logic::mode##_32_sse2, Constraint(CPU_SSE2, 1, 1, 1, 1), 1)); \
+         logic32.push_back(Filtering::Processor<Logic::Processor32>(Logic::mode##_32_asse2, Constraint(CPU_SSE2, 1, 1, 16, 16), 2)); \
+         logic32.push_back(Filtering::Processor<Logic::Processor32>(Logic::mode##_32_avx, Constraint(CPU_AVX, 1, 1, 1, 1), 3)); \
+         logic32.push_back(Filtering::Processor<Logic::Processor32>(Logic::mode##_32_aavx, Constraint(CPU_AVX, 1, 1, 32, 32), 4)); \
+      }
+      if (kind == NATIVE_MIN) { SET_MODE(min); }
+      else { SET_MODE(max); }
+#undef SET_MODE
+      break;
+
+   case NATIVE_MAKEDIFF:
+   case NATIVE_ADDDIFF:
+#define SET_MODE(ns, mode) \
+      switch (bits_per_pixel) { \
+      case 8: \
+         processors.push_back(Filtering::Processor<Support::MakeDiff::Processor>(&ns::mode##_c, Constraint(CPU_NONE, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 1), 0)); \
+         processors.push_back(Filtering::Processor<Support::MakeDiff::Processor>(ns::mode##_sse2, Constraint(CPU_SSE2, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 1), 1)); \
+         processors.push_back(Filtering::Processor<Support::MakeDiff::Processor>(ns::mode##_asse2, Constraint(CPU_SSE2, MODULO_NONE, MODULO_NONE, ALIGNMENT_16, 16), 2)); \
+         break; \
+      case 10: \
+         processors16.push_back(Filtering::Processor<Support::MakeDiff::Processor16>(ns::mode##16_native_10_c, Constraint(CPU_NONE, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 1), 0)); \
+         processors16.push_back(Filtering::Processor<Support::MakeDiff::Processor16>(ns::mode##16_native_10_sse2, Constraint(CPU_SSE2, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 1), 1)); \
+         processors16.push_back(Filtering::Processor<Support::MakeDiff::Processor16>(ns::mode##16_native_10_sse4_1, Constraint(CPU_SSE4_1, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 1), 2)); \
+         break; \
+      case 12: \
+         processors16.push_back(Filtering::Processor<Support::MakeDiff::Processor16>(ns::mode##16_native_12_c, Constraint(CPU_NONE, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 1), 0)); \
+         processors16.push_back(Filtering::Processor<Support::MakeDiff::Processor16>(ns::mode##16_native_12_sse2, Constraint(CPU_SSE2, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 1), 1)); \
+         processors16.push_back(Filtering::Processor<Support::MakeDiff::Processor16>(ns::mode##16_native_12_sse4_1, Constraint(CPU_SSE4_1, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 1), 2)); \
+         break; \
+      case 14: \
+         processors16.push_back(Filtering::Processor<Support::MakeDiff::Processor16>(ns::mode##16_native_14_c, Constraint(CPU_NONE, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 1), 0)); \
+         processors16.push_back(Filtering::Processor<Support::MakeDiff::Processor16>(ns::mode##16_native_14_sse2, Constraint(CPU_SSE2, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 1), 1)); \
+         processors16.push_back(Filtering::Processor<Support::MakeDiff::Processor16>(ns::mode##16_native_14_sse4_1, Constraint(CPU_SSE4_1, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 1), 2)); \
+         break; \
+      case 16: \
+         processors16.push_back(Filtering::Processor<Support::MakeDiff::Processor16>(ns::mode##16_native_16_c, Constraint(CPU_NONE, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 1), 0)); \
+         processors16.push_back(Filtering::Processor<Support::MakeDiff::Processor16>(ns::mode##16_native_16_sse2, Constraint(CPU_SSE2, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 1), 1)); \
+         processors16.push_back(Filtering::Processor<Support::MakeDiff::Processor16>(ns::mode##16_native_16_sse4_1, Constraint(CPU_SSE4_1, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 1), 2)); \
+         break; \
+      case 32: \
+         processors32.push_back(Filtering::Processor<Support::MakeDiff::Processor32>(&ns::mode##32_c, Constraint(CPU_NONE, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 1), 0)); \
+         processors32.push_back(Filtering::Processor<Support::MakeDiff::Processor32>(ns::mode##32_sse2, Constraint(CPU_SSE2, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 1), 1)); \
+         processors32.push_back(Filtering::Processor<Support::MakeDiff::Processor32>(ns::mode##32_asse2, Constraint(CPU_SSE2, MODULO_NONE, MODULO_NONE, ALIGNMENT_16, 16), 2)); \
+         break; \
+      }
+      if (kind == NATIVE_MAKEDIFF) { SET_MODE(Support::MakeDiff, makediff); }
+      else { SET_MODE(Support::AddDiff, adddiff); }
+#undef SET_MODE
+      break;
+
+   case NATIVE_AVERAGE:
+      if (bits_per_pixel == 8) {
+         processors.push_back(Filtering::Processor<Support::MakeDiff::Processor>(&Support::Average::average_c, Constraint(CPU_NONE, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 1), 0));
+         processors.push_back(Filtering::Processor<Support::MakeDiff::Processor>(Support::Average::average_sse2, Constraint(CPU_SSE2, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 1), 1));
+         processors.push_back(Filtering::Processor<Support::MakeDiff::Processor>(Support::Average::average_asse2, Constraint(CPU_SSE2, MODULO_NONE, MODULO_NONE, ALIGNMENT_16, 16), 2));
+      }
+      else if (bits_per_pixel <= 16) {
+         processors16.push_back(Filtering::Processor<Support::MakeDiff::Processor16>(Support::Average::average16_native_c, Constraint(CPU_NONE, 1, 1, 1, 1), 0));
+         processors16.push_back(Filtering::Processor<Support::MakeDiff::Processor16>(Support::Average::average16_native_sse2, Constraint(CPU_SSE2, 1, 1, 1, 1), 1));
+      }
+      else {
+         processors32.push_back(Filtering::Processor<Support::MakeDiff::Processor32>(&Support::Average::average32_c, Constraint(CPU_NONE, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 1), 0));
+         processors32.push_back(Filtering::Processor<Support::MakeDiff::Processor32>(Support::Average::average32_sse2, Constraint(CPU_SSE2, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 1), 1));
+         processors32.push_back(Filtering::Processor<Support::MakeDiff::Processor32>(Support::Average::average32_asse2, Constraint(CPU_SSE2, MODULO_NONE, MODULO_NONE, ALIGNMENT_16, 16), 2));
+      }
+      break;
+
+   case NATIVE_ABSDIFF:
+      if (bits_per_pixel == 8) {
+         processors.push_back(Filtering::Processor<Support::MakeDiff::Processor>(&absdiff_c, Constraint(CPU_NONE, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 1), 0));
+         processors.push_back(Filtering::Processor<Support::MakeDiff::Processor>(&absdiff_sse2, Constraint(CPU_SSE2, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 1), 1));
+      }
+      else if (bits_per_pixel <= 16) {
+         processors16.push_back(Filtering::Processor<Support::MakeDiff::Processor16>(absdiff16_native_c, Constraint(CPU_NONE, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 1), 0));
+         processors16.push_back(Filtering::Processor<Support::MakeDiff::Processor16>(absdiff16_native_sse2, Constraint(CPU_SSE2, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 1), 1));
+      }
+      else {
+         processors32.push_back(Filtering::Processor<Support::MakeDiff::Processor32>(&absdiff32_c, Constraint(CPU_NONE, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 1), 0));
+         processors32.push_back(Filtering::Processor<Support::MakeDiff::Processor32>(&absdiff32_sse2, Constraint(CPU_SSE2, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 1), 1));
+      }
+      break;
+
+   case NATIVE_INVERT:
+      switch (bits_per_pixel) {
+      case 8:
+         invert.push_back(Filtering::Processor<Invert::Processor>(Invert::invert_c, Constraint(CPU_NONE, 1, 1, 1, 1), 0));
+         invert.push_back(Filtering::Processor<Invert::Processor>(Invert::invert_sse2, Constraint(CPU_SSE2, 16, 1, 16, 16), 1));
+         break;
+      case 10:
+         invert.push_back(Filtering::Processor<Invert::Processor>(Invert::invert10_c, Constraint(CPU_NONE, 1, 1, 1, 1), 0));
+         invert.push_back(Filtering::Processor<Invert::Processor>(Invert::invert10_sse2, Constraint(CPU_SSE2, 16, 1, 16, 16), 1));
+         break;
+      case 12:
+         invert.push_back(Filtering::Processor<Invert::Processor>(Invert::invert12_c, Constraint(CPU_NONE, 1, 1, 1, 1), 0));
+         invert.push_back(Filtering::Processor<Invert::Processor>(Invert::invert12_sse2, Constraint(CPU_SSE2, 16, 1, 16, 16), 1));
+         break;
+      case 14:
+         invert.push_back(Filtering::Processor<Invert::Processor>(Invert::invert14_c, Constraint(CPU_NONE, 1, 1, 1, 1), 0));
+         invert.push_back(Filtering::Processor<Invert::Processor>(Invert::invert14_sse2, Constraint(CPU_SSE2, 16, 1, 16, 16), 1));
+         break;
+      case 16:
+         invert.push_back(Filtering::Processor<Invert::Processor>(Invert::invert16_c, Constraint(CPU_NONE, 1, 1, 1, 1), 0));
+         invert.push_back(Filtering::Processor<Invert::Processor>(Invert::invert16_sse2, Constraint(CPU_SSE2, 16, 1, 16, 16), 1));
+         break;
+      case 32:
+         invert.push_back(Filtering::Processor<Invert::Processor>(Invert::invert32_c, Constraint(CPU_NONE, 1, 1, 1, 1), 0));
+         invert.push_back(Filtering::Processor<Invert::Processor>(Invert::invert32_sse2, Constraint(CPU_SSE2, 16, 1, 16, 16), 1));
+         break;
+      }
+      break;
+
+   case NATIVE_BINARIZE_LOWER:
+   case NATIVE_BINARIZE_UPPER:
+#define SET_MODE(mode) \
+      switch (bits_per_pixel) { \
+      case 8: \
+         binarize.push_back(Filtering::Processor<Binarize::Processor>(Binarize::binarize_##mode##_c, Constraint(CPU_NONE, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 1), 0)); \
+         binarize.push_back(Filtering::Processor<Binarize::Processor>(Binarize::binarize_##mode##_sse2, Constraint(CPU_SSE2, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 1), 1)); \
+         binarize.push_back(Filtering::Processor<Binarize::Processor>(Binarize::binarize_##mode##_asse2, Constraint(CPU_SSE2, MODULO_NONE, MODULO_NONE, ALIGNMENT_16, 16), 2)); \
+         break; \
+      case 10: \
+         binarize16.push_back(Filtering::Processor<Binarize::Processor16>(Binarize::binarize_##mode##_native_10_c, Constraint(CPU_NONE, 1, 1, 1, 1), 0)); \
+         binarize16.push_back(Filtering::Processor<Binarize::Processor16>(Binarize::binarize_##mode##_native_10_sse2, Constraint(CPU_SSE2, 1, 1, 1, 1), 1)); \
+         break; \
+      case 12: \
+         binarize16.push_back(Filtering::Processor<Binarize::Processor16>(Binarize::binarize_##mode##_native_12_c, Constraint(CPU_NONE, 1, 1, 1, 1), 0)); \
+         binarize16.push_back(Filtering::Processor<Binarize::Processor16>(Binarize::binarize_##mode##_native_12_sse2, Constraint(CPU_SSE2, 1, 1, 1, 1), 1)); \
+         break; \
+      case 14: \
+         binarize16.push_back(Filtering::Processor<Binarize::Processor16>(Binarize::binarize_##mode##_native_14_c, Constraint(CPU_NONE, 1, 1, 1, 1), 0)); \
+         binarize16.push_back(Filtering::Processor<Binarize::Processor16>(Binarize::binarize_##mode##_native_14_sse2, Constraint(CPU_SSE2, 1, 1, 1, 1), 1)); \
+         break; \
+      case 16: \
+         binarize16.push_back(Filtering::Processor<Binarize::Processor16>(Binarize::binarize_##mode##_native_16_c, Constraint(CPU_NONE, 1, 1, 1, 1), 0)); \
+         binarize16.push_back(Filtering::Processor<Binarize::Processor16>(Binarize::binarize_##mode##_native_16_sse2, Constraint(CPU_SSE2, 1, 1, 1, 1), 1)); \
+         break; \
+      case 32: \
+         binarize32.push_back(Filtering::Processor<Binarize::Processor32>(Binarize::binarize32_##mode##_c, Constraint(CPU_NONE, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 1), 0)); \
+         binarize32.push_back(Filtering::Processor<Binarize::Processor32>(Binarize::binarize32_##mode##_sse2, Constraint(CPU_SSE2, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 1), 1)); \
+         binarize32.push_back(Filtering::Processor<Binarize::Processor32>(Binarize::binarize32_##mode##_asse2, Constraint(CPU_SSE2, MODULO_NONE, MODULO_NONE, ALIGNMENT_16, 16), 2)); \
+         break; \
+      }
+      if (kind == NATIVE_BINARIZE_LOWER) { SET_MODE(lower); }
+      else { SET_MODE(upper); }
+#undef SET_MODE
+      break;
+
+   default:
+      break;
+   }
+}
+
+void Native::process(Byte *pDst, ptrdiff_t nDstPitch, const Byte *pSrc, ptrdiff_t nSrcPitch, int nWidth, int nHeight, int nOrigHeight, const Constraint &constraint) const
+{
+   switch (kind) {
+   case NATIVE_MIN:
+   case NATIVE_MAX:
+      if (bits_per_pixel == 8)
+         logic.best_processor(constraint)(pDst, nDstPitch, pSrc, nSrcPitch, nWidth, nHeight, 0, 0);
+      else if (bits_per_pixel <= 16)
+         logic16.best_processor(constraint)(pDst, nDstPitch, pSrc, nSrcPitch, nWidth, nHeight, nOrigHeight, 0, 0);
+      else
+         logic32.best_processor(constraint)((Float *)pDst, nDstPitch, (const Float *)pSrc, nSrcPitch, nWidth, nHeight, 0.0f, 0.0f);
+      break;
+
+   case NATIVE_INVERT:
+      invert.best_processor(constraint)(pDst, nDstPitch, nWidth, nHeight);
+      break;
+
+   case NATIVE_BINARIZE_LOWER:
+   case NATIVE_BINARIZE_UPPER:
+      if (bits_per_pixel == 8)
+         binarize.best_processor(constraint)(pDst, nDstPitch, (Byte)nThreshold, nWidth, nHeight);
+      else if (bits_per_pixel <= 16)
+         binarize16.best_processor(constraint)(pDst, nDstPitch, (Word)nThreshold, nWidth, nHeight, nOrigHeight);
+      else
+         binarize32.best_processor(constraint)(pDst, nDstPitch, nThreshold_f, nWidth, nHeight);
+      break;
+
+   default:
+      if (bits_per_pixel == 8)
+         processors.best_processor(constraint)(pDst, nDstPitch, pSrc, nSrcPitch, nWidth, nHeight);
+      else if (bits_per_pixel <= 16)
+         processors16.best_processor(constraint)(pDst, nDstPitch, pSrc, nSrcPitch, nWidth, nHeight, nOrigHeight);
+      else
+         processors32.best_processor(constraint)(pDst, nDstPitch, pSrc, nSrcPitch, nWidth, nHeight);
+      break;
+   }
+}
+
+} } } } // namespace Lut, Filters, MaskTools, Filtering
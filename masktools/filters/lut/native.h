@@ -0,0 +1,72 @@
+#ifndef __Mt_Lut_Native_H__
+#define __Mt_Lut_Native_H__
+
+#include "../../common/base/filter.h"
+#include "../../../common/parser/parser.h"
+#include "../logic/logic.h"
+#include "../support/makediff/makediff.h"
+#include "../support/adddiff/adddiff.h"
+#include "../support/average/average.h"
+#include "../invert/invert.h"
+#include "../binarize/binarize.h"
+
+namespace Filtering { namespace MaskTools { namespace Filters { namespace Lut {
+
+// expressions computed by the kernels of the dedicated filters instead of a lut or the parser
+typedef enum {
+
+   NATIVE_NONE = 0,
+   NATIVE_MIN,            // x y min             -> kmt_logic mode="min"
+   NATIVE_MAX,            // x y max             -> kmt_logic mode="max"
+   NATIVE_AVERAGE,        // x y + 2 /           -> kmt_average
+   NATIVE_MAKEDIFF,       // x y - range_half +  -> kmt_makediff
+   NATIVE_ADDDIFF,        // x y + range_half -  -> kmt_adddiff
+   NATIVE_ABSDIFF,        // x y - abs
+   NATIVE_INVERT,         // range_max x -       -> kmt_invert
+   NATIVE_BINARIZE_LOWER, // x t > range_max 0 ? -> kmt_binarize mode="lower"
+   NATIVE_BINARIZE_UPPER, // x t > 0 range_max ? -> kmt_binarize mode="upper"
+
+} NATIVE;
+
+// x y - abs has no filter of its own, same signatures as kmt_makediff
+Support::MakeDiff::Processor absdiff_c;
+Support::MakeDiff::Processor absdiff_sse2;
+extern Support::MakeDiff::Processor16 *absdiff16_native_c;
+extern Support::MakeDiff::Processor16 *absdiff16_native_sse2;
+Support::MakeDiff::Processor32 absdiff32_c;
+Support::MakeDiff::Processor32 absdiff32_sse2;
+
+class Native {
+
+   NATIVE kind;
+   int bits_per_pixel;
+   int nThreshold;
+   Float nThreshold_f;
+
+   // makediff, adddiff, average and absdiff share their signatures
+   ProcessorList<Support::MakeDiff::Processor> processors;
+   ProcessorList<Support::MakeDiff::Processor16> processors16;
+   ProcessorList<Support::MakeDiff::Processor32> processors32;
+   ProcessorList<Logic::Processor> logic;
+   ProcessorList<Logic::Processor16> logic16;
+   ProcessorList<Logic::Processor32> logic32;
+   ProcessorList<Invert::Processor> invert;
+   ProcessorList<Binarize::Processor> binarize;
+   ProcessorList<Binarize::Processor16> binarize16;
+   ProcessorList<Binarize::Processor32> binarize32;
+
+public:
+
+   // kernel computing the expression at this bit depth, NATIVE_NONE when there is none.
+   // nInputs: 1 for kmt_lut (x only), 2 for kmt_lutxy
+   static NATIVE recognize(Parser::Context &ctx, int nInputs, int bits_per_pixel, double &threshold);
+
+   Native(NATIVE kind, int bits_per_pixel, double threshold);
+
+   // x is pDst, processed in place, y is pSrc for the two input kernels
+   void process(Byte *pDst, ptrdiff_t nDstPitch, const Byte *pSrc, ptrdiff_t nSrcPitch, int nWidth, int nHeight, int nOrigHeight, const Constraint &constraint) const;
+};
+
+} } } } // namespace Lut, Filters, MaskTools, Filtering
+
+#endif
@@ -0,0 +1,35 @@
+#include "neighbourhood_simd.h"
+
+namespace Filtering { namespace MaskTools { namespace Filters { namespace Lut {
+
+void network_row_sse2(Byte *pDst, const Byte *const *pRows, int nCount, int nWidth, int nMode, int bits_per_pixel)
+{
+   network_row_simd<NetworkSse2>(pDst, pRows, nCount, nWidth, nMode, bits_per_pixel);
+}
+
+void network_row_sse4_16(Word *pDst, const Word *const *pRows, int nCount, int nWidth, int nMode, int bits_per_pixel)
+{
+   network_row_simd<NetworkSse4_16>(pDst, pRows, nCount, nWidth, nMode, bits_per_pixel);
+}
+
+void network_row32_sse2(Float *pDst, const Float *const *pRows, int nCount, int nWidth, int nMode, int bits_per_pixel)
+{
+   network_row_simd<NetworkSse2_32>(pDst, pRows, nCount, nWidth, nMode, bits_per_pixel);
+}
+
+Byte network_plane_sse2(const Byte *pSrc, ptrdiff_t nPitch, int nWidth, int nHeight, int nMode, int bits_per_pixel)
+{
+   return network_plane_simd<NetworkSse2>(pSrc, nPitch, nWidth, nHeight, nMode, bits_per_pixel);
+}
+
+Word network_plane_sse4_16(const Word *pSrc, ptrdiff_t nPitch, int nWidth, int nHeight, int nMode, int bits_per_pixel)
+{
+   return network_plane_simd<NetworkSse4_16>(pSrc, nPitch, nWidth, nHeight, nMode, bits_per_pixel);
+}
+
+Float network_plane32_sse2(const Float *pSrc, ptrdiff_t nPitch, int nWidth, int nHeight, int nMode, int bits_per_pixel)
+{
+   return network_plane_bounds<NetworkSse2_32>(pSrc, nPitch, nWidth, nHeight, nMode, bits_per_pixel);
+}
+
+} } } } // namespace Lut, Filters, MaskTools, Filtering
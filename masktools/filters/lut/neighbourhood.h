@@ -0,0 +1,137 @@
+#ifndef __Mt_Lut_Neighbourhood_H__
+#define __Mt_Lut_Neighbourhood_H__
+
+#include "../../common/base/filter.h"
+#include "../../../common/parser/parser.h"
+#include "../../../common/utils/utils.h"
+#include "../morphologic/structuring_element.h"
+#include "functions.h"
+#include <vector>
+
+namespace Filtering { namespace MaskTools { namespace Filters { namespace Lut {
+
+/* The pixels of the spatial luts: the rows of the neighbours are padded with their border pixels
+   so that every neighbour of a pixel is at a constant offset, without clamping its coordinates.
+   In the min, max, range, average and standard deviation modes a vector of pixels is reduced at
+   once, and in the median mode too for the usual 3x3 square, 3x3 cross and 5x5 square, by a sorting
+   network. */
+
+/* sums of the values below 2^31 in 32 bit lanes */
+static const int network_max_count = 32767;
+
+static inline bool is_network_neighbourhood(const int *pCoordinates, int nCoordinates)
+{
+   Morphologic::CoordinatesMap map;
+   if ( !map.fill(pCoordinates, nCoordinates) )
+      return false;
+
+   const int nRadius = map.x1;
+   if ( map.x0 != -nRadius || map.y0 != -nRadius || map.y1 != nRadius || (nRadius != 1 && nRadius != 2) )
+      return false;
+
+   /* each point given once: as many coordinates as points of the shape, all of them in the map */
+   const bool isCross = nRadius == 1 && nCoordinates / 2 == 5;
+   if ( !isCross && nCoordinates / 2 != map.width() * map.height() )
+      return false;
+   for ( int y = -nRadius; y <= nRadius; y++ )
+      for ( int x = -nRadius; x <= nRadius; x++ )
+         if ( (!isCross || x == 0 || y == 0) && !map.contains(x, y) )
+            return false;
+   return true;
+}
+
+static inline bool is_network_reducible(int nMode, const int *pCoordinates, int nCoordinates)
+{
+   if ( nCoordinates < 2 || nCoordinates / 2 > network_max_count )
+      return false;
+   if ( nMode == MEDIANIZER4 )
+      return is_network_neighbourhood(pCoordinates, nCoordinates);
+   return nMode == MINIMIZER || nMode == MAXIMIZER || nMode == RANGIZER || nMode == AVERAGER || nMode == DEVIATER;
+}
+
+/* The rows of a plane around row y, each mapped once by map(pRow, pSrcRow, nWidth) and padded on
+   both sides, in a ring of as many rows as the neighbourhood is high. The rows are also readable
+   past their end by a vector of 32 pixels. */
+template<typename T>
+class NeighbourhoodRows {
+
+   const int *pCoordinates;
+   int nCoordinates;
+   int nWidth, nHeight;
+   int nRadius;
+   ptrdiff_t nStride;
+   int nMapped;
+   std::vector<T> buffer;
+   std::vector<const T *> neighbours;
+
+   T *row(int y) { return &buffer[size_t(y % (2 * nRadius + 1)) * nStride]; }
+
+public:
+
+   NeighbourhoodRows(const int *pCoordinates, int nCoordinates, int nWidth, int nHeight) :
+      pCoordinates(pCoordinates), nCoordinates(nCoordinates), nWidth(nWidth), nHeight(nHeight), nRadius(0), nMapped(0)
+   {
+      for ( int k = 0; k < nCoordinates; k++ )
+         nRadius = max(nRadius, abs(pCoordinates[k]));
+      nStride = nWidth + 2 * nRadius + 32;
+      buffer.resize(size_t(2 * nRadius + 1) * nStride);
+      neighbours.resize(nCoordinates / 2);
+   }
+
+   /* the neighbours of row y in the order of the coordinates, pSrc at the top of the plane */
+   template<class Map>
+   const T *const *get(int y, const T *pSrc, ptrdiff_t nSrcPitch, Map map)
+   {
+      for ( ; nMapped <= min(y + nRadius, nHeight - 1); nMapped++ )
+      {
+         T *pRow = row(nMapped);
+         map(pRow + nRadius, pSrc + nMapped * nSrcPitch, nWidth);
+         for ( int x = 0; x < nRadius; x++ )
+         {
+            pRow[x] = pRow[nRadius];
+            pRow[nRadius + nWidth + x] = pRow[nRadius + nWidth - 1];
+         }
+      }
+
+      for ( int k = 0; k < nCoordinates; k += 2 )
+         neighbours[k / 2] = row(clip<int, int>(y + pCoordinates[k + 1], 0, nHeight - 1)) + nRadius + pCoordinates[k];
+      return neighbours.data();
+   }
+};
+
+/* the map of the rows when the neighbours are used as they are */
+template<typename T>
+static void copy_row(T *pRow, const T *pSrcRow, int nWidth)
+{
+   memcpy(pRow, pSrcRow, nWidth * sizeof(T));
+}
+
+/* the value of the mode over nCount neighbours for each pixel of a row, the same as the aggregators of
+   functions.h. bits_per_pixel bounds min and range like Minimizer16 */
+typedef void (NeighbourhoodRow)(Byte *pDst, const Byte *const *pRows, int nCount, int nWidth, int nMode, int bits_per_pixel);
+typedef void (NeighbourhoodRow16)(Word *pDst, const Word *const *pRows, int nCount, int nWidth, int nMode, int bits_per_pixel);
+typedef void (NeighbourhoodRow32)(Float *pDst, const Float *const *pRows, int nCount, int nWidth, int nMode, int bits_per_pixel);
+
+NeighbourhoodRow network_row_sse2;
+NeighbourhoodRow network_row_avx2;
+NeighbourhoodRow16 network_row_sse4_16;
+NeighbourhoodRow16 network_row_avx2_16;
+NeighbourhoodRow32 network_row32_sse2;
+NeighbourhoodRow32 network_row32_avx2;
+
+/* the value of the mode over a whole plane of nPitch pixels per row, for the frame luts. Float only in the min, max and range
+   modes, the sums of Averager32 and Deviater32 depend on the order of the pixels */
+typedef Byte (NeighbourhoodPlane)(const Byte *pSrc, ptrdiff_t nPitch, int nWidth, int nHeight, int nMode, int bits_per_pixel);
+typedef Word (NeighbourhoodPlane16)(const Word *pSrc, ptrdiff_t nPitch, int nWidth, int nHeight, int nMode, int bits_per_pixel);
+typedef Float (NeighbourhoodPlane32)(const Float *pSrc, ptrdiff_t nPitch, int nWidth, int nHeight, int nMode, int bits_per_pixel);
+
+NeighbourhoodPlane network_plane_sse2;
+NeighbourhoodPlane network_plane_avx2;
+NeighbourhoodPlane16 network_plane_sse4_16;
+NeighbourhoodPlane16 network_plane_avx2_16;
+NeighbourhoodPlane32 network_plane32_sse2;
+NeighbourhoodPlane32 network_plane32_avx2;
+
+} } } } // namespace Lut, Filters, MaskTools, Filtering
+
+#endif
@@ -0,0 +1,314 @@
+#include "neighbourhood_simd.h"
+
+namespace Filtering { namespace MaskTools { namespace Filters { namespace Lut {
+
+/* avx2 policies of network_row_simd, the same operations as their sse counterparts on 32 bytes.
+   The unpacks and packs work within each 128 bit lane and keep the order of the pixels. The sums
+   of any count are widened in the order of the pixels instead, and converted to double by halves */
+
+static MT_FORCEINLINE __m256i average_epi32_avx2(__m256i sum, int nCount)
+{
+   const auto divisor = _mm256_set1_pd(Double(nCount));
+   sum = _mm256_add_epi32(sum, _mm256_set1_epi32(nCount >> 1));
+   auto lo = _mm256_cvttpd_epi32(_mm256_div_pd(_mm256_cvtepi32_pd(_mm256_castsi256_si128(sum)), divisor));
+   auto hi = _mm256_cvttpd_epi32(_mm256_div_pd(_mm256_cvtepi32_pd(_mm256_extracti128_si256(sum, 1)), divisor));
+   return _mm256_set_m128i(hi, lo);
+}
+
+static MT_FORCEINLINE __m256d deviation_pd_avx2(__m256d sum, __m256d sum2, __m256d count)
+{
+   return _mm256_sqrt_pd(_mm256_div_pd(_mm256_sub_pd(_mm256_mul_pd(sum2, count), _mm256_mul_pd(sum, sum)), _mm256_mul_pd(count, count)));
+}
+
+static MT_FORCEINLINE __m256d cvtepu64_pd_avx2(__m256i value)
+{
+   const auto magic = _mm256_set1_pd(4503599627370496.0);
+   return _mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(value, _mm256_castpd_si256(magic))), magic);
+}
+
+static MT_FORCEINLINE __m128i round_pd_avx2(__m256d value)
+{
+   return _mm256_cvttpd_epi32(_mm256_add_pd(value, _mm256_set1_pd(0.5)));
+}
+
+static MT_FORCEINLINE __m128i round_clip_pd_avx2(__m256d value)
+{
+   return round_pd_avx2(_mm256_min_pd(_mm256_set1_pd(255.0), _mm256_max_pd(_mm256_setzero_pd(), value)));
+}
+
+struct NetworkAvx2 {
+   typedef Byte pixel_t;
+   typedef __m256i vector_t;
+   static const int count = 32;
+
+   static MT_FORCEINLINE __m256i load(const Byte *ptr) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ptr)); }
+   static MT_FORCEINLINE void store(Byte *ptr, __m256i value) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(ptr), value); }
+   static MT_FORCEINLINE __m256i lowest() { return _mm256_setzero_si256(); }
+   static MT_FORCEINLINE __m256i highest(int bits_per_pixel) { UNUSED(bits_per_pixel); return _mm256_set1_epi8(-1); }
+   static MT_FORCEINLINE __m256i min(__m256i a, __m256i b) { return _mm256_min_epu8(a, b); }
+   static MT_FORCEINLINE __m256i max(__m256i a, __m256i b) { return _mm256_max_epu8(a, b); }
+   static MT_FORCEINLINE __m256i sub(__m256i a, __m256i b) { return _mm256_sub_epi8(a, b); }
+   static MT_FORCEINLINE __m256i median(__m256i value) { return value; }
+
+   static MT_FORCEINLINE __m256i divide(__m256i sum, __m256 divisor) {
+      const __m256i zero = _mm256_setzero_si256();
+      auto lo = _mm256_cvttps_epi32(_mm256_div_ps(_mm256_cvtepi32_ps(_mm256_unpacklo_epi16(sum, zero)), divisor));
+      auto hi = _mm256_cvttps_epi32(_mm256_div_ps(_mm256_cvtepi32_ps(_mm256_unpackhi_epi16(sum, zero)), divisor));
+      return _mm256_packs_epi32(lo, hi);
+   }
+   static MT_FORCEINLINE __m256i average(const __m256i *values, int nCount) {
+      const __m256i zero = _mm256_setzero_si256();
+      auto lo = _mm256_set1_epi16(short(nCount >> 1));
+      auto hi = lo;
+      for ( int k = 0; k < nCount; k++ )
+      {
+         lo = _mm256_add_epi16(lo, _mm256_unpacklo_epi8(values[k], zero));
+         hi = _mm256_add_epi16(hi, _mm256_unpackhi_epi8(values[k], zero));
+      }
+      const auto divisor = _mm256_set1_ps(Float(nCount));
+      return _mm256_packus_epi16(divide(lo, divisor), divide(hi, divisor));
+   }
+
+   typedef Averager<int64_t> averager_t;
+   typedef Deviater<int64_t> deviater_t;
+   struct sums_t { __m256i sum[4], sum2[4]; };
+
+   static MT_FORCEINLINE void widen(__m256i value, __m256i *dwords) {
+      auto lo = _mm256_castsi256_si128(value);
+      auto hi = _mm256_extracti128_si256(value, 1);
+      dwords[0] = _mm256_cvtepu8_epi32(lo);
+      dwords[1] = _mm256_cvtepu8_epi32(_mm_srli_si128(lo, 8));
+      dwords[2] = _mm256_cvtepu8_epi32(hi);
+      dwords[3] = _mm256_cvtepu8_epi32(_mm_srli_si128(hi, 8));
+   }
+   /* the packs interleave the 4 bytes groups of the lanes */
+   static MT_FORCEINLINE __m256i narrow(const __m256i *dwords) {
+      auto bytes = _mm256_packus_epi16(_mm256_packs_epi32(dwords[0], dwords[1]), _mm256_packs_epi32(dwords[2], dwords[3]));
+      return _mm256_permutevar8x32_epi32(bytes, _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7));
+   }
+   static MT_FORCEINLINE void clear(sums_t &sums) {
+      for ( int k = 0; k < 4; k++ )
+         sums.sum[k] = sums.sum2[k] = _mm256_setzero_si256();
+   }
+   static MT_FORCEINLINE void add(sums_t &sums, __m256i value) {
+      __m256i dwords[4];
+      widen(value, dwords);
+      for ( int k = 0; k < 4; k++ )
+         sums.sum[k] = _mm256_add_epi32(sums.sum[k], dwords[k]);
+   }
+   static MT_FORCEINLINE void add_squares(sums_t &sums, __m256i value) {
+      __m256i dwords[4];
+      widen(value, dwords);
+      for ( int k = 0; k < 4; k++ )
+      {
+         sums.sum[k] = _mm256_add_epi32(sums.sum[k], dwords[k]);
+         sums.sum2[k] = _mm256_add_epi32(sums.sum2[k], _mm256_madd_epi16(dwords[k], dwords[k]));
+      }
+   }
+   static MT_FORCEINLINE __m256i finalize_average(const sums_t &sums, int nCount) {
+      __m256i dwords[4];
+      for ( int k = 0; k < 4; k++ )
+         dwords[k] = average_epi32_avx2(sums.sum[k], nCount);
+      return narrow(dwords);
+   }
+   static MT_FORCEINLINE __m256i finalize_deviation(const sums_t &sums, int nCount) {
+      const auto count = _mm256_set1_pd(Double(nCount));
+      __m256i dwords[4];
+      for ( int k = 0; k < 4; k++ )
+      {
+         auto lo = round_clip_pd_avx2(deviation_pd_avx2(_mm256_cvtepi32_pd(_mm256_castsi256_si128(sums.sum[k])), _mm256_cvtepi32_pd(_mm256_castsi256_si128(sums.sum2[k])), count));
+         auto hi = round_clip_pd_avx2(deviation_pd_avx2(_mm256_cvtepi32_pd(_mm256_extracti128_si256(sums.sum[k], 1)), _mm256_cvtepi32_pd(_mm256_extracti128_si256(sums.sum2[k], 1)), count));
+         dwords[k] = _mm256_set_m128i(hi, lo);
+      }
+      return narrow(dwords);
+   }
+   static MT_FORCEINLINE void total(const sums_t &sums, Int64 &nSum, Int64 &nSum2) {
+      int32_t lanes[8], lanes2[8];
+      nSum = nSum2 = 0;
+      for ( int k = 0; k < 4; k++ )
+      {
+         _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), sums.sum[k]);
+         _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes2), sums.sum2[k]);
+         for ( int i = 0; i < 8; i++ )
+         {
+            nSum += lanes[i];
+            nSum2 += lanes2[i];
+         }
+      }
+   }
+};
+
+struct NetworkAvx2_16 {
+   typedef Word pixel_t;
+   typedef __m256i vector_t;
+   static const int count = 16;
+
+   static MT_FORCEINLINE __m256i load(const Word *ptr) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ptr)); }
+   static MT_FORCEINLINE void store(Word *ptr, __m256i value) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(ptr), value); }
+   static MT_FORCEINLINE __m256i lowest() { return _mm256_setzero_si256(); }
+   static MT_FORCEINLINE __m256i highest(int bits_per_pixel) { return _mm256_set1_epi16(short((1 << bits_per_pixel) - 1)); }
+   static MT_FORCEINLINE __m256i min(__m256i a, __m256i b) { return _mm256_min_epu16(a, b); }
+   static MT_FORCEINLINE __m256i max(__m256i a, __m256i b) { return _mm256_max_epu16(a, b); }
+   static MT_FORCEINLINE __m256i sub(__m256i a, __m256i b) { return _mm256_sub_epi16(a, b); }
+   static MT_FORCEINLINE __m256i median(__m256i value) { return value; }
+
+   static MT_FORCEINLINE __m256i divide(__m256i sum, __m256 divisor) {
+      return _mm256_cvttps_epi32(_mm256_div_ps(_mm256_cvtepi32_ps(sum), divisor));
+   }
+   static MT_FORCEINLINE __m256i average(const __m256i *values, int nCount) {
+      const __m256i zero = _mm256_setzero_si256();
+      auto lo = _mm256_set1_epi32(nCount >> 1);
+      auto hi = lo;
+      for ( int k = 0; k < nCount; k++ )
+      {
+         lo = _mm256_add_epi32(lo, _mm256_unpacklo_epi16(values[k], zero));
+         hi = _mm256_add_epi32(hi, _mm256_unpackhi_epi16(values[k], zero));
+      }
+      const auto divisor = _mm256_set1_ps(Float(nCount));
+      return _mm256_packus_epi32(divide(lo, divisor), divide(hi, divisor));
+   }
+
+   typedef Averager16 averager_t;
+   typedef Deviater16 deviater_t;
+   struct sums_t { __m256i sum[2], sum2[4]; };
+
+   static MT_FORCEINLINE __m256i narrow(__m256i lo, __m256i hi) {
+      return _mm256_permute4x64_epi64(_mm256_packus_epi32(lo, hi), _MM_SHUFFLE(3, 1, 2, 0));
+   }
+   static MT_FORCEINLINE void clear(sums_t &sums) {
+      sums.sum[0] = sums.sum[1] = _mm256_setzero_si256();
+      for ( int k = 0; k < 4; k++ )
+         sums.sum2[k] = _mm256_setzero_si256();
+   }
+   static MT_FORCEINLINE void add(sums_t &sums, __m256i value) {
+      sums.sum[0] = _mm256_add_epi32(sums.sum[0], _mm256_cvtepu16_epi32(_mm256_castsi256_si128(value)));
+      sums.sum[1] = _mm256_add_epi32(sums.sum[1], _mm256_cvtepu16_epi32(_mm256_extracti128_si256(value, 1)));
+   }
+   static MT_FORCEINLINE void add_squares(sums_t &sums, __m256i value) {
+      const __m256i dwords[2] = { _mm256_cvtepu16_epi32(_mm256_castsi256_si128(value)), _mm256_cvtepu16_epi32(_mm256_extracti128_si256(value, 1)) };
+      for ( int k = 0; k < 2; k++ )
+      {
+         sums.sum[k] = _mm256_add_epi32(sums.sum[k], dwords[k]);
+         auto lo = _mm256_cvtepu32_epi64(_mm256_castsi256_si128(dwords[k]));
+         auto hi = _mm256_cvtepu32_epi64(_mm256_extracti128_si256(dwords[k], 1));
+         sums.sum2[2 * k] = _mm256_add_epi64(sums.sum2[2 * k], _mm256_mul_epu32(lo, lo));
+         sums.sum2[2 * k + 1] = _mm256_add_epi64(sums.sum2[2 * k + 1], _mm256_mul_epu32(hi, hi));
+      }
+   }
+   static MT_FORCEINLINE __m256i finalize_average(const sums_t &sums, int nCount) {
+      return narrow(average_epi32_avx2(sums.sum[0], nCount), average_epi32_avx2(sums.sum[1], nCount));
+   }
+   static MT_FORCEINLINE __m256i deviation(__m256i sum, __m256i sum2_lo, __m256i sum2_hi, __m256d count) {
+      auto lo = round_pd_avx2(deviation_pd_avx2(_mm256_cvtepi32_pd(_mm256_castsi256_si128(sum)), cvtepu64_pd_avx2(sum2_lo), count));
+      auto hi = round_pd_avx2(deviation_pd_avx2(_mm256_cvtepi32_pd(_mm256_extracti128_si256(sum, 1)), cvtepu64_pd_avx2(sum2_hi), count));
+      return _mm256_set_m128i(hi, lo);
+   }
+   static MT_FORCEINLINE __m256i finalize_deviation(const sums_t &sums, int nCount) {
+      const auto count = _mm256_set1_pd(Double(nCount));
+      return narrow(deviation(sums.sum[0], sums.sum2[0], sums.sum2[1], count), deviation(sums.sum[1], sums.sum2[2], sums.sum2[3], count));
+   }
+   static MT_FORCEINLINE void total(const sums_t &sums, Int64 &nSum, Int64 &nSum2) {
+      int32_t lanes[8];
+      Int64 lanes2[4];
+      nSum = nSum2 = 0;
+      for ( int k = 0; k < 2; k++ )
+      {
+         _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), sums.sum[k]);
+         for ( int i = 0; i < 8; i++ )
+            nSum += lanes[i];
+      }
+      for ( int k = 0; k < 4; k++ )
+      {
+         _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes2), sums.sum2[k]);
+         nSum2 += lanes2[0] + lanes2[1] + lanes2[2] + lanes2[3];
+      }
+   }
+};
+
+struct NetworkAvx2_32 {
+   typedef Float pixel_t;
+   typedef __m256 vector_t;
+   static const int count = 8;
+
+   static MT_FORCEINLINE __m256 load(const Float *ptr) { return _mm256_loadu_ps(ptr); }
+   static MT_FORCEINLINE void store(Float *ptr, __m256 value) { _mm256_storeu_ps(ptr, value); }
+   static MT_FORCEINLINE __m256 lowest() { return _mm256_setzero_ps(); }
+   static MT_FORCEINLINE __m256 highest(int bits_per_pixel) { UNUSED(bits_per_pixel); return _mm256_set1_ps(1.0f); }
+   static MT_FORCEINLINE __m256 min(__m256 a, __m256 b) { return _mm256_min_ps(a, b); }
+   static MT_FORCEINLINE __m256 max(__m256 a, __m256 b) { return _mm256_max_ps(a, b); }
+   static MT_FORCEINLINE __m256 sub(__m256 a, __m256 b) { return _mm256_sub_ps(a, b); }
+
+   static MT_FORCEINLINE __m256 median(__m256 value) {
+      auto clamped = _mm256_min_ps(_mm256_max_ps(value, _mm256_setzero_ps()), _mm256_set1_ps(1.0f));
+      auto quantized = _mm256_cvttps_epi32(_mm256_mul_ps(clamped, _mm256_set1_ps(65535.0f)));
+      return _mm256_div_ps(_mm256_cvtepi32_ps(quantized), _mm256_set1_ps(65535.0f));
+   }
+   static MT_FORCEINLINE __m256 average(const __m256 *values, int nCount) {
+      auto lo = _mm256_setzero_pd();
+      auto hi = lo;
+      for ( int k = 0; k < nCount; k++ )
+      {
+         lo = _mm256_add_pd(lo, _mm256_cvtps_pd(_mm256_castps256_ps128(values[k])));
+         hi = _mm256_add_pd(hi, _mm256_cvtps_pd(_mm256_extractf128_ps(values[k], 1)));
+      }
+      const auto divisor = _mm256_set1_pd(Double(nCount));
+      return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm256_cvtpd_ps(_mm256_div_pd(lo, divisor))), _mm256_cvtpd_ps(_mm256_div_pd(hi, divisor)), 1);
+   }
+
+   struct sums_t { __m256d sum[2]; __m256 fsum, fsum2; };
+
+   static MT_FORCEINLINE void clear(sums_t &sums) {
+      sums.sum[0] = sums.sum[1] = _mm256_setzero_pd();
+      sums.fsum = sums.fsum2 = _mm256_setzero_ps();
+   }
+   static MT_FORCEINLINE void add(sums_t &sums, __m256 value) {
+      sums.sum[0] = _mm256_add_pd(sums.sum[0], _mm256_cvtps_pd(_mm256_castps256_ps128(value)));
+      sums.sum[1] = _mm256_add_pd(sums.sum[1], _mm256_cvtps_pd(_mm256_extractf128_ps(value, 1)));
+   }
+   static MT_FORCEINLINE void add_squares(sums_t &sums, __m256 value) {
+      sums.fsum = _mm256_add_ps(sums.fsum, value);
+      sums.fsum2 = _mm256_add_ps(sums.fsum2, _mm256_mul_ps(value, value));
+   }
+   static MT_FORCEINLINE __m256 finalize_average(const sums_t &sums, int nCount) {
+      const auto divisor = _mm256_set1_pd(Double(nCount));
+      return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm256_cvtpd_ps(_mm256_div_pd(sums.sum[0], divisor))), _mm256_cvtpd_ps(_mm256_div_pd(sums.sum[1], divisor)), 1);
+   }
+   static MT_FORCEINLINE __m256 finalize_deviation(const sums_t &sums, int nCount) {
+      const auto count = _mm256_set1_pd(Double(nCount));
+      auto lo = deviation_pd_avx2(_mm256_cvtps_pd(_mm256_castps256_ps128(sums.fsum)), _mm256_cvtps_pd(_mm256_castps256_ps128(sums.fsum2)), count);
+      auto hi = deviation_pd_avx2(_mm256_cvtps_pd(_mm256_extractf128_ps(sums.fsum, 1)), _mm256_cvtps_pd(_mm256_extractf128_ps(sums.fsum2, 1)), count);
+      return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm256_cvtpd_ps(lo)), _mm256_cvtpd_ps(hi), 1);
+   }
+};
+
+void network_row_avx2(Byte *pDst, const Byte *const *pRows, int nCount, int nWidth, int nMode, int bits_per_pixel)
+{
+   network_row_simd<NetworkAvx2>(pDst, pRows, nCount, nWidth, nMode, bits_per_pixel);
+}
+
+void network_row_avx2_16(Word *pDst, const Word *const *pRows, int nCount, int nWidth, int nMode, int bits_per_pixel)
+{
+   network_row_simd<NetworkAvx2_16>(pDst, pRows, nCount, nWidth, nMode, bits_per_pixel);
+}
+
+void network_row32_avx2(Float *pDst, const Float *const *pRows, int nCount, int nWidth, int nMode, int bits_per_pixel)
+{
+   network_row_simd<NetworkAvx2_32>(pDst, pRows, nCount, nWidth, nMode, bits_per_pixel);
+}
+
+Byte network_plane_avx2(const Byte *pSrc, ptrdiff_t nPitch, int nWidth, int nHeight, int nMode, int bits_per_pixel)
+{
+   return network_plane_simd<NetworkAvx2>(pSrc, nPitch, nWidth, nHeight, nMode, bits_per_pixel);
+}
+
+Word network_plane_avx2_16(const Word *pSrc, ptrdiff_t nPitch, int nWidth, int nHeight, int nMode, int bits_per_pixel)
+{
+   return network_plane_simd<NetworkAvx2_16>(pSrc, nPitch, nWidth, nHeight, nMode, bits_per_pixel);
+}
+
+Float network_plane32_avx2(const Float *pSrc, ptrdiff_t nPitch, int nWidth, int nHeight, int nMode, int bits_per_pixel)
+{
+   return network_plane_bounds<NetworkAvx2_32>(pSrc, nPitch, nWidth, nHeight, nMode, bits_per_pixel);
+}
+
+} } } } // namespace Lut, Filters, MaskTools, Filtering
@@ -0,0 +1,555 @@
+#ifndef __Mt_Lut_NeighbourhoodSimd_H__
+#define __Mt_Lut_NeighbourhoodSimd_H__
+
+#include "neighbourhood.h"
+#include "../../common/simd.h"
+
+namespace Filtering { namespace MaskTools { namespace Filters { namespace Lut {
+
+/* Sorting networks reduced to the comparisons the middle element depends on: after each pair
+   (a, b), a holds the smaller value. 5 and 9 elements are Paeth's, 25 is Batcher's odd-even merge
+   sort of 32 elements without the 7 largest ones. */
+static const Byte median_network_5[][2] = {
+   { 0, 1 }, { 3, 4 }, { 0, 3 }, { 1, 4 }, { 1, 2 }, { 2, 3 }, { 1, 2 }
+};
+
+static const Byte median_network_9[][2] = {
+   { 1, 2 }, { 4, 5 }, { 7, 8 }, { 0, 1 }, { 3, 4 }, { 6, 7 }, { 1, 2 }, { 4, 5 }, { 7, 8 }, { 0, 3 },
+   { 5, 8 }, { 4, 7 }, { 3, 6 }, { 1, 4 }, { 2, 5 }, { 4, 7 }, { 4, 2 }, { 6, 4 }, { 4, 2 }
+};
+
+static const Byte median_network_25[][2] = {
+   { 0, 1 }, { 2, 3 }, { 4, 5 }, { 6, 7 }, { 8, 9 }, { 10, 11 }, { 12, 13 }, { 14, 15 }, { 16, 17 },
+   { 18, 19 }, { 20, 21 }, { 22, 23 }, { 0, 2 }, { 1, 3 }, { 4, 6 }, { 5, 7 }, { 8, 10 }, { 9, 11 },
+   { 12, 14 }, { 13, 15 }, { 16, 18 }, { 17, 19 }, { 20, 22 }, { 21, 23 }, { 1, 2 }, { 5, 6 }, { 9, 10 },
+   { 13, 14 }, { 17, 18 }, { 21, 22 }, { 0, 4 }, { 1, 5 }, { 2, 6 }, { 3, 7 }, { 8, 12 }, { 9, 13 },
+   { 10, 14 }, { 11, 15 }, { 16, 20 }, { 17, 21 }, { 18, 22 }, { 19, 23 }, { 2, 4 }, { 3, 5 }, { 10, 12 },
+   { 11, 13 }, { 18, 20 }, { 19, 21 }, { 1, 2 }, { 3, 4 }, { 5, 6 }, { 9, 10 }, { 11, 12 }, { 13, 14 },
+   { 17, 18 }, { 19, 20 }, { 21, 22 }, { 0, 8 }, { 1, 9 }, { 2, 10 }, { 3, 11 }, { 4, 12 }, { 5, 13 },
+   { 6, 14 }, { 7, 15 }, { 16, 24 }, { 4, 8 }, { 5, 9 }, { 6, 10 }, { 7, 11 }, { 20, 24 }, { 2, 4 },
+   { 3, 5 }, { 6, 8 }, { 7, 9 }, { 10, 12 }, { 11, 13 }, { 18, 20 }, { 19, 21 }, { 22, 24 }, { 1, 2 },
+   { 3, 4 }, { 5, 6 }, { 7, 8 }, { 9, 10 }, { 11, 12 }, { 13, 14 }, { 17, 18 }, { 19, 20 }, { 21, 22 },
+   { 23, 24 }, { 0, 16 }, { 1, 17 }, { 2, 18 }, { 3, 19 }, { 4, 20 }, { 5, 21 }, { 6, 22 }, { 7, 23 },
+   { 8, 24 }, { 8, 16 }, { 9, 17 }, { 10, 18 }, { 11, 19 }, { 12, 20 }, { 13, 21 }, { 6, 10 }, { 7, 11 },
+   { 12, 16 }, { 13, 17 }, { 10, 12 }, { 11, 13 }, { 11, 12 }
+};
+
+/* A policy P gives the vector type of a pixel type:
+      count                   pixels of a vector
+      load, store
+      lowest(), highest(bpp)  starting values of Maximizer and Minimizer
+      min, max, sub
+      average(values, n)      rounded like Averager, accumulated like Averager32 for float
+      median(value)           the middle value like Medianizer, quantized for float
+   and for any count of values, sums_t that holds their sums in wider lanes:
+      clear(sums)
+      add(sums, value)        the sum for finalize_average
+      add_squares(sums, value) the sums of the values and of their squares for finalize_deviation
+      finalize_average(sums, n), finalize_deviation(sums, n)  like Averager and Deviater
+      total(sums, sum, sum2)  the sums of all the pixels, for the integer policies */
+
+/* Averager's rounded division (sum + n / 2) / n of 4 32 bit sums, exact in double */
+static MT_FORCEINLINE __m128i average_epi32(__m128i sum, int nCount)
+{
+   const auto divisor = _mm_set1_pd(Double(nCount));
+   sum = _mm_add_epi32(sum, _mm_set1_epi32(nCount >> 1));
+   auto lo = _mm_cvttpd_epi32(_mm_div_pd(_mm_cvtepi32_pd(sum), divisor));
+   auto hi = _mm_cvttpd_epi32(_mm_div_pd(_mm_cvtepi32_pd(_mm_unpackhi_epi64(sum, sum)), divisor));
+   return _mm_unpacklo_epi64(lo, hi);
+}
+
+/* Deviater's sqrt((s2 * n - s * s) / (n * n)), the same operations in the same order */
+static MT_FORCEINLINE __m128d deviation_pd(__m128d sum, __m128d sum2, __m128d count)
+{
+   return _mm_sqrt_pd(_mm_div_pd(_mm_sub_pd(_mm_mul_pd(sum2, count), _mm_mul_pd(sum, sum)), _mm_mul_pd(count, count)));
+}
+
+/* 64 bit integers below 2^52 */
+static MT_FORCEINLINE __m128d cvtepu64_pd(__m128i value)
+{
+   const auto magic = _mm_set1_pd(4503599627370496.0);
+   return _mm_sub_pd(_mm_castsi128_pd(_mm_or_si128(value, _mm_castpd_si128(magic))), magic);
+}
+
+/* convert<Word, Double> or, saturated first, convert<Byte, Double> of 2 pixels */
+static MT_FORCEINLINE __m128i round_pd(__m128d value)
+{
+   return _mm_cvttpd_epi32(_mm_add_pd(value, _mm_set1_pd(0.5)));
+}
+
+static MT_FORCEINLINE __m128i round_clip_pd(__m128d value)
+{
+   return round_pd(_mm_min_pd(_mm_set1_pd(255.0), _mm_max_pd(_mm_setzero_pd(), value)));
+}
+
+template<class P, int nCount>
+static MT_FORCEINLINE typename P::vector_t median_network(typename P::vector_t *values)
+{
+   const Byte (*pairs)[2] = nCount == 5 ? median_network_5 : nCount == 9 ? median_network_9 : median_network_25;
+   const int nPairs = nCount == 5 ? int(sizeof(median_network_5) / sizeof(median_network_5[0])) :
+                      nCount == 9 ? int(sizeof(median_network_9) / sizeof(median_network_9[0])) :
+                                    int(sizeof(median_network_25) / sizeof(median_network_25[0]));
+   for ( int k = 0; k < nPairs; k++ )
+   {
+      const auto a = values[pairs[k][0]];
+      const auto b = values[pairs[k][1]];
+      values[pairs[k][0]] = P::min(a, b);
+      values[pairs[k][1]] = P::max(a, b);
+   }
+   return P::median(values[nCount / 2]);
+}
+
+/* the rows are readable past the end, not the destination */
+template<class P>
+static MT_FORCEINLINE void store_row(typename P::pixel_t *pDst, int x, int nWidth, typename P::vector_t result)
+{
+   if ( x + P::count <= nWidth )
+      P::store(pDst + x, result);
+   else
+   {
+      typename P::pixel_t tail[P::count];
+      P::store(tail, result);
+      memcpy(pDst + x, tail, (nWidth - x) * sizeof(typename P::pixel_t));
+   }
+}
+
+template<class P, int nMode, int nCount>
+static void network_row(typename P::pixel_t *pDst, const typename P::pixel_t *const *pRows, int nWidth, int bits_per_pixel)
+{
+   typedef typename P::pixel_t T;
+   typedef typename P::vector_t V;
+
+   const V lowest = P::lowest();
+   const V highest = P::highest(bits_per_pixel);
+   V values[nCount];
+
+   for ( int x = 0; x < nWidth; x += P::count )
+   {
+      for ( int k = 0; k < nCount; k++ )
+         values[k] = P::load(pRows[k] + x);
+
+      V result;
+      if ( nMode == MINIMIZER || nMode == MAXIMIZER || nMode == RANGIZER )
+      {
+         V nMin = highest, nMax = lowest;
+         for ( int k = 0; k < nCount; k++ )
+         {
+            nMin = P::min(nMin, values[k]);
+            nMax = P::max(nMax, values[k]);
+         }
+         result = nMode == MINIMIZER ? nMin : nMode == MAXIMIZER ? nMax : P::sub(nMax, nMin);
+      }
+      else if ( nMode == AVERAGER )
+         result = P::average(values, nCount);
+      else
+         result = median_network<P, nCount>(values);
+
+      store_row<P>(pDst, x, nWidth, result);
+   }
+}
+
+/* any count of neighbours, folded as they are loaded */
+template<class P, int nMode>
+static void reduce_row(typename P::pixel_t *pDst, const typename P::pixel_t *const *pRows, int nCount, int nWidth, int bits_per_pixel)
+{
+   typedef typename P::vector_t V;
+
+   const V lowest = P::lowest();
+   const V highest = P::highest(bits_per_pixel);
+
+   for ( int x = 0; x < nWidth; x += P::count )
+   {
+      V result;
+      if ( nMode == MINIMIZER || nMode == MAXIMIZER || nMode == RANGIZER )
+      {
+         V nMin = highest, nMax = lowest;
+         for ( int k = 0; k < nCount; k++ )
+         {
+            const V value = P::load(pRows[k] + x);
+            nMin = P::min(nMin, value);
+            nMax = P::max(nMax, value);
+         }
+         result = nMode == MINIMIZER ? nMin : nMode == MAXIMIZER ? nMax : P::sub(nMax, nMin);
+      }
+      else
+      {
+         typename P::sums_t sums;
+         P::clear(sums);
+         for ( int k = 0; k < nCount; k++ )
+         {
+            if ( nMode == AVERAGER )
+               P::add(sums, P::load(pRows[k] + x));
+            else
+               P::add_squares(sums, P::load(pRows[k] + x));
+         }
+         result = nMode == AVERAGER ? P::finalize_average(sums, nCount) : P::finalize_deviation(sums, nCount);
+      }
+
+      store_row<P>(pDst, x, nWidth, result);
+   }
+}
+
+template<class P, int nMode>
+static void network_row(typename P::pixel_t *pDst, const typename P::pixel_t *const *pRows, int nCount, int nWidth, int bits_per_pixel)
+{
+   switch ( nCount )
+   {
+   case 5: network_row<P, nMode, 5>(pDst, pRows, nWidth, bits_per_pixel); break;
+   case 9: network_row<P, nMode, 9>(pDst, pRows, nWidth, bits_per_pixel); break;
+   default: network_row<P, nMode, 25>(pDst, pRows, nWidth, bits_per_pixel); break;
+   }
+}
+
+/* the counts of the networks keep all their values in registers, the others are folded */
+template<class P>
+static void network_row_simd(typename P::pixel_t *pDst, const typename P::pixel_t *const *pRows, int nCount, int nWidth, int nMode, int bits_per_pixel)
+{
+   const bool isNetwork = nCount == 5 || nCount == 9 || nCount == 25;
+   switch ( nMode )
+   {
+   case MINIMIZER: isNetwork ? network_row<P, MINIMIZER>(pDst, pRows, nCount, nWidth, bits_per_pixel) : reduce_row<P, MINIMIZER>(pDst, pRows, nCount, nWidth, bits_per_pixel); break;
+   case MAXIMIZER: isNetwork ? network_row<P, MAXIMIZER>(pDst, pRows, nCount, nWidth, bits_per_pixel) : reduce_row<P, MAXIMIZER>(pDst, pRows, nCount, nWidth, bits_per_pixel); break;
+   case RANGIZER: isNetwork ? network_row<P, RANGIZER>(pDst, pRows, nCount, nWidth, bits_per_pixel) : reduce_row<P, RANGIZER>(pDst, pRows, nCount, nWidth, bits_per_pixel); break;
+   case AVERAGER: isNetwork ? network_row<P, AVERAGER>(pDst, pRows, nCount, nWidth, bits_per_pixel) : reduce_row<P, AVERAGER>(pDst, pRows, nCount, nWidth, bits_per_pixel); break;
+   case DEVIATER: reduce_row<P, DEVIATER>(pDst, pRows, nCount, nWidth, bits_per_pixel); break;
+   default: network_row<P, MEDIANIZER4>(pDst, pRows, nCount, nWidth, bits_per_pixel); break;
+   }
+}
+
+/* A whole plane for the frame luts, the pixels past the last vector of a row one at a time */
+template<class P>
+static typename P::pixel_t network_plane_bounds(const typename P::pixel_t *pSrc, ptrdiff_t nPitch, int nWidth, int nHeight, int nMode, int bits_per_pixel)
+{
+   typedef typename P::pixel_t T;
+   typedef typename P::vector_t V;
+
+   const int nVectors = nWidth - nWidth % P::count;
+
+   V vMin = P::highest(bits_per_pixel), vMax = P::lowest();
+   T lanes[P::count];
+   P::store(lanes, vMin);
+   T nMin = lanes[0], nMax = T(0);
+   for ( int y = 0; y < nHeight; y++ )
+   {
+      for ( int x = 0; x < nVectors; x += P::count )
+      {
+         const V value = P::load(pSrc + x);
+         vMin = P::min(vMin, value);
+         vMax = P::max(vMax, value);
+      }
+      for ( int x = nVectors; x < nWidth; x++ )
+      {
+         nMin = min<T>(nMin, pSrc[x]);
+         nMax = max<T>(nMax, pSrc[x]);
+      }
+      pSrc += nPitch;
+   }
+   P::store(lanes, vMin);
+   for ( int k = 0; k < P::count; k++ )
+      nMin = min<T>(nMin, lanes[k]);
+   P::store(lanes, vMax);
+   for ( int k = 0; k < P::count; k++ )
+      nMax = max<T>(nMax, lanes[k]);
+   return nMode == MINIMIZER ? nMin : nMode == MAXIMIZER ? nMax : T(nMax - nMin);
+}
+
+/* the lanes of the sums are totalled every 2^15 vectors */
+template<class P, int nMode>
+static typename P::pixel_t network_plane_sums(const typename P::pixel_t *pSrc, ptrdiff_t nPitch, int nWidth, int nHeight)
+{
+   const int nVectors = nWidth - nWidth % P::count;
+
+   Int64 nSum = 0, nSum2 = 0;
+   for ( int y = 0; y < nHeight; y++ )
+   {
+      for ( int nStart = 0; nStart < nVectors; nStart += P::count << 15 )
+      {
+         const int nEnd = min<int>(nVectors, nStart + (P::count << 15));
+         typename P::sums_t sums;
+         P::clear(sums);
+         for ( int x = nStart; x < nEnd; x += P::count )
+         {
+            if ( nMode == AVERAGER )
+               P::add(sums, P::load(pSrc + x));
+            else
+               P::add_squares(sums, P::load(pSrc + x));
+         }
+         Int64 nPartSum, nPartSum2;
+         P::total(sums, nPartSum, nPartSum2);
+         nSum += nPartSum;
+         nSum2 += nPartSum2;
+      }
+      for ( int x = nVectors; x < nWidth; x++ )
+      {
+         nSum += pSrc[x];
+         nSum2 += Int64(pSrc[x]) * pSrc[x];
+      }
+      pSrc += nPitch;
+   }
+   const Int64 nCount = Int64(nWidth) * nHeight;
+   if ( nMode == AVERAGER )
+      return P::averager_t::finalize(nSum, nCount);
+   return P::deviater_t::finalize(Double(nSum), Double(nSum2), Double(nCount));
+}
+
+template<class P>
+static typename P::pixel_t network_plane_simd(const typename P::pixel_t *pSrc, ptrdiff_t nPitch, int nWidth, int nHeight, int nMode, int bits_per_pixel)
+{
+   switch ( nMode )
+   {
+   case AVERAGER: return network_plane_sums<P, AVERAGER>(pSrc, nPitch, nWidth, nHeight);
+   case DEVIATER: return network_plane_sums<P, DEVIATER>(pSrc, nPitch, nWidth, nHeight);
+   default: return network_plane_bounds<P>(pSrc, nPitch, nWidth, nHeight, nMode, bits_per_pixel);
+   }
+}
+
+/* sse2, 8 bit */
+struct NetworkSse2 {
+   typedef Byte pixel_t;
+   typedef __m128i vector_t;
+   static const int count = 16;
+
+   static MT_FORCEINLINE __m128i load(const Byte *ptr) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr)); }
+   static MT_FORCEINLINE void store(Byte *ptr, __m128i value) { _mm_storeu_si128(reinterpret_cast<__m128i*>(ptr), value); }
+   static MT_FORCEINLINE __m128i lowest() { return _mm_setzero_si128(); }
+   static MT_FORCEINLINE __m128i highest(int bits_per_pixel) { UNUSED(bits_per_pixel); return _mm_set1_epi8(-1); }
+   static MT_FORCEINLINE __m128i min(__m128i a, __m128i b) { return _mm_min_epu8(a, b); }
+   static MT_FORCEINLINE __m128i max(__m128i a, __m128i b) { return _mm_max_epu8(a, b); }
+   static MT_FORCEINLINE __m128i sub(__m128i a, __m128i b) { return _mm_sub_epi8(a, b); }
+   static MT_FORCEINLINE __m128i median(__m128i value) { return value; }
+
+   /* sums below 2^24 divided as floats: the quotient is exact enough to be truncated */
+   static MT_FORCEINLINE __m128i divide(__m128i sum, __m128 divisor) {
+      const __m128i zero = _mm_setzero_si128();
+      auto lo = _mm_cvttps_epi32(_mm_div_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(sum, zero)), divisor));
+      auto hi = _mm_cvttps_epi32(_mm_div_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(sum, zero)), divisor));
+      return _mm_packs_epi32(lo, hi);
+   }
+   static MT_FORCEINLINE __m128i average(const __m128i *values, int nCount) {
+      const __m128i zero = _mm_setzero_si128();
+      auto lo = _mm_set1_epi16(short(nCount >> 1));
+      auto hi = lo;
+      for ( int k = 0; k < nCount; k++ )
+      {
+         lo = _mm_add_epi16(lo, _mm_unpacklo_epi8(values[k], zero));
+         hi = _mm_add_epi16(hi, _mm_unpackhi_epi8(values[k], zero));
+      }
+      const auto divisor = _mm_set1_ps(Float(nCount));
+      return _mm_packus_epi16(divide(lo, divisor), divide(hi, divisor));
+   }
+
+   /* 32 bit sums of values and squares, below 2^31 up to 2^15 values */
+   typedef Averager<int64_t> averager_t;
+   typedef Deviater<int64_t> deviater_t;
+   struct sums_t { __m128i sum[4], sum2[4]; };
+
+   static MT_FORCEINLINE void widen(__m128i value, __m128i *dwords) {
+      const __m128i zero = _mm_setzero_si128();
+      auto lo = _mm_unpacklo_epi8(value, zero);
+      auto hi = _mm_unpackhi_epi8(value, zero);
+      dwords[0] = _mm_unpacklo_epi16(lo, zero);
+      dwords[1] = _mm_unpackhi_epi16(lo, zero);
+      dwords[2] = _mm_unpacklo_epi16(hi, zero);
+      dwords[3] = _mm_unpackhi_epi16(hi, zero);
+   }
+   static MT_FORCEINLINE void clear(sums_t &sums) {
+      for ( int k = 0; k < 4; k++ )
+         sums.sum[k] = sums.sum2[k] = _mm_setzero_si128();
+   }
+   static MT_FORCEINLINE void add(sums_t &sums, __m128i value) {
+      __m128i dwords[4];
+      widen(value, dwords);
+      for ( int k = 0; k < 4; k++ )
+         sums.sum[k] = _mm_add_epi32(sums.sum[k], dwords[k]);
+   }
+   static MT_FORCEINLINE void add_squares(sums_t &sums, __m128i value) {
+      __m128i dwords[4];
+      widen(value, dwords);
+      for ( int k = 0; k < 4; k++ )
+      {
+         sums.sum[k] = _mm_add_epi32(sums.sum[k], dwords[k]);
+         sums.sum2[k] = _mm_add_epi32(sums.sum2[k], _mm_madd_epi16(dwords[k], dwords[k])); /* high words are 0 */
+      }
+   }
+   static MT_FORCEINLINE __m128i finalize_average(const sums_t &sums, int nCount) {
+      auto lo = _mm_packs_epi32(average_epi32(sums.sum[0], nCount), average_epi32(sums.sum[1], nCount));
+      auto hi = _mm_packs_epi32(average_epi32(sums.sum[2], nCount), average_epi32(sums.sum[3], nCount));
+      return _mm_packus_epi16(lo, hi);
+   }
+   static MT_FORCEINLINE __m128i deviation(__m128i sum, __m128i sum2, __m128d count) {
+      auto lo = round_clip_pd(deviation_pd(_mm_cvtepi32_pd(sum), _mm_cvtepi32_pd(sum2), count));
+      auto hi = round_clip_pd(deviation_pd(_mm_cvtepi32_pd(_mm_unpackhi_epi64(sum, sum)), _mm_cvtepi32_pd(_mm_unpackhi_epi64(sum2, sum2)), count));
+      return _mm_unpacklo_epi64(lo, hi);
+   }
+   static MT_FORCEINLINE __m128i finalize_deviation(const sums_t &sums, int nCount) {
+      const auto count = _mm_set1_pd(Double(nCount));
+      auto lo = _mm_packs_epi32(deviation(sums.sum[0], sums.sum2[0], count), deviation(sums.sum[1], sums.sum2[1], count));
+      auto hi = _mm_packs_epi32(deviation(sums.sum[2], sums.sum2[2], count), deviation(sums.sum[3], sums.sum2[3], count));
+      return _mm_packus_epi16(lo, hi);
+   }
+   static MT_FORCEINLINE void total(const sums_t &sums, Int64 &nSum, Int64 &nSum2) {
+      int32_t lanes[4], lanes2[4];
+      nSum = nSum2 = 0;
+      for ( int k = 0; k < 4; k++ )
+      {
+         _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), sums.sum[k]);
+         _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes2), sums.sum2[k]);
+         for ( int i = 0; i < 4; i++ )
+         {
+            nSum += lanes[i];
+            nSum2 += lanes2[i];
+         }
+      }
+   }
+};
+
+/* sse4.1, 10-16 bit */
+struct NetworkSse4_16 {
+   typedef Word pixel_t;
+   typedef __m128i vector_t;
+   static const int count = 8;
+
+   static MT_FORCEINLINE __m128i load(const Word *ptr) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr)); }
+   static MT_FORCEINLINE void store(Word *ptr, __m128i value) { _mm_storeu_si128(reinterpret_cast<__m128i*>(ptr), value); }
+   static MT_FORCEINLINE __m128i lowest() { return _mm_setzero_si128(); }
+   static MT_FORCEINLINE __m128i highest(int bits_per_pixel) { return _mm_set1_epi16(short((1 << bits_per_pixel) - 1)); }
+   static MT_FORCEINLINE __m128i min(__m128i a, __m128i b) { return _mm_min_epu16(a, b); }
+   static MT_FORCEINLINE __m128i max(__m128i a, __m128i b) { return _mm_max_epu16(a, b); }
+   static MT_FORCEINLINE __m128i sub(__m128i a, __m128i b) { return _mm_sub_epi16(a, b); }
+   static MT_FORCEINLINE __m128i median(__m128i value) { return value; }
+
+   static MT_FORCEINLINE __m128i divide(__m128i sum, __m128 divisor) {
+      return _mm_cvttps_epi32(_mm_div_ps(_mm_cvtepi32_ps(sum), divisor));
+   }
+   static MT_FORCEINLINE __m128i average(const __m128i *values, int nCount) {
+      const __m128i zero = _mm_setzero_si128();
+      auto lo = _mm_set1_epi32(nCount >> 1);
+      auto hi = lo;
+      for ( int k = 0; k < nCount; k++ )
+      {
+         lo = _mm_add_epi32(lo, _mm_unpacklo_epi16(values[k], zero));
+         hi = _mm_add_epi32(hi, _mm_unpackhi_epi16(values[k], zero));
+      }
+      const auto divisor = _mm_set1_ps(Float(nCount));
+      return _mm_packus_epi32(divide(lo, divisor), divide(hi, divisor));
+   }
+
+   /* 32 bit sums of values, 64 bit sums of squares */
+   typedef Averager16 averager_t;
+   typedef Deviater16 deviater_t;
+   struct sums_t { __m128i sum[2], sum2[4]; };
+
+   static MT_FORCEINLINE void clear(sums_t &sums) {
+      sums.sum[0] = sums.sum[1] = _mm_setzero_si128();
+      for ( int k = 0; k < 4; k++ )
+         sums.sum2[k] = _mm_setzero_si128();
+   }
+   static MT_FORCEINLINE void add(sums_t &sums, __m128i value) {
+      const __m128i zero = _mm_setzero_si128();
+      sums.sum[0] = _mm_add_epi32(sums.sum[0], _mm_unpacklo_epi16(value, zero));
+      sums.sum[1] = _mm_add_epi32(sums.sum[1], _mm_unpackhi_epi16(value, zero));
+   }
+   static MT_FORCEINLINE void add_squares(sums_t &sums, __m128i value) {
+      const __m128i zero = _mm_setzero_si128();
+      const __m128i dwords[2] = { _mm_unpacklo_epi16(value, zero), _mm_unpackhi_epi16(value, zero) };
+      for ( int k = 0; k < 2; k++ )
+      {
+         sums.sum[k] = _mm_add_epi32(sums.sum[k], dwords[k]);
+         auto lo = _mm_unpacklo_epi32(dwords[k], zero);
+         auto hi = _mm_unpackhi_epi32(dwords[k], zero);
+         sums.sum2[2 * k] = _mm_add_epi64(sums.sum2[2 * k], _mm_mul_epu32(lo, lo));
+         sums.sum2[2 * k + 1] = _mm_add_epi64(sums.sum2[2 * k + 1], _mm_mul_epu32(hi, hi));
+      }
+   }
+   static MT_FORCEINLINE __m128i finalize_average(const sums_t &sums, int nCount) {
+      return _mm_packus_epi32(average_epi32(sums.sum[0], nCount), average_epi32(sums.sum[1], nCount));
+   }
+   static MT_FORCEINLINE __m128i deviation(__m128i sum, __m128i sum2_lo, __m128i sum2_hi, __m128d count) {
+      auto lo = round_pd(deviation_pd(_mm_cvtepi32_pd(sum), cvtepu64_pd(sum2_lo), count));
+      auto hi = round_pd(deviation_pd(_mm_cvtepi32_pd(_mm_unpackhi_epi64(sum, sum)), cvtepu64_pd(sum2_hi), count));
+      return _mm_unpacklo_epi64(lo, hi);
+   }
+   static MT_FORCEINLINE __m128i finalize_deviation(const sums_t &sums, int nCount) {
+      const auto count = _mm_set1_pd(Double(nCount));
+      return _mm_packus_epi32(deviation(sums.sum[0], sums.sum2[0], sums.sum2[1], count), deviation(sums.sum[1], sums.sum2[2], sums.sum2[3], count));
+   }
+   static MT_FORCEINLINE void total(const sums_t &sums, Int64 &nSum, Int64 &nSum2) {
+      int32_t lanes[4];
+      Int64 lanes2[2];
+      nSum = nSum2 = 0;
+      for ( int k = 0; k < 2; k++ )
+      {
+         _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), sums.sum[k]);
+         for ( int i = 0; i < 4; i++ )
+            nSum += lanes[i];
+      }
+      for ( int k = 0; k < 4; k++ )
+      {
+         _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes2), sums.sum2[k]);
+         nSum2 += lanes2[0] + lanes2[1];
+      }
+   }
+};
+
+/* sse2, float. min_ps and max_ps compare like min and max of utils.h */
+struct NetworkSse2_32 {
+   typedef Float pixel_t;
+   typedef __m128 vector_t;
+   static const int count = 4;
+
+   static MT_FORCEINLINE __m128 load(const Float *ptr) { return _mm_loadu_ps(ptr); }
+   static MT_FORCEINLINE void store(Float *ptr, __m128 value) { _mm_storeu_ps(ptr, value); }
+   static MT_FORCEINLINE __m128 lowest() { return _mm_setzero_ps(); }
+   static MT_FORCEINLINE __m128 highest(int bits_per_pixel) { UNUSED(bits_per_pixel); return _mm_set1_ps(1.0f); }
+   static MT_FORCEINLINE __m128 min(__m128 a, __m128 b) { return _mm_min_ps(a, b); }
+   static MT_FORCEINLINE __m128 max(__m128 a, __m128 b) { return _mm_max_ps(a, b); }
+   static MT_FORCEINLINE __m128 sub(__m128 a, __m128 b) { return _mm_sub_ps(a, b); }
+
+   /* Medianizer32 quantizes to 16 bit, which keeps the order */
+   static MT_FORCEINLINE __m128 median(__m128 value) {
+      auto clamped = _mm_min_ps(_mm_max_ps(value, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+      auto quantized = _mm_cvttps_epi32(_mm_mul_ps(clamped, _mm_set1_ps(65535.0f)));
+      return _mm_div_ps(_mm_cvtepi32_ps(quantized), _mm_set1_ps(65535.0f));
+   }
+   static MT_FORCEINLINE __m128 average(const __m128 *values, int nCount) {
+      auto lo = _mm_setzero_pd();
+      auto hi = lo;
+      for ( int k = 0; k < nCount; k++ )
+      {
+         lo = _mm_add_pd(lo, _mm_cvtps_pd(values[k]));
+         hi = _mm_add_pd(hi, _mm_cvtps_pd(_mm_movehl_ps(values[k], values[k])));
+      }
+      const auto divisor = _mm_set1_pd(Double(nCount));
+      return _mm_movelh_ps(_mm_cvtpd_ps(_mm_div_pd(lo, divisor)), _mm_cvtpd_ps(_mm_div_pd(hi, divisor)));
+   }
+
+   /* double sums like Averager32, float sums like Deviater32 */
+   struct sums_t { __m128d sum[2]; __m128 fsum, fsum2; };
+
+   static MT_FORCEINLINE void clear(sums_t &sums) {
+      sums.sum[0] = sums.sum[1] = _mm_setzero_pd();
+      sums.fsum = sums.fsum2 = _mm_setzero_ps();
+   }
+   static MT_FORCEINLINE void add(sums_t &sums, __m128 value) {
+      sums.sum[0] = _mm_add_pd(sums.sum[0], _mm_cvtps_pd(value));
+      sums.sum[1] = _mm_add_pd(sums.sum[1], _mm_cvtps_pd(_mm_movehl_ps(value, value)));
+   }
+   static MT_FORCEINLINE void add_squares(sums_t &sums, __m128 value) {
+      sums.fsum = _mm_add_ps(sums.fsum, value);
+      sums.fsum2 = _mm_add_ps(sums.fsum2, _mm_mul_ps(value, value));
+   }
+   static MT_FORCEINLINE __m128 finalize_average(const sums_t &sums, int nCount) {
+      const auto divisor = _mm_set1_pd(Double(nCount));
+      return _mm_movelh_ps(_mm_cvtpd_ps(_mm_div_pd(sums.sum[0], divisor)), _mm_cvtpd_ps(_mm_div_pd(sums.sum[1], divisor)));
+   }
+   static MT_FORCEINLINE __m128 finalize_deviation(const sums_t &sums, int nCount) {
+      const auto count = _mm_set1_pd(Double(nCount));
+      auto lo = deviation_pd(_mm_cvtps_pd(sums.fsum), _mm_cvtps_pd(sums.fsum2), count);
+      auto hi = deviation_pd(_mm_cvtps_pd(_mm_movehl_ps(sums.fsum, sums.fsum)), _mm_cvtps_pd(_mm_movehl_ps(sums.fsum2, sums.fsum2)), count);
+      return _mm_movelh_ps(_mm_cvtpd_ps(lo), _mm_cvtpd_ps(hi));
+   }
+};
+
+} } } } // namespace Lut, Filters, MaskTools, Filtering
+
+#endif
@@ -0,0 +1,111 @@
+#ifndef __Mt_Lut_SlidingMedian_H__
+#define __Mt_Lut_SlidingMedian_H__
+
+#include "../../../common/utils/utils.h"
+#include "../morphologic/structuring_element.h"
+#include "functions.h"
+#include <vector>
+
+namespace Filtering { namespace MaskTools { namespace Filters { namespace Lut {
+
+/* Median over a rectangle of pixels, borders repeated like in the spatial luts, by Huang's sliding
+   histogram: the next pixel of a row removes the column leaving the rectangle and adds the one
+   entering it, instead of building its histogram again. A coarse histogram of 16 values per bin
+   shortens the search. Same result as Medianizer, for each point of the rectangle given once. */
+class SlidingMedian {
+
+   int fine[256];
+   int coarse[16];
+   int nSize;
+   std::vector<ptrdiff_t> rows; // offsets of the rows of the rectangle, clamped to the plane
+
+   void add_column(const Byte *pSrc, const Byte *pTable, int x, int nDelta)
+   {
+      for ( auto offset : rows )
+      {
+         const int nValue = pTable[pSrc[offset + x]];
+         fine[nValue] += nDelta;
+         coarse[nValue >> 4] += nDelta;
+      }
+   }
+
+   Byte median() const
+   {
+      const int nLowHalf = (nSize + 1) >> 1;
+      int nCount = 0;
+      int nBin = 0;
+      while ( nCount + coarse[nBin] < nLowHalf )
+         nCount += coarse[nBin++];
+
+      int nIdx = nBin << 4;
+      while ( nCount + fine[nIdx] < nLowHalf )
+         nCount += fine[nIdx++];
+      nCount += fine[nIdx];
+
+      if ( (nSize & 1) || nCount >= nLowHalf + 1 )
+         return static_cast<Byte>(nIdx);
+
+      /* nSize even, the middle class owns only the lowest element: average with the next one */
+      int nSndIdx = nIdx + 1;
+      while ( !fine[nSndIdx] )
+         nSndIdx += (nSndIdx & 15) || coarse[nSndIdx >> 4] ? 1 : 16;
+      return static_cast<Byte>((nIdx + nSndIdx + 1) >> 1);
+   }
+
+public:
+
+   SlidingMedian(const String &mode) { UNUSED(mode); }
+
+   static bool is_rectangle(const int *pCoordinates, int nCoordinates)
+   {
+      Morphologic::CoordinatesMap map;
+      if ( !map.fill(pCoordinates, nCoordinates) || Int64(map.width()) * map.height() != nCoordinates / 2 )
+         return false;
+      for ( int y = map.y0; y <= map.y1; y++ )
+         for ( int x = map.x0; x <= map.x1; x++ )
+            if ( !map.contains(x, y) )
+               return false;
+      return true;
+   }
+
+   /* medians of row y of the plane pSrc, over the values pTable[pixel] */
+   void process_row(Byte *pDst, const Byte *pSrc, ptrdiff_t nSrcPitch, const Byte *pTable, const int *pCoordinates, int nCoordinates, int y, int nWidth, int nHeight)
+   {
+      int x0 = pCoordinates[0], x1 = pCoordinates[0], y0 = pCoordinates[1], y1 = pCoordinates[1];
+      for ( int k = 2; k < nCoordinates; k += 2 )
+      {
+         x0 = min(x0, pCoordinates[k]);
+         x1 = max(x1, pCoordinates[k]);
+         y0 = min(y0, pCoordinates[k+1]);
+         y1 = max(y1, pCoordinates[k+1]);
+      }
+
+      rows.clear();
+      for ( int k = y + y0; k <= y + y1; k++ )
+         rows.push_back(clip<int, int>(k, 0, nHeight - 1) * nSrcPitch);
+
+      memset(fine, 0, sizeof(fine));
+      memset(coarse, 0, sizeof(coarse));
+      nSize = nCoordinates / 2;
+      for ( int x = x0; x <= x1; x++ )
+         add_column(pSrc, pTable, clip<int, int>(x, 0, nWidth - 1), 1);
+
+      for ( int x = 0; x < nWidth; x++ )
+      {
+         pDst[x] = median();
+         if ( x + 1 < nWidth )
+         {
+            add_column(pSrc, pTable, clip<int, int>(x + 1 + x1, 0, nWidth - 1), 1);
+            add_column(pSrc, pTable, clip<int, int>(x + x0, 0, nWidth - 1), -1);
+         }
+      }
+   }
+};
+
+/* aggregator of a spatial lut on a rectangle: the sliding median replaces the median one */
+template<class T> struct RectangleAggregator { typedef T type; };
+template<> struct RectangleAggregator<MedianizerBetter<4>> { typedef SlidingMedian type; };
+
+} } } } // namespace Lut, Filters, MaskTools, Filtering
+
+#endif
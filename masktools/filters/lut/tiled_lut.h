@@ -0,0 +1,173 @@
+#ifndef __Mt_Lut_Tiled_H__
+#define __Mt_Lut_Tiled_H__
+
+#include "lut_data.h"
+#include "../../../common/parser/context_pool.h"
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+
+namespace Filtering {
+
+// memory kept by one tiled table before its least recently used tiles are dropped
+static const size_t tiled_lut_budget = size_t(256) << 20;
+
+// (x << bits_per_pixel) + y table where the whole table doesn't fit (16 bit: 8 GB of Word).
+// Tiles of 2^tile_bits_x x 2^tile_bits_y entries are computed the first time a pixel needs them:
+// natural video only reaches a small part of the (x, y) pairs, mostly around the diagonal.
+// Past budget bytes of tiles, the next plane drops the tiles unused for the longest time
+// (clock approximation of lru).
+template <typename pixel_t>
+class TiledLut
+{
+   enum { TILE_EMPTY, TILE_FILLING, TILE_READY };
+
+   struct Tile {
+      std::atomic<pixel_t *> data;
+      std::atomic<int> state;
+      std::atomic<bool> referenced; // since the last clock pass
+   };
+
+   int bits_per_pixel;
+   int tile_bits_x;
+   int tile_bits_y;
+   size_t tile_size; // in entries
+   size_t budget;    // in bytes
+
+   std::unique_ptr<Tile[]> tiles;
+   Parser::ContextPool contexts;
+
+   // tiles are only freed while no plane is processed: planes hold it shared, eviction exclusive
+   std::shared_timed_mutex planes;
+   std::mutex resident_mutex;
+   std::vector<size_t> resident; // tiles holding data
+   size_t hand;                  // clock position in resident
+   std::atomic<size_t> resident_bytes;
+
+   const pixel_t *fill(Tile &tile, int x, int y)
+   {
+      int expected = TILE_EMPTY;
+      if (tile.state.compare_exchange_strong(expected, TILE_FILLING)) {
+         pixel_t *data = new pixel_t[tile_size];
+         {
+            auto ctx = contexts.acquire();
+            fill_lut_rect(data, *ctx, bits_per_pixel,
+               x & ~((1 << tile_bits_x) - 1), 1 << tile_bits_x, y & ~((1 << tile_bits_y) - 1), 1 << tile_bits_y);
+         }
+         {
+            std::lock_guard<std::mutex> lock(resident_mutex);
+            resident.push_back(&tile - tiles.get());
+         }
+         resident_bytes += tile_size * sizeof(pixel_t);
+         tile.data.store(data, std::memory_order_release);
+         tile.state.store(TILE_READY, std::memory_order_release);
+         return data;
+      }
+
+      // being computed by another thread
+      const pixel_t *data;
+      while ((data = tile.data.load(std::memory_order_acquire)) == nullptr) {
+         std::this_thread::yield();
+      }
+      return data;
+   }
+
+   // with planes held exclusively, down to 3/4 of the budget
+   void evict()
+   {
+      const size_t target = budget / 4 * 3;
+      size_t bytes = resident_bytes.load();
+      while (bytes > target && !resident.empty()) {
+         if (hand >= resident.size()) {
+            hand = 0;
+         }
+         Tile &tile = tiles[resident[hand]];
+         if (tile.referenced.load(std::memory_order_relaxed)) {
+            tile.referenced.store(false, std::memory_order_relaxed);
+            ++hand;
+            continue;
+         }
+         delete[] tile.data.load(std::memory_order_relaxed);
+         tile.data.store(nullptr, std::memory_order_relaxed);
+         tile.state.store(TILE_EMPTY, std::memory_order_relaxed);
+         resident[hand] = resident.back();
+         resident.pop_back();
+         bytes -= tile_size * sizeof(pixel_t);
+      }
+      resident_bytes = bytes;
+   }
+
+   MT_FORCEINLINE Tile &tile_of(int x, int y)
+   {
+      return tiles[((size_t)(x >> tile_bits_x) << (bits_per_pixel - tile_bits_y)) + (y >> tile_bits_y)];
+   }
+
+public:
+   TiledLut(const std::deque<Parser::Symbol> &expression, int bits_per_pixel, int tile_bits_x, int tile_bits_y, size_t budget)
+      : bits_per_pixel(bits_per_pixel)
+      , tile_bits_x(tile_bits_x)
+      , tile_bits_y(tile_bits_y)
+      , tile_size(size_t(1) << (tile_bits_x + tile_bits_y))
+      , budget(budget)
+      , contexts(expression, false, false)
+      , hand(0)
+      , resident_bytes(0)
+   {
+      const size_t num_tiles = size_t(1) << (2 * bits_per_pixel - tile_bits_x - tile_bits_y);
+      tiles.reset(new Tile[num_tiles]);
+      for (size_t i = 0; i < num_tiles; ++i) {
+         tiles[i].data.store(nullptr, std::memory_order_relaxed);
+         tiles[i].state.store(TILE_EMPTY, std::memory_order_relaxed);
+         tiles[i].referenced.store(false, std::memory_order_relaxed);
+      }
+   }
+
+   ~TiledLut()
+   {
+      for (size_t i : resident) {
+         delete[] tiles[i].data.load(std::memory_order_relaxed);
+      }
+   }
+
+   // to hold while a plane uses the table
+   std::shared_lock<std::shared_timed_mutex> read()
+   {
+      if (resident_bytes.load(std::memory_order_relaxed) > budget) {
+         std::unique_lock<std::shared_timed_mutex> lock(planes);
+         evict();
+      }
+      return std::shared_lock<std::shared_timed_mutex>(planes);
+   }
+
+   // x and y within the pixel range
+   MT_FORCEINLINE pixel_t operator()(int x, int y)
+   {
+      Tile &tile = tile_of(x, y);
+      const pixel_t *data = tile.data.load(std::memory_order_acquire);
+      if (data == nullptr) {
+         data = fill(tile, x, y);
+      }
+      if (!tile.referenced.load(std::memory_order_relaxed)) {
+         tile.referenced.store(true, std::memory_order_relaxed);
+      }
+      return data[((size_t)(x & ((1 << tile_bits_x) - 1)) << tile_bits_y) + (y & ((1 << tile_bits_y) - 1))];
+   }
+
+   // entries of every y for x, for tiles spanning whole rows (tile_bits_y == bits_per_pixel)
+   const pixel_t *row(int x)
+   {
+      assert(tile_bits_y == bits_per_pixel);
+      Tile &tile = tile_of(x, 0);
+      const pixel_t *data = tile.data.load(std::memory_order_acquire);
+      if (data == nullptr) {
+         data = fill(tile, x, 0);
+      }
+      tile.referenced.store(true, std::memory_order_relaxed);
+      return data + ((size_t)(x & ((1 << tile_bits_x) - 1)) << tile_bits_y);
+   }
+};
+
+} // namespace Filtering
+
+#endif
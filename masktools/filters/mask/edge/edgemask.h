@@ -12,39 +12,47 @@ typedef void(Processor32)(Float *pDst, ptrdiff_t nDstPitch, const Float *pSrc, p
 extern Processor *convolution_c;
 extern Processor *convolution_sse2;
 extern Processor *convolution_avx2;
+extern Processor *convolution_avx512;
 
 extern Processor *sobel_c;
 extern Processor *sobel_sse2;
 extern Processor *sobel_ssse3;
 extern Processor *sobel_avx2;
+extern Processor *sobel_avx512;
 
 extern Processor *roberts_c;
 extern Processor *roberts_sse2;
 extern Processor *roberts_ssse3;
 extern Processor *roberts_avx2;
+extern Processor *roberts_avx512;
 
 extern Processor *laplace_c;
 extern Processor *laplace_sse2;
 extern Processor *laplace_ssse3;
 extern Processor *laplace_avx2;
+extern Processor *laplace_avx512;
 
 extern Processor *cartoon_c;
 extern Processor *cartoon_sse2;
 extern Processor *cartoon_avx2;
+extern Processor *cartoon_avx512;
 
 extern Processor *half_prewitt_c;
 extern Processor *half_prewitt_sse2;
 extern Processor *half_prewitt_ssse3;
 extern Processor *half_prewitt_avx2;
+extern Processor *half_prewitt_avx512;
 
 extern Processor *prewitt_c;
 extern Processor *prewitt_sse2;
 extern Processor *prewitt_ssse3;
 extern Processor *prewitt_avx2;
+extern Processor *prewitt_avx512;
 
 extern Processor *morpho_c;
 extern Processor *morpho_sse2;
 extern Processor *morpho_avx2;
+extern Processor *morpho_avx512;
 
 // uint16_t
 #define DEFINE_EXTERNS(name) \
@@ -145,6 +153,7 @@ public:
    EdgeMask(const Parameters &parameters, CpuFlags cpuFlags, PNeoEnv env)
       : MaskTools::Filter( parameters, FilterProcessingType::CHILD, (CpuFlags)cpuFlags)
    {
+      nStripeHalo = 1; // 3x3
       UNUSED(env);
      int bits_per_pixel = bit_depths[C];
      bool isFloat = bits_per_pixel == 32;
@@ -226,6 +235,7 @@ public:
            processors.push_back(Filtering::Processor<Processor>(sobel_sse2, Constraint(CPU_SSE2, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 16), 1));
            processors.push_back(Filtering::Processor<Processor>(sobel_ssse3, Constraint(CPU_SSSE3, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 16), 2));
            processors.push_back(Filtering::Processor<Processor>(sobel_avx2, Constraint(CPU_AVX2, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 32), 3));
+           processors.push_back(Filtering::Processor<Processor>(sobel_avx512, Constraint(CPU_AVX512F | CPU_AVX512BW, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 65), 4));
            break;
          case 10: 
            processors16.push_back(Filtering::Processor<Processor16>(sobel_10_c, Constraint(CPU_NONE, 1, 1, 1, 1), 0));
@@ -267,6 +277,7 @@ public:
            processors.push_back(Filtering::Processor<Processor>(roberts_sse2, Constraint(CPU_SSE2, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 16), 1));
            processors.push_back(Filtering::Processor<Processor>(roberts_ssse3, Constraint(CPU_SSSE3, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 16), 2));
            processors.push_back(Filtering::Processor<Processor>(roberts_avx2, Constraint(CPU_AVX2, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 32), 3));
+           processors.push_back(Filtering::Processor<Processor>(roberts_avx512, Constraint(CPU_AVX512F | CPU_AVX512BW, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 65), 4));
            break;
          case 10:
            processors16.push_back(Filtering::Processor<Processor16>(roberts_10_c, Constraint(CPU_NONE, 1, 1, 1, 1), 0));
@@ -308,6 +319,7 @@ public:
           processors.push_back(Filtering::Processor<Processor>(laplace_sse2, Constraint(CPU_SSE2, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 16), 1));
           processors.push_back(Filtering::Processor<Processor>(laplace_ssse3, Constraint(CPU_SSSE3, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 16), 2));
           processors.push_back(Filtering::Processor<Processor>(laplace_avx2, Constraint(CPU_AVX2, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 32), 3));
+          processors.push_back(Filtering::Processor<Processor>(laplace_avx512, Constraint(CPU_AVX512F | CPU_AVX512BW, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 65), 4));
           break;
         case 10: 
           processors16.push_back(Filtering::Processor<Processor16>(laplace_10_c, Constraint(CPU_NONE, 1, 1, 1, 1), 0));
@@ -348,6 +360,7 @@ public:
           processors.push_back(Filtering::Processor<Processor>(cartoon_c, Constraint(CPU_NONE, 1, 1, 1, 1), 0));
           processors.push_back(Filtering::Processor<Processor>(cartoon_sse2, Constraint(CPU_SSE2, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 16), 2));
           processors.push_back(Filtering::Processor<Processor>(cartoon_avx2, Constraint(CPU_AVX2, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 32), 3));
+          processors.push_back(Filtering::Processor<Processor>(cartoon_avx512, Constraint(CPU_AVX512F | CPU_AVX512BW, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 65), 4));
           break;
         case 10: 
           processors16.push_back(Filtering::Processor<Processor16>(cartoon_10_c, Constraint(CPU_NONE, 1, 1, 1, 1), 0));
@@ -388,6 +401,7 @@ public:
           processors.push_back(Filtering::Processor<Processor>(morpho_c, Constraint(CPU_NONE, 1, 1, 1, 1), 0));
           processors.push_back(Filtering::Processor<Processor>(morpho_sse2, Constraint(CPU_SSE2, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 16), 1));
           processors.push_back(Filtering::Processor<Processor>(morpho_avx2, Constraint(CPU_AVX2, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 32), 3));
+          processors.push_back(Filtering::Processor<Processor>(morpho_avx512, Constraint(CPU_AVX512F | CPU_AVX512BW, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 65), 4));
           break;
         case 10: 
           processors16.push_back(Filtering::Processor<Processor16>(morpho_10_c, Constraint(CPU_NONE, 1, 1, 1, 1), 0));
@@ -429,6 +443,7 @@ public:
           processors.push_back(Filtering::Processor<Processor>(prewitt_sse2, Constraint(CPU_SSE2, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 16), 1));
           processors.push_back(Filtering::Processor<Processor>(prewitt_ssse3, Constraint(CPU_SSSE3, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 16), 2));
           processors.push_back(Filtering::Processor<Processor>(prewitt_avx2, Constraint(CPU_AVX2, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 32), 3));
+          processors.push_back(Filtering::Processor<Processor>(prewitt_avx512, Constraint(CPU_AVX512F | CPU_AVX512BW, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 65), 4));
           break;
         case 10: 
           processors16.push_back(Filtering::Processor<Processor16>(prewitt_10_c, Constraint(CPU_NONE, 1, 1, 1, 1), 0));
@@ -470,6 +485,7 @@ public:
           processors.push_back(Filtering::Processor<Processor>(half_prewitt_sse2, Constraint(CPU_SSE2, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 16), 1));
           processors.push_back(Filtering::Processor<Processor>(half_prewitt_ssse3, Constraint(CPU_SSSE3, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 16), 2));
           processors.push_back(Filtering::Processor<Processor>(half_prewitt_avx2, Constraint(CPU_AVX2, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 32), 3));
+          processors.push_back(Filtering::Processor<Processor>(half_prewitt_avx512, Constraint(CPU_AVX512F | CPU_AVX512BW, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 65), 4));
           break;
         case 10: 
           processors16.push_back(Filtering::Processor<Processor16>(half_prewitt_10_c, Constraint(CPU_NONE, 1, 1, 1, 1), 0));
@@ -622,6 +638,7 @@ public:
            {
              processors.push_back(Filtering::Processor<Processor>(convolution_sse2, Constraint(CPU_SSE2, 8, 1, 1, 1), 2)); // why is it mod 8????
              processors.push_back(Filtering::Processor<Processor>(convolution_avx2, Constraint(CPU_AVX2, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 32), 3));
+             processors.push_back(Filtering::Processor<Processor>(convolution_avx512, Constraint(CPU_AVX512F | CPU_AVX512BW, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 65), 4));
            }
            break;
          case 10: 
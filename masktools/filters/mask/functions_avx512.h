@@ -0,0 +1,64 @@
+#ifndef __Mt_MaskFunctions_AVX512_H__
+#define __Mt_MaskFunctions_AVX512_H__
+
+#include "../../../common/utils/utils.h"
+#include "../../common/simd.h"
+
+namespace Filtering { namespace MaskTools { namespace Filters { namespace Mask {
+
+typedef void (ProcessLineAvx512)(Byte *pDst, const Byte *pSrcp, const Byte *pSrc, const Byte *pSrcn, const Short matrix[10], const __m512i &lowThresh, const __m512i &highThresh, int width);
+
+template<ProcessLineAvx512 process_line_left, ProcessLineAvx512 process_line, ProcessLineAvx512 process_line_right>
+static void generic_avx512(Byte *pDst, ptrdiff_t nDstPitch, const Byte *pSrc, ptrdiff_t nSrcPitch, const Short matrix[10], int nLowThreshold, int nHighThreshold, int nWidth, int nHeight) {
+    const Byte *pSrcp = pSrc - nSrcPitch;
+    const Byte *pSrcn = pSrc + nSrcPitch;
+
+    auto v128 = _mm512_set1_epi8(Byte(128));
+    auto low_thr_v = _mm512_set1_epi8(Byte(nLowThreshold));
+    low_thr_v = _mm512_sub_epi8(low_thr_v, v128);
+    auto high_thr_v = _mm512_set1_epi8(Byte(nHighThreshold));
+    high_thr_v = _mm512_sub_epi8(high_thr_v, v128);
+
+    // the right block would overwrite the left border pixel of a 64 wide row, hence the 65 minimum width
+    int avx512_width = (nWidth - 1 - 64) / 64 * 64 + 64;
+    /* top-left */
+    process_line_left(pDst, pSrc, pSrc, pSrcn, matrix, low_thr_v, high_thr_v, 64);
+    /* top */
+    process_line(pDst + 64, pSrc+64, pSrc+64, pSrcn+64, matrix, low_thr_v, high_thr_v, avx512_width - 64);
+
+    /* top-right */
+    process_line_right(pDst + nWidth - 64, pSrc + nWidth - 64, pSrc + nWidth - 64, pSrcn + nWidth - 64, matrix, low_thr_v, high_thr_v, 64);
+
+    pDst  += nDstPitch;
+    pSrcp += nSrcPitch;
+    pSrc  += nSrcPitch;
+    pSrcn += nSrcPitch;
+
+    for ( int y = 1; y < nHeight-1; y++ )
+    {
+        /* left */
+        process_line_left(pDst, pSrcp, pSrc, pSrcn, matrix, low_thr_v, high_thr_v, 64);
+        /* center */
+        process_line(pDst + 64, pSrcp+64, pSrc+64, pSrcn+64, matrix, low_thr_v, high_thr_v, avx512_width - 64);
+        /* right */
+        process_line_right(pDst + nWidth - 64, pSrcp + nWidth - 64, pSrc + nWidth - 64, pSrcn + nWidth - 64, matrix, low_thr_v, high_thr_v, 64);
+
+        pDst  += nDstPitch;
+        pSrcp += nSrcPitch;
+        pSrc  += nSrcPitch;
+        pSrcn += nSrcPitch;
+    }
+
+    /* bottom-left */
+    process_line_left(pDst, pSrcp, pSrc, pSrc, matrix, low_thr_v, high_thr_v, 64);
+    /* bottom */
+    process_line(pDst + 64, pSrcp+64, pSrc+64, pSrc+64, matrix, low_thr_v, high_thr_v, avx512_width - 64);
+    /* bottom-right */
+    process_line_right(pDst + nWidth - 64, pSrcp + nWidth - 64, pSrc + nWidth - 64, pSrc + nWidth - 64, matrix, low_thr_v, high_thr_v, 64);
+
+    _mm256_zeroupper();
+}
+
+} } } }
+
+#endif
@@ -41,6 +41,10 @@ extern Processor *merge_luma_420_avx2;
 extern Processor *merge_luma_422_avx2;
 extern Processor *merge_luma_411_avx2;
 
+extern Processor *merge_avx512;
+extern Processor *merge_luma_420_avx512;
+extern Processor *merge_luma_422_avx512;
+
 /* 16 bit */
 
 extern Processor16 *merge16_c_stacked;
@@ -191,6 +195,7 @@ public:
    Merge(const Parameters &parameters, CpuFlags cpuFlags, PNeoEnv env)
       : MaskTools::Filter( parameters, FilterProcessingType::INPLACE, (CpuFlags)cpuFlags)
    {
+      nStripeHalo = 0;
       UNUSED(env);
       bool isStacked = parameters["stacked"].toBool();
       int bits_per_pixel = bit_depths[C];
@@ -268,6 +273,7 @@ public:
           processors.push_back(Filtering::Processor<Processor>(merge_sse4, Constraint(CPU_SSE4_1, 1, 1, 1, 1), 3));
           processors.push_back(Filtering::Processor<Processor>(merge_asse4, Constraint(CPU_SSE4_1, 1, 1, 16, 16), 4));
           processors.push_back(Filtering::Processor<Processor>(merge_avx2, Constraint(CPU_AVX2, 1, 1, 1, 1), 5));
+          processors.push_back(Filtering::Processor<Processor>(merge_avx512, Constraint(CPU_AVX512F | CPU_AVX512BW, 1, 1, 1, 1), 6));
 
           /* add the chroma processors */
           // they are used only for 420 and 422
@@ -278,6 +284,7 @@ public:
             chroma_processors.push_back(Filtering::Processor<Processor>(merge_luma_420_sse4, Constraint(CPU_SSE4_1, 1, 1, 1, 1), 3));
             chroma_processors.push_back(Filtering::Processor<Processor>(merge_luma_420_asse4, Constraint(CPU_SSE4_1, 1, 1, 16, 16), 4));
             chroma_processors.push_back(Filtering::Processor<Processor>(merge_luma_420_avx2, Constraint(CPU_AVX2, 1, 1, 1, 1), 5));
+            chroma_processors.push_back(Filtering::Processor<Processor>(merge_luma_420_avx512, Constraint(CPU_AVX512F | CPU_AVX512BW, 1, 1, 1, 1), 6));
           }
           else if (is422) { // 422
             chroma_processors.push_back(Filtering::Processor<Processor>(merge_luma_422_c, Constraint(CPU_NONE, 1, 1, 1, 1), 0));
@@ -286,6 +293,7 @@ public:
             chroma_processors.push_back(Filtering::Processor<Processor>(merge_luma_422_sse4, Constraint(CPU_SSE4_1, 1, 1, 1, 1), 3));
             chroma_processors.push_back(Filtering::Processor<Processor>(merge_luma_422_asse4, Constraint(CPU_SSE4_1, 1, 1, 16, 16), 4));
             chroma_processors.push_back(Filtering::Processor<Processor>(merge_luma_422_avx2, Constraint(CPU_AVX2, 1, 1, 1, 1), 5));
+            chroma_processors.push_back(Filtering::Processor<Processor>(merge_luma_422_avx512, Constraint(CPU_AVX512F | CPU_AVX512BW, 1, 1, 1, 1), 6));
           }
           else {
             chroma_processors.push_back(Filtering::Processor<Processor>(merge_luma_411_c, Constraint(CPU_NONE, 1, 1, 1, 1), 0));
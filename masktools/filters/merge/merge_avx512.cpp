@@ -0,0 +1,218 @@
+#include "merge.h"
+#include "../../common/simd.h"
+
+namespace Filtering { namespace MaskTools { namespace Filters { namespace Merge {
+
+   static void merge_avx512_c(Byte *pDst, ptrdiff_t nDstPitch, const Byte *pSrc1, ptrdiff_t nSrc1Pitch,
+      const Byte *pMask, ptrdiff_t nSrc2Pitch, int nWidth, int nHeight)
+   {
+      for (int y = 0; y < nHeight; ++y)
+      {
+         for (int x = 0; x < nWidth; ++x) {
+           const int nMask = pMask[x];
+           if (nMask == 255)
+             pDst[x] = pSrc1[x]; // max mask value (255): keep source
+           else if (nMask != 0)
+             pDst[x] = static_cast<Byte>(((256 - int(nMask)) * pDst[x] + int(nMask) * pSrc1[x] + 128) >> 8);
+           // nMask == 0: keep pDst as is
+         }
+         pDst += nDstPitch;
+         pSrc1 += nSrc1Pitch;
+         pMask += nSrc2Pitch;
+      }
+   }
+
+   static void merge_luma_420_avx512_c(Byte *pDst, ptrdiff_t nDstPitch, const Byte *pSrc1, ptrdiff_t nSrc1Pitch,
+      const Byte *pMask, ptrdiff_t nSrc2Pitch, int nWidth, int nHeight)
+   {
+      for (int y = 0; y < nHeight; ++y)
+      {
+         for (int x = 0; x < nWidth; ++x)
+         {
+           // 420: both width and height is halved, averaging from 4 pixels of full size mask
+            const int nMask = (((pMask[x * 2] + pMask[x * 2 + nSrc2Pitch] + 1) >> 1) + ((pMask[x * 2 + 1] + pMask[x * 2 + nSrc2Pitch + 1] + 1) >> 1) + 1) >> 1;
+            if (nMask == 255)
+              pDst[x] = pSrc1[x];
+            else if (nMask != 0)
+              pDst[x] = static_cast<Byte>(((256 - int(nMask)) * pDst[x] + int(nMask) * pSrc1[x] + 128) >> 8);
+            // nMask == 0: keep pDst as is
+         }
+         pDst += nDstPitch;
+         pSrc1 += nSrc1Pitch;
+         pMask += nSrc2Pitch * 2;
+      }
+   }
+
+   static void merge_luma_422_avx512_c(Byte *pDst, ptrdiff_t nDstPitch, const Byte *pSrc1, ptrdiff_t nSrc1Pitch,
+     const Byte *pMask, ptrdiff_t nSrc2Pitch, int nWidth, int nHeight)
+   {
+     for (int y = 0; y < nHeight; ++y)
+     {
+       for (int x = 0; x < nWidth; ++x)
+       {
+         const int nMask = (pMask[x * 2] + pMask[x * 2 + 1] + 1) >> 1; // 422: only width is halved, averaging from two pixels of full size mask
+         if (nMask == 255)
+           pDst[x] = pSrc1[x];
+         else if (nMask != 0)
+           pDst[x] = static_cast<Byte>(((256 - int(nMask)) * pDst[x] + int(nMask) * pSrc1[x] + 128) >> 8);
+         // nMask == 0: keep pDst as is
+       }
+       pDst += nDstPitch;
+       pSrc1 += nSrc1Pitch;
+       pMask += nSrc2Pitch;
+     }
+   }
+
+   template <MemoryMode mem_mode>
+   MT_FORCEINLINE __m512i merge_avx512_core(Byte *pDst, const Byte *pSrc, const __m512i& mask_lo, const __m512i& mask_hi,
+      const __m512i& v128, const __m512i& zero) {
+      auto dst = simd512_load_si512<mem_mode>(pDst);
+      auto dst_lo = _mm512_unpacklo_epi8(dst, zero);
+      auto dst_hi = _mm512_unpackhi_epi8(dst, zero);
+
+      auto src = simd512_load_si512<mem_mode>(pSrc);
+      auto src1_lo = _mm512_unpacklo_epi8(src, zero);
+      auto src1_hi = _mm512_unpackhi_epi8(src, zero);
+
+      auto dst_lo_sh = _mm512_slli_epi16(dst_lo, 8);
+      auto diff_lo = _mm512_sub_epi16(src1_lo, dst_lo);
+      auto tmp1_lo = _mm512_mullo_epi16(diff_lo, mask_lo); // (p2-p1)*mask
+      auto tmp2_lo = _mm512_or_si512(dst_lo_sh, v128);    // p1<<8 + 128 == p1<<8 | 128
+      auto result_lo = _mm512_add_epi16(tmp1_lo, tmp2_lo);
+      result_lo = _mm512_srli_epi16(result_lo, 8);
+
+      auto dst_hi_sh = _mm512_slli_epi16(dst_hi, 8);
+      auto diff_hi = _mm512_sub_epi16(src1_hi, dst_hi);
+      auto tmp1_hi = _mm512_mullo_epi16(diff_hi, mask_hi); // (p2-p1)*mask
+      auto tmp2_hi = _mm512_or_si512(dst_hi_sh, v128);    // p1<<8 + 128 == p1<<8 | 128
+      auto result_hi = _mm512_add_epi16(tmp1_hi, tmp2_hi);
+      result_hi = _mm512_srli_epi16(result_hi, 8);
+
+      auto result = _mm512_packus_epi16(result_lo, result_hi);
+      // when mask is FF, keep src
+      // when mask is 00, keep dst
+      auto mask = _mm512_packus_epi16(mask_lo, mask_hi);
+      result = _mm512_mask_mov_epi8(result, _mm512_cmpeq_epi8_mask(mask, _mm512_set1_epi8(-1)), src);
+      result = _mm512_mask_mov_epi8(result, _mm512_cmpeq_epi8_mask(mask, zero), dst);
+
+      return result;
+   }
+
+   // averaged subsampled masks are words of pixels 0..31 and 32..63; the unpacks in _core
+   // take bytes 0-7 (lo) and 8-15 (hi) of every 128 bit lane
+   static MT_FORCEINLINE void subsampled_mask_avx512(const __m512i &avg_t1, const __m512i &avg_t2, __m512i &mask_lo, __m512i &mask_hi) {
+      auto v255 = _mm512_set1_epi16(0x00FF);
+      mask_lo = _mm512_and_si512(_mm512_permutex2var_epi64(avg_t1, _mm512_set_epi64(13, 12, 9, 8, 5, 4, 1, 0), avg_t2), v255);
+      mask_hi = _mm512_and_si512(_mm512_permutex2var_epi64(avg_t1, _mm512_set_epi64(15, 14, 11, 10, 7, 6, 3, 2), avg_t2), v255);
+   }
+
+   template <MemoryMode mem_mode>
+   void merge_avx512_t(Byte *pDst, ptrdiff_t nDstPitch, const Byte *pSrc1, ptrdiff_t nSrc1Pitch,
+      const Byte *pMask, ptrdiff_t nSrc2Pitch, int nWidth, int nHeight)
+   {
+      int wMod64 = (nWidth / 64) * 64;
+      auto pDst_s = pDst;
+      auto pSrc1_s = pSrc1;
+      auto pMask_s = pMask;
+      auto v128 = _mm512_set1_epi16(0x0080);
+      auto zero = _mm512_setzero_si512();
+      for (int j = 0; j < nHeight; ++j) {
+         for (int i = 0; i < wMod64; i += 64) {
+            auto src2 = simd512_load_si512<mem_mode>(pMask + i);
+            auto mask_t1 = _mm512_unpacklo_epi8(src2, zero);
+            auto mask_t2 = _mm512_unpackhi_epi8(src2, zero);
+
+            auto result = merge_avx512_core<mem_mode>(pDst + i, pSrc1 + i, mask_t1, mask_t2, v128, zero);
+
+            simd512_store_si512<mem_mode>(pDst + i, result);
+         }
+         pDst += nDstPitch;
+         pSrc1 += nSrc1Pitch;
+         pMask += nSrc2Pitch;
+      }
+
+      if (nWidth > wMod64) {
+         merge_avx512_c(pDst_s + wMod64, nDstPitch, pSrc1_s + wMod64, nSrc1Pitch, pMask_s + wMod64, nSrc2Pitch, nWidth - wMod64, nHeight);
+      }
+      _mm256_zeroupper();
+   }
+
+   template <MemoryMode mem_mode>
+   void merge_luma_420_avx512_t(Byte *pDst, ptrdiff_t nDstPitch, const Byte *pSrc1, ptrdiff_t nSrc1Pitch,
+     const Byte *pMask, ptrdiff_t nSrc2Pitch, int nWidth, int nHeight)
+   {
+     int wMod64 = (nWidth / 64) * 64;
+     auto pDst_s = pDst;
+     auto pSrc1_s = pSrc1;
+     auto pMask_s = pMask;
+     auto v128 = _mm512_set1_epi16(0x0080);
+     auto zero = _mm512_setzero_si512();
+     for (int j = 0; j < nHeight; ++j) {
+       for (int i = 0; i < wMod64; i += 64) {
+         // preparing mask
+         auto src2_row1_t1 = simd512_load_si512<mem_mode>(pMask + i * 2);
+         auto src2_row1_t2 = simd512_load_si512<mem_mode>(pMask + i * 2 + 64);
+         auto src2_row2_t1 = simd512_load_si512<mem_mode>(pMask + nSrc2Pitch + i * 2);
+         auto src2_row2_t2 = simd512_load_si512<mem_mode>(pMask + nSrc2Pitch + i * 2 + 64);
+         auto avg_t1 = _mm512_avg_epu8(src2_row1_t1, src2_row2_t1);
+         auto avg_t2 = _mm512_avg_epu8(src2_row1_t2, src2_row2_t2);
+         avg_t1 = _mm512_avg_epu8(avg_t1, _mm512_bsrli_epi128(avg_t1, 1)); // in-lane shift is OK here
+         avg_t2 = _mm512_avg_epu8(avg_t2, _mm512_bsrli_epi128(avg_t2, 1));
+         __m512i mask_t1, mask_t2;
+         subsampled_mask_avx512(avg_t1, avg_t2, mask_t1, mask_t2);
+
+         auto result = merge_avx512_core<mem_mode>(pDst + i, pSrc1 + i, mask_t1, mask_t2, v128, zero);
+
+         simd512_store_si512<mem_mode>(pDst + i, result);
+       }
+       pDst += nDstPitch;
+       pSrc1 += nSrc1Pitch;
+       pMask += nSrc2Pitch * 2;
+     }
+     if (nWidth > wMod64) {
+       // pMask offset: mask is not subsampled -> width*2
+       merge_luma_420_avx512_c(pDst_s + wMod64, nDstPitch, pSrc1_s + wMod64, nSrc1Pitch, pMask_s + wMod64 * 2, nSrc2Pitch, nWidth - wMod64, nHeight);
+     }
+     _mm256_zeroupper();
+   }
+
+   template <MemoryMode mem_mode>
+   void merge_luma_422_avx512_t(Byte *pDst, ptrdiff_t nDstPitch, const Byte *pSrc1, ptrdiff_t nSrc1Pitch,
+     const Byte *pMask, ptrdiff_t nSrc2Pitch, int nWidth, int nHeight)
+   {
+     int wMod64 = (nWidth / 64) * 64;
+     auto pDst_s = pDst;
+     auto pSrc1_s = pSrc1;
+     auto pMask_s = pMask;
+     auto v128 = _mm512_set1_epi16(0x0080);
+     auto zero = _mm512_setzero_si512();
+     for (int j = 0; j < nHeight; ++j) {
+       for (int i = 0; i < wMod64; i += 64) {
+         // preparing mask
+         auto src2_row1_t1 = simd512_load_si512<mem_mode>(pMask + i * 2);
+         auto src2_row1_t2 = simd512_load_si512<mem_mode>(pMask + i * 2 + 64);
+         auto avg_t1 = _mm512_avg_epu8(src2_row1_t1, _mm512_bsrli_epi128(src2_row1_t1, 1)); // in-lane shift is OK here
+         auto avg_t2 = _mm512_avg_epu8(src2_row1_t2, _mm512_bsrli_epi128(src2_row1_t2, 1));
+         __m512i mask_t1, mask_t2;
+         subsampled_mask_avx512(avg_t1, avg_t2, mask_t1, mask_t2);
+
+         auto result = merge_avx512_core<mem_mode>(pDst + i, pSrc1 + i, mask_t1, mask_t2, v128, zero);
+
+         simd512_store_si512<mem_mode>(pDst + i, result);
+       }
+       pDst += nDstPitch;
+       pSrc1 += nSrc1Pitch;
+       pMask += nSrc2Pitch;
+     }
+     if (nWidth > wMod64) {
+       // pMask offset: mask is not subsampled -> width*2
+       merge_luma_422_avx512_c(pDst_s + wMod64, nDstPitch, pSrc1_s + wMod64, nSrc1Pitch, pMask_s + wMod64 * 2, nSrc2Pitch, nWidth - wMod64, nHeight);
+     }
+     _mm256_zeroupper();
+   }
+
+   Processor *merge_avx512 = merge_avx512_t<MemoryMode::SSE2_UNALIGNED>;
+   Processor *merge_luma_420_avx512 = merge_luma_420_avx512_t<MemoryMode::SSE2_UNALIGNED>;
+   Processor *merge_luma_422_avx512 = merge_luma_422_avx512_t<MemoryMode::SSE2_UNALIGNED>;
+
+} } } }
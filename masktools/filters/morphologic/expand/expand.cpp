@@ -1,5 +1,7 @@
 #include "expand.h"
 #include "../functions.h"
+#include "../functions_rectangle.h"
+#include "../functions_custom.h"
 
 using namespace Filtering;
 
@@ -70,24 +72,6 @@ extern "C" static MT_FORCEINLINE __m128i expand_operator_sse2(__m128i a, __m128i
 
 namespace Filtering { namespace MaskTools { namespace Filters { namespace Morphologic { namespace Expand {
 
-class ExpandProcessor {
-    int max;
-    int max_deviation;
-    Byte value;
-public:
-    ExpandProcessor(Byte nValue, int nMaxDeviation) : max(-1), max_deviation(nMaxDeviation), value(nValue) { }
-
-    void add(Byte nValue) {
-        if (nValue > max) {
-            max = nValue;
-        }
-    }
-
-    Byte finalize() const {
-        return static_cast<Byte>(max < 0 ? value : (max - value > max_deviation ? value + max_deviation : max));
-    }
-};
-
 Processor *expand_square_c       = &generic_c<maximumThresholded<::maximum_square> >;
 Processor *expand_both_c         = &generic_c<maximumThresholded<::maximum_both> >;
 Processor *expand_horizontal_c   = &generic_c<maximumThresholded<::maximum_horizontal> >;
@@ -114,5 +98,8 @@ Processor *expand_square_sse2 = &xxpand_sse2_square<expand_operator_sse2, limit_
 Processor *expand_square_asse2 = &xxpand_sse2_square<expand_operator_sse2, limit_up_sse2, MemoryMode::SSE2_ALIGNED, expand_c_horizontal_core>;
 
 Processor *expand_custom_c = &generic_custom_c<ExpandProcessor>;
+Processor *expand_custom_sse2 = &custom_simd<ExpandProcessor, CustomSse2<true>>;
+Processor *expand_rectangle_c = &rectangle_c<ExpandProcessor, true, false>;
+Processor *expand_rectangle_sse2 = &rectangle_c<ExpandProcessor, true, true>;
 
 } } } } }
\ No newline at end of file
@@ -6,6 +6,45 @@
 namespace Filtering { namespace MaskTools { namespace Filters { namespace Morphologic { namespace Expand {
 
 
+/* accumulators of the custom modes, over the pixel and its neighbours */
+class ExpandProcessor {
+    int max;
+    int max_deviation;
+    Byte value;
+public:
+    ExpandProcessor(Byte nValue, int nMaxDeviation) : max(-1), max_deviation(nMaxDeviation), value(nValue) { }
+
+    void add(Byte nValue) {
+        if (nValue > max) {
+            max = nValue;
+        }
+    }
+
+    Byte finalize() const {
+        return static_cast<Byte>(max < 0 ? value : (max - value > max_deviation ? value + max_deviation : max));
+    }
+};
+
+class NewValue16 {
+    int nMax;
+    int nMaxDeviation;
+    Word nValue;
+public:
+    NewValue16(Word nValue, int nMaxDeviation) : nMax(-1), nMaxDeviation(nMaxDeviation), nValue(nValue) { }
+    void add(Word _nValue) { if ( _nValue > nMax ) nMax = _nValue; }
+    Word finalize() const { return static_cast<Word>(nMax < 0 ? nValue : (nMax - nValue > nMaxDeviation ? nValue + nMaxDeviation : nMax)); }
+};
+
+class NewValue32 {
+    Float nMax;
+    Float nMaxDeviation;
+    Float nValue;
+public:
+    NewValue32(Float nValue, Float nMaxDeviation) : nMax(-1.0), nMaxDeviation(nMaxDeviation), nValue(nValue) { }
+    void add(Float _nValue) { if ( _nValue > nMax ) nMax = _nValue; }
+    Float finalize() const { return nMax < 0 ? nValue : (nMax - nValue > nMaxDeviation ? nValue + nMaxDeviation : nMax); }
+};
+
 extern Processor *expand_square_c;
 extern Processor *expand_square_sse2;
 extern Processor *expand_square_asse2;
@@ -23,6 +62,10 @@ extern Processor *expand_both_sse2;
 extern Processor *expand_both_asse2;
 
 extern Processor *expand_custom_c;
+extern Processor *expand_custom_sse2;
+extern Processor *expand_custom_avx2;
+extern Processor *expand_rectangle_c;
+extern Processor *expand_rectangle_sse2;
 
 /* 16 bit */
 extern StackedProcessor *expand_square_stacked_c;
@@ -30,12 +73,18 @@ extern StackedProcessor *expand_horizontal_stacked_c;
 extern StackedProcessor *expand_vertical_stacked_c;
 extern StackedProcessor *expand_both_stacked_c;
 extern StackedProcessor *expand_custom_stacked_c;
+extern StackedProcessor *expand_rectangle_stacked_c;
+extern StackedProcessor *expand_rectangle_stacked_sse4;
 
 extern Processor16 *expand_square_native_c;
 extern Processor16 *expand_horizontal_native_c;
 extern Processor16 *expand_vertical_native_c;
 extern Processor16 *expand_both_native_c;
 extern Processor16 *expand_custom_native_c;
+extern Processor16 *expand_custom_sse4_16;
+extern Processor16 *expand_custom_avx2_16;
+extern Processor16 *expand_rectangle_native_c;
+extern Processor16 *expand_rectangle_sse4_16;
 
 extern Processor16 *expand_square_sse4_16;
 extern Processor16 *expand_square_asse4_16;
@@ -52,6 +101,10 @@ extern Processor32 *expand32_horizontal_c;
 extern Processor32 *expand32_vertical_c;
 extern Processor32 *expand32_both_c;
 extern Processor32 *expand32_custom_c;
+extern Processor32 *expand32_custom_sse2;
+extern Processor32 *expand32_custom_avx2;
+extern Processor32 *expand32_rectangle_c;
+extern Processor32 *expand32_rectangle_sse2;
 
 
 class Expand : public Morphologic::MorphologicFilter
@@ -142,19 +195,54 @@ public:
     }
     else
     {
-      if (_bits_per_pixel == 8) {
+      FillCoordinates(parameters["mode"].toString());
+      if (has_passes())
+      {
+        // octagons (mt_losange, small mt_ellipse) as 3x3 passes, when there are no thresholds
+        add_pass_processors(PASS_SQUARE, expand_square_c, expand_square_sse2, expand_square_asse2, expand_square_native_c, expand_square_sse4_16, expand_square_asse4_16);
+        add_pass_processors(PASS_BOTH, expand_both_c, expand_both_sse2, expand_both_asse2, expand_both_native_c, expand_both_sse4_16, expand_both_asse4_16);
+        add_pass_processors(PASS_HORIZONTAL, expand_horizontal_c, expand_horizontal_sse2, expand_horizontal_asse2, expand_horizontal_native_c, expand_horizontal_sse4_16, expand_horizontal_asse4_16);
+        add_pass_processors(PASS_VERTICAL, expand_vertical_c, expand_vertical_sse2, expand_vertical_asse2, expand_vertical_native_c, expand_vertical_sse4_16, expand_vertical_asse4_16);
+      }
+      if (is_separable())
+      {
+        // separable van Herk/Gil-Werman passes, O(1) per pixel and rectangle whatever the size
+        if (_bits_per_pixel == 8) {
+          processors.push_back(Filtering::Processor<Processor>(expand_rectangle_c, Constraint(CPU_NONE, 1, 1, 1, 1), 0));
+          processors.push_back(Filtering::Processor<Processor>(expand_rectangle_sse2, Constraint(CPU_SSE2, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 1), 1));
+        }
+        else if (_isStacked) {
+          stackedProcessors.push_back(Filtering::Processor<StackedProcessor>(expand_rectangle_stacked_c, Constraint(CPU_NONE, 1, 1, 1, 1), 0));
+          stackedProcessors.push_back(Filtering::Processor<StackedProcessor>(expand_rectangle_stacked_sse4, Constraint(CPU_SSE4_1, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 1), 1));
+        }
+        else if (_bits_per_pixel <= 16) {
+          processors16.push_back(Filtering::Processor<Processor16>(expand_rectangle_native_c, Constraint(CPU_NONE, 1, 1, 1, 1), 0));
+          processors16.push_back(Filtering::Processor<Processor16>(expand_rectangle_sse4_16, Constraint(CPU_SSE4_1, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 1), 1));
+        }
+        else {
+          processors32.push_back(Filtering::Processor<Processor32>(expand32_rectangle_c, Constraint(CPU_NONE, 1, 1, 1, 1), 0));
+          processors32.push_back(Filtering::Processor<Processor32>(expand32_rectangle_sse2, Constraint(CPU_SSE2, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 1), 1));
+        }
+      }
+      else if (_bits_per_pixel == 8) {
+        // anything else: a vector of pixels per coordinate, scalar only at the borders
         processors.push_back(Filtering::Processor<Processor>(expand_custom_c, Constraint(CPU_NONE, 1, 1, 1, 1), 0));
+        processors.push_back(Filtering::Processor<Processor>(expand_custom_sse2, Constraint(CPU_SSE2, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 1), 1));
+        processors.push_back(Filtering::Processor<Processor>(expand_custom_avx2, Constraint(CPU_AVX2, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 1), 2));
       }
       else if (_isStacked) {
         stackedProcessors.push_back(Filtering::Processor<StackedProcessor>(expand_custom_stacked_c, Constraint(CPU_NONE, 1, 1, 1, 1), 0));
       }
       else if (_bits_per_pixel <= 16) {
         processors16.push_back(Filtering::Processor<Processor16>(expand_custom_native_c, Constraint(CPU_NONE, 1, 1, 1, 1), 0));
+        processors16.push_back(Filtering::Processor<Processor16>(expand_custom_sse4_16, Constraint(CPU_SSE4_1, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 1), 1));
+        processors16.push_back(Filtering::Processor<Processor16>(expand_custom_avx2_16, Constraint(CPU_AVX2, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 1), 2));
       }
       else {
         processors32.push_back(Filtering::Processor<Processor32>(expand32_custom_c, Constraint(CPU_NONE, 1, 1, 1, 1), 0));
+        processors32.push_back(Filtering::Processor<Processor32>(expand32_custom_sse2, Constraint(CPU_SSE2, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 1), 1));
+        processors32.push_back(Filtering::Processor<Processor32>(expand32_custom_avx2, Constraint(CPU_AVX2, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 1), 2));
       }
-      FillCoordinates(parameters["mode"].toString());
     }
   }
 
@@ -170,6 +258,7 @@ public:
     add_defaults(signature);
 
     signature.add(Parameter(false, "stacked", false));
+    signature.add(Parameter(1, "iterations", false));
     return signature;
   }
 };
@@ -1,5 +1,7 @@
 #include "expand.h"
 #include "../functions16.h"
+#include "../functions_rectangle.h"
+#include "../functions_custom.h"
 
 using namespace Filtering;
 
@@ -68,17 +70,6 @@ extern "C" static MT_FORCEINLINE __m128i expand_operator_sse4_16(__m128i a, __m1
 
 namespace Filtering { namespace MaskTools { namespace Filters { namespace Morphologic { namespace Expand {
 
-    class NewValue16 {
-        int nMax;
-        int nMaxDeviation;
-        Word nValue;
-    public:
-        NewValue16(Word nValue, int nMaxDeviation) : nMax(-1), nMaxDeviation(nMaxDeviation), nValue(nValue) { }
-        void add(Word _nValue) { if ( _nValue > nMax ) nMax = _nValue; }
-        Word finalize() const { return static_cast<Word>(nMax < 0 ? nValue : (nMax - nValue > nMaxDeviation ? nValue + nMaxDeviation : nMax)); }
-    };
-
-
 StackedProcessor *expand_square_stacked_c = &MorphologicProcessor<Byte>::generic_16_c<
     process_line_morpho_stacked_c<Border::Left, maximumThresholded<::maximum_square>>,
     process_line_morpho_stacked_c<Border::None, maximumThresholded<::maximum_square>>,
@@ -150,5 +141,11 @@ Processor16 *expand_square_asse4_16 = &xxpand_sse4_square_16<expand_operator_sse
 
 StackedProcessor *expand_custom_stacked_c       = &generic_custom_stacked_c<NewValue16>;
 Processor16 *expand_custom_native_c   = &generic_custom_native_c<NewValue16>;
+Processor16 *expand_custom_sse4_16 = &custom_simd_16<NewValue16, CustomSse4_16<true>>;
+
+StackedProcessor *expand_rectangle_stacked_c = &rectangle_stacked_c<NewValue16, true, false>;
+StackedProcessor *expand_rectangle_stacked_sse4 = &rectangle_stacked_c<NewValue16, true, true>;
+Processor16 *expand_rectangle_native_c = &rectangle_native_c<NewValue16, true, false>;
+Processor16 *expand_rectangle_sse4_16 = &rectangle_native_c<NewValue16, true, true>;
 
 } } } } }
\ No newline at end of file
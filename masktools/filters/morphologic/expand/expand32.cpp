@@ -1,5 +1,7 @@
 #include "expand.h"
 #include "../functions32.h"
+#include "../functions_rectangle.h"
+#include "../functions_custom.h"
 
 using namespace Filtering;
 
@@ -64,17 +66,6 @@ static inline Float maximumThresholded(Float a1, Float a2, Float a3, Float a4, F
 
 namespace Filtering { namespace MaskTools { namespace Filters { namespace Morphologic { namespace Expand {
 
-    class NewValue32 {
-        Float nMax;
-        Float nMaxDeviation;
-        Float nValue;
-    public:
-        NewValue32(Float nValue, Float nMaxDeviation) : nMax(-1.0), nMaxDeviation(nMaxDeviation), nValue(nValue) { }
-        void add(Float _nValue) { if ( _nValue > nMax ) nMax = _nValue; }
-        Float finalize() const { return nMax < 0 ? nValue : (nMax - nValue > nMaxDeviation ? nValue + nMaxDeviation : nMax); }
-    };
-
-
 Processor32 *expand32_square_c = &MorphologicProcessor<Float>::generic_32_c<
     process_line_morpho_32_c<Border::Left, maximumThresholded<::maximum_square>>,
     process_line_morpho_32_c<Border::None, maximumThresholded<::maximum_square>>,
@@ -101,5 +92,8 @@ Processor32 *expand32_both_c = &MorphologicProcessor<Float>::generic_32_c<
 
 
 Processor32 *expand32_custom_c   = &generic_custom_32_c<NewValue32>;
+Processor32 *expand32_custom_sse2 = &custom_simd<NewValue32, CustomSse2_32<true>>;
+Processor32 *expand32_rectangle_c = &rectangle_32_c<NewValue32, true, false>;
+Processor32 *expand32_rectangle_sse2 = &rectangle_32_c<NewValue32, true, true>;
 
 } } } } }
\ No newline at end of file
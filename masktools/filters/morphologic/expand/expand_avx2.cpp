@@ -0,0 +1,12 @@
+#include "expand.h"
+#include "../functions_custom_avx2.h"
+
+using namespace Filtering;
+
+namespace Filtering { namespace MaskTools { namespace Filters { namespace Morphologic { namespace Expand {
+
+Processor *expand_custom_avx2 = &custom_simd<ExpandProcessor, CustomAvx2<true>>;
+Processor16 *expand_custom_avx2_16 = &custom_simd_16<NewValue16, CustomAvx2_16<true>>;
+Processor32 *expand32_custom_avx2 = &custom_simd<NewValue32, CustomAvx2_32<true>>;
+
+} } } } }
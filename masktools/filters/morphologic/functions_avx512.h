@@ -0,0 +1,117 @@
+#ifndef __Mt_MorphologicFunctions_AVX512_H__
+#define __Mt_MorphologicFunctions_AVX512_H__
+
+#include "../../../common/utils/utils.h"
+#include "../../common/simd.h"
+
+namespace Filtering { namespace MaskTools { namespace Filters { namespace Morphologic {
+
+typedef __m512i (LimitAvx512)(__m512i source, __m512i sum, __m512i deviation);
+typedef void (ProcessLineAvx512)(Byte *pDst, const Byte *pSrcp, const Byte *pSrc, const Byte *pSrcn, const __m512i &maxDeviation, int width);
+
+extern "C" static MT_FORCEINLINE __m512i limit_up_avx512(__m512i source, __m512i sum, __m512i deviation) {
+    auto limit = _mm512_adds_epu8(source, deviation);
+    return _mm512_min_epu8(limit, _mm512_max_epu8(source, sum));
+}
+
+extern "C" static MT_FORCEINLINE __m512i limit_down_avx512(__m512i source, __m512i sum, __m512i deviation) {
+    auto limit = _mm512_subs_epu8(source, deviation);
+    return _mm512_max_epu8(limit, _mm512_min_epu8(source, sum));
+}
+
+
+template<Border borderMode, LimitAvx512 limit, MemoryMode mem_mode>
+static MT_FORCEINLINE void process_line_xxflate_avx512(Byte *pDst, const Byte *pSrcp, const Byte *pSrc, const Byte *pSrcn, const __m512i &maxDeviation, int width) {
+    auto zero = _mm512_setzero_si512();
+    for ( int x = 0; x < width; x+=64 ) {
+        auto up_left = load_one_to_left_si512<borderMode, mem_mode>(pSrcp+x);
+        auto up_center = simd512_load_si512<mem_mode>(pSrcp + x);
+        auto up_right = load_one_to_right_si512<borderMode, mem_mode>(pSrcp+x);
+
+        auto middle_left = load_one_to_left_si512<borderMode, mem_mode>(pSrc+x);
+        auto middle_right = load_one_to_right_si512<borderMode, mem_mode>(pSrc+x);
+
+        auto down_left = load_one_to_left_si512<borderMode, mem_mode>(pSrcn+x);
+        auto down_center = simd512_load_si512<mem_mode>(pSrcn + x);
+        auto down_right = load_one_to_right_si512<borderMode, mem_mode>(pSrcn+x);
+
+        auto sum_lo = _mm512_add_epi16(_mm512_unpacklo_epi8(up_left, zero), _mm512_unpacklo_epi8(up_center, zero));
+        sum_lo = _mm512_add_epi16(sum_lo, _mm512_unpacklo_epi8(up_right, zero));
+        sum_lo = _mm512_add_epi16(sum_lo, _mm512_unpacklo_epi8(middle_left, zero));
+        sum_lo = _mm512_add_epi16(sum_lo, _mm512_unpacklo_epi8(middle_right, zero));
+        sum_lo = _mm512_add_epi16(sum_lo, _mm512_unpacklo_epi8(down_left, zero));
+        sum_lo = _mm512_add_epi16(sum_lo, _mm512_unpacklo_epi8(down_center, zero));
+        sum_lo = _mm512_add_epi16(sum_lo, _mm512_unpacklo_epi8(down_right, zero));
+
+        auto sum_hi = _mm512_add_epi16(_mm512_unpackhi_epi8(up_left, zero), _mm512_unpackhi_epi8(up_center, zero));
+        sum_hi = _mm512_add_epi16(sum_hi, _mm512_unpackhi_epi8(up_right, zero));
+        sum_hi = _mm512_add_epi16(sum_hi, _mm512_unpackhi_epi8(middle_left, zero));
+        sum_hi = _mm512_add_epi16(sum_hi, _mm512_unpackhi_epi8(middle_right, zero));
+        sum_hi = _mm512_add_epi16(sum_hi, _mm512_unpackhi_epi8(down_left, zero));
+        sum_hi = _mm512_add_epi16(sum_hi, _mm512_unpackhi_epi8(down_center, zero));
+        sum_hi = _mm512_add_epi16(sum_hi, _mm512_unpackhi_epi8(down_right, zero));
+
+        sum_lo = _mm512_srai_epi16(sum_lo, 3);
+        sum_hi = _mm512_srai_epi16(sum_hi, 3);
+
+        // unpack and pack both work per 128 bit lane, so the order comes back as it was
+        auto result = _mm512_packus_epi16(sum_lo, sum_hi);
+
+        auto middle_center = simd512_load_si512<mem_mode>(pSrc + x);
+
+        result = limit(middle_center, result, maxDeviation);
+
+        simd512_store_si512<mem_mode>(pDst+x, result);
+    }
+}
+
+template<ProcessLineAvx512 process_line_left, ProcessLineAvx512 process_line, ProcessLineAvx512 process_line_right>
+static void generic_avx512(Byte *pDst, ptrdiff_t nDstPitch, const Byte *pSrc, ptrdiff_t nSrcPitch, int nMaxDeviation, const int *pCoordinates, int nCoordinates, int nWidth, int nHeight) {
+    const Byte *pSrcp = pSrc - nSrcPitch;
+    const Byte *pSrcn = pSrc + nSrcPitch;
+
+    UNUSED(nCoordinates); UNUSED(pCoordinates);
+    auto max_dev_v = _mm512_set1_epi8(Byte(nMaxDeviation));
+    // the right block would overwrite the left border pixel of a 64 wide row, hence the 65 minimum width
+    int avx512_width = (nWidth - 1 - 64) / 64 * 64 + 64;
+    /* top-left */
+    process_line_left(pDst, pSrc, pSrc, pSrcn, max_dev_v, 64);
+    /* top */
+    process_line(pDst + 64, pSrc+64, pSrc+64, pSrcn+64, max_dev_v, avx512_width - 64);
+
+    /* top-right */
+    process_line_right(pDst + nWidth - 64, pSrc + nWidth - 64, pSrc + nWidth - 64, pSrcn + nWidth - 64, max_dev_v, 64);
+
+    pDst  += nDstPitch;
+    pSrcp += nSrcPitch;
+    pSrc  += nSrcPitch;
+    pSrcn += nSrcPitch;
+
+    for ( int y = 1; y < nHeight-1; y++ )
+    {
+        /* left */
+        process_line_left(pDst, pSrcp, pSrc, pSrcn, max_dev_v, 64);
+        /* center */
+        process_line(pDst + 64, pSrcp+64, pSrc+64, pSrcn+64, max_dev_v, avx512_width - 64);
+        /* right */
+        process_line_right(pDst + nWidth - 64, pSrcp + nWidth - 64, pSrc + nWidth - 64, pSrcn + nWidth - 64, max_dev_v, 64);
+
+        pDst  += nDstPitch;
+        pSrcp += nSrcPitch;
+        pSrc  += nSrcPitch;
+        pSrcn += nSrcPitch;
+    }
+
+    /* bottom-left */
+    process_line_left(pDst, pSrcp, pSrc, pSrc, max_dev_v, 64);
+    /* bottom */
+    process_line(pDst + 64, pSrcp+64, pSrc+64, pSrc+64, max_dev_v, avx512_width - 64);
+    /* bottom-right */
+    process_line_right(pDst + nWidth - 64, pSrcp + nWidth - 64, pSrc + nWidth - 64, pSrc + nWidth - 64, max_dev_v, 64);
+
+    _mm256_zeroupper();
+}
+
+} } } }
+
+#endif
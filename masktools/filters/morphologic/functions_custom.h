@@ -0,0 +1,168 @@
+#ifndef __Mt_MorphologicFunctionsCustom_H__
+#define __Mt_MorphologicFunctionsCustom_H__
+
+#include "../../../common/utils/utils.h"
+#include "../../common/simd.h"
+#include <vector>
+
+namespace Filtering { namespace MaskTools { namespace Filters { namespace Morphologic {
+
+/* Custom coordinates that don't decompose: the same as generic_custom_c, but the columns where every
+   coordinate is inside the row are done a vector at a time, with one load of the shifted source row
+   per coordinate. Borders and rows without any neighbour stay with NewValue, pixel by pixel.
+   A policy P gives the vector type of a pixel type:
+      count                   pixels of a vector
+      load, store
+      init()                  extremum before the first coordinate, the one of NewValue
+      op(acc, v)              extremum, acc is kept when they are equal
+      deviation(nMaxDev)      the limit as a vector
+      finalize(value, m, dev) NewValue::finalize when there is a neighbour */
+
+template<class NewValue, typename T, typename D>
+static MT_FORCEINLINE T custom_pixel(const T *pSrc, ptrdiff_t nSrcPitch, D nMaxDeviation, const int *pCoordinates, int nCoordinates, int x, int y, int nWidth, int nHeight)
+{
+   NewValue new_value(pSrc[x], nMaxDeviation);
+   for ( int k = 0; k < nCoordinates; k += 2 )
+   {
+      if ( pCoordinates[k] + x >= 0 && pCoordinates[k] + x < nWidth &&
+           pCoordinates[k+1] + y >= 0 && pCoordinates[k+1] + y < nHeight )
+         new_value.add(pSrc[x + pCoordinates[k] + pCoordinates[k+1] * nSrcPitch]);
+   }
+   return new_value.finalize();
+}
+
+template<class NewValue, class P, typename D>
+void custom_simd(typename P::pixel_t *pDst, ptrdiff_t nDstPitch, const typename P::pixel_t *pSrc, ptrdiff_t nSrcPitch, D nMaxDeviation, const int *pCoordinates, int nCoordinates, int nWidth, int nHeight)
+{
+   typedef typename P::pixel_t T;
+   typedef typename P::vector_t V;
+
+   /* columns where every coordinate stays in the row */
+   int nMinX = 0, nMaxX = 0;
+   for ( int k = 0; k < nCoordinates; k += 2 )
+   {
+      nMinX = min(nMinX, pCoordinates[k]);
+      nMaxX = max(nMaxX, pCoordinates[k]);
+   }
+   const int nBegin = -nMinX;
+   const int nEnd = nWidth - nMaxX;
+   const bool isVectorWide = nEnd - nBegin >= P::count;
+
+   const V deviation = P::deviation(nMaxDeviation);
+   std::vector<ptrdiff_t> offsets;
+   offsets.reserve(nCoordinates / 2);
+
+   const T *pSrcRow = pSrc;
+   for ( int y = 0; y < nHeight; y++ )
+   {
+      /* coordinates whose row is in the plane */
+      offsets.clear();
+      for ( int k = 0; k < nCoordinates; k += 2 )
+         if ( pCoordinates[k+1] + y >= 0 && pCoordinates[k+1] + y < nHeight )
+            offsets.push_back(pCoordinates[k] + pCoordinates[k+1] * nSrcPitch);
+
+      if ( offsets.empty() || !isVectorWide )
+      {
+         for ( int x = 0; x < nWidth; x++ )
+            pDst[x] = custom_pixel<NewValue>(pSrc, nSrcPitch, nMaxDeviation, pCoordinates, nCoordinates, x, y, nWidth, nHeight);
+      }
+      else
+      {
+         for ( int x = 0; x < nBegin; x++ )
+            pDst[x] = custom_pixel<NewValue>(pSrc, nSrcPitch, nMaxDeviation, pCoordinates, nCoordinates, x, y, nWidth, nHeight);
+
+         /* the last vector overlaps the previous one instead of a scalar tail */
+         for ( int x = nBegin; x < nEnd; x += P::count )
+         {
+            if ( x > nEnd - P::count )
+               x = nEnd - P::count;
+
+            V extremum = P::init();
+            for ( auto offset : offsets )
+               extremum = P::op(extremum, P::load(pSrcRow + x + offset));
+            P::store(pDst + x, P::finalize(P::load(pSrcRow + x), extremum, deviation));
+         }
+
+         for ( int x = nEnd; x < nWidth; x++ )
+            pDst[x] = custom_pixel<NewValue>(pSrc, nSrcPitch, nMaxDeviation, pCoordinates, nCoordinates, x, y, nWidth, nHeight);
+      }
+
+      pSrc += nSrcPitch;
+      pSrcRow += nSrcPitch;
+      pDst += nDstPitch;
+   }
+}
+
+template<class NewValue, class P>
+void custom_simd_16(Word *pDst, ptrdiff_t nDstPitch, const Word *pSrc, ptrdiff_t nSrcPitch, int nMaxDeviation, const int *pCoordinates, int nCoordinates, int nWidth, int nHeight, int nOrigHeight)
+{
+   UNUSED(nOrigHeight);
+   custom_simd<NewValue, P>(pDst, nDstPitch, pSrc, nSrcPitch, nMaxDeviation, pCoordinates, nCoordinates, nWidth, nHeight);
+}
+
+/* sse2, 8 bit */
+template<bool isMax>
+struct CustomSse2 {
+   typedef Byte pixel_t;
+   typedef __m128i vector_t;
+   static const int count = 16;
+
+   static MT_FORCEINLINE __m128i load(const Byte *ptr) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr)); }
+   static MT_FORCEINLINE void store(Byte *ptr, __m128i value) { _mm_storeu_si128(reinterpret_cast<__m128i*>(ptr), value); }
+   static MT_FORCEINLINE __m128i init() { return isMax ? _mm_setzero_si128() : _mm_set1_epi8(-1); }
+   static MT_FORCEINLINE __m128i op(__m128i acc, __m128i value) { return isMax ? _mm_max_epu8(acc, value) : _mm_min_epu8(acc, value); }
+   static MT_FORCEINLINE __m128i deviation(int nMaxDeviation) { return _mm_set1_epi8(Byte(min(nMaxDeviation, 255))); }
+   static MT_FORCEINLINE __m128i finalize(__m128i value, __m128i extremum, __m128i deviation) {
+      return isMax ? _mm_min_epu8(extremum, _mm_adds_epu8(value, deviation)) : _mm_max_epu8(extremum, _mm_subs_epu8(value, deviation));
+   }
+};
+
+/* sse4.1, 10-16 bit */
+template<bool isMax>
+struct CustomSse4_16 {
+   typedef Word pixel_t;
+   typedef __m128i vector_t;
+   static const int count = 8;
+
+   static MT_FORCEINLINE __m128i load(const Word *ptr) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr)); }
+   static MT_FORCEINLINE void store(Word *ptr, __m128i value) { _mm_storeu_si128(reinterpret_cast<__m128i*>(ptr), value); }
+   static MT_FORCEINLINE __m128i init() { return isMax ? _mm_setzero_si128() : _mm_set1_epi16(-1); }
+   static MT_FORCEINLINE __m128i op(__m128i acc, __m128i value) { return isMax ? _mm_max_epu16(acc, value) : _mm_min_epu16(acc, value); }
+   static MT_FORCEINLINE __m128i deviation(int nMaxDeviation) { return _mm_set1_epi16(short(min(nMaxDeviation, 65535))); }
+   static MT_FORCEINLINE __m128i finalize(__m128i value, __m128i extremum, __m128i deviation) {
+      return isMax ? _mm_min_epu16(extremum, _mm_adds_epu16(value, deviation)) : _mm_max_epu16(extremum, _mm_subs_epu16(value, deviation));
+   }
+};
+
+/* sse2, float. NewValue32 starts from -1 (expand) or 1 (inpand) and keeps it without neighbour
+   beyond it, max_ps and min_ps return their second operand on equality */
+template<bool isMax>
+struct CustomSse2_32 {
+   typedef Float pixel_t;
+   typedef __m128 vector_t;
+   static const int count = 4;
+
+   static MT_FORCEINLINE __m128 load(const Float *ptr) { return _mm_loadu_ps(ptr); }
+   static MT_FORCEINLINE void store(Float *ptr, __m128 value) { _mm_storeu_ps(ptr, value); }
+   static MT_FORCEINLINE __m128 init() { return _mm_set1_ps(isMax ? -1.0f : 1.0f); }
+   static MT_FORCEINLINE __m128 op(__m128 acc, __m128 value) { return isMax ? _mm_max_ps(value, acc) : _mm_min_ps(value, acc); }
+   static MT_FORCEINLINE __m128 deviation(Float nMaxDeviation) { return _mm_set1_ps(nMaxDeviation); }
+   static MT_FORCEINLINE __m128 finalize(__m128 value, __m128 extremum, __m128 deviation) {
+      if (isMax) {
+         auto over = _mm_cmpgt_ps(_mm_sub_ps(extremum, value), deviation);
+         auto result = _mm_or_ps(_mm_and_ps(over, _mm_add_ps(value, deviation)), _mm_andnot_ps(over, extremum));
+         auto none = _mm_cmplt_ps(extremum, _mm_setzero_ps());
+         return _mm_or_ps(_mm_and_ps(none, value), _mm_andnot_ps(none, result));
+      }
+      else {
+         auto over = _mm_cmpgt_ps(_mm_sub_ps(value, extremum), deviation);
+         auto result = _mm_or_ps(_mm_and_ps(over, _mm_sub_ps(value, deviation)), _mm_andnot_ps(over, extremum));
+         auto none = _mm_cmpgt_ps(extremum, _mm_set1_ps(1.0f));
+         return _mm_or_ps(_mm_and_ps(none, value), _mm_andnot_ps(none, result));
+      }
+   }
+};
+
+} } } } // namespace Morphologic, Filters, MaskTools, Filtering
+
+#endif
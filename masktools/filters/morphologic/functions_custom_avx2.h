@@ -0,0 +1,69 @@
+#ifndef __Mt_MorphologicFunctionsCustomAvx2_H__
+#define __Mt_MorphologicFunctionsCustomAvx2_H__
+
+#include "functions_custom.h"
+
+namespace Filtering { namespace MaskTools { namespace Filters { namespace Morphologic {
+
+/* avx2 policies of custom_simd, the same operations as their sse counterparts on 32 bytes */
+
+template<bool isMax>
+struct CustomAvx2 {
+   typedef Byte pixel_t;
+   typedef __m256i vector_t;
+   static const int count = 32;
+
+   static MT_FORCEINLINE __m256i load(const Byte *ptr) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ptr)); }
+   static MT_FORCEINLINE void store(Byte *ptr, __m256i value) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(ptr), value); }
+   static MT_FORCEINLINE __m256i init() { return isMax ? _mm256_setzero_si256() : _mm256_set1_epi8(-1); }
+   static MT_FORCEINLINE __m256i op(__m256i acc, __m256i value) { return isMax ? _mm256_max_epu8(acc, value) : _mm256_min_epu8(acc, value); }
+   static MT_FORCEINLINE __m256i deviation(int nMaxDeviation) { return _mm256_set1_epi8(Byte(min(nMaxDeviation, 255))); }
+   static MT_FORCEINLINE __m256i finalize(__m256i value, __m256i extremum, __m256i deviation) {
+      return isMax ? _mm256_min_epu8(extremum, _mm256_adds_epu8(value, deviation)) : _mm256_max_epu8(extremum, _mm256_subs_epu8(value, deviation));
+   }
+};
+
+template<bool isMax>
+struct CustomAvx2_16 {
+   typedef Word pixel_t;
+   typedef __m256i vector_t;
+   static const int count = 16;
+
+   static MT_FORCEINLINE __m256i load(const Word *ptr) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ptr)); }
+   static MT_FORCEINLINE void store(Word *ptr, __m256i value) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(ptr), value); }
+   static MT_FORCEINLINE __m256i init() { return isMax ? _mm256_setzero_si256() : _mm256_set1_epi16(-1); }
+   static MT_FORCEINLINE __m256i op(__m256i acc, __m256i value) { return isMax ? _mm256_max_epu16(acc, value) : _mm256_min_epu16(acc, value); }
+   static MT_FORCEINLINE __m256i deviation(int nMaxDeviation) { return _mm256_set1_epi16(short(min(nMaxDeviation, 65535))); }
+   static MT_FORCEINLINE __m256i finalize(__m256i value, __m256i extremum, __m256i deviation) {
+      return isMax ? _mm256_min_epu16(extremum, _mm256_adds_epu16(value, deviation)) : _mm256_max_epu16(extremum, _mm256_subs_epu16(value, deviation));
+   }
+};
+
+template<bool isMax>
+struct CustomAvx2_32 {
+   typedef Float pixel_t;
+   typedef __m256 vector_t;
+   static const int count = 8;
+
+   static MT_FORCEINLINE __m256 load(const Float *ptr) { return _mm256_loadu_ps(ptr); }
+   static MT_FORCEINLINE void store(Float *ptr, __m256 value) { _mm256_storeu_ps(ptr, value); }
+   static MT_FORCEINLINE __m256 init() { return _mm256_set1_ps(isMax ? -1.0f : 1.0f); }
+   static MT_FORCEINLINE __m256 op(__m256 acc, __m256 value) { return isMax ? _mm256_max_ps(value, acc) : _mm256_min_ps(value, acc); }
+   static MT_FORCEINLINE __m256 deviation(Float nMaxDeviation) { return _mm256_set1_ps(nMaxDeviation); }
+   static MT_FORCEINLINE __m256 finalize(__m256 value, __m256 extremum, __m256 deviation) {
+      if (isMax) {
+         auto over = _mm256_cmp_ps(_mm256_sub_ps(extremum, value), deviation, _CMP_GT_OQ);
+         auto result = _mm256_blendv_ps(extremum, _mm256_add_ps(value, deviation), over);
+         return _mm256_blendv_ps(result, value, _mm256_cmp_ps(extremum, _mm256_setzero_ps(), _CMP_LT_OQ));
+      }
+      else {
+         auto over = _mm256_cmp_ps(_mm256_sub_ps(value, extremum), deviation, _CMP_GT_OQ);
+         auto result = _mm256_blendv_ps(extremum, _mm256_sub_ps(value, deviation), over);
+         return _mm256_blendv_ps(result, value, _mm256_cmp_ps(extremum, _mm256_set1_ps(1.0f), _CMP_GT_OQ));
+      }
+   }
+};
+
+} } } } // namespace Morphologic, Filters, MaskTools, Filtering
+
+#endif
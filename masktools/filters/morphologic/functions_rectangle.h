@@ -0,0 +1,269 @@
+#ifndef __Mt_MorphologicFunctionsRectangle_H__
+#define __Mt_MorphologicFunctionsRectangle_H__
+
+#include "../../../common/utils/utils.h"
+#include "../../common/simd.h"
+#include "../../common/16bit.h"
+#include "structuring_element.h"
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+namespace Filtering { namespace MaskTools { namespace Filters { namespace Morphologic {
+
+/* Custom coordinates that fill a rectangle (mt_square, mt_rectangle, lines): the extremum over the
+   rectangle is the extremum over its rows of the extremum over its columns, and both passes use the
+   van Herk/Gil-Werman method. The line is cut into blocks of the window length, a window spans the end
+   of a block and the start of the next one: op(suffix of the block, prefix of the next block), three
+   operations per pixel whatever the radius. Neighbours outside the plane are skipped like in
+   generic_custom_c: they are the identity of the operation.
+   Shapes made of runs (mt_ellipse, mt_losange) are the union of a few rectangles, see
+   decompose_rectangles, and take the extremum of the rectangles. */
+
+template<typename T, bool isMax>
+struct Extremum {
+   static T identity() { return isMax ? std::numeric_limits<T>::lowest() : std::numeric_limits<T>::max(); }
+   static T op(T a, T b) { return isMax ? (a > b ? a : b) : (a < b ? a : b); }
+};
+
+/* pDst = op(pSrc1, pSrc2) on a row, returns the number of pixels done */
+template<typename T, bool isMax>
+struct ExtremumSimd;
+
+#define DEFINE_EXTREMUM_SIMD(type, isMax, count, load, store, cast, op) \
+template<> \
+struct ExtremumSimd<type, isMax> { \
+   static int process_row(type *pDst, const type *pSrc1, const type *pSrc2, int nWidth) { \
+      int x = 0; \
+      for ( ; x <= nWidth - count; x += count ) \
+         store(reinterpret_cast<cast *>(pDst + x), op(load(reinterpret_cast<const cast *>(pSrc1 + x)), load(reinterpret_cast<const cast *>(pSrc2 + x)))); \
+      return x; \
+   } \
+};
+
+DEFINE_EXTREMUM_SIMD(Byte, true, 16, _mm_loadu_si128, _mm_storeu_si128, __m128i, _mm_max_epu8)
+DEFINE_EXTREMUM_SIMD(Byte, false, 16, _mm_loadu_si128, _mm_storeu_si128, __m128i, _mm_min_epu8)
+DEFINE_EXTREMUM_SIMD(Word, true, 8, _mm_loadu_si128, _mm_storeu_si128, __m128i, _mm_max_epu16) // sse4.1
+DEFINE_EXTREMUM_SIMD(Word, false, 8, _mm_loadu_si128, _mm_storeu_si128, __m128i, _mm_min_epu16) // sse4.1
+DEFINE_EXTREMUM_SIMD(Float, true, 4, _mm_loadu_ps, _mm_storeu_ps, float, _mm_max_ps)
+DEFINE_EXTREMUM_SIMD(Float, false, 4, _mm_loadu_ps, _mm_storeu_ps, float, _mm_min_ps)
+
+#undef DEFINE_EXTREMUM_SIMD
+
+template<typename T, bool isMax, bool isSimd>
+static MT_FORCEINLINE void extremum_row(T *pDst, const T *pSrc1, const T *pSrc2, int nWidth)
+{
+   int x = isSimd ? ExtremumSimd<T, isMax>::process_row(pDst, pSrc1, pSrc2, nWidth) : 0;
+   for ( ; x < nWidth; x++ )
+      pDst[x] = Extremum<T, isMax>::op(pSrc1[x], pSrc2[x]);
+}
+
+/* pDst[x] = op of pSrc[x + x0 .. x + x0 + nLength - 1], pExtended and pPrefix hold nWidth + nLength - 1 values */
+template<typename T, bool isMax>
+static void rectangle_row(T *pDst, const T *pSrc, int nWidth, int x0, int nLength, T *pExtended, T *pPrefix)
+{
+   typedef Extremum<T, isMax> E;
+   const int nExtended = nWidth + nLength - 1;
+
+   if ( nLength == 1 && x0 == 0 )
+   {
+      std::copy(pSrc, pSrc + nWidth, pDst);
+      return;
+   }
+
+   for ( int e = 0; e < nExtended; e++ )
+      pExtended[e] = e + x0 >= 0 && e + x0 < nWidth ? pSrc[e + x0] : E::identity();
+
+   /* prefixes of the blocks, suffixes in place */
+   for ( int nStart = 0; nStart < nExtended; nStart += nLength )
+   {
+      const int nStop = min(nStart + nLength, nExtended);
+      pPrefix[nStart] = pExtended[nStart];
+      for ( int e = nStart + 1; e < nStop; e++ )
+         pPrefix[e] = E::op(pPrefix[e-1], pExtended[e]);
+      for ( int e = nStop - 2; e >= nStart; e-- )
+         pExtended[e] = E::op(pExtended[e], pExtended[e+1]);
+   }
+
+   for ( int x = 0; x < nWidth; x++ )
+      pDst[x] = E::op(pExtended[x], pPrefix[x + nLength - 1]);
+}
+
+/* load_row(y) returns row y of the source as T, store_row(y, pExtremum, nBegin, nEnd) gets the extremum over
+   the rectangle of the pixels [nBegin, nEnd) of row y, the other ones have no neighbour in the plane
+   (pExtremum is NULL when none of the row has) */
+template<typename T, bool isMax, bool isSimd, class LoadRow, class StoreRow>
+static void rectangle_generic(const Rectangle &rectangle, int nWidth, int nHeight, LoadRow load_row, StoreRow store_row)
+{
+   typedef Extremum<T, isMax> E;
+
+   const int x0 = rectangle.x0, y0 = rectangle.y0, x1 = rectangle.x1, y1 = rectangle.y1;
+   const int nLengthX = x1 - x0 + 1;
+   const int nLengthY = y1 - y0 + 1;
+   const int nBegin = max(0, -x1);
+   const int nEnd = min(nWidth, nWidth - x0);
+
+   /* two blocks of horizontal results, the prefix of the second one and an output row */
+   std::vector<T> buffer(size_t(2 * nLengthY + 2) * nWidth + 2 * size_t(nWidth + nLengthX - 1));
+   T *pBlocks[2] = { &buffer[0], &buffer[size_t(nLengthY) * nWidth] };
+   T *pPrefix = &buffer[size_t(2 * nLengthY) * nWidth];
+   T *pOut = pPrefix + nWidth;
+   T *pExtended = pOut + nWidth;
+   T *pExtendedPrefix = pExtended + nWidth + nLengthX - 1;
+
+   /* row e of the vertical pass is plane row e + y0 */
+   auto horizontal = [&](T *pDst, int e) {
+      const int y = e + y0;
+      if ( y >= 0 && y < nHeight )
+         rectangle_row<T, isMax>(pDst, load_row(y), nWidth, x0, nLengthX, pExtended, pExtendedPrefix);
+      else
+         std::fill(pDst, pDst + nWidth, E::identity());
+   };
+
+   for ( int o = 0; o < nLengthY; o++ )
+      horizontal(pBlocks[0] + o * nWidth, o);
+
+   for ( int nBlock = 0; nBlock * nLengthY < nHeight; nBlock++ )
+   {
+      T *pBlock = pBlocks[nBlock & 1];
+      T *pNext = pBlocks[(nBlock + 1) & 1];
+
+      /* suffixes in place */
+      for ( int o = nLengthY - 2; o >= 0; o-- )
+         extremum_row<T, isMax, isSimd>(pBlock + o * nWidth, pBlock + o * nWidth, pBlock + (o + 1) * nWidth, nWidth);
+
+      /* window of row y: the suffix of the block from o, the prefix of the next block up to o - 1 */
+      for ( int o = 0; o < nLengthY; o++ )
+      {
+         const int y = nBlock * nLengthY + o;
+         const T *pRow = pBlock + o * nWidth;
+         if ( o > 0 )
+         {
+            extremum_row<T, isMax, isSimd>(pOut, pRow, pPrefix, nWidth);
+            pRow = pOut;
+         }
+
+         if ( y < nHeight )
+            store_row(y, y + y1 < 0 || y + y0 >= nHeight ? NULL : pRow, nBegin, nEnd);
+
+         T *pNextRow = pNext + o * nWidth;
+         horizontal(pNextRow, (nBlock + 1) * nLengthY + o);
+         if ( o == 0 )
+            std::copy(pNextRow, pNextRow + nWidth, pPrefix);
+         else
+            extremum_row<T, isMax, isSimd>(pPrefix, pPrefix, pNextRow, nWidth);
+      }
+   }
+}
+
+/* same for the union of the rectangles of the coordinates, which hold the center when there are
+   several of them: their extremum is accumulated in a plane, every pixel has a neighbour */
+template<typename T, bool isMax, bool isSimd, class LoadRow, class StoreRow>
+static void rectangles_generic(const int *pCoordinates, int nCoordinates, int nWidth, int nHeight, LoadRow load_row, StoreRow store_row)
+{
+   const std::vector<Rectangle> rectangles = decompose_rectangles(pCoordinates, nCoordinates);
+   if ( rectangles.size() == 1 )
+   {
+      rectangle_generic<T, isMax, isSimd>(rectangles[0], nWidth, nHeight, load_row, store_row);
+      return;
+   }
+
+   std::vector<T> extremum(size_t(nWidth) * nHeight, Extremum<T, isMax>::identity());
+   for ( auto &rectangle : rectangles )
+   {
+      rectangle_generic<T, isMax, isSimd>(rectangle, nWidth, nHeight, load_row, [&](int y, const T *pExtremum, int, int) {
+         T *pRow = &extremum[size_t(y) * nWidth];
+         if ( pExtremum )
+            extremum_row<T, isMax, isSimd>(pRow, pRow, pExtremum, nWidth);
+      });
+   }
+
+   for ( int y = 0; y < nHeight; y++ )
+      store_row(y, &extremum[size_t(y) * nWidth], 0, nWidth);
+}
+
+template<class NewValue, bool isMax, bool isSimd>
+void rectangle_c(Byte *pDst, ptrdiff_t nDstPitch, const Byte *pSrc, ptrdiff_t nSrcPitch, int nMaxDeviation, const int *pCoordinates, int nCoordinates, int nWidth, int nHeight)
+{
+   rectangles_generic<Byte, isMax, isSimd>(pCoordinates, nCoordinates, nWidth, nHeight,
+      [&](int y) { return pSrc + y * nSrcPitch; },
+      [&](int y, const Byte *pExtremum, int nBegin, int nEnd) {
+         const Byte *pValue = pSrc + y * nSrcPitch;
+         Byte *pRow = pDst + y * nDstPitch;
+         for ( int x = 0; x < nWidth; x++ )
+         {
+            NewValue new_value(pValue[x], nMaxDeviation);
+            if ( pExtremum && x >= nBegin && x < nEnd )
+               new_value.add(pExtremum[x]);
+            pRow[x] = new_value.finalize();
+         }
+      });
+}
+
+template<class NewValue, bool isMax, bool isSimd>
+void rectangle_stacked_c(Byte *pDst, ptrdiff_t nDstPitch, const Byte *pSrc, ptrdiff_t nSrcPitch, int nMaxDeviation, const int *pCoordinates, int nCoordinates, int nWidth, int nHeight, int nOrigHeight)
+{
+   Byte *pDstLsb = pDst + nOrigHeight * nDstPitch / 2;
+   const Byte *pSrcLsb = pSrc + nOrigHeight * nDstPitch / 2;
+   std::vector<Word> values(nWidth), centers(nWidth);
+
+   auto read_row = [&](int y, Word *pRow) {
+      for ( int x = 0; x < nWidth; x++ )
+         pRow[x] = read_word_stacked(pSrc + y * nSrcPitch, pSrcLsb + y * nSrcPitch, x);
+   };
+
+   rectangles_generic<Word, isMax, isSimd>(pCoordinates, nCoordinates, nWidth, nHeight,
+      [&](int y) -> const Word * { read_row(y, &values[0]); return &values[0]; },
+      [&](int y, const Word *pExtremum, int nBegin, int nEnd) {
+         read_row(y, &centers[0]);
+         for ( int x = 0; x < nWidth; x++ )
+         {
+            NewValue new_value(centers[x], nMaxDeviation);
+            if ( pExtremum && x >= nBegin && x < nEnd )
+               new_value.add(pExtremum[x]);
+            write_word_stacked(pDst + y * nDstPitch, pDstLsb + y * nDstPitch, x, new_value.finalize());
+         }
+      });
+}
+
+template<class NewValue, bool isMax, bool isSimd>
+void rectangle_native_c(Word *pDst, ptrdiff_t nDstPitch, const Word *pSrc, ptrdiff_t nSrcPitch, int nMaxDeviation, const int *pCoordinates, int nCoordinates, int nWidth, int nHeight, int nOrigHeight)
+{
+   UNUSED(nOrigHeight);
+
+   rectangles_generic<Word, isMax, isSimd>(pCoordinates, nCoordinates, nWidth, nHeight,
+      [&](int y) { return pSrc + y * nSrcPitch; },
+      [&](int y, const Word *pExtremum, int nBegin, int nEnd) {
+         const Word *pValue = pSrc + y * nSrcPitch;
+         Word *pRow = pDst + y * nDstPitch;
+         for ( int x = 0; x < nWidth; x++ )
+         {
+            NewValue new_value(pValue[x], nMaxDeviation);
+            if ( pExtremum && x >= nBegin && x < nEnd )
+               new_value.add(pExtremum[x]);
+            pRow[x] = new_value.finalize();
+         }
+      });
+}
+
+template<class NewValue, bool isMax, bool isSimd>
+void rectangle_32_c(Float *pDst, ptrdiff_t nDstPitch, const Float *pSrc, ptrdiff_t nSrcPitch, Float nMaxDeviation, const int *pCoordinates, int nCoordinates, int nWidth, int nHeight)
+{
+   rectangles_generic<Float, isMax, isSimd>(pCoordinates, nCoordinates, nWidth, nHeight,
+      [&](int y) { return pSrc + y * nSrcPitch; },
+      [&](int y, const Float *pExtremum, int nBegin, int nEnd) {
+         const Float *pValue = pSrc + y * nSrcPitch;
+         Float *pRow = pDst + y * nDstPitch;
+         for ( int x = 0; x < nWidth; x++ )
+         {
+            NewValue new_value(pValue[x], nMaxDeviation);
+            if ( pExtremum && x >= nBegin && x < nEnd )
+               new_value.add(pExtremum[x]);
+            pRow[x] = new_value.finalize();
+         }
+      });
+}
+
+} } } } // namespace Morphologic, Filters, MaskTools, Filtering
+
+#endif
@@ -8,6 +8,7 @@ namespace Filtering { namespace MaskTools { namespace Filters { namespace Morpho
 extern Processor *inflate_c;
 extern Processor *inflate_sse2;
 extern Processor *inflate_asse2;
+extern Processor *inflate_avx512;
 
 /* 16 bit */
 extern StackedProcessor *inflate_stacked_c;
@@ -34,6 +35,7 @@ public:
       processors.push_back(Filtering::Processor<Processor>(inflate_c, Constraint(CPU_NONE, 1, 1, 1, 1), 0));
       processors.push_back(Filtering::Processor<Processor>(inflate_sse2, Constraint(CPU_SSE2, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 16), 1));
       processors.push_back(Filtering::Processor<Processor>(inflate_asse2, Constraint(CPU_SSE2, MODULO_NONE, MODULO_NONE, ALIGNMENT_16, 16), 2));
+      processors.push_back(Filtering::Processor<Processor>(inflate_avx512, Constraint(CPU_AVX512F | CPU_AVX512BW, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 65), 3));
     }
     else if (_isStacked) {
       stackedProcessors.push_back(Filtering::Processor<StackedProcessor>(inflate_stacked_c, Constraint(CPU_NONE, 1, 1, 1, 1), 0));
@@ -59,6 +61,7 @@ public:
     add_defaults(signature);
 
     signature.add(Parameter(false, "stacked", false));
+    signature.add(Parameter(1, "iterations", false));
     return signature;
   }
 };
@@ -0,0 +1,14 @@
+#include "inflate.h"
+#include "../functions_avx512.h"
+
+using namespace Filtering;
+
+namespace Filtering { namespace MaskTools { namespace Filters { namespace Morphologic { namespace Inflate {
+
+Processor *inflate_avx512 = &generic_avx512<
+    process_line_xxflate_avx512<Border::Left, limit_up_avx512, MemoryMode::SSE2_UNALIGNED>,
+    process_line_xxflate_avx512<Border::None, limit_up_avx512, MemoryMode::SSE2_UNALIGNED>,
+    process_line_xxflate_avx512<Border::Right, limit_up_avx512, MemoryMode::SSE2_UNALIGNED>
+>;
+
+} } } } }
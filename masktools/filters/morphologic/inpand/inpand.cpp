@@ -1,5 +1,7 @@
 #include "inpand.h"
 #include "../functions.h"
+#include "../functions_rectangle.h"
+#include "../functions_custom.h"
 
 using namespace Filtering;
 
@@ -70,23 +72,6 @@ extern "C" static MT_FORCEINLINE __m128i inpand_operator_sse2(__m128i a, __m128i
 
 namespace Filtering { namespace MaskTools { namespace Filters { namespace Morphologic { namespace Inpand {
 
-class NewValue {
-    int min;
-    int max_deviation;
-    Byte value;
-public:
-    NewValue(Byte nValue, int nMaxDeviation) : min(256), max_deviation(nMaxDeviation), value(nValue) { }
-
-    void add(Byte nValue) {
-        if (nValue < min) {
-            min = nValue;
-        }
-    }
-    Byte finalize() const {
-        return static_cast<Byte>(min > 255 ? value : (value - min > max_deviation ? value - max_deviation : min));
-    }
-};
-
 Processor *inpand_square_c       = &generic_c<minimumThresholded<::minimum_square> >;
 Processor *inpand_horizontal_c   = &generic_c<minimumThresholded<::minimum_horizontal> >;
 Processor *inpand_vertical_c     = &generic_c<minimumThresholded<::minimum_vertical> >;
@@ -113,5 +98,8 @@ Processor *inpand_square_asse2 = &xxpand_sse2_square<inpand_operator_sse2, limit
 
 
 Processor *inpand_custom_c = &generic_custom_c<NewValue>;
+Processor *inpand_custom_sse2 = &custom_simd<NewValue, CustomSse2<false>>;
+Processor *inpand_rectangle_c = &rectangle_c<NewValue, false, false>;
+Processor *inpand_rectangle_sse2 = &rectangle_c<NewValue, false, true>;
 
 } } } } }
\ No newline at end of file
@@ -6,6 +6,44 @@
 namespace Filtering { namespace MaskTools { namespace Filters { namespace Morphologic { namespace Inpand {
 
 
+/* accumulators of the custom modes, over the pixel and its neighbours */
+class NewValue {
+    int min;
+    int max_deviation;
+    Byte value;
+public:
+    NewValue(Byte nValue, int nMaxDeviation) : min(256), max_deviation(nMaxDeviation), value(nValue) { }
+
+    void add(Byte nValue) {
+        if (nValue < min) {
+            min = nValue;
+        }
+    }
+    Byte finalize() const {
+        return static_cast<Byte>(min > 255 ? value : (value - min > max_deviation ? value - max_deviation : min));
+    }
+};
+
+class NewValue16 {
+    int nMin;
+    int nMaxDeviation;
+    Word nValue;
+public:
+    NewValue16(Word nValue, int nMaxDeviation) : nMin(65536), nMaxDeviation(nMaxDeviation), nValue(nValue) { }
+    void add(Word _nValue) { if ( _nValue < nMin ) nMin = _nValue; }
+    Word finalize() const { return static_cast<Word>(nMin > 65535 ? nValue : (nValue - nMin > nMaxDeviation ? nValue - nMaxDeviation : nMin)); }
+};
+
+class NewValue32 {
+    Float nMin;
+    Float nMaxDeviation;
+    Float nValue;
+public:
+    NewValue32(Float nValue, Float nMaxDeviation) : nMin(1.0f), nMaxDeviation(nMaxDeviation), nValue(nValue) { }
+    void add(Float _nValue) { if ( _nValue < nMin ) nMin = _nValue; }
+    Float finalize() const { return nMin > 1.0f ? nValue : (nValue - nMin > nMaxDeviation ? nValue - nMaxDeviation : nMin); }
+};
+
 extern Processor *inpand_square_c;
 extern Processor *inpand_square_sse2;
 extern Processor *inpand_square_asse2;
@@ -23,6 +61,10 @@ extern Processor *inpand_both_sse2;
 extern Processor *inpand_both_asse2;
 
 extern Processor *inpand_custom_c;
+extern Processor *inpand_custom_sse2;
+extern Processor *inpand_custom_avx2;
+extern Processor *inpand_rectangle_c;
+extern Processor *inpand_rectangle_sse2;
 
 /* 16 bit */
 extern StackedProcessor *inpand_square_stacked_c;
@@ -30,12 +72,18 @@ extern StackedProcessor *inpand_horizontal_stacked_c;
 extern StackedProcessor *inpand_vertical_stacked_c;
 extern StackedProcessor *inpand_both_stacked_c;
 extern StackedProcessor *inpand_custom_stacked_c;
+extern StackedProcessor *inpand_rectangle_stacked_c;
+extern StackedProcessor *inpand_rectangle_stacked_sse4;
 
 extern Processor16 *inpand_square_native_c;
 extern Processor16 *inpand_horizontal_native_c;
 extern Processor16 *inpand_vertical_native_c;
 extern Processor16 *inpand_both_native_c;
 extern Processor16 *inpand_custom_native_c;
+extern Processor16 *inpand_custom_sse4_16;
+extern Processor16 *inpand_custom_avx2_16;
+extern Processor16 *inpand_rectangle_native_c;
+extern Processor16 *inpand_rectangle_sse4_16;
 
 extern Processor16 *inpand_square_sse4_16;
 extern Processor16 *inpand_square_asse4_16;
@@ -52,6 +100,10 @@ extern Processor32 *inpand32_horizontal_c;
 extern Processor32 *inpand32_vertical_c;
 extern Processor32 *inpand32_both_c;
 extern Processor32 *inpand32_custom_c;
+extern Processor32 *inpand32_custom_sse2;
+extern Processor32 *inpand32_custom_avx2;
+extern Processor32 *inpand32_rectangle_c;
+extern Processor32 *inpand32_rectangle_sse2;
 
 class Inpand : public Morphologic::MorphologicFilter
 {
@@ -142,19 +194,54 @@ public:
     }
     else
     {
-      if (_bits_per_pixel == 8) {
+      FillCoordinates(parameters["mode"].toString());
+      if (has_passes())
+      {
+        // octagons (mt_losange, small mt_ellipse) as 3x3 passes, when there are no thresholds
+        add_pass_processors(PASS_SQUARE, inpand_square_c, inpand_square_sse2, inpand_square_asse2, inpand_square_native_c, inpand_square_sse4_16, inpand_square_asse4_16);
+        add_pass_processors(PASS_BOTH, inpand_both_c, inpand_both_sse2, inpand_both_asse2, inpand_both_native_c, inpand_both_sse4_16, inpand_both_asse4_16);
+        add_pass_processors(PASS_HORIZONTAL, inpand_horizontal_c, inpand_horizontal_sse2, inpand_horizontal_asse2, inpand_horizontal_native_c, inpand_horizontal_sse4_16, inpand_horizontal_asse4_16);
+        add_pass_processors(PASS_VERTICAL, inpand_vertical_c, inpand_vertical_sse2, inpand_vertical_asse2, inpand_vertical_native_c, inpand_vertical_sse4_16, inpand_vertical_asse4_16);
+      }
+      if (is_separable())
+      {
+        // separable van Herk/Gil-Werman passes, O(1) per pixel and rectangle whatever the size
+        if (_bits_per_pixel == 8) {
+          processors.push_back(Filtering::Processor<Processor>(inpand_rectangle_c, Constraint(CPU_NONE, 1, 1, 1, 1), 0));
+          processors.push_back(Filtering::Processor<Processor>(inpand_rectangle_sse2, Constraint(CPU_SSE2, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 1), 1));
+        }
+        else if (_isStacked) {
+          stackedProcessors.push_back(Filtering::Processor<StackedProcessor>(inpand_rectangle_stacked_c, Constraint(CPU_NONE, 1, 1, 1, 1), 0));
+          stackedProcessors.push_back(Filtering::Processor<StackedProcessor>(inpand_rectangle_stacked_sse4, Constraint(CPU_SSE4_1, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 1), 1));
+        }
+        else if (_bits_per_pixel <= 16) {
+          processors16.push_back(Filtering::Processor<Processor16>(inpand_rectangle_native_c, Constraint(CPU_NONE, 1, 1, 1, 1), 0));
+          processors16.push_back(Filtering::Processor<Processor16>(inpand_rectangle_sse4_16, Constraint(CPU_SSE4_1, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 1), 1));
+        }
+        else {
+          processors32.push_back(Filtering::Processor<Processor32>(inpand32_rectangle_c, Constraint(CPU_NONE, 1, 1, 1, 1), 0));
+          processors32.push_back(Filtering::Processor<Processor32>(inpand32_rectangle_sse2, Constraint(CPU_SSE2, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 1), 1));
+        }
+      }
+      else if (_bits_per_pixel == 8) {
+        // anything else: a vector of pixels per coordinate, scalar only at the borders
         processors.push_back(Filtering::Processor<Processor>(inpand_custom_c, Constraint(CPU_NONE, 1, 1, 1, 1), 0));
+        processors.push_back(Filtering::Processor<Processor>(inpand_custom_sse2, Constraint(CPU_SSE2, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 1), 1));
+        processors.push_back(Filtering::Processor<Processor>(inpand_custom_avx2, Constraint(CPU_AVX2, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 1), 2));
       }
       else if (_isStacked) {
         stackedProcessors.push_back(Filtering::Processor<StackedProcessor>(inpand_custom_stacked_c, Constraint(CPU_NONE, 1, 1, 1, 1), 0));
       }
       else if (_bits_per_pixel <= 16) {
         processors16.push_back(Filtering::Processor<Processor16>(inpand_custom_native_c, Constraint(CPU_NONE, 1, 1, 1, 1), 0));
+        processors16.push_back(Filtering::Processor<Processor16>(inpand_custom_sse4_16, Constraint(CPU_SSE4_1, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 1), 1));
+        processors16.push_back(Filtering::Processor<Processor16>(inpand_custom_avx2_16, Constraint(CPU_AVX2, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 1), 2));
       }
       else {
         processors32.push_back(Filtering::Processor<Processor32>(inpand32_custom_c, Constraint(CPU_NONE, 1, 1, 1, 1), 0));
+        processors32.push_back(Filtering::Processor<Processor32>(inpand32_custom_sse2, Constraint(CPU_SSE2, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 1), 1));
+        processors32.push_back(Filtering::Processor<Processor32>(inpand32_custom_avx2, Constraint(CPU_AVX2, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 1), 2));
       }
-      FillCoordinates(parameters["mode"].toString());
     }
   }
 
@@ -170,6 +257,7 @@ public:
     add_defaults(signature);
 
     signature.add(Parameter(false, "stacked", false));
+    signature.add(Parameter(1, "iterations", false));
     return signature;
   }
 };
@@ -1,5 +1,7 @@
 #include "inpand.h"
 #include "../functions16.h"
+#include "../functions_rectangle.h"
+#include "../functions_custom.h"
 
 using namespace Filtering;
 
@@ -68,16 +70,6 @@ extern "C" static MT_FORCEINLINE __m128i inpand_operator_sse4_16(__m128i a, __m1
 
 namespace Filtering { namespace MaskTools { namespace Filters { namespace Morphologic { namespace Inpand {
 
-    class NewValue16 {
-        int nMin;
-        int nMaxDeviation;
-        Word nValue;
-    public:
-        NewValue16(Word nValue, int nMaxDeviation) : nMin(65536), nMaxDeviation(nMaxDeviation), nValue(nValue) { }
-        void add(Word _nValue) { if ( _nValue < nMin ) nMin = _nValue; }
-        Word finalize() const { return static_cast<Word>(nMin > 65535 ? nValue : (nValue - nMin > nMaxDeviation ? nValue - nMaxDeviation : nMin)); }
-    };
-
 StackedProcessor *inpand_square_stacked_c = &MorphologicProcessor<Byte>::generic_16_c<
     process_line_morpho_stacked_c<Border::Left, minimumThresholded<::minimum_square>>,
     process_line_morpho_stacked_c<Border::None, minimumThresholded<::minimum_square>>,
@@ -149,5 +141,11 @@ Processor16 *inpand_square_asse4_16 = &xxpand_sse4_square_16<inpand_operator_sse
 
 StackedProcessor *inpand_custom_stacked_c = &generic_custom_stacked_c<NewValue16>;
 Processor16 *inpand_custom_native_c = &generic_custom_native_c<NewValue16>;
+Processor16 *inpand_custom_sse4_16 = &custom_simd_16<NewValue16, CustomSse4_16<false>>;
+
+StackedProcessor *inpand_rectangle_stacked_c = &rectangle_stacked_c<NewValue16, false, false>;
+StackedProcessor *inpand_rectangle_stacked_sse4 = &rectangle_stacked_c<NewValue16, false, true>;
+Processor16 *inpand_rectangle_native_c = &rectangle_native_c<NewValue16, false, false>;
+Processor16 *inpand_rectangle_sse4_16 = &rectangle_native_c<NewValue16, false, true>;
 
 } } } } }
\ No newline at end of file
@@ -1,5 +1,7 @@
 #include "inpand.h"
 #include "../functions32.h"
+#include "../functions_rectangle.h"
+#include "../functions_custom.h"
 
 using namespace Filtering;
 
@@ -64,17 +66,6 @@ static inline Float minimumThresholded(Float a1, Float a2, Float a3, Float a4, F
 
 namespace Filtering { namespace MaskTools { namespace Filters { namespace Morphologic { namespace Inpand {
 
-    class NewValue32 {
-        Float nMin;
-        Float nMaxDeviation;
-        Float nValue;
-    public:
-        NewValue32(Float nValue, Float nMaxDeviation) : nMin(1.0f), nMaxDeviation(nMaxDeviation), nValue(nValue) { }
-        void add(Float _nValue) { if ( _nValue < nMin ) nMin = _nValue; }
-        Float finalize() const { return nMin > 1.0f ? nValue : (nValue - nMin > nMaxDeviation ? nValue - nMaxDeviation : nMin); }
-    };
-
-
 Processor32 *inpand32_square_c = &MorphologicProcessor<Float>::generic_32_c<
     process_line_morpho_32_c<Border::Left, minimumThresholded<::minimum_square>>,
     process_line_morpho_32_c<Border::None, minimumThresholded<::minimum_square>>,
@@ -100,5 +91,8 @@ Processor32 *inpand32_both_c = &MorphologicProcessor<Float>::generic_32_c<
     >;
 
 Processor32 *inpand32_custom_c = &generic_custom_32_c<NewValue32>;
+Processor32 *inpand32_custom_sse2 = &custom_simd<NewValue32, CustomSse2_32<false>>;
+Processor32 *inpand32_rectangle_c = &rectangle_32_c<NewValue32, false, false>;
+Processor32 *inpand32_rectangle_sse2 = &rectangle_32_c<NewValue32, false, true>;
 
 } } } } }
\ No newline at end of file
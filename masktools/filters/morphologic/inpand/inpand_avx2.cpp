@@ -0,0 +1,12 @@
+#include "inpand.h"
+#include "../functions_custom_avx2.h"
+
+using namespace Filtering;
+
+namespace Filtering { namespace MaskTools { namespace Filters { namespace Morphologic { namespace Inpand {
+
+Processor *inpand_custom_avx2 = &custom_simd<NewValue, CustomAvx2<false>>;
+Processor16 *inpand_custom_avx2_16 = &custom_simd_16<NewValue16, CustomAvx2_16<false>>;
+Processor32 *inpand32_custom_avx2 = &custom_simd<NewValue32, CustomAvx2_32<false>>;
+
+} } } } }
@@ -3,6 +3,8 @@
 
 #include "../../common/base/filter.h"
 #include "../../../common/parser/parser.h"
+#include "structuring_element.h"
+#include <vector>
 
 namespace Filtering { namespace MaskTools { namespace Filters { namespace Morphologic {
 
@@ -17,11 +19,14 @@ class MorphologicFilter : public MaskTools::Filter
     float nMaxDeviations_f[4];
     int *coordinates_list;
     int coordinates_count;
+    bool isSeparable; // rectangles and lines, or a union of them around the center
+    std::vector<int> passes; // 3x3 passes that add up to the coordinates, see decompose_passes
 
     MorphologicFilter(const MorphologicFilter &filter);
 
     int bits_per_pixel;
     bool isStacked;
+    int nIterations; // passes of the kernel
 
 protected:
 
@@ -30,29 +35,77 @@ protected:
     ProcessorList<Processor16> processors16;
     ProcessorList<Processor32> processors32;
 
-    virtual void process(int n, const Plane<Byte> &dst, int nPlane, const ::Filtering::Frame<const Byte> frames[4], const Constraint constraints[4], PNeoEnv env) override
+    ProcessorList<Processor> passProcessors[PASS_COUNT];
+    ProcessorList<Processor16> passProcessors16[PASS_COUNT];
+
+    void process_pass(Byte *pDst, ptrdiff_t nDstPitch, const Byte *pSrc, ptrdiff_t nSrcPitch, int nWidth, int nHeight, int nOrigHeight, int nPlane, const Constraint &constraint)
     {
-      UNUSED(n); UNUSED(env);
       if (bits_per_pixel == 8) {
-        processors.best_processor(constraints[nPlane])(dst.data(), dst.pitch(),
-          frames[0].plane(nPlane).data(), frames[0].plane(nPlane).pitch(),
-          nMaxDeviations[nPlane], coordinates_list, coordinates_count, dst.width(), dst.height());
+        processors.best_processor(constraint)(pDst, nDstPitch, pSrc, nSrcPitch,
+          nMaxDeviations[nPlane], coordinates_list, coordinates_count, nWidth, nHeight);
       }
       else if (isStacked) {
-        stackedProcessors.best_processor(constraints[nPlane])(dst.data(), dst.pitch(),
-          frames[0].plane(nPlane).data(), frames[0].plane(nPlane).pitch(),
-          nMaxDeviations[nPlane], coordinates_list, coordinates_count, dst.width(), dst.height() / 2, dst.origheight()); // stacked: /2
+        stackedProcessors.best_processor(constraint)(pDst, nDstPitch, pSrc, nSrcPitch,
+          nMaxDeviations[nPlane], coordinates_list, coordinates_count, nWidth, nHeight / 2, nOrigHeight); // stacked: /2
       }
       else if(bits_per_pixel <= 16) {
-        processors16.best_processor(constraints[nPlane])(reinterpret_cast<Word*>((Byte*)dst.data()), dst.pitch() / sizeof(uint16_t), /* /2: word sized */
-          reinterpret_cast<const Word*>((const Byte*)(frames[0].plane(nPlane).data())), frames[0].plane(nPlane).pitch() / sizeof(uint16_t),
-          nMaxDeviations[nPlane], coordinates_list, coordinates_count, dst.width(), dst.height(), dst.origheight());
+        processors16.best_processor(constraint)(reinterpret_cast<Word*>(pDst), nDstPitch / sizeof(uint16_t), /* /2: word sized */
+          reinterpret_cast<const Word*>(pSrc), nSrcPitch / sizeof(uint16_t),
+          nMaxDeviations[nPlane], coordinates_list, coordinates_count, nWidth, nHeight, nOrigHeight);
+      }
+      else {
+        processors32.best_processor(constraint)((Float *)pDst, nDstPitch / sizeof(Float),
+          (const Float *)pSrc, nSrcPitch / sizeof(Float),
+          nMaxDeviations_f[nPlane], coordinates_list, coordinates_count, nWidth, nHeight);
+      }
+    }
+
+    void process_decomposed_pass(int nPass, Byte *pDst, ptrdiff_t nDstPitch, const Byte *pSrc, ptrdiff_t nSrcPitch, int nWidth, int nHeight, int nOrigHeight, int nPlane, const Constraint &constraint)
+    {
+      if (bits_per_pixel == 8) {
+        passProcessors[nPass].best_processor(constraint)(pDst, nDstPitch, pSrc, nSrcPitch,
+          nMaxDeviations[nPlane], NULL, 0, nWidth, nHeight);
       }
       else {
-        processors32.best_processor(constraints[nPlane])((Float *)dst.data(), dst.pitch() / sizeof(Float),
-          (Float *)frames[0].plane(nPlane).data(), frames[0].plane(nPlane).pitch() / sizeof(Float),
-          nMaxDeviations_f[nPlane], coordinates_list, coordinates_count, dst.width(), dst.height());
+        passProcessors16[nPass].best_processor(constraint)(reinterpret_cast<Word*>(pDst), nDstPitch / sizeof(uint16_t),
+          reinterpret_cast<const Word*>(pSrc), nSrcPitch / sizeof(uint16_t),
+          nMaxDeviations[nPlane], NULL, 0, nWidth, nHeight, nOrigHeight);
+      }
+    }
+
+    virtual void process(int n, const Plane<Byte> &dst, int nPlane, const ::Filtering::Frame<const Byte> frames[4], const Constraint constraints[4], PNeoEnv env) override
+    {
+      UNUSED(n);
+      const Plane<const Byte> src = frames[0].plane(nPlane);
+
+      // coordinates that add up from 3x3 passes run them with the 3x3 kernels, unless a threshold
+      // would apply at each of them. The 3x3 kernels need two rows and columns
+      const bool isDecomposed = !passes.empty() && nMaxDeviations[nPlane] >= (1 << bits_per_pixel) - 1
+        && dst.width() >= 2 && dst.height() >= 2;
+      const int nSteps = nIterations * (isDecomposed ? int(passes.size()) : 1);
+
+      auto step = [&](int nStep, Byte *pDst, ptrdiff_t nDstPitch, const Byte *pSrc, ptrdiff_t nSrcPitch, int nWidth, int nHeight, int nOrigHeight, const Constraint &constraint) {
+        if (isDecomposed)
+          process_decomposed_pass(passes[nStep % passes.size()], pDst, nDstPitch, pSrc, nSrcPitch, nWidth, nHeight, nOrigHeight, nPlane, constraint);
+        else
+          process_pass(pDst, nDstPitch, pSrc, nSrcPitch, nWidth, nHeight, nOrigHeight, nPlane, constraint);
+      };
+
+      if (nSteps == 1) {
+        step(0, dst.data(), dst.pitch(), src.data(), src.pitch(), dst.width(), dst.height(), dst.origheight(), constraints[nPlane]);
+        return;
       }
+
+      // all the passes in one sweep over the plane instead of nSteps full planes
+      StripeChain chain;
+      for (int i = 0; i < nSteps; i++)
+        chain.add(isDecomposed ? (passes[i % passes.size()] == PASS_HORIZONTAL ? 0 : 1) : nStripeHalo / nIterations, false);
+
+      chain.process(dst, src, [&](int nStep, Byte *pDst, ptrdiff_t nDstPitch, const Byte *pSrc, ptrdiff_t nSrcPitch, int nWidth, int nHeight) {
+        const Constraint constraint(Constraint(flags, Plane<Byte>(pDst, nDstPitch, nWidth, nHeight, dst.pixelsize(), nHeight)),
+          Plane<const Byte>(pSrc, nSrcPitch, nWidth, nHeight, dst.pixelsize(), nHeight));
+        step(nStep, pDst, nDstPitch, pSrc, nSrcPitch, nWidth, nHeight, nHeight, constraint);
+      }, nullptr, 1, env);
     }
 
     void FillCoordinates(const String &coordinates)
@@ -67,16 +120,58 @@ protected:
             coordinates_list[i++] = int(coeffs.front().getValue(0, 0, 0));
             coeffs.pop_front();
         }
+
+        // stripes need the rows of the farthest neighbour, for each pass
+        int nPassHalo = 0;
+        for (int k = 1; k < coordinates_count; k += 2)
+            nPassHalo = max(nPassHalo, abs<int>(coordinates_list[k]));
+        nStripeHalo = nIterations * nPassHalo;
+
+        // rectangles, lines and shapes made of runs get the separable kernels, shapes that add up
+        // from 3x3 passes the 3x3 kernels (8-16 bit), except the large rectangles
+        const size_t nRectangles = decompose_rectangles(coordinates_list, coordinates_count).size();
+        isSeparable = nRectangles > 0;
+        if (!isStacked && bits_per_pixel <= 16)
+            passes = decompose_passes(coordinates_list, coordinates_count);
+        if (nRectangles == 1 && passes.size() > 8)
+            passes.clear();
+    }
+
+    // the 3x3 processors of a pass of decompose_passes. The left and right blocks of the 8 bit
+    // sse2 ones are the same one at width 16, so they start at 17
+    void add_pass_processors(Pass pass, Processor *c, Processor *sse2, Processor *asse2, Processor16 *native_c, Processor16 *sse4_16, Processor16 *asse4_16)
+    {
+        passProcessors[pass].push_back(Filtering::Processor<Processor>(c, Constraint(CPU_NONE, 1, 1, 1, 1), 0));
+        passProcessors[pass].push_back(Filtering::Processor<Processor>(sse2, Constraint(CPU_SSE2, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 17), 1));
+        passProcessors[pass].push_back(Filtering::Processor<Processor>(asse2, Constraint(CPU_SSE2, MODULO_NONE, MODULO_NONE, ALIGNMENT_16, 17), 2));
+        passProcessors16[pass].push_back(Filtering::Processor<Processor16>(native_c, Constraint(CPU_NONE, 1, 1, 1, 1), 0));
+        passProcessors16[pass].push_back(Filtering::Processor<Processor16>(sse4_16, Constraint(CPU_SSE4_1, MODULO_NONE, MODULO_NONE, ALIGNMENT_NONE, 16), 1));
+        passProcessors16[pass].push_back(Filtering::Processor<Processor16>(asse4_16, Constraint(CPU_SSE4_1, MODULO_NONE, MODULO_NONE, ALIGNMENT_16, 16), 2));
     }
 
+    bool is_separable() const { return isSeparable; }
+    bool has_passes() const { return !passes.empty(); }
+
 public:
     MorphologicFilter(const Parameters &parameters, CpuFlags cpuFlags, PNeoEnv env)
-       : MaskTools::Filter(parameters, FilterProcessingType::CHILD, (CpuFlags)cpuFlags), coordinates_list(NULL), coordinates_count(0)
+       : MaskTools::Filter(parameters, FilterProcessingType::CHILD, (CpuFlags)cpuFlags), coordinates_list(NULL), coordinates_count(0), isSeparable(false)
     {
+       nIterations = parameters["iterations"].is_defined() ? parameters["iterations"].toInt() : 1;
+       nStripeHalo = nIterations; // 3x3
        UNUSED(env);
       isStacked = parameters["stacked"].toBool();
       bits_per_pixel = bit_depths[C];
 
+      if (nIterations < 1) {
+        error = "iterations must be at least 1";
+        return;
+      }
+
+      if (isStacked && nIterations > 1) {
+        error = "iterations is not supported for stacked clips";
+        return;
+      }
+
       if (isStacked && bits_per_pixel != 8) {
         error = "Stacked specified for a non-8 bit clip";
         return;
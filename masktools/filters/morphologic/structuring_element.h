@@ -0,0 +1,161 @@
+#ifndef __Mt_MorphologicStructuringElement_H__
+#define __Mt_MorphologicStructuringElement_H__
+
+#include "../../../common/utils/utils.h"
+#include <vector>
+
+namespace Filtering { namespace MaskTools { namespace Filters { namespace Morphologic {
+
+/* Decompositions of custom coordinates (mt_rectangle, mt_losange, mt_ellipse...) into operations
+   cheaper than visiting every coordinate for every pixel. Both are exact: with a structuring
+   element B = B1 + B2 (Minkowski sum), expanding by B is expanding by B1 then by B2, and for the
+   sums below the neighbours skipped at the borders of the plane don't change the result. */
+
+struct Rectangle {
+   int x0, y0, x1, y1; // inclusive offsets
+};
+
+/* the coordinates as a bitmap of their bounding box, false if there are none */
+class CoordinatesMap {
+   std::vector<bool> map;
+
+public:
+   int x0, y0, x1, y1;
+
+   bool fill(const int *pCoordinates, int nCoordinates)
+   {
+      if ( nCoordinates < 2 || nCoordinates % 2 )
+         return false;
+
+      x0 = x1 = pCoordinates[0];
+      y0 = y1 = pCoordinates[1];
+      for ( int k = 2; k < nCoordinates; k += 2 )
+      {
+         x0 = min(x0, pCoordinates[k]);
+         x1 = max(x1, pCoordinates[k]);
+         y0 = min(y0, pCoordinates[k+1]);
+         y1 = max(y1, pCoordinates[k+1]);
+      }
+
+      /* more offsets than coordinates: can't be anything dense */
+      if ( Int64(width()) * height() > Int64(nCoordinates) * 64 )
+         return false;
+
+      map.assign(size_t(width()) * height(), false);
+      for ( int k = 0; k < nCoordinates; k += 2 )
+         map[size_t(pCoordinates[k+1] - y0) * width() + pCoordinates[k] - x0] = true;
+      return true;
+   }
+
+   int width() const { return x1 - x0 + 1; }
+   int height() const { return y1 - y0 + 1; }
+   bool contains(int x, int y) const
+   {
+      return x >= x0 && x <= x1 && y >= y0 && y <= y1 && map[size_t(y - y0) * width() + x - x0];
+   }
+};
+
+/* Rectangles whose union is the element: itself for a rectangle or a line, else one per distinct row
+   of shapes whose rows are runs (ellipses, losanges), over the rows that hold that run. The union of
+   several of them is only taken when the center is part of the element, so that every pixel has a
+   neighbour in the plane. Empty when the element isn't made of runs. */
+static inline std::vector<Rectangle> decompose_rectangles(const int *pCoordinates, int nCoordinates)
+{
+   std::vector<Rectangle> rectangles;
+   CoordinatesMap map;
+   if ( !map.fill(pCoordinates, nCoordinates) )
+      return rectangles;
+
+   /* run of each row, x0 > x1 when the row is empty */
+   std::vector<Rectangle> runs(map.height());
+   for ( int y = map.y0; y <= map.y1; y++ )
+   {
+      Rectangle &run = runs[y - map.y0];
+      run.x0 = map.x1 + 1;
+      run.x1 = map.x0 - 1;
+      for ( int x = map.x0; x <= map.x1; x++ )
+      {
+         if ( map.contains(x, y) )
+         {
+            if ( run.x1 >= run.x0 && run.x1 != x - 1 )
+               return std::vector<Rectangle>(); // two runs
+            run.x0 = min(run.x0, x);
+            run.x1 = x;
+         }
+      }
+   }
+
+   for ( int y = map.y0; y <= map.y1; y++ )
+   {
+      const Rectangle &run = runs[y - map.y0];
+      if ( run.x0 > run.x1 )
+         continue;
+
+      /* the rows around y that hold the run, once per run */
+      int top = y, bottom = y;
+      while ( top > map.y0 && runs[top - 1 - map.y0].x0 <= run.x0 && runs[top - 1 - map.y0].x1 >= run.x1 )
+         top--;
+      while ( bottom < map.y1 && runs[bottom + 1 - map.y0].x0 <= run.x0 && runs[bottom + 1 - map.y0].x1 >= run.x1 )
+         bottom++;
+
+      bool isKnown = false;
+      for ( auto &rectangle : rectangles )
+         isKnown |= rectangle.x0 <= run.x0 && rectangle.x1 >= run.x1 && rectangle.y0 <= top && rectangle.y1 >= bottom;
+      if ( !isKnown )
+      {
+         Rectangle rectangle = { run.x0, top, run.x1, bottom };
+         rectangles.push_back(rectangle);
+      }
+   }
+
+   if ( rectangles.size() > 1 && !map.contains(0, 0) )
+      rectangles.clear();
+   return rectangles;
+}
+
+enum Pass {
+   PASS_SQUARE,
+   PASS_BOTH,
+   PASS_HORIZONTAL,
+   PASS_VERTICAL,
+   PASS_COUNT
+};
+
+/* 3x3 passes whose sum is the element: squares, crosses (both) and lines make the octagons
+   |x| <= rx, |y| <= ry, |x| + |y| <= rd, like mt_losange or small mt_ellipse. Empty if the element
+   is not one of them. */
+static inline std::vector<int> decompose_passes(const int *pCoordinates, int nCoordinates)
+{
+   std::vector<int> passes;
+   CoordinatesMap map;
+   if ( !map.fill(pCoordinates, nCoordinates) )
+      return passes;
+
+   const int rx = map.x1, ry = map.y1;
+   int rd = 0;
+   for ( int y = map.y0; y <= map.y1; y++ )
+      for ( int x = map.x0; x <= map.x1; x++ )
+         if ( map.contains(x, y) )
+            rd = max(rd, abs(x) + abs(y));
+
+   if ( map.x0 != -rx || map.y0 != -ry || rd > rx + ry || rd < max(rx, ry) )
+      return passes;
+
+   for ( int y = -ry; y <= ry; y++ )
+      for ( int x = -rx; x <= rx; x++ )
+         if ( map.contains(x, y) != (abs(x) + abs(y) <= rd) )
+            return passes;
+
+   /* a square is a horizontal line plus a vertical one */
+   const int nBoth = rx + ry - rd;
+   const int nSquare = min(rd - rx, rd - ry);
+   passes.insert(passes.end(), nSquare, PASS_SQUARE);
+   passes.insert(passes.end(), nBoth, PASS_BOTH);
+   passes.insert(passes.end(), rd - ry - nSquare, PASS_HORIZONTAL);
+   passes.insert(passes.end(), rd - rx - nSquare, PASS_VERTICAL);
+   return passes;
+}
+
+} } } } // namespace Morphologic, Filters, MaskTools, Filtering
+
+#endif
@@ -68,6 +68,7 @@ public:
     AddDiff(const Parameters &parameters, CpuFlags cpuFlags, PNeoEnv env)
        : MaskTools::Filter(parameters, FilterProcessingType::INPLACE, (CpuFlags)cpuFlags)
     {
+       nStripeHalo = 0;
        UNUSED(env);
       bool isStacked = parameters["stacked"].toBool();
       int bits_per_pixel = bit_depths[C];
@@ -55,6 +55,7 @@ public:
     Average(const Parameters &parameters, CpuFlags cpuFlags, PNeoEnv env)
        : MaskTools::Filter(parameters, FilterProcessingType::INPLACE, (CpuFlags)cpuFlags)
     {
+       nStripeHalo = 0;
        UNUSED(env);
       bool isStacked = parameters["stacked"].toBool();
       bits_per_pixel = bit_depths[C];